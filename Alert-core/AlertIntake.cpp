@@ -0,0 +1,381 @@
+// AlertIntake.cpp
+#include "AlertIntake.h"
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#include <stdio.h>
+#include <cstdlib>
+#include <chrono>
+#include <algorithm>
+
+#pragma comment(lib, "ws2_32.lib")
+
+static const size_t kMaxLineBytes = 64 * 1024;          // ޣΪЭ󲢶Ͽ
+static const size_t kMaxPendingOut = 1024 * 1024;       // ִѹֵʱͣȡӣѹ
+static const size_t kMaxClients = 64;
+static const size_t kApplySamples = 8192;
+
+static int64_t IntakeNowUs()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void SetNonBlocking(SOCKET s)
+{
+    u_long mode = 1;
+    ioctlsocket(s, FIONBIO, &mode);
+}
+
+static bool ParseLongField(const std::string& v, long& out)
+{
+    char* end = nullptr;
+    out = strtol(v.c_str(), &end, 10);
+    return !v.empty() && end && *end == '\0';
+}
+
+static bool ParseIntField(const std::string& v, int& out)
+{
+    long x;
+    if (!ParseLongField(v, x)) return false;
+    out = (int)x;
+    return true;
+}
+
+static bool ParseDoubleField(const std::string& v, double& out)
+{
+    char* end = nullptr;
+    out = strtod(v.c_str(), &end);
+    return !v.empty() && end && *end == '\0';
+}
+
+AlertIntakeServer::~AlertIntakeServer()
+{
+    Stop();
+}
+
+bool AlertIntakeServer::Start(const std::string& bind, int port, BatchHandler handler)
+{
+    if (m_running.load() || port <= 0) return false;
+
+    WSADATA wsaData;
+    WSAStartup(MAKEWORD(2, 2), &wsaData);
+
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((u_short)port);
+    if (inet_pton(AF_INET, bind.empty() ? "127.0.0.1" : bind.c_str(), &addr.sin_addr) != 1) {
+        printf("[INTAKE ERROR] Чļַ: %s\n", bind.c_str());
+        fflush(stdout);
+        return false;
+    }
+
+    m_listen = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (m_listen == INVALID_SOCKET ||
+        ::bind(m_listen, (sockaddr*)&addr, sizeof(addr)) != 0 ||
+        listen(m_listen, SOMAXCONN) != 0) {
+        printf("[INTAKE ERROR] ޷ %s:%d %d\n", bind.c_str(), port, WSAGetLastError());
+        fflush(stdout);
+        if (m_listen != INVALID_SOCKET) closesocket(m_listen);
+        m_listen = INVALID_SOCKET;
+        return false;
+    }
+    SetNonBlocking(m_listen);
+
+    m_handler = std::move(handler);
+    m_applyUs.reserve(kApplySamples);
+    m_running = true;
+    m_thread = std::thread([this]() { run(); });
+
+    printf("[INTAKE] Ԥͽӿڼ %s:%d\n", bind.c_str(), port);
+    fflush(stdout);
+    return true;
+}
+
+void AlertIntakeServer::Stop()
+{
+    if (!m_running.exchange(false)) return;
+    if (m_thread.joinable())
+        m_thread.join();
+    for (auto& c : m_clients)
+        closesocket(c->s);
+    m_clients.clear();
+    closesocket(m_listen);
+    m_listen = INVALID_SOCKET;
+}
+
+bool AlertIntakeServer::ParseLine(const std::string& line, IntakeCommand& cmd, std::string& error)
+{
+    cmd = IntakeCommand();
+
+    std::vector<std::string> fields;
+    size_t start = 0;
+    while (start <= line.size()) {
+        size_t tab = line.find('\t', start);
+        if (tab == std::string::npos) tab = line.size();
+        if (tab > start) fields.push_back(line.substr(start, tab - start));
+        start = tab + 1;
+    }
+    if (fields.empty()) {
+        error = "";
+        return false;
+    }
+
+    const std::string& op = fields[0];
+    if (op == "ADD" || op == "MOD") cmd.op = IntakeCommand::INTAKE_UPSERT;
+    else if (op == "DEL") cmd.op = IntakeCommand::INTAKE_CANCEL;
+    else if (op == "PING") cmd.op = IntakeCommand::INTAKE_PING;
+    else {
+        error = "δ֪ " + op;
+        return false;
+    }
+
+    bool hasId = false;
+    for (size_t i = 1; i < fields.size(); ++i) {
+        size_t eq = fields[i].find('=');
+        if (eq == std::string::npos) {
+            error = "ֶȱ '=': " + fields[i];
+            return false;
+        }
+        std::string key = fields[i].substr(0, eq);
+        std::string value = fields[i].substr(eq + 1);
+
+        bool ok = true;
+        if (key == "id") ok = hasId = ParseLongField(value, cmd.orderId);
+        else if (key == "account") cmd.account = value;
+        else if (key == "symbol") cmd.symbol = value;
+        else if (key == "max") ok = ParseDoubleField(value, cmd.maxPrice);
+        else if (key == "min") ok = ParseDoubleField(value, cmd.minPrice);
+        else if (key == "time") cmd.triggerTime = value;
+        else if (key == "rule") cmd.rule = value;
+        else if (key == "repeat") ok = ParseIntField(value, cmd.repeatMax);
+        else if (key == "cooldown") ok = ParseIntField(value, cmd.cooldownSec);
+        else if (key == "rearm") ok = ParseDoubleField(value, cmd.rearmBand);
+        else if (key == "priority") ok = ParseIntField(value, cmd.priority);
+        else {
+            error = "δֶ֪ " + key;
+            return false;
+        }
+        if (!ok) {
+            error = "ֵֶЧ " + fields[i];
+            return false;
+        }
+    }
+
+    if (cmd.op == IntakeCommand::INTAKE_PING)
+        return true;
+    if (!hasId || cmd.orderId <= 0) {
+        error = "ȱ id";
+        return false;
+    }
+    if (cmd.op == IntakeCommand::INTAKE_UPSERT && cmd.symbol.empty()) {
+        error = "ȱ symbol";
+        return false;
+    }
+    return true;
+}
+
+void AlertIntakeServer::run()
+{
+    std::vector<WSAPOLLFD> fds;
+    while (m_running.load())
+    {
+        fds.clear();
+        WSAPOLLFD lfd = {};
+        lfd.fd = m_listen;
+        lfd.events = POLLRDNORM;
+        fds.push_back(lfd);
+        for (auto& c : m_clients) {
+            WSAPOLLFD pfd = {};
+            pfd.fd = c->s;
+            if (c->out.size() - c->sent < kMaxPendingOut) pfd.events |= POLLRDNORM;
+            if (c->sent < c->out.size()) pfd.events |= POLLWRNORM;
+            fds.push_back(pfd);
+        }
+
+        // ʱֻڼֹͣ־
+        int n = WSAPoll(fds.data(), (ULONG)fds.size(), 100);
+        if (n <= 0)
+            continue;
+
+        // ȴӣfds  m_clients ± 1ٽ
+        std::vector<bool> dead(m_clients.size(), false);
+        for (size_t i = 0; i < m_clients.size(); ++i) {
+            short re = fds[i + 1].revents;
+            Client& c = *m_clients[i];
+            if (re & (POLLRDNORM | POLLHUP | POLLERR)) {
+                if (!onReadable(c)) dead[i] = true;
+            }
+            if (!dead[i] && (re & POLLWRNORM || c.sent < c.out.size())) {
+                if (!flush(c)) dead[i] = true;
+            }
+        }
+        for (size_t i = m_clients.size(); i-- > 0;) {
+            if (dead[i]) {
+                closesocket(m_clients[i]->s);
+                m_clients.erase(m_clients.begin() + i);
+            }
+        }
+
+        if (fds[0].revents & POLLRDNORM)
+            acceptClients();
+    }
+}
+
+void AlertIntakeServer::acceptClients()
+{
+    for (;;) {
+        SOCKET s = accept(m_listen, nullptr, nullptr);
+        if (s == INVALID_SOCKET)
+            return;
+        if (m_clients.size() >= kMaxClients) {
+            closesocket(s);
+            continue;
+        }
+        SetNonBlocking(s);
+        BOOL noDelay = TRUE;
+        setsockopt(s, IPPROTO_TCP, TCP_NODELAY, (const char*)&noDelay, sizeof(noDelay));
+        std::unique_ptr<Client> c(new Client());
+        c->s = s;
+        m_clients.push_back(std::move(c));
+    }
+}
+
+// սջдӹرջЭʱ false
+bool AlertIntakeServer::onReadable(Client& c)
+{
+    char buf[16384];
+    bool closed = false;
+    for (;;) {
+        int n = recv(c.s, buf, sizeof(buf), 0);
+        if (n > 0) {
+            c.in.append(buf, n);
+            continue;
+        }
+        if (n == 0 || WSAGetLastError() != WSAEWOULDBLOCK)
+            closed = true;
+        break;
+    }
+
+    processLines(c);
+    if (c.in.size() > kMaxLineBytes) {
+        printf("[INTAKE ERROR] г %zu ֽڣϿ\n", kMaxLineBytes);
+        fflush(stdout);
+        return false;
+    }
+    // Զ˰رգִٶϿ
+    if (closed) {
+        flush(c);
+        return false;
+    }
+    return true;
+}
+
+bool AlertIntakeServer::flush(Client& c)
+{
+    while (c.sent < c.out.size()) {
+        int n = send(c.s, c.out.data() + c.sent, (int)(c.out.size() - c.sent), 0);
+        if (n > 0) {
+            c.sent += n;
+            continue;
+        }
+        return n < 0 && WSAGetLastError() == WSAEWOULDBLOCK;
+    }
+    c.out.clear();
+    c.sent = 0;
+    return true;
+}
+
+// ζΪһнϷһԽ handlerٰԭ˳дִ
+void AlertIntakeServer::processLines(Client& c)
+{
+    size_t end = c.in.rfind('\n');
+    if (end == std::string::npos)
+        return;
+
+    struct LineResult { long id; bool inBatch; std::string error; };
+    std::vector<LineResult> lines;
+    m_batch.clear();
+
+    size_t start = 0;
+    while (start <= end) {
+        size_t nl = c.in.find('\n', start);
+        size_t len = nl - start;
+        if (len > 0 && c.in[nl - 1] == '\r') len--;
+        std::string line = c.in.substr(start, len);
+        start = nl + 1;
+        if (line.empty()) continue;
+
+        IntakeCommand cmd;
+        LineResult r;
+        bool parsed = ParseLine(line, cmd, r.error);
+        r.id = cmd.orderId;
+        r.inBatch = parsed && cmd.op != IntakeCommand::INTAKE_PING;
+        if (r.inBatch)
+            m_batch.push_back(std::move(cmd));
+        lines.push_back(std::move(r));
+    }
+    c.in.erase(0, end + 1);
+
+    double applyUs = 0.0;
+    m_errors.assign(m_batch.size(), std::string());
+    if (!m_batch.empty()) {
+        int64_t t0 = IntakeNowUs();
+        m_handler(m_batch, m_errors);
+        applyUs = (double)(IntakeNowUs() - t0);
+    }
+
+    size_t k = 0;
+    size_t rejected = 0;
+    for (auto& r : lines) {
+        std::string error = r.error;
+        if (r.inBatch)
+            error = m_errors[k++];
+        if (error.empty()) {
+            c.out += "OK\t" + std::to_string(r.id) + "\n";
+        }
+        else {
+            c.out += "ERR\t" + std::to_string(r.id) + "\t" + error + "\n";
+            rejected++;
+        }
+    }
+
+    std::lock_guard<std::mutex> lk(m_statsMutex);
+    m_commands += lines.size();
+    m_rejected += rejected;
+    if (!m_batch.empty()) {
+        m_batches++;
+        if (m_applyUs.size() < kApplySamples) m_applyUs.push_back(applyUs);
+        else m_applyUs[m_applyPos] = applyUs;
+        m_applyPos = (m_applyPos + 1) % kApplySamples;
+    }
+}
+
+void AlertIntakeServer::Report()
+{
+    std::vector<double> samples;
+    uint64_t batches, commands, rejected;
+    {
+        std::lock_guard<std::mutex> lk(m_statsMutex);
+        samples.swap(m_applyUs);
+        m_applyPos = 0;
+        batches = m_batches;
+        commands = m_commands;
+        rejected = m_rejected;
+        m_batches = m_commands = m_rejected = 0;
+    }
+    if (commands == 0)
+        return;
+
+    double p50 = 0.0, p99 = 0.0;
+    if (!samples.empty()) {
+        size_t i50 = samples.size() / 2;
+        size_t i99 = samples.size() * 99 / 100;
+        std::nth_element(samples.begin(), samples.begin() + i50, samples.end());
+        p50 = samples[i50];
+        std::nth_element(samples.begin(), samples.begin() + i99, samples.end());
+        p99 = samples[i99];
+    }
+    printf("[INTAKE] %llu  %llu ܾ %lluÿӦúʱ p50=%.0f us p99=%.0f us\n",
+        (unsigned long long)batches, (unsigned long long)commands, (unsigned long long)rejected, p50, p99);
+    fflush(stdout);
+}
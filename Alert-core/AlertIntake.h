@@ -0,0 +1,95 @@
+﻿// AlertIntake.h
+#pragma once
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <functional>
+#include <cstdint>
+#include <WinSock2.h>
+
+// =========================================================
+// ===========   预警推送接口（本机 TCP，行协议）   ===========
+// =========================================================
+//
+// 后台在写入 alert_order 并提交后，把同一变更推送到这里，预警在微秒级进入内存，
+// 不必等待下一轮 DB 轮询；DB 仍是唯一数据源，定期全量 / 增量同步照常对账。
+//
+// 每行一条命令，字段以 TAB 分隔，除命令字外均为 key=value（顺序任意，未给出的取默认值）：
+//     ADD  id=1001  account=u1  symbol=rb2601  max=4000  min=0  time=  rule=last > ma(20)
+//          repeat=1  cooldown=0  rearm=0  priority=0
+//     MOD  同 ADD，整条替换（id 不存在时等同 ADD）
+//     DEL  id=1001
+//     PING
+// 一次读到的所有完整行作为一批按顺序应用，每行回一行：OK<TAB>id 或 ERR<TAB>id<TAB>原因。
+// 只监听 [Intake] Bind（默认 127.0.0.1），不做鉴权，不要绑定到对外网卡。
+
+struct IntakeCommand
+{
+    enum Op { INTAKE_UPSERT, INTAKE_CANCEL, INTAKE_PING };
+
+    Op op{ INTAKE_PING };
+    long orderId{ 0 };
+    std::string account;
+    std::string symbol;
+    double maxPrice{ 0.0 };
+    double minPrice{ 0.0 };
+    std::string triggerTime;
+    std::string rule;
+    int repeatMax{ 1 };
+    int cooldownSec{ 0 };
+    double rearmBand{ 0.0 };
+    int priority{ 0 };
+};
+
+class AlertIntakeServer {
+public:
+    // 在网络线程调用：按顺序应用一批命令，errors[i] 为空表示第 i 条成功
+    typedef std::function<void(const std::vector<IntakeCommand>& batch, std::vector<std::string>& errors)> BatchHandler;
+
+    ~AlertIntakeServer();
+
+    bool Start(const std::string& bind, int port, BatchHandler handler);
+    void Stop();
+    bool Running() const { return m_running.load(std::memory_order_relaxed); }
+
+    // 解析一行（不含换行符），失败时返回 false 并给出原因
+    static bool ParseLine(const std::string& line, IntakeCommand& cmd, std::string& error);
+
+    // 输出并清零本周期的批次数、命令数与应用耗时分布
+    void Report();
+
+private:
+    struct Client {
+        SOCKET s = INVALID_SOCKET;
+        std::string in;
+        std::string out;
+        size_t sent = 0;
+    };
+
+    void run();
+    void acceptClients();
+    bool onReadable(Client& c);
+    bool flush(Client& c);
+    void processLines(Client& c);
+
+    BatchHandler m_handler;
+    SOCKET m_listen = INVALID_SOCKET;
+    std::atomic<bool> m_running{ false };
+    std::thread m_thread;
+
+    // 以下仅网络线程访问
+    std::vector<std::unique_ptr<Client>> m_clients;
+    std::vector<IntakeCommand> m_batch;
+    std::vector<std::string> m_errors;
+
+    // 统计
+    std::mutex m_statsMutex;
+    uint64_t m_batches = 0;
+    uint64_t m_commands = 0;
+    uint64_t m_rejected = 0;
+    std::vector<double> m_applyUs;          // 每批应用耗时，环形，最多 kApplySamples 个
+    size_t m_applyPos = 0;
+};
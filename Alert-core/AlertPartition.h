@@ -0,0 +1,149 @@
+﻿#pragma once
+#include "Crc32.h"
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <utility>
+#include <cstdint>
+
+// =========================================================
+// ===========   一致性哈希分区（多实例分摊预警）   ===========
+// =========================================================
+//
+// 分区键是 alert_order.symbol（合成合约按合成名称），键的哈希取 CRC32，与 MySQL 的 CRC32(symbol) 一致，
+// 因此归属可以直接写成 SQL 条件。每个实例在环上放 VirtualNodes 个虚拟节点（由 "实例名#序号" 算出位置），
+// 键归属顺时针方向第一个虚拟节点所在的实例；实例加入 / 离开时只有相邻区段的键换主。
+
+// 一个实例拥有的哈希区间集合（闭区间，已排序合并）
+struct PartitionSet
+{
+    bool all{ true };       // 未启用分区：拥有全部键
+    std::vector<std::pair<uint32_t, uint32_t>> ranges;
+
+    bool Contains(uint32_t h) const
+    {
+        if (all) return true;
+        auto it = std::upper_bound(ranges.begin(), ranges.end(), h,
+            [](uint32_t v, const std::pair<uint32_t, uint32_t>& r) { return v < r.first; });
+        return it != ranges.begin() && h <= (--it)->second;
+    }
+
+    bool Owns(const std::string& symbol) const
+    {
+        return all || Contains(Crc32(symbol.data(), symbol.size()));
+    }
+
+    // 拥有的哈希空间占比（0~1）
+    double Share() const
+    {
+        if (all) return 1.0;
+        double n = 0;
+        for (const auto& r : ranges)
+            n += (double)r.second - r.first + 1;
+        return n / 4294967296.0;
+    }
+
+    // 并集：交接期间同时拥有新旧区间
+    PartitionSet Union(const PartitionSet& o) const
+    {
+        if (all || o.all) return PartitionSet();
+        PartitionSet s;
+        s.all = false;
+        s.ranges = ranges;
+        s.ranges.insert(s.ranges.end(), o.ranges.begin(), o.ranges.end());
+        s.Normalize();
+        return s;
+    }
+
+    // 归属条件，用于 WHERE 子句，例如 "(CRC32(symbol) BETWEEN 0 AND 99 OR ...)"；拥有全部时返回空串
+    std::string SqlFilter(const char* column) const
+    {
+        if (all) return "";
+        if (ranges.empty()) return "1=0";
+        std::string sql = "(";
+        for (size_t i = 0; i < ranges.size(); ++i) {
+            if (i) sql += " OR ";
+            sql += std::string("CRC32(") + column + ") BETWEEN " + std::to_string(ranges[i].first) +
+                " AND " + std::to_string(ranges[i].second);
+        }
+        return sql + ")";
+    }
+
+    bool operator==(const PartitionSet& o) const { return all == o.all && ranges == o.ranges; }
+    bool operator!=(const PartitionSet& o) const { return !(*this == o); }
+
+    // 排序并合并重叠 / 相邻区间；覆盖整个哈希空间时化为 all
+    void Normalize()
+    {
+        std::sort(ranges.begin(), ranges.end());
+        std::vector<std::pair<uint32_t, uint32_t>> merged;
+        for (const auto& r : ranges) {
+            if (!merged.empty() && (uint64_t)r.first <= (uint64_t)merged.back().second + 1)
+                merged.back().second = std::max(merged.back().second, r.second);
+            else
+                merged.push_back(r);
+        }
+        ranges.swap(merged);
+        if (ranges.size() == 1 && ranges[0].first == 0 && ranges[0].second == 0xFFFFFFFFu) {
+            all = true;
+            ranges.clear();
+        }
+    }
+};
+
+class HashRing
+{
+public:
+    // 由成员列表计算 self 拥有的区间；self 不在列表中时视为已加入
+    static PartitionSet Build(std::vector<std::string> members, const std::string& self, int virtualNodes)
+    {
+        if (std::find(members.begin(), members.end(), self) == members.end())
+            members.push_back(self);
+        std::sort(members.begin(), members.end());
+        members.erase(std::unique(members.begin(), members.end()), members.end());
+        if (virtualNodes < 1) virtualNodes = 1;
+
+        // (环上位置, 是否 self)；同一位置按实例名排序后取第一个，各实例计算结果一致
+        std::vector<std::pair<uint32_t, size_t>> points;
+        for (size_t m = 0; m < members.size(); ++m) {
+            for (int v = 0; v < virtualNodes; ++v) {
+                std::string key = members[m] + "#" + std::to_string(v);
+                points.emplace_back(Mix(Crc32(key.data(), key.size())), m);
+            }
+        }
+        std::sort(points.begin(), points.end());
+
+        size_t selfIndex = std::find(members.begin(), members.end(), self) - members.begin();
+        PartitionSet s;
+        s.all = false;
+        for (size_t j = 0; j < points.size(); ++j) {
+            if (j > 0 && points[j].first == points[j - 1].first)
+                continue;   // 同位置的后续节点拿不到任何键
+            if (points[j].second != selfIndex)
+                continue;
+            uint32_t hi = points[j].first;
+            if (j > 0) {
+                s.ranges.emplace_back(points[j - 1].first + 1, hi);
+                continue;
+            }
+            // 第一个节点还拥有环尾绕回的部分
+            s.ranges.emplace_back(0, hi);
+            if (points.back().first != 0xFFFFFFFFu)
+                s.ranges.emplace_back(points.back().first + 1, 0xFFFFFFFFu);
+        }
+        s.Normalize();
+        return s;
+    }
+
+private:
+    // CRC32 是线性的，相近的节点名算出的位置会扎堆；再过一遍 murmur3 的 fmix32 打散（键的哈希不受影响）
+    static uint32_t Mix(uint32_t h)
+    {
+        h ^= h >> 16;
+        h *= 0x85EBCA6Bu;
+        h ^= h >> 13;
+        h *= 0xC2B2AE35u;
+        h ^= h >> 16;
+        return h;
+    }
+};
@@ -0,0 +1,559 @@
+﻿#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <cctype>
+#include <cmath>
+#include <memory>
+#include <functional>
+
+// =========================================================
+// ===========   预警规则表达式：解析 + 字节码执行   ===========
+// =========================================================
+//
+// alert_order.rule 列保存一条小型表达式，例如：
+//     last >= 4000 AND volume > 1e5
+//     ask - bid > 3 ticks
+// 规则在 ReloadAlertsFromDB 中编译一次为紧凑的栈式字节码，
+// 每个 tick 只需对归一化的 TickRecord 顺序执行，不做任何内存分配。
+// 技术指标（ma/vwap/stdev/chg）由 Indicators.h 提供，编译时绑定到具体指标对象。
+
+// ------------------------- 归一化行情记录 -------------------------
+// 所有字段统一为 double，缺失值（CTP 的 DBL_MAX）归一化为 NaN，
+// 与 NaN 的任何比较都为 false，因此缺失字段不会误触发。
+enum TickField : uint8_t
+{
+    TF_LAST = 0,
+    TF_BID,
+    TF_ASK,
+    TF_BID_VOLUME,
+    TF_ASK_VOLUME,
+    TF_VOLUME,
+    TF_TURNOVER,
+    TF_OPEN_INTEREST,
+    TF_OPEN,
+    TF_HIGH,
+    TF_LOW,
+    TF_PRE_CLOSE,
+    TF_PRE_SETTLEMENT,
+    TF_UPPER_LIMIT,
+    TF_LOWER_LIMIT,
+    TF_SPREAD,          // ask - bid
+    TF_PRICE_TICK,      // 最小变动价位（无元数据时为 1）
+    TF_MULTIPLIER,      // 合约乘数（无元数据时缺失）
+    TF_COUNT
+};
+
+// ------------------------- 定点价格 -------------------------
+// 价格 / 定点单位 四舍五入后的整数。价格类判断（上下限、迟滞带、规则中“价格字段 比较 常数”）
+// 只比较整数，不受二进制浮点的表示误差影响（如 3500.2 在 double 中并不精确）。
+static const int64_t kNoTicks = INT64_MIN;              // 缺失
+static const double kFallbackPriceUnit = 0.0001;        // 最小变动价位未知时的单位（CTP 各品种价位都是它的整数倍）
+static const double kSyntheticPriceUnit = 0.000001;     // 价差/比价合成价格的单位
+
+inline int64_t PriceToTicks(double price, double unit)
+{
+    return std::isnan(price) ? kNoTicks : std::llround(price / unit);
+}
+
+// 阈值换算：price >= x 等价于 ticks >= TicksAtLeast(x)，price <= x 等价于 ticks <= TicksAtMost(x)
+inline int64_t TicksAtLeast(double x, double unit)
+{
+    return (int64_t)std::ceil(x / unit - 1e-6);
+}
+
+inline int64_t TicksAtMost(double x, double unit)
+{
+    return (int64_t)std::floor(x / unit + 1e-6);
+}
+
+struct TickRecord
+{
+    double v[TF_COUNT];
+    double time;        // 交易所时间：当日秒数（含毫秒）
+    int64_t recvUs;     // 本地收到该 tick 的时间（steady_clock 微秒），用于统计检测延迟
+
+    // 定点价格，由 TickValidator 换算（合成合约由 EvaluateTick 计算）
+    int64_t lastTicks;
+    int64_t bidTicks;
+    int64_t askTicks;
+    double priceUnit;   // 定点单位
+};
+
+class Indicator;        // Indicators.h
+
+// 编译期解析指标引用：name/param 来自规则文本，成功时返回指标对象及其值地址
+struct IndicatorRef
+{
+    std::shared_ptr<Indicator> owner;
+    const double* value{ nullptr };
+};
+typedef std::function<bool(const std::string& name, int param, IndicatorRef& out)> IndicatorResolver;
+
+// ------------------------- 字节码 -------------------------
+enum RuleOpCode : uint8_t
+{
+    RULE_OP_CONST = 0,
+    RULE_OP_FIELD,
+    RULE_OP_REF,        // 读取指标当前值
+    RULE_OP_NEG,
+    RULE_OP_NOT,
+    RULE_OP_ADD,
+    RULE_OP_SUB,
+    RULE_OP_MUL,
+    RULE_OP_DIV,
+    RULE_OP_LT,
+    RULE_OP_LE,
+    RULE_OP_GT,
+    RULE_OP_GE,
+    RULE_OP_EQ,
+    RULE_OP_NE,
+    RULE_OP_AND,
+    RULE_OP_OR,
+    RULE_OP_PRICE_CMP   // last/bid/ask 与常数比较，按定点整数判断（编译时由 字段 常数 比较 合并而来）
+};
+
+struct RuleInstr
+{
+    uint8_t op;
+    uint8_t field;              // RULE_OP_FIELD / RULE_OP_PRICE_CMP 使用
+    uint8_t cmp;                // RULE_OP_PRICE_CMP 使用：比较运算（RULE_OP_LT … RULE_OP_NE）
+    uint16_t slot;              // RULE_OP_PRICE_CMP 使用：在定点边界数组中的下标
+    union {
+        double k;               // RULE_OP_CONST / RULE_OP_PRICE_CMP 使用
+        const double* ref;      // RULE_OP_REF 使用
+    };
+};
+
+// RULE_OP_PRICE_CMP 的常数按某个定点单位换算后的边界
+struct RulePriceBound
+{
+    int64_t atLeast;
+    int64_t atMost;
+};
+
+// 求值栈深度上限，编译期校验，执行期使用定长数组
+static const int kRuleMaxStack = 16;
+
+struct CompiledRule
+{
+    std::string text;
+    std::vector<RuleInstr> code;
+
+    // 规则引用的指标，持有引用保证 RULE_OP_REF 指针有效
+    std::vector<std::shared_ptr<Indicator>> inputs;
+
+    // RULE_OP_PRICE_CMP 的条数。不含指标的规则按文本在多个合约、多个线程间共享，
+    // 编译结果只读；定点边界与单位相关，由调用方按合约换算保存（见 AlertOrder::PrepareTicks）
+    uint16_t priceCmpCount{ 0 };
+
+    void PrepareTicks(double unit, std::vector<RulePriceBound>& bounds) const
+    {
+        bounds.resize(priceCmpCount);
+        for (const RuleInstr& in : code) {
+            if (in.op != RULE_OP_PRICE_CMP) continue;
+            bounds[in.slot].atLeast = TicksAtLeast(in.k, unit);
+            bounds[in.slot].atMost = TicksAtMost(in.k, unit);
+        }
+    }
+
+    // 每 tick 调用：AND/OR 不做短路，指令序列固定，执行成本稳定。
+    // bounds 为 PrepareTicks(t.priceUnit) 的结果，不含 RULE_OP_PRICE_CMP 时可为空
+    bool Eval(const TickRecord& t, const RulePriceBound* bounds) const
+    {
+        double st[kRuleMaxStack];
+        int sp = 0;
+        for (const RuleInstr& in : code)
+        {
+            switch (in.op)
+            {
+            case RULE_OP_CONST: st[sp++] = in.k; break;
+            case RULE_OP_FIELD: st[sp++] = t.v[in.field]; break;
+            case RULE_OP_REF:   st[sp++] = *in.ref; break;
+            case RULE_OP_NEG:   st[sp - 1] = -st[sp - 1]; break;
+            case RULE_OP_NOT:   st[sp - 1] = (st[sp - 1] != 0.0) ? 0.0 : 1.0; break;
+            case RULE_OP_ADD:   --sp; st[sp - 1] = st[sp - 1] + st[sp]; break;
+            case RULE_OP_SUB:   --sp; st[sp - 1] = st[sp - 1] - st[sp]; break;
+            case RULE_OP_MUL:   --sp; st[sp - 1] = st[sp - 1] * st[sp]; break;
+            case RULE_OP_DIV:   --sp; st[sp - 1] = st[sp - 1] / st[sp]; break;
+            case RULE_OP_LT:    --sp; st[sp - 1] = (st[sp - 1] <  st[sp]) ? 1.0 : 0.0; break;
+            case RULE_OP_LE:    --sp; st[sp - 1] = (st[sp - 1] <= st[sp]) ? 1.0 : 0.0; break;
+            case RULE_OP_GT:    --sp; st[sp - 1] = (st[sp - 1] >  st[sp]) ? 1.0 : 0.0; break;
+            case RULE_OP_GE:    --sp; st[sp - 1] = (st[sp - 1] >= st[sp]) ? 1.0 : 0.0; break;
+            case RULE_OP_EQ:    --sp; st[sp - 1] = (st[sp - 1] == st[sp]) ? 1.0 : 0.0; break;
+            case RULE_OP_NE:    --sp; st[sp - 1] = (st[sp - 1] != st[sp]) ? 1.0 : 0.0; break;
+            case RULE_OP_AND:   --sp; st[sp - 1] = (st[sp - 1] != 0.0 && st[sp] != 0.0) ? 1.0 : 0.0; break;
+            case RULE_OP_OR:    --sp; st[sp - 1] = (st[sp - 1] != 0.0 || st[sp] != 0.0) ? 1.0 : 0.0; break;
+            case RULE_OP_PRICE_CMP: st[sp++] = ComparePrice(t, in, bounds[in.slot]) ? 1.0 : 0.0; break;
+            }
+        }
+        // NaN 参与的结果视为不满足
+        return sp == 1 && st[0] != 0.0 && !std::isnan(st[0]);
+    }
+
+    static bool ComparePrice(const TickRecord& t, const RuleInstr& in, const RulePriceBound& b)
+    {
+        int64_t x = in.field == TF_LAST ? t.lastTicks : (in.field == TF_BID ? t.bidTicks : t.askTicks);
+        if (x == kNoTicks)
+            return in.cmp == RULE_OP_NE;        // 与 NaN 比较的结果一致
+        int64_t atLeast = b.atLeast;
+        int64_t atMost = b.atMost;
+        switch (in.cmp)
+        {
+        case RULE_OP_LT: return x < atLeast;
+        case RULE_OP_LE: return x <= atMost;
+        case RULE_OP_GT: return x > atMost;
+        case RULE_OP_GE: return x >= atLeast;
+        case RULE_OP_EQ: return atLeast == atMost && x == atMost;   // 常数不在定点网格上时永不相等
+        default:         return !(atLeast == atMost && x == atMost);
+        }
+    }
+};
+
+// ------------------------- 编译器（递归下降） -------------------------
+//
+// 语法：
+//   or    := and  ( (OR | "||") and )*
+//   and   := not  ( (AND | "&&") not )*
+//   not   := (NOT | "!") not | cmp
+//   cmp   := sum  ( ("<" | "<=" | ">" | ">=" | "==" | "=" | "!=") sum )?
+//   sum   := term ( ("+" | "-") term )*
+//   term  := unary ( ("*" | "/") unary )*
+//   unary := "-" unary | primary
+//   primary := number [ticks] | field | indicator [ "(" integer ")" ] | "(" or ")"
+class RuleCompiler
+{
+public:
+    // resolver 为空时规则中不允许出现指标
+    static bool Compile(const std::string& text, CompiledRule& out, std::string& error,
+        const IndicatorResolver& resolver = IndicatorResolver())
+    {
+        RuleCompiler c(text);
+        out.text = text;
+        out.code.clear();
+        out.inputs.clear();
+        out.priceCmpCount = 0;
+        c.m_out = &out;
+        c.m_resolver = &resolver;
+
+        bool ok = c.parseOr() && c.expectEnd();
+        if (ok && c.m_maxDepth > kRuleMaxStack) {
+            c.fail("expression too deep");
+            ok = false;
+        }
+        if (!ok) {
+            out.code.clear();
+            out.inputs.clear();
+            out.priceCmpCount = 0;
+            error = c.m_error;
+        }
+        return ok;
+    }
+
+private:
+    const std::string& m_src;
+    size_t m_pos{ 0 };
+    CompiledRule* m_out{ nullptr };
+    const IndicatorResolver* m_resolver{ nullptr };
+    int m_depth{ 0 };
+    int m_maxDepth{ 0 };
+    std::string m_error;
+
+    explicit RuleCompiler(const std::string& src) : m_src(src) {}
+
+    bool fail(const std::string& msg)
+    {
+        if (m_error.empty())
+            m_error = msg + " at position " + std::to_string(m_pos);
+        return false;
+    }
+
+    // 发射指令的同时跟踪栈深度
+    void emit(uint8_t op, uint8_t field = 0, double k = 0.0, const double* ref = nullptr, uint8_t cmp = 0)
+    {
+        RuleInstr in;
+        in.op = op;
+        in.field = field;
+        in.cmp = cmp;
+        in.slot = op == RULE_OP_PRICE_CMP ? m_out->priceCmpCount++ : 0;
+        if (op == RULE_OP_REF) in.ref = ref;
+        else in.k = k;
+        m_out->code.push_back(in);
+
+        if (op == RULE_OP_CONST || op == RULE_OP_FIELD || op == RULE_OP_REF || op == RULE_OP_PRICE_CMP) {
+            if (++m_depth > m_maxDepth) m_maxDepth = m_depth;
+        }
+        else if (op != RULE_OP_NEG && op != RULE_OP_NOT) {
+            --m_depth;
+        }
+    }
+
+    void skipSpace()
+    {
+        while (m_pos < m_src.size() && isspace((unsigned char)m_src[m_pos])) m_pos++;
+    }
+
+    bool acceptSymbol(const char* sym)
+    {
+        skipSpace();
+        size_t n = strlen(sym);
+        if (m_src.compare(m_pos, n, sym) == 0) {
+            m_pos += n;
+            return true;
+        }
+        return false;
+    }
+
+    // 关键字大小写不敏感，且要求是完整单词
+    bool acceptKeyword(const char* kw)
+    {
+        skipSpace();
+        size_t n = strlen(kw);
+        if (m_pos + n > m_src.size()) return false;
+        for (size_t i = 0; i < n; ++i) {
+            if (tolower((unsigned char)m_src[m_pos + i]) != kw[i]) return false;
+        }
+        if (m_pos + n < m_src.size()) {
+            char c = m_src[m_pos + n];
+            if (isalnum((unsigned char)c) || c == '_') return false;
+        }
+        m_pos += n;
+        return true;
+    }
+
+    bool expectEnd()
+    {
+        skipSpace();
+        if (m_pos != m_src.size()) return fail("unexpected token");
+        return true;
+    }
+
+    bool parseOr()
+    {
+        if (!parseAnd()) return false;
+        while (acceptKeyword("or") || acceptSymbol("||")) {
+            if (!parseAnd()) return false;
+            emit(RULE_OP_OR);
+        }
+        return true;
+    }
+
+    bool parseAnd()
+    {
+        if (!parseNot()) return false;
+        while (acceptKeyword("and") || acceptSymbol("&&")) {
+            if (!parseNot()) return false;
+            emit(RULE_OP_AND);
+        }
+        return true;
+    }
+
+    bool parseNot()
+    {
+        skipSpace();
+        if (acceptKeyword("not") ||
+            (m_pos + 1 < m_src.size() && m_src[m_pos] == '!' && m_src[m_pos + 1] != '=' && acceptSymbol("!"))) {
+            if (!parseNot()) return false;
+            emit(RULE_OP_NOT);
+            return true;
+        }
+        return parseCmp();
+    }
+
+    bool parseCmp()
+    {
+        if (!parseSum()) return false;
+
+        uint8_t op;
+        if (acceptSymbol("<=")) op = RULE_OP_LE;
+        else if (acceptSymbol(">=")) op = RULE_OP_GE;
+        else if (acceptSymbol("==")) op = RULE_OP_EQ;
+        else if (acceptSymbol("!=")) op = RULE_OP_NE;
+        else if (acceptSymbol("<")) op = RULE_OP_LT;
+        else if (acceptSymbol(">")) op = RULE_OP_GT;
+        else if (acceptSymbol("=")) op = RULE_OP_EQ;
+        else return true;
+
+        if (!parseSum()) return false;
+        if (!fusePriceCompare(op))
+            emit(op);
+        return true;
+    }
+
+    // 两侧恰好是 last/bid/ask 与一个常数时合并为 RULE_OP_PRICE_CMP（常数在左侧时交换比较方向）。
+    // 操作数的后缀码以 FIELD / CONST 结尾说明它就是单个字段或常数，复合表达式必以运算指令结尾。
+    bool fusePriceCompare(uint8_t op)
+    {
+        std::vector<RuleInstr>& code = m_out->code;
+        size_t n = code.size();
+        if (n < 2) return false;
+        const RuleInstr& a = code[n - 2];
+        const RuleInstr& b = code[n - 1];
+        uint8_t field;
+        double k;
+        if (a.op == RULE_OP_FIELD && b.op == RULE_OP_CONST) {
+            field = a.field;
+            k = b.k;
+        }
+        else if (a.op == RULE_OP_CONST && b.op == RULE_OP_FIELD) {
+            field = b.field;
+            k = a.k;
+            op = op == RULE_OP_LT ? (uint8_t)RULE_OP_GT : op == RULE_OP_GT ? (uint8_t)RULE_OP_LT :
+                op == RULE_OP_LE ? (uint8_t)RULE_OP_GE : op == RULE_OP_GE ? (uint8_t)RULE_OP_LE : op;
+        }
+        else return false;
+        if (field != TF_LAST && field != TF_BID && field != TF_ASK)
+            return false;
+        if (m_out->priceCmpCount == UINT16_MAX)
+            return false;
+
+        code.resize(n - 2);
+        m_depth -= 2;
+        emit(RULE_OP_PRICE_CMP, field, k, nullptr, op);
+        return true;
+    }
+
+    bool parseSum()
+    {
+        if (!parseTerm()) return false;
+        for (;;) {
+            if (acceptSymbol("+")) {
+                if (!parseTerm()) return false;
+                emit(RULE_OP_ADD);
+            }
+            else if (acceptSymbol("-")) {
+                if (!parseTerm()) return false;
+                emit(RULE_OP_SUB);
+            }
+            else return true;
+        }
+    }
+
+    bool parseTerm()
+    {
+        if (!parseUnary()) return false;
+        for (;;) {
+            if (acceptSymbol("*")) {
+                if (!parseUnary()) return false;
+                emit(RULE_OP_MUL);
+            }
+            else if (acceptSymbol("/")) {
+                if (!parseUnary()) return false;
+                emit(RULE_OP_DIV);
+            }
+            else return true;
+        }
+    }
+
+    bool parseUnary()
+    {
+        if (acceptSymbol("-")) {
+            if (!parseUnary()) return false;
+            emit(RULE_OP_NEG);
+            return true;
+        }
+        return parsePrimary();
+    }
+
+    bool parsePrimary()
+    {
+        skipSpace();
+        if (m_pos >= m_src.size()) return fail("unexpected end of rule");
+
+        char c = m_src[m_pos];
+        if (c == '(') {
+            m_pos++;
+            if (!parseOr()) return false;
+            if (!acceptSymbol(")")) return fail("expected ')'");
+            return true;
+        }
+
+        if (isdigit((unsigned char)c) || c == '.') {
+            const char* begin = m_src.c_str() + m_pos;
+            char* end = nullptr;
+            double k = strtod(begin, &end);
+            if (end == begin) return fail("bad number");
+            m_pos += (size_t)(end - begin);
+            emit(RULE_OP_CONST, 0, k);
+
+            // "3 ticks" = 3 * 最小变动价位
+            if (acceptKeyword("ticks") || acceptKeyword("tick")) {
+                emit(RULE_OP_FIELD, TF_PRICE_TICK);
+                emit(RULE_OP_MUL);
+            }
+            return true;
+        }
+
+        if (isalpha((unsigned char)c) || c == '_') {
+            size_t start = m_pos;
+            while (m_pos < m_src.size() &&
+                (isalnum((unsigned char)m_src[m_pos]) || m_src[m_pos] == '_')) m_pos++;
+            std::string name = m_src.substr(start, m_pos - start);
+            for (auto& ch : name) ch = (char)tolower((unsigned char)ch);
+
+            // 带参数的一定是指标，如 ma(20)
+            int param = 0;
+            bool hasParam = acceptSymbol("(");
+            if (hasParam) {
+                skipSpace();
+                const char* begin = m_src.c_str() + m_pos;
+                char* end = nullptr;
+                long v = strtol(begin, &end, 10);
+                if (end == begin) return fail("expected integer parameter");
+                m_pos += (size_t)(end - begin);
+                if (!acceptSymbol(")")) return fail("expected ')'");
+                param = (int)v;
+            }
+            else {
+                int field = lookupField(name);
+                if (field >= 0) {
+                    emit(RULE_OP_FIELD, (uint8_t)field);
+                    return true;
+                }
+            }
+
+            IndicatorRef ref;
+            if (!m_resolver || !*m_resolver || !(*m_resolver)(name, param, ref) || !ref.value) {
+                m_pos = start;
+                return fail("unknown field or indicator '" + name + "'");
+            }
+            m_out->inputs.push_back(ref.owner);
+            emit(RULE_OP_REF, 0, 0.0, ref.value);
+            return true;
+        }
+
+        return fail("unexpected character");
+    }
+
+    static int lookupField(const std::string& name)
+    {
+        static const struct { const char* name; TickField field; } kFields[] = {
+            { "last",          TF_LAST },
+            { "price",         TF_LAST },
+            { "bid",           TF_BID },
+            { "ask",           TF_ASK },
+            { "bid_vol",       TF_BID_VOLUME },
+            { "ask_vol",       TF_ASK_VOLUME },
+            { "volume",        TF_VOLUME },
+            { "turnover",      TF_TURNOVER },
+            { "oi",            TF_OPEN_INTEREST },
+            { "open_interest", TF_OPEN_INTEREST },
+            { "open",          TF_OPEN },
+            { "high",          TF_HIGH },
+            { "low",           TF_LOW },
+            { "pre_close",     TF_PRE_CLOSE },
+            { "pre_settle",    TF_PRE_SETTLEMENT },
+            { "upper_limit",   TF_UPPER_LIMIT },
+            { "lower_limit",   TF_LOWER_LIMIT },
+            { "spread",        TF_SPREAD },
+            { "tick",          TF_PRICE_TICK },
+            { "multiplier",    TF_MULTIPLIER },
+        };
+        for (const auto& f : kFields) {
+            if (name == f.name) return f.field;
+        }
+        return -1;
+    }
+};
@@ -0,0 +1,372 @@
+﻿#pragma once
+#include "Crc32.h"
+#include <Windows.h>
+#include <io.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <cstddef>
+
+// =========================================================
+// ===========   预警簿快照（内存映射，热启动）   ===========
+// =========================================================
+//
+// 进程定时、退出时把内存中的预警簿写成一个快照文件；启动时先映射快照恢复预警簿立即开始判断，
+// 再与 DB 做增量同步，不必先全表读取 alert_order。
+//
+// 文件布局（小端，定长记录，字符串统一放在末尾的字符串池）：
+//     SnapshotHeader                       64 字节，含版本号、记录数、水位、载荷与头部 CRC32
+//     SnapshotStr     × instrumentCount    合约注册表（下标即合约 id，恢复后 id 与分片归属不变）
+//     SnapshotSymbol  × symbolCount        预警索引：symbol -> 预警记录区间
+//     SnapshotAlertRec × alertCount        预警记录（按 symbol 分组连续存放）
+//     字符串池
+// 写入先落到 .tmp 并 fsync，再原子替换旧文件；读取时任何校验失败都放弃快照，回退到从 DB 全量加载。
+
+// 一条预警的持久字段 + 运行期状态（symbol 由所在分组给出）
+struct SnapshotAlert
+{
+    long orderId{ 0 };
+    std::string account;
+    double max_price{ 0.0 };
+    double min_price{ 0.0 };
+    std::string trigger_time;
+    int state{ 0 };
+    std::string rule;
+    int repeat_max{ 1 };
+    int cooldown_sec{ 0 };
+    double rearm_band{ 0.0 };
+    int priority{ 0 };
+
+    uint8_t arm_state{ 0 };
+    int fire_count{ 0 };
+    int64_t last_fire_wall_ms{ 0 };     // 上次触发的墙钟时间（steady 时钟跨进程无意义），0 为未触发
+};
+
+struct SnapshotBucket
+{
+    std::string symbol;
+    std::vector<SnapshotAlert> alerts;
+};
+
+struct AlertSnapshotData
+{
+    int64_t createdMs{ 0 };             // 写入时间（Unix 毫秒）
+    int64_t watermarkMs{ 0 };           // 增量同步水位（DB 时钟，Unix 毫秒），0 表示没有
+    std::vector<std::string> instruments;
+    std::vector<SnapshotBucket> buckets;
+};
+
+// ------------------------- 只读内存映射文件 -------------------------
+class MappedFile
+{
+public:
+    ~MappedFile() { Close(); }
+
+    bool Open(const std::string& path)
+    {
+        Close();
+        m_file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (m_file == INVALID_HANDLE_VALUE)
+            return false;
+
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(m_file, &size) || size.QuadPart <= 0) {
+            Close();
+            return false;
+        }
+        m_size = (size_t)size.QuadPart;
+
+        m_map = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!m_map) {
+            Close();
+            return false;
+        }
+        m_view = (const char*)MapViewOfFile(m_map, FILE_MAP_READ, 0, 0, 0);
+        if (!m_view) {
+            Close();
+            return false;
+        }
+        return true;
+    }
+
+    void Close()
+    {
+        if (m_view) UnmapViewOfFile(m_view);
+        if (m_map) CloseHandle(m_map);
+        if (m_file != INVALID_HANDLE_VALUE) CloseHandle(m_file);
+        m_view = nullptr;
+        m_map = nullptr;
+        m_file = INVALID_HANDLE_VALUE;
+        m_size = 0;
+    }
+
+    const char* Data() const { return m_view; }
+    size_t Size() const { return m_size; }
+
+private:
+    HANDLE m_file{ INVALID_HANDLE_VALUE };
+    HANDLE m_map{ nullptr };
+    const char* m_view{ nullptr };
+    size_t m_size{ 0 };
+};
+
+// ------------------------- 快照读写 -------------------------
+class AlertSnapshot
+{
+public:
+    static const uint32_t kVersion = 1;
+
+    static bool Write(const std::string& path, const AlertSnapshotData& data)
+    {
+        std::vector<SnapshotStr> instruments;
+        std::vector<SnapshotSymbol> symbols;
+        std::vector<SnapshotAlertRec> alerts;
+        std::string pool;
+
+        for (const auto& name : data.instruments)
+            instruments.push_back(AddStr(pool, name));
+        for (const auto& b : data.buckets) {
+            if (b.alerts.empty()) continue;
+            SnapshotSymbol sym;
+            sym.name = AddStr(pool, b.symbol);
+            sym.firstAlert = (uint32_t)alerts.size();
+            sym.alertCount = (uint32_t)b.alerts.size();
+            symbols.push_back(sym);
+            for (const auto& a : b.alerts) {
+                SnapshotAlertRec r;
+                memset(&r, 0, sizeof(r));
+                r.orderId = a.orderId;
+                r.maxPrice = a.max_price;
+                r.minPrice = a.min_price;
+                r.rearmBand = a.rearm_band;
+                r.lastFireWallMs = a.last_fire_wall_ms;
+                r.state = a.state;
+                r.repeatMax = a.repeat_max;
+                r.cooldownSec = a.cooldown_sec;
+                r.priority = a.priority;
+                r.fireCount = a.fire_count;
+                r.armState = a.arm_state;
+                r.account = AddStr(pool, a.account);
+                r.triggerTime = AddStr(pool, a.trigger_time);
+                r.rule = AddStr(pool, a.rule);
+                alerts.push_back(r);
+            }
+        }
+
+        std::string payload;
+        payload.reserve(instruments.size() * sizeof(SnapshotStr) + symbols.size() * sizeof(SnapshotSymbol)
+            + alerts.size() * sizeof(SnapshotAlertRec) + pool.size());
+        payload.append((const char*)instruments.data(), instruments.size() * sizeof(SnapshotStr));
+        payload.append((const char*)symbols.data(), symbols.size() * sizeof(SnapshotSymbol));
+        payload.append((const char*)alerts.data(), alerts.size() * sizeof(SnapshotAlertRec));
+        payload.append(pool);
+
+        SnapshotHeader h;
+        memset(&h, 0, sizeof(h));
+        memcpy(h.magic, kMagic, sizeof(h.magic));
+        h.version = kVersion;
+        h.headerBytes = sizeof(SnapshotHeader);
+        h.createdMs = data.createdMs;
+        h.watermarkMs = data.watermarkMs;
+        h.instrumentCount = (uint32_t)instruments.size();
+        h.symbolCount = (uint32_t)symbols.size();
+        h.alertCount = (uint32_t)alerts.size();
+        h.payloadBytes = payload.size();
+        h.payloadCrc = Crc32(payload.data(), payload.size());
+        h.headerCrc = Crc32(&h, offsetof(SnapshotHeader, headerCrc));
+
+        std::string tmpPath = path + ".tmp";
+        FILE* fp = nullptr;
+        if (fopen_s(&fp, tmpPath.c_str(), "wb") != 0 || !fp) {
+            printf("[SNAPSHOT ERROR] 无法创建 %s\n", tmpPath.c_str());
+            fflush(stdout);
+            return false;
+        }
+        bool ok = fwrite(&h, 1, sizeof(h), fp) == sizeof(h);
+        ok = ok && (payload.empty() || fwrite(payload.data(), 1, payload.size(), fp) == payload.size());
+        ok = ok && fflush(fp) == 0 && _commit(_fileno(fp)) == 0;
+        fclose(fp);
+        if (!ok || !MoveFileExA(tmpPath.c_str(), path.c_str(),
+            MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH)) {
+            printf("[SNAPSHOT ERROR] 写入 %s 失败\n", path.c_str());
+            fflush(stdout);
+            return false;
+        }
+        return true;
+    }
+
+    // 映射并校验快照；文件不存在或校验失败返回 false（原因写入 error）
+    static bool Read(const std::string& path, AlertSnapshotData& out, std::string& error)
+    {
+        MappedFile file;
+        if (!file.Open(path)) {
+            error = "文件不存在或无法映射";
+            return false;
+        }
+        const char* base = file.Data();
+        size_t size = file.Size();
+
+        SnapshotHeader h;
+        if (size < sizeof(h)) {
+            error = "文件过短";
+            return false;
+        }
+        memcpy(&h, base, sizeof(h));
+        if (memcmp(h.magic, kMagic, sizeof(h.magic)) != 0) {
+            error = "文件标识不符";
+            return false;
+        }
+        if (h.headerCrc != Crc32(&h, offsetof(SnapshotHeader, headerCrc))) {
+            error = "头部校验失败";
+            return false;
+        }
+        if (h.version != kVersion || h.headerBytes != sizeof(SnapshotHeader)) {
+            error = "版本 " + std::to_string(h.version) + " 与当前版本 " + std::to_string(kVersion) + " 不符";
+            return false;
+        }
+        if (h.payloadBytes != size - sizeof(h)) {
+            error = "文件长度与头部不符";
+            return false;
+        }
+
+        const char* payload = base + sizeof(h);
+        if (Crc32(payload, (size_t)h.payloadBytes) != h.payloadCrc) {
+            error = "载荷校验失败";
+            return false;
+        }
+
+        uint64_t fixedBytes = (uint64_t)h.instrumentCount * sizeof(SnapshotStr)
+            + (uint64_t)h.symbolCount * sizeof(SnapshotSymbol)
+            + (uint64_t)h.alertCount * sizeof(SnapshotAlertRec);
+        if (fixedBytes > h.payloadBytes) {
+            error = "记录区越界";
+            return false;
+        }
+        const char* instruments = payload;
+        const char* symbols = instruments + (size_t)h.instrumentCount * sizeof(SnapshotStr);
+        const char* alerts = symbols + (size_t)h.symbolCount * sizeof(SnapshotSymbol);
+        const char* pool = payload + fixedBytes;
+        uint64_t poolBytes = h.payloadBytes - fixedBytes;
+
+        auto str = [&](const SnapshotStr& s, std::string& v) {
+            if ((uint64_t)s.off + s.len > poolBytes) return false;
+            v.assign(pool + s.off, s.len);
+            return true;
+        };
+
+        out = AlertSnapshotData();
+        out.createdMs = h.createdMs;
+        out.watermarkMs = h.watermarkMs;
+        out.instruments.resize(h.instrumentCount);
+        for (uint32_t i = 0; i < h.instrumentCount; ++i) {
+            SnapshotStr s;
+            memcpy(&s, instruments + (size_t)i * sizeof(s), sizeof(s));
+            if (!str(s, out.instruments[i])) {
+                error = "字符串越界";
+                return false;
+            }
+        }
+
+        out.buckets.resize(h.symbolCount);
+        for (uint32_t i = 0; i < h.symbolCount; ++i) {
+            SnapshotSymbol sym;
+            memcpy(&sym, symbols + (size_t)i * sizeof(sym), sizeof(sym));
+            SnapshotBucket& b = out.buckets[i];
+            if (!str(sym.name, b.symbol) || (uint64_t)sym.firstAlert + sym.alertCount > h.alertCount) {
+                error = "索引越界";
+                return false;
+            }
+
+            b.alerts.resize(sym.alertCount);
+            for (uint32_t k = 0; k < sym.alertCount; ++k) {
+                SnapshotAlertRec r;
+                memcpy(&r, alerts + (size_t)(sym.firstAlert + k) * sizeof(r), sizeof(r));
+                SnapshotAlert& a = b.alerts[k];
+                a.orderId = (long)r.orderId;
+                a.max_price = r.maxPrice;
+                a.min_price = r.minPrice;
+                a.rearm_band = r.rearmBand;
+                a.last_fire_wall_ms = r.lastFireWallMs;
+                a.state = r.state;
+                a.repeat_max = r.repeatMax;
+                a.cooldown_sec = r.cooldownSec;
+                a.priority = r.priority;
+                a.fire_count = r.fireCount;
+                a.arm_state = r.armState;
+                if (!str(r.account, a.account) || !str(r.triggerTime, a.trigger_time) || !str(r.rule, a.rule)) {
+                    error = "字符串越界";
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+private:
+    static constexpr const char* kMagic = "ALRTSNAP";
+
+    struct SnapshotHeader
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t headerBytes;
+        int64_t createdMs;
+        int64_t watermarkMs;
+        uint32_t instrumentCount;
+        uint32_t symbolCount;
+        uint32_t alertCount;
+        uint32_t reserved;
+        uint64_t payloadBytes;
+        uint32_t payloadCrc;
+        uint32_t headerCrc;         // 覆盖本字段之前的所有头部字节
+    };
+
+    struct SnapshotStr
+    {
+        uint32_t off;               // 在字符串池中的偏移
+        uint32_t len;
+    };
+
+    struct SnapshotSymbol
+    {
+        SnapshotStr name;
+        uint32_t firstAlert;
+        uint32_t alertCount;
+    };
+
+    struct SnapshotAlertRec
+    {
+        int64_t orderId;
+        double maxPrice;
+        double minPrice;
+        double rearmBand;
+        int64_t lastFireWallMs;
+        int32_t state;
+        int32_t repeatMax;
+        int32_t cooldownSec;
+        int32_t priority;
+        int32_t fireCount;
+        uint8_t armState;
+        uint8_t pad[3];
+        SnapshotStr account;
+        SnapshotStr triggerTime;
+        SnapshotStr rule;
+    };
+
+    static_assert(sizeof(SnapshotHeader) == 64, "snapshot header layout");
+    static_assert(sizeof(SnapshotStr) == 8, "snapshot string layout");
+    static_assert(sizeof(SnapshotSymbol) == 16, "snapshot symbol layout");
+    static_assert(sizeof(SnapshotAlertRec) == 88, "snapshot alert layout");
+
+    static SnapshotStr AddStr(std::string& pool, const std::string& s)
+    {
+        SnapshotStr r;
+        r.off = (uint32_t)pool.size();
+        r.len = (uint32_t)s.size();
+        pool.append(s);
+        return r;
+    }
+};
@@ -0,0 +1,944 @@
+// BinlogClient.cpp
+#include "BinlogClient.h"
+#include "Crc32.h"
+#include "Sha.h"
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#include <stdio.h>
+#include <cstring>
+#include <ctime>
+#include <chrono>
+#include <algorithm>
+
+#pragma comment(lib, "ws2_32.lib")
+
+// ͻλ
+static const uint32_t kClientLongPassword = 0x00000001;
+static const uint32_t kClientLongFlag = 0x00000004;
+static const uint32_t kClientProtocol41 = 0x00000200;
+static const uint32_t kClientTransactions = 0x00002000;
+static const uint32_t kClientSecureConnection = 0x00008000;
+static const uint32_t kClientPluginAuth = 0x00080000;
+
+// binlog ¼
+enum {
+    EV_QUERY = 2, EV_ROTATE = 4, EV_FORMAT_DESCRIPTION = 15, EV_XID = 16, EV_TABLE_MAP = 19,
+    EV_WRITE_ROWS_V1 = 23, EV_UPDATE_ROWS_V1 = 24, EV_DELETE_ROWS_V1 = 25, EV_HEARTBEAT = 27,
+    EV_WRITE_ROWS = 30, EV_UPDATE_ROWS = 31, EV_DELETE_ROWS = 32
+};
+
+// 
+enum {
+    COL_TINY = 1, COL_SHORT = 2, COL_LONG = 3, COL_FLOAT = 4, COL_DOUBLE = 5, COL_NULL = 6,
+    COL_TIMESTAMP = 7, COL_LONGLONG = 8, COL_INT24 = 9, COL_DATE = 10, COL_TIME = 11, COL_DATETIME = 12,
+    COL_YEAR = 13, COL_VARCHAR = 15, COL_BIT = 16, COL_TIMESTAMP2 = 17, COL_DATETIME2 = 18, COL_TIME2 = 19,
+    COL_JSON = 245, COL_NEWDECIMAL = 246, COL_ENUM = 247, COL_SET = 248, COL_TINY_BLOB = 249,
+    COL_MEDIUM_BLOB = 250, COL_LONG_BLOB = 251, COL_BLOB = 252, COL_VAR_STRING = 253, COL_STRING = 254,
+    COL_GEOMETRY = 255
+};
+
+static const size_t kEventHeader = 19;
+
+static uint64_t ReadLE(const unsigned char* p, int n)
+{
+    uint64_t v = 0;
+    for (int i = n - 1; i >= 0; --i) v = (v << 8) | p[i];
+    return v;
+}
+
+static uint64_t ReadBE(const unsigned char* p, int n)
+{
+    uint64_t v = 0;
+    for (int i = 0; i < n; ++i) v = (v << 8) | p[i];
+    return v;
+}
+
+// ȱԽʱ false
+static bool ReadLenEnc(const unsigned char*& p, const unsigned char* end, uint64_t& v)
+{
+    if (p >= end) return false;
+    int n = *p < 0xFB ? 0 : (*p == 0xFC ? 2 : (*p == 0xFD ? 3 : (*p == 0xFE ? 8 : -1)));
+    if (n < 0 || end - p < 1 + n) return false;
+    v = n == 0 ? *p : ReadLE(p + 1, n);
+    p += 1 + n;
+    return true;
+}
+
+static std::string XorBytes(const std::string& a, const std::string& b)
+{
+    std::string out(a);
+    for (size_t i = 0; i < out.size(); ++i) out[i] ^= b[i % b.size()];
+    return out;
+}
+
+static std::string AuthResponse(const std::string& plugin, const std::string& password, const std::string& scramble)
+{
+    if (password.empty())
+        return std::string();
+    if (plugin == "caching_sha2_password") {
+        std::string h1 = Sha256(password);
+        return XorBytes(h1, Sha256(Sha256(h1) + scramble));
+    }
+    // mysql_native_password
+    std::string h1 = Sha1(password);
+    return XorBytes(h1, Sha1(scramble + Sha1(h1)));
+}
+
+static std::string QuoteSql(const std::string& s)
+{
+    std::string out = "'";
+    for (char c : s) {
+        if (c == '\'' || c == '\\') out += '\\';
+        out += c;
+    }
+    return out + "'";
+}
+
+// ------------------------- һ MySQL Э -------------------------
+class MySqlWire
+{
+public:
+    ~MySqlWire() { Close(); }
+
+    SOCKET Socket() const { return m_s; }
+
+    bool Connect(const BinlogClient::Options& o, std::string& error)
+    {
+        WSADATA wsaData;
+        WSAStartup(MAKEWORD(2, 2), &wsaData);
+
+        addrinfo hints = {};
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        addrinfo* res = nullptr;
+        if (getaddrinfo(o.host.c_str(), std::to_string(o.port).c_str(), &hints, &res) != 0 || !res) {
+            error = "޷ " + o.host;
+            return false;
+        }
+        m_s = socket(res->ai_family, res->ai_socktype, res->ai_protocol);
+        bool ok = m_s != INVALID_SOCKET && connect(m_s, res->ai_addr, (int)res->ai_addrlen) == 0;
+        freeaddrinfo(res);
+        if (!ok) {
+            error = "޷ " + o.host + ":" + std::to_string(o.port);
+            return false;
+        }
+        SetReadTimeout(10000);
+
+        // ְ HandshakeV10
+        std::string hs;
+        if (!ReadPacket(hs)) { error = "ȡְʧ"; return false; }
+        if (!hs.empty() && (unsigned char)hs[0] == 0xFF) { error = ErrorText(hs); return false; }
+        const unsigned char* p = (const unsigned char*)hs.data();
+        const unsigned char* end = p + hs.size();
+        if (hs.empty() || *p != 10) { error = "ֵ֧Э汾"; return false; }
+        p++;
+        while (p < end && *p) p++;                      // server version
+        if (end - p < 1 + 4 + 8 + 1 + 2) { error = "ְ"; return false; }
+        p += 1 + 4;                                     // NUL, thread id
+        std::string scramble((const char*)p, 8);
+        p += 8 + 1;                                     // part 1, filler
+        uint32_t caps = (uint32_t)ReadLE(p, 2);
+        p += 2;
+        std::string plugin = "mysql_native_password";
+        if (end - p >= 1 + 2 + 2 + 1 + 10) {
+            p += 1 + 2;                                 // charset, status
+            caps |= (uint32_t)ReadLE(p, 2) << 16;
+            p += 2;
+            int authLen = *p;
+            p += 1 + 10;
+            int part2 = std::max(13, authLen - 8);
+            if (end - p >= part2) {
+                scramble.append((const char*)p, part2 - 1);   // ĩβ NUL
+                p += part2;
+            }
+            if ((caps & kClientPluginAuth) && p < end)
+                plugin.assign((const char*)p, strnlen((const char*)p, end - p));
+        }
+        if (!(caps & kClientProtocol41)) { error = "֧ 4.1 Э"; return false; }
+
+        // HandshakeResponse41
+        uint32_t clientCaps = kClientLongPassword | kClientLongFlag | kClientProtocol41 |
+            kClientTransactions | kClientSecureConnection | kClientPluginAuth;
+        std::string auth = AuthResponse(plugin, o.password, scramble);
+        std::string resp;
+        for (int i = 0; i < 4; ++i) resp += (char)(clientCaps >> (i * 8));
+        uint32_t maxPacket = 1 << 24;
+        for (int i = 0; i < 4; ++i) resp += (char)(maxPacket >> (i * 8));
+        resp += (char)45;                               // utf8mb4_general_ci
+        resp.append(23, '\0');
+        resp += o.user;
+        resp += '\0';
+        resp += (char)auth.size();
+        resp += auth;
+        resp += plugin;
+        resp += '\0';
+        if (!WritePacket(resp)) { error = "֤ʧ"; return false; }
+
+        for (;;) {
+            std::string pkt;
+            if (!ReadPacket(pkt) || pkt.empty()) { error = "֤ӶϿ"; return false; }
+            unsigned char head = (unsigned char)pkt[0];
+            if (head == 0x00)
+                return true;
+            if (head == 0xFF) { error = ErrorText(pkt); return false; }
+            if (head == 0xFE) {
+                // л֤ NUL  scramble
+                size_t nul = pkt.find('\0', 1);
+                plugin = pkt.substr(1, nul == std::string::npos ? std::string::npos : nul - 1);
+                scramble = nul == std::string::npos ? std::string() : pkt.substr(nul + 1);
+                if (!scramble.empty() && scramble.back() == '\0') scramble.pop_back();
+                if (plugin != "mysql_native_password" && plugin != "caching_sha2_password") {
+                    error = "ֵ֧֤ " + plugin;
+                    return false;
+                }
+                if (!WritePacket(AuthResponse(plugin, o.password, scramble))) { error = "֤ʧ"; return false; }
+                continue;
+            }
+            if (head == 0x01 && pkt.size() >= 2) {
+                if (pkt[1] == 0x03) continue;           // caching_sha2 ֤ɹ OK
+                error = "caching_sha2_password Ҫ֤δ˺ţͨ DB ӳɹ¼һκԼɣ";
+                return false;
+            }
+            error = "޷ʶ֤Ӧ";
+            return false;
+        }
+    }
+
+    // ִһ䣻rows ǿʱռNULL մ
+    bool Query(const std::string& sql, std::vector<std::vector<std::string>>* rows, std::string& error)
+    {
+        m_seq = 0;
+        if (!WritePacket(std::string(1, (char)0x03) + sql)) { error = "Ͳѯʧ"; return false; }
+
+        std::string pkt;
+        if (!ReadPacket(pkt) || pkt.empty()) { error = "ȡѯʧ"; return false; }
+        if ((unsigned char)pkt[0] == 0x00) return true;
+        if ((unsigned char)pkt[0] == 0xFF) { error = ErrorText(pkt); return false; }
+
+        const unsigned char* p = (const unsigned char*)pkt.data();
+        uint64_t columns = 0;
+        if (!ReadLenEnc(p, p + pkt.size(), columns)) { error = "ʽ"; return false; }
+        for (uint64_t i = 0; i <= columns; ++i)        // ж + EOF
+            if (!ReadPacket(pkt)) { error = "ȡжʧ"; return false; }
+
+        for (;;) {
+            if (!ReadPacket(pkt) || pkt.empty()) { error = "ȡʧ"; return false; }
+            unsigned char head = (unsigned char)pkt[0];
+            if (head == 0xFE && pkt.size() < 9) return true;
+            if (head == 0xFF) { error = ErrorText(pkt); return false; }
+            if (!rows) continue;
+
+            std::vector<std::string> row;
+            const unsigned char* q = (const unsigned char*)pkt.data();
+            const unsigned char* end = q + pkt.size();
+            for (uint64_t i = 0; i < columns; ++i) {
+                if (q < end && *q == 0xFB) { row.emplace_back(); q++; continue; }
+                uint64_t len = 0;
+                if (!ReadLenEnc(q, end, len) || (uint64_t)(end - q) < len) { error = "иʽ"; return false; }
+                row.emplace_back((const char*)q, (size_t)len);
+                q += len;
+            }
+            rows->push_back(std::move(row));
+        }
+    }
+
+    bool Command(const std::string& payload)
+    {
+        m_seq = 0;
+        return WritePacket(payload);
+    }
+
+    // ȡһϲ 16MB Ƭ
+    bool ReadPacket(std::string& out)
+    {
+        out.clear();
+        for (;;) {
+            unsigned char h[4];
+            if (!RecvAll((char*)h, 4)) return false;
+            size_t len = (size_t)ReadLE(h, 3);
+            m_seq = (uint8_t)(h[3] + 1);
+            size_t off = out.size();
+            out.resize(off + len);
+            if (len > 0 && !RecvAll(&out[off], len)) return false;
+            if (len < 0xFFFFFF) return true;
+        }
+    }
+
+    bool WritePacket(const std::string& payload)
+    {
+        std::string pkt;
+        pkt += (char)(payload.size() & 0xFF);
+        pkt += (char)((payload.size() >> 8) & 0xFF);
+        pkt += (char)((payload.size() >> 16) & 0xFF);
+        pkt += (char)m_seq++;
+        pkt += payload;
+        size_t sent = 0;
+        while (sent < pkt.size()) {
+            int n = send(m_s, pkt.data() + sent, (int)(pkt.size() - sent), 0);
+            if (n <= 0) return false;
+            sent += n;
+        }
+        return true;
+    }
+
+    void SetReadTimeout(int ms)
+    {
+#ifdef _WIN32
+        DWORD tv = (DWORD)ms;
+#else
+        timeval tv = { ms / 1000, (ms % 1000) * 1000 };
+#endif
+        setsockopt(m_s, SOL_SOCKET, SO_RCVTIMEO, (const char*)&tv, sizeof(tv));
+    }
+
+    void Close()
+    {
+        if (m_s != INVALID_SOCKET) closesocket(m_s);
+        m_s = INVALID_SOCKET;
+    }
+
+    static std::string ErrorText(const std::string& pkt)
+    {
+        if (pkt.size() < 3) return "δ֪";
+        int code = (int)ReadLE((const unsigned char*)pkt.data() + 1, 2);
+        size_t msg = pkt.size() > 9 && pkt[3] == '#' ? 9 : 3;
+        return "MySQL  " + std::to_string(code) + ": " + pkt.substr(msg);
+    }
+
+private:
+    bool RecvAll(char* buf, size_t len)
+    {
+        size_t got = 0;
+        while (got < len) {
+            int n = recv(m_s, buf + got, (int)(len - got), 0);
+            if (n <= 0) return false;
+            got += n;
+        }
+        return true;
+    }
+
+    SOCKET m_s = INVALID_SOCKET;
+    uint8_t m_seq = 0;
+};
+
+// ------------------------- ֵ -------------------------
+static const int kDigitBytes[10] = { 0, 1, 1, 2, 2, 3, 3, 4, 4, 4 };
+
+// NEWDECIMAL 9 λһĶƸʽֽp Ϊʱֻ㳤ȣ
+static size_t DecodeDecimal(const unsigned char* p, int precision, int scale, std::string* out)
+{
+    int intg = precision - scale;
+    int intg0 = intg / 9, intg0x = intg % 9, frac0 = scale / 9, frac0x = scale % 9;
+    size_t size = intg0 * 4 + kDigitBytes[intg0x] + frac0 * 4 + kDigitBytes[frac0x];
+    if (!p || !out) return size;
+
+    std::string b((const char*)p, size);
+    bool negative = !((unsigned char)b[0] & 0x80);
+    b[0] ^= (char)0x80;
+    if (negative)
+        for (auto& c : b) c = (char)~c;
+
+    const unsigned char* q = (const unsigned char*)b.data();
+    std::string intPart, fracPart;
+    char buf[16];
+    if (intg0x) {
+        snprintf(buf, sizeof(buf), "%llu", (unsigned long long)ReadBE(q, kDigitBytes[intg0x]));
+        intPart += buf;
+        q += kDigitBytes[intg0x];
+    }
+    for (int i = 0; i < intg0; ++i, q += 4) {
+        snprintf(buf, sizeof(buf), intPart.empty() ? "%u" : "%09u", (unsigned)ReadBE(q, 4));
+        intPart += buf;
+    }
+    for (int i = 0; i < frac0; ++i, q += 4) {
+        snprintf(buf, sizeof(buf), "%09u", (unsigned)ReadBE(q, 4));
+        fracPart += buf;
+    }
+    if (frac0x) {
+        snprintf(buf, sizeof(buf), "%0*u", frac0x, (unsigned)ReadBE(q, kDigitBytes[frac0x]));
+        fracPart += buf;
+    }
+
+    size_t nz = intPart.find_first_not_of('0');
+    intPart = nz == std::string::npos ? "0" : intPart.substr(nz);
+    *out = (negative ? "-" : "") + intPart + (fracPart.empty() ? "" : "." + fracPart);
+    return size;
+}
+
+static std::string FormatFraction(const unsigned char* p, int fsp)
+{
+    if (fsp <= 0) return std::string();
+    int bytes = (fsp + 1) / 2;
+    uint64_t v = ReadBE(p, bytes);
+    uint64_t micros = bytes == 1 ? v * 10000 : (bytes == 2 ? v * 100 : v);
+    char buf[16];
+    snprintf(buf, sizeof(buf), ".%06llu", (unsigned long long)micros);
+    return std::string(buf, 1 + fsp);
+}
+
+// һ NULL ֵΪı false ʾͲֻ֧Խ
+static bool DecodeValue(uint8_t type, uint16_t meta, const unsigned char*& p, const unsigned char* end, std::string& out)
+{
+    char buf[64];
+    auto need = [&](size_t n) { return (size_t)(end - p) >= n; };
+
+    // STRING ԪʵͣCHAR / ENUM / SET볤
+    if (type == COL_STRING && meta >= 256) {
+        uint8_t real = (uint8_t)(meta >> 8);
+        uint32_t len = meta & 0xFF;
+        if ((real & 0x30) != 0x30) {
+            len |= ((real & 0x30) ^ 0x30) << 4;
+            real |= 0x30;
+        }
+        if (real == COL_ENUM || real == COL_SET) {
+            if (!need(len)) return false;
+            out = std::to_string(ReadLE(p, (int)len));
+            p += len;
+            return true;
+        }
+        meta = (uint16_t)len;
+    }
+
+    switch (type)
+    {
+    case COL_TINY: if (!need(1)) return false; out = std::to_string((int8_t)p[0]); p += 1; return true;
+    case COL_SHORT: if (!need(2)) return false; out = std::to_string((int16_t)ReadLE(p, 2)); p += 2; return true;
+    case COL_INT24: {
+        if (!need(3)) return false;
+        int32_t v = (int32_t)ReadLE(p, 3);
+        if (v & 0x800000) v |= (int32_t)0xFF000000;
+        out = std::to_string(v);
+        p += 3;
+        return true;
+    }
+    case COL_LONG: if (!need(4)) return false; out = std::to_string((int32_t)ReadLE(p, 4)); p += 4; return true;
+    case COL_LONGLONG: if (!need(8)) return false; out = std::to_string((long long)ReadLE(p, 8)); p += 8; return true;
+    case COL_YEAR: if (!need(1)) return false; out = p[0] ? std::to_string(1900 + p[0]) : "0000"; p += 1; return true;
+    case COL_FLOAT: {
+        if (!need(4)) return false;
+        float f;
+        memcpy(&f, p, 4);
+        snprintf(buf, sizeof(buf), "%.9g", f);
+        out = buf;
+        p += 4;
+        return true;
+    }
+    case COL_DOUBLE: {
+        if (!need(8)) return false;
+        double d;
+        memcpy(&d, p, 8);
+        snprintf(buf, sizeof(buf), "%.17g", d);
+        out = buf;
+        p += 8;
+        return true;
+    }
+    case COL_NEWDECIMAL: {
+        int precision = meta >> 8, scale = meta & 0xFF;
+        size_t size = DecodeDecimal(nullptr, precision, scale, nullptr);
+        if (precision <= 0 || scale > precision || !need(size)) return false;
+        DecodeDecimal(p, precision, scale, &out);
+        p += size;
+        return true;
+    }
+    case COL_VARCHAR:
+    case COL_VAR_STRING:
+    case COL_STRING: {
+        int lenBytes = meta < 256 ? 1 : 2;
+        if (!need(lenBytes)) return false;
+        size_t len = (size_t)ReadLE(p, lenBytes);
+        p += lenBytes;
+        if (!need(len)) return false;
+        out.assign((const char*)p, len);
+        p += len;
+        return true;
+    }
+    case COL_TINY_BLOB: case COL_MEDIUM_BLOB: case COL_LONG_BLOB: case COL_BLOB:
+    case COL_GEOMETRY: case COL_JSON: {
+        int lenBytes = meta;
+        if (lenBytes < 1 || lenBytes > 4 || !need(lenBytes)) return false;
+        size_t len = (size_t)ReadLE(p, lenBytes);
+        p += lenBytes;
+        if (!need(len)) return false;
+        out.assign((const char*)p, len);               // JSON ΪڲƸʽﲻչ
+        p += len;
+        return true;
+    }
+    case COL_BIT: {
+        size_t bytes = (meta & 0xFF) + ((meta >> 8) ? 1 : 0);
+        if (!need(bytes) || bytes > 8) return false;
+        out = std::to_string(ReadBE(p, (int)bytes));
+        p += bytes;
+        return true;
+    }
+    case COL_DATE: {
+        if (!need(3)) return false;
+        uint32_t v = (uint32_t)ReadLE(p, 3);
+        snprintf(buf, sizeof(buf), "%04u-%02u-%02u", v >> 9, (v >> 5) & 15, v & 31);
+        out = buf;
+        p += 3;
+        return true;
+    }
+    case COL_DATETIME: {
+        if (!need(8)) return false;
+        uint64_t v = ReadLE(p, 8);
+        unsigned d = (unsigned)(v / 1000000), t = (unsigned)(v % 1000000);
+        snprintf(buf, sizeof(buf), "%04u-%02u-%02u %02u:%02u:%02u",
+            d / 10000, d / 100 % 100, d % 100, t / 10000, t / 100 % 100, t % 100);
+        out = buf;
+        p += 8;
+        return true;
+    }
+    case COL_DATETIME2: {
+        size_t fracBytes = (meta + 1) / 2;
+        if (!need(5 + fracBytes)) return false;
+        uint64_t v = ReadBE(p, 5) - 0x8000000000ULL;
+        uint64_t ymd = v >> 17, ym = ymd >> 5, hms = v & 0x1FFFF;
+        snprintf(buf, sizeof(buf), "%04u-%02u-%02u %02u:%02u:%02u",
+            (unsigned)(ym / 13), (unsigned)(ym % 13), (unsigned)(ymd & 31),
+            (unsigned)(hms >> 12), (unsigned)((hms >> 6) & 63), (unsigned)(hms & 63));
+        out = buf + FormatFraction(p + 5, meta);
+        p += 5 + fracBytes;
+        return true;
+    }
+    case COL_TIMESTAMP:
+    case COL_TIMESTAMP2: {
+        //  UTC 洢ʱʾĬϻỰʱ SELECT Ľһ£
+        size_t fracBytes = type == COL_TIMESTAMP2 ? (meta + 1) / 2 : 0;
+        if (!need(4 + fracBytes)) return false;
+        time_t t = type == COL_TIMESTAMP2 ? (time_t)ReadBE(p, 4) : (time_t)ReadLE(p, 4);
+        if (t == 0) {
+            out = "0000-00-00 00:00:00";
+        }
+        else {
+            tm local = {};
+            localtime_s(&local, &t);
+            strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S", &local);
+            out = buf;
+        }
+        if (type == COL_TIMESTAMP2)
+            out += FormatFraction(p + 4, meta);
+        p += 4 + fracBytes;
+        return true;
+    }
+    case COL_TIME: {
+        if (!need(3)) return false;
+        uint32_t v = (uint32_t)ReadLE(p, 3);
+        snprintf(buf, sizeof(buf), "%02u:%02u:%02u", v / 10000, v / 100 % 100, v % 100);
+        out = buf;
+        p += 3;
+        return true;
+    }
+    case COL_TIME2: {
+        size_t fracBytes = (meta + 1) / 2;
+        if (!need(3 + fracBytes)) return false;
+        int64_t v = (int64_t)ReadBE(p, 3) - 0x800000;
+        bool negative = v < 0;
+        if (negative) v = -v;
+        snprintf(buf, sizeof(buf), "%s%02u:%02u:%02u", negative ? "-" : "",
+            (unsigned)((v >> 12) & 0x3FF), (unsigned)((v >> 6) & 63), (unsigned)(v & 63));
+        out = buf;
+        p += 3 + fracBytes;
+        return true;
+    }
+    default:
+        return false;
+    }
+}
+
+// ------------------------- BinlogClient -------------------------
+BinlogClient::~BinlogClient()
+{
+    Stop();
+}
+
+void BinlogClient::Start(const Options& options, RowsHandler onRows, StartHandler onStart)
+{
+    if (m_running.load() || options.serverId == 0) return;
+    m_opt = options;
+    if (m_opt.heartbeatSec < 1) m_opt.heartbeatSec = 1;
+    m_onRows = std::move(onRows);
+    m_onStart = std::move(onStart);
+    m_running = true;
+    m_thread = std::thread([this]() { run(); });
+}
+
+void BinlogClient::Stop()
+{
+    if (!m_running.exchange(false)) return;
+    SOCKET s = m_socket.exchange(INVALID_SOCKET);
+    if (s != INVALID_SOCKET)
+        shutdown(s, SD_BOTH);
+    if (m_thread.joinable())
+        m_thread.join();
+}
+
+void BinlogClient::run()
+{
+    int attempt = 0;
+    while (m_running.load())
+    {
+        std::string error;
+        auto started = std::chrono::steady_clock::now();
+        stream(error);
+        m_streaming = false;
+        m_socket = INVALID_SOCKET;
+        if (!m_running.load())
+            break;
+
+        // չһʱָ˱ܴͷʼ
+        if (std::chrono::steady_clock::now() - started > std::chrono::seconds(60))
+            attempt = 0;
+        int delaySec = std::min(60, 1 << std::min(attempt, 6));
+        attempt++;
+        printf("[BINLOG] жϣ%s%d ڼΪѯ DB\n", error.c_str(), delaySec);
+        fflush(stdout);
+        for (int i = 0; i < delaySec * 10 && m_running.load(); ++i)
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+}
+
+// Ӳ¼ֱֹͣʱ error ԭ
+bool BinlogClient::stream(std::string& error)
+{
+    MySqlWire wire;
+    if (!wire.Connect(m_opt, error))
+        return false;
+    m_socket = wire.Socket();
+    if (!m_running.load()) { error = "ֹͣ"; return false; }
+
+    std::vector<std::vector<std::string>> rows;
+    if (!wire.Query("SELECT @@GLOBAL.binlog_format, @@GLOBAL.binlog_row_image, @@GLOBAL.binlog_checksum", &rows, error))
+        return false;
+    if (rows.empty() || rows[0].size() < 3) { error = "޷ȡ binlog "; return false; }
+    if (rows[0][0] != "ROW" || rows[0][1] != "FULL") {
+        error = "Ҫ binlog_format=ROW  binlog_row_image=FULLǰ " + rows[0][0] + " / " + rows[0][1] + "";
+        return false;
+    }
+    m_checksum = rows[0][2] == "CRC32";
+
+    if (!wire.Query("SET @master_binlog_checksum = @@GLOBAL.binlog_checksum", nullptr, error) ||
+        !wire.Query("SET @master_heartbeat_period = " + std::to_string((long long)m_opt.heartbeatSec * 1000000000LL), nullptr, error))
+        return false;
+    if (!loadColumns(error))
+        return false;
+
+    // ûλʱӷǰλÿʼ8.4  SHOW MASTER STATUS Ϊ SHOW BINARY LOG STATUS
+    bool resumed = !m_file.empty();
+    if (!resumed) {
+        rows.clear();
+        std::string ignored;
+        if (!wire.Query("SHOW MASTER STATUS", &rows, ignored) &&
+            !wire.Query("SHOW BINARY LOG STATUS", &rows, error))
+            return false;
+        if (rows.empty() || rows[0].size() < 2 || rows[0][0].empty()) {
+            error = "δ binlog";
+            return false;
+        }
+        m_file = rows[0][0];
+        m_pos = (uint32_t)strtoul(rows[0][1].c_str(), nullptr, 10);
+    }
+    m_curFile = m_file;
+    m_tableMaps.clear();
+
+    // COM_BINLOG_DUMPλá־server_idļ
+    std::string dump(1, (char)0x12);
+    for (int i = 0; i < 4; ++i) dump += (char)(m_pos >> (i * 8));
+    dump.append(2, '\0');
+    for (int i = 0; i < 4; ++i) dump += (char)(m_opt.serverId >> (i * 8));
+    dump += m_file;
+    if (!wire.Command(dump)) { error = " COM_BINLOG_DUMP ʧ"; return false; }
+    wire.SetReadTimeout(m_opt.heartbeatSec * 3000);
+
+    bool first = true;
+    std::string pkt;
+    while (m_running.load())
+    {
+        if (!wire.ReadPacket(pkt) || pkt.empty()) {
+            error = "ӶϿ " + std::to_string(m_opt.heartbeatSec * 3) + " δյ";
+            return false;
+        }
+        unsigned char head = (unsigned char)pkt[0];
+        if (head == 0xFF) {
+            error = MySqlWire::ErrorText(pkt);
+            // λѲã binlog ´δӵǰλ¿ʼɵ÷ȫ
+            if (first) m_file.clear();
+            return false;
+        }
+        if (head == 0xFE && pkt.size() < 9) { error = " binlog "; return false; }
+
+        if (first) {
+            first = false;
+            m_streaming = true;
+            printf("[BINLOG] ʼ %s:%u%s\n", m_file.c_str(), m_pos, resumed ? "" : "ǰλ");
+            fflush(stdout);
+            if (m_onStart)
+                m_onStart(resumed);
+        }
+        if (!handleEvent((const unsigned char*)pkt.data() + 1, pkt.size() - 1, error))
+            return false;
+    }
+    error = "ֹͣ";
+    return false;
+}
+
+// ȡע ORDINAL_POSITIONõĶӣbinlog ҲԵ
+bool BinlogClient::loadColumns(std::string& error)
+{
+    MySqlWire wire;
+    if (!wire.Connect(m_opt, error))
+        return false;
+
+    std::string in;
+    for (const auto& t : m_opt.tables)
+        in += (in.empty() ? "" : ",") + QuoteSql(t);
+    std::vector<std::vector<std::string>> rows;
+    if (!wire.Query("SELECT TABLE_NAME, COLUMN_NAME FROM information_schema.COLUMNS WHERE TABLE_SCHEMA = " +
+        QuoteSql(m_opt.schema) + " AND TABLE_NAME IN (" + in + ") ORDER BY TABLE_NAME, ORDINAL_POSITION", &rows, error))
+        return false;
+
+    m_columns.clear();
+    for (const auto& r : rows)
+        if (r.size() >= 2)
+            m_columns[r[0]].push_back(r[1]);
+    return true;
+}
+
+bool BinlogClient::handleEvent(const unsigned char* p, size_t len, std::string& error)
+{
+    if (len < kEventHeader) { error = "¼"; return false; }
+    uint32_t timestamp = (uint32_t)ReadLE(p, 4);
+    uint8_t type = p[4];
+    uint32_t logPos = (uint32_t)ReadLE(p + 13, 4);
+
+    if (m_checksum) {
+        if (len < kEventHeader + 4) { error = "¼"; return false; }
+        len -= 4;
+        if (Crc32(p, len) != (uint32_t)ReadLE(p + len, 4)) {
+            error = "¼Уʧܣ " + std::to_string(type) + "";
+            return false;
+        }
+    }
+    const unsigned char* body = p + kEventHeader;
+    size_t bodyLen = len - kEventHeader;
+
+    {
+        std::lock_guard<std::mutex> lk(m_statsMutex);
+        m_events++;
+        if (timestamp) m_lastEventSec = timestamp;
+    }
+
+    switch (type)
+    {
+    case EV_ROTATE:
+        if (bodyLen < 8) { error = "ROTATE ¼"; return false; }
+        m_curFile.assign((const char*)body + 8, bodyLen - 8);
+        m_file = m_curFile;
+        m_pos = (uint32_t)ReadLE(body, 4);
+        break;
+    case EV_XID:
+        m_file = m_curFile;
+        m_pos = logPos;
+        break;
+    case EV_QUERY: {
+        // ʼ BEGIN Ǳ߽磻DDL ܸıУ´ TABLE_MAP ʱ¶ȡ
+        if (bodyLen < 13) break;
+        size_t dbLen = body[8];
+        size_t varsLen = (size_t)ReadLE(body + 11, 2);
+        size_t off = 13 + varsLen + dbLen + 1;
+        std::string sql = off <= bodyLen ? std::string((const char*)body + off, bodyLen - off) : std::string();
+        if (sql == "BEGIN")
+            break;
+        std::string upper = sql.substr(0, 64);
+        std::transform(upper.begin(), upper.end(), upper.begin(), ::toupper);
+        if (upper.find("ALTER") != std::string::npos || upper.find("RENAME") != std::string::npos)
+            m_columns.clear();
+        m_file = m_curFile;
+        m_pos = logPos;
+        break;
+    }
+    case EV_TABLE_MAP:
+        if (!handleTableMap(body, bodyLen)) { error = "TABLE_MAP ¼ʽ"; return false; }
+        break;
+    case EV_WRITE_ROWS_V1: case EV_UPDATE_ROWS_V1: case EV_DELETE_ROWS_V1:
+    case EV_WRITE_ROWS: case EV_UPDATE_ROWS: case EV_DELETE_ROWS:
+        return handleRows(type, body, bodyLen, error);
+    default:
+        break;      // FORMAT_DESCRIPTIONHEARTBEATGTID ȲҪ
+    }
+    return true;
+}
+
+bool BinlogClient::handleTableMap(const unsigned char* p, size_t len)
+{
+    const unsigned char* end = p + len;
+    if (len < 8 + 2) return false;
+    uint64_t tableId = ReadLE(p, 6);
+    p += 8;
+    size_t dbLen = *p++;
+    if ((size_t)(end - p) < dbLen + 2) return false;
+    std::string db((const char*)p, dbLen);
+    p += dbLen + 1;
+    size_t tblLen = *p++;
+    if ((size_t)(end - p) < tblLen + 1) return false;
+    std::string table((const char*)p, tblLen);
+    p += tblLen + 1;
+
+    if (db != m_opt.schema || std::find(m_opt.tables.begin(), m_opt.tables.end(), table) == m_opt.tables.end()) {
+        m_tableMaps.erase(tableId);
+        return true;
+    }
+
+    uint64_t count = 0, metaLen = 0;
+    if (!ReadLenEnc(p, end, count) || (uint64_t)(end - p) < count) return false;
+    TableInfo t;
+    t.table = table;
+    t.types.assign(p, p + count);
+    p += count;
+    if (!ReadLenEnc(p, end, metaLen) || (uint64_t)(end - p) < metaLen) return false;
+    const unsigned char* m = p;
+    const unsigned char* mEnd = p + metaLen;
+    for (uint8_t type : t.types) {
+        uint16_t meta = 0;
+        switch (type) {
+        case COL_FLOAT: case COL_DOUBLE: case COL_TINY_BLOB: case COL_MEDIUM_BLOB: case COL_LONG_BLOB:
+        case COL_BLOB: case COL_GEOMETRY: case COL_JSON: case COL_TIMESTAMP2: case COL_DATETIME2: case COL_TIME2:
+            if (m + 1 > mEnd) return false;
+            meta = *m++;
+            break;
+        case COL_VARCHAR: case COL_VAR_STRING:
+            if (m + 2 > mEnd) return false;
+            meta = (uint16_t)ReadLE(m, 2);
+            m += 2;
+            break;
+        case COL_STRING: case COL_NEWDECIMAL: case COL_BIT: case COL_ENUM: case COL_SET:
+            if (m + 2 > mEnd) return false;
+            meta = (uint16_t)(m[0] << 8 | m[1]);
+            m += 2;
+            break;
+        default:
+            break;
+        }
+        t.meta.push_back(meta);
+    }
+
+    // 뻺ṹʱ¶ȡ
+    auto it = m_columns.find(table);
+    if (it == m_columns.end() || it->second.size() != count) {
+        std::string error;
+        if (!loadColumns(error)) {
+            printf("[BINLOG] ȡ %s ʧܣ%s\n", table.c_str(), error.c_str());
+            fflush(stdout);
+        }
+        it = m_columns.find(table);
+    }
+    if (it != m_columns.end() && it->second.size() == count)
+        t.columns = it->second;
+    else {
+        printf("[BINLOG] %s %llu information_schema һ£ñ¼\n",
+            table.c_str(), (unsigned long long)count);
+        fflush(stdout);
+    }
+    m_tableMaps[tableId] = std::move(t);
+    return true;
+}
+
+bool BinlogClient::handleRows(uint8_t type, const unsigned char* p, size_t len, std::string& error)
+{
+    const unsigned char* end = p + len;
+    if (len < 8) { error = "¼"; return false; }
+    uint64_t tableId = ReadLE(p, 6);
+    p += 8;
+    bool v2 = type >= EV_WRITE_ROWS;
+    if (v2) {
+        if (end - p < 2) { error = "¼"; return false; }
+        size_t extra = (size_t)ReadLE(p, 2);
+        if (extra < 2 || (size_t)(end - p) < extra) { error = "¼ʽ"; return false; }
+        p += extra;
+    }
+
+    auto it = m_tableMaps.find(tableId);
+    if (it == m_tableMaps.end() || it->second.columns.empty())
+        return true;        // עı
+    const TableInfo& t = it->second;
+
+    bool update = type == EV_UPDATE_ROWS || type == EV_UPDATE_ROWS_V1;
+    bool deleted = type == EV_DELETE_ROWS || type == EV_DELETE_ROWS_V1;
+
+    uint64_t width = 0;
+    if (!ReadLenEnc(p, end, width) || width != t.types.size()) { error = "¼ TABLE_MAP "; return false; }
+    size_t bitmapBytes = (size_t)(width + 7) / 8;
+    auto readBitmap = [&](std::vector<bool>& bits) {
+        if ((size_t)(end - p) < bitmapBytes) return false;
+        for (size_t i = 0; i < width; ++i) bits.push_back((p[i / 8] >> (i % 8)) & 1);
+        p += bitmapBytes;
+        return true;
+    };
+    std::vector<bool> before, after;
+    if (!readBitmap(before) || (update && !readBitmap(after))) { error = "¼ʽ"; return false; }
+
+    std::vector<BinlogRow> rows;
+    while (p < end)
+    {
+        BinlogRow row;
+        if (!decodeRow(t, p, end, before, row)) {
+            error = t.table + " ޷";
+            return false;
+        }
+        if (update) {
+            row.values.clear();
+            if (!decodeRow(t, p, end, after, row)) {
+                error = t.table + " ޷";
+                return false;
+            }
+        }
+        rows.push_back(std::move(row));
+    }
+
+    {
+        std::lock_guard<std::mutex> lk(m_statsMutex);
+        m_rows += rows.size();
+    }
+    if (!rows.empty() && m_onRows)
+        m_onRows(t.table, deleted, rows);
+    return true;
+}
+
+bool BinlogClient::decodeRow(const TableInfo& t, const unsigned char*& p, const unsigned char* end,
+    const std::vector<bool>& present, BinlogRow& row)
+{
+    size_t n = (size_t)std::count(present.begin(), present.end(), true);
+    size_t nullBytes = (n + 7) / 8;
+    if ((size_t)(end - p) < nullBytes) return false;
+    const unsigned char* nulls = p;
+    p += nullBytes;
+
+    size_t k = 0;
+    for (size_t i = 0; i < t.types.size(); ++i) {
+        if (!present[i]) continue;
+        bool isNull = (nulls[k / 8] >> (k % 8)) & 1;
+        k++;
+        if (isNull) continue;
+        std::string value;
+        if (!DecodeValue(t.types[i], t.meta[i], p, end, value))
+            return false;
+        row.values[t.columns[i]] = std::move(value);
+    }
+    return true;
+}
+
+void BinlogClient::Report()
+{
+    uint64_t events, rows;
+    int64_t lastSec;
+    {
+        std::lock_guard<std::mutex> lk(m_statsMutex);
+        events = m_events;
+        rows = m_rows;
+        lastSec = m_lastEventSec;
+        m_events = m_rows = 0;
+    }
+    long long lag = lastSec > 0 ? (long long)time(nullptr) - lastSec : -1;
+    printf("[BINLOG] %s¼ %llu  %llu¼ %lld ǰ\n", Streaming() ? "" : "δ",
+        (unsigned long long)events, (unsigned long long)rows, lag);
+    fflush(stdout);
+}
@@ -0,0 +1,111 @@
+﻿// BinlogClient.h
+#pragma once
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <functional>
+#include <cstdint>
+#include <cstdlib>
+#include <WinSock2.h>
+
+// =========================================================
+// ===========   MySQL binlog 变更订阅（复制客户端）   ===========
+// =========================================================
+//
+// 以复制客户端身份连接 MySQL（COM_BINLOG_DUMP），解码指定库中若干张表的行事件
+// （WRITE/UPDATE/DELETE_ROWS），把每行转换为“列名 -> 文本值”交给回调，语义与 SELECT 读到的行一致。
+//   - 需要 binlog_format=ROW、binlog_row_image=FULL，账号需要 REPLICATION SLAVE、REPLICATION CLIENT 权限
+//   - 认证支持 mysql_native_password 与 caching_sha2_password 的快速认证（服务器已缓存该账号，
+//     即该账号此前以普通方式成功登录过；本进程的 DB 连接会先完成这一步）
+//   - 列名从 information_schema 读取；表结构变更（列数变化）时重新读取
+//   - 断线后从最近一个事务边界的位置续传；无法续传（如 binlog 已被清理）时从当前位置重新开始，
+//     并通过 StartHandler(false) 通知调用方做一次全量对账
+// 不可用期间（未授权、未开启 ROW 格式等）Streaming() 为 false，调用方继续轮询 DB。
+
+// 一行数据：列名 -> 文本形式的值（NULL 列不出现）
+struct BinlogRow
+{
+    std::unordered_map<std::string, std::string> values;
+
+    bool Has(const std::string& column) const { return values.count(column) > 0; }
+    std::string Get(const std::string& column) const
+    {
+        auto it = values.find(column);
+        return it == values.end() ? std::string() : it->second;
+    }
+    long GetLong(const std::string& column) const { return strtol(Get(column).c_str(), nullptr, 10); }
+    int GetInt(const std::string& column) const { return (int)GetLong(column); }
+    double GetDouble(const std::string& column) const { return strtod(Get(column).c_str(), nullptr); }
+};
+
+class BinlogClient {
+public:
+    struct Options {
+        std::string host = "127.0.0.1";
+        int port = 3306;
+        std::string user;
+        std::string password;
+        std::string schema;
+        std::vector<std::string> tables;    // 只解码这些表
+        uint32_t serverId = 0;              // 复制客户端的 server_id，须与其他副本不同
+        int heartbeatSec = 5;               // 空闲时服务器发送心跳的间隔，3 倍时间收不到任何事件视为断线
+    };
+
+    // 在 binlog 线程调用。deleted=false 时 rows 为写入 / 更新后的行，deleted=true 时为删除前的行
+    typedef std::function<void(const std::string& table, bool deleted, const std::vector<BinlogRow>& rows)> RowsHandler;
+    // 开始接收时调用：resumed=false 表示从服务器当前位置开始，之前的变更可能遗漏
+    typedef std::function<void(bool resumed)> StartHandler;
+
+    ~BinlogClient();
+
+    void Start(const Options& options, RowsHandler onRows, StartHandler onStart);
+    void Stop();
+
+    // 已连接并在接收事件
+    bool Streaming() const { return m_streaming.load(std::memory_order_relaxed); }
+
+    // 输出并清零本周期的事件数、行数，以及当前位置与复制延迟
+    void Report();
+
+private:
+    struct TableInfo {
+        std::string table;
+        std::vector<uint8_t> types;
+        std::vector<uint16_t> meta;
+        std::vector<std::string> columns;   // 与 types 等长时才解码
+    };
+
+    void run();
+    bool stream(std::string& error);
+    bool loadColumns(std::string& error);
+    bool handleEvent(const unsigned char* p, size_t len, std::string& error);
+    bool handleTableMap(const unsigned char* p, size_t len);
+    bool handleRows(uint8_t type, const unsigned char* p, size_t len, std::string& error);
+    bool decodeRow(const TableInfo& t, const unsigned char*& p, const unsigned char* end,
+        const std::vector<bool>& present, BinlogRow& row);
+
+    Options m_opt;
+    RowsHandler m_onRows;
+    StartHandler m_onStart;
+    std::atomic<bool> m_running{ false };
+    std::atomic<bool> m_streaming{ false };
+    std::atomic<SOCKET> m_socket{ INVALID_SOCKET };    // 当前连接，Stop() 关闭它以打断阻塞读
+    std::thread m_thread;
+
+    // 以下仅 binlog 线程访问
+    std::string m_file;                     // 续传位置（事务边界）
+    uint32_t m_pos = 0;
+    std::string m_curFile;                  // 当前读到的位置
+    bool m_checksum = false;                // 事件末尾带 CRC32
+    std::unordered_map<std::string, std::vector<std::string>> m_columns;   // 表名 -> 列名（按 ORDINAL_POSITION）
+    std::unordered_map<uint64_t, TableInfo> m_tableMaps;                  // table_id -> 表结构
+
+    // 统计
+    std::mutex m_statsMutex;
+    uint64_t m_events = 0;
+    uint64_t m_rows = 0;
+    int64_t m_lastEventSec = 0;             // 最近一个事件的服务器时间戳
+};
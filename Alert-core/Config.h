@@ -1,4 +1,3 @@
-Config.h
 #pragma once
 #include <string>
 
@@ -10,21 +9,122 @@ public:
     void Load(const std::string& filePath = "config.ini");
 
     // 
-    std::string mdAddress;
+    std::string mdAddress;      // ǰԶŷָÿǰһỰtick ȥغ
+    std::string mdFlowDir;      // Ựļ.conĸĿ¼Ựʹµ front<N>/ Ŀ¼
+    int mdPartitions;           // ÿǰòɼỰֱһֺԼԤͬʽƬ
+    std::string mdTransport;    // tcp / udp / multicast
+    int mdMulticastTopicId;     // ѯ鲥Լţ0 Ϊȫ
+    int mdQuietFallbackMs;      // UDP / 鲥ú TCP0 
+    std::string mdTcpFallbackAddress;   // ʹõ TCP ǰãԭǰõַ
     std::string brokerId;
     std::string userId;
     std::string password;
 
+    // ص / ¶ģ˱ܻޣ룩ÿĵĺԼ
+    int sessionBackoffBaseMs;
+    int sessionBackoffMaxMs;
+    int sessionSubscribeChunk;
+
+    // У飺ʱ뱾ʱƫ룬0 飩ΪǽʱεĲ
+    int tickMaxAgeSec;
+    int tickLog;                // 1ȥغ飨ãص߳ͬд̨
+
+    // ԼԪݣDB ȣ CSV ļΪղأÿˢʱ̣ HH:MM
+    std::string instrumentsTable;
+    std::string instrumentsFile;
+    std::string instrumentsRefreshTime;
+
+    // Ƭж߳0 Ϊصֱ߳жϣÿߵÿ̵߳Ķ
+    int evalWorkers;
+    int evalQueueSize;
+    std::string evalIdle;       // park evalSpinUs busyһֱѯ
+    int evalSpinUs;
+
+    // ̰߳ˣCPU б "2,3,6-7"Ϊ󶨣SDK ص̡߳ж߳ˣ̨߳ ServiceCpus
+    std::string threadCallbackCpus;
+    std::string threadEvalCpus;
+    std::string threadServiceCpus;
+    int threadRealtime;         // 1 HIGH ȼص / ж߳ TIME_CRITICAL
+
     std::string dbHost;
     int dbPort;
     std::string dbUser;
     std::string dbPassword;
     std::string dbSchema;
 
+    // ¼ outboxԤд־
+    std::string outboxPath;
+
+    // Ԥգ·Ϊղãʱд룬0 ֻ˳ʱд
+    std::string snapshotPath;
+    int snapshotIntervalSec;
+
+    // ͬalert_order ÿ޸ĸµʱУΪÿȫأȫ˼룬<=0 ֻʱȫ
+    std::string reloadDeltaColumn;
+    int reloadFullSec;
+
+    // Ԥͽӿڣַ˿ڣ0 ã
+    std::string intakeBind;
+    int intakePort;
+
+    // binlog ģƿͻ server_id0 ã룩˺ţΪ [Database]
+    int binlogServerId;
+    int binlogHeartbeatSec;
+    std::string binlogUser;
+    std::string binlogPassword;
+
+    // ʵʵΪղ̬ԱбŷָԱǼǱΪþ̬б
+    // ÿʵڵԱʱ䣨룩ʧȥж϶ͷţ룩
+    std::string clusterSelf;
+    std::string clusterInstances;
+    std::string clusterTable;
+    int clusterVirtualNodes;
+    int clusterLeaseSec;
+    int clusterHandoffSec;
+
+    // 죺ΪղãʵҪԼ룩
+    std::string claimTable;
+    int claimLeaseSec;
+
+    // ڴߣڴΪղãλλȡΪ 2 ݣ
+    std::string tickBusName;
+    int tickBusCapacity;
+
+    // ڴ津¼ڴΪղãλȡΪ 2 ݣ
+    std::string triggerBusName;
+    int triggerBusCapacity;
+
+    // ʷд룺ÿȴ룩
+    int triggerLogBatchSize;
+    int triggerLogLingerMs;
+
+    // Webhook ֪ͨ URL ԶŷָΪ
+    std::string webhookUrls;
+    int webhookMaxInFlight;
+    int webhookConnectTimeoutMs;
+    int webhookRequestTimeoutMs;
+    int webhookMaxRetries;
+
+    // ֪ͨϲͬһ˻ڵĴϲΪһ0 ʾϲժҪ
+    int digestWindowMs;
+    int digestMaxItems;
+
+    // ֪ͨͰΪÿ<=0 ޣ֪ͨӳٶ
+    double rateGlobalPerSec;
+    double rateGlobalBurst;
+    double rateEmailPerSec;
+    double rateEmailBurst;
+    double rateWebhookPerSec;
+    double rateWebhookBurst;
+    double rateAccountPerSec;
+    double rateAccountBurst;
+    int rateMaxDeferred;
+
 private:
     Config();
     void loadDefaults();
     void loadFromEnv();
     void loadFromFile(const std::string& filePath);
+    void apply(const std::string& section, const std::string& key, const std::string& value);
     static std::string trim(const std::string& s);
 };
\ No newline at end of file
@@ -80,7 +80,18 @@ std::string EmailNotifier::GetFormattedTime() {
     return std::string(time_buffer);
 }
 
+// 仺Чڣ룩ѯʧܻδ䲻
+static const std::time_t kEmailCacheSeconds = 300;
+
 std::string EmailNotifier::GetUserEmail(const std::string& account) {
+    std::time_t now = std::time(nullptr);
+    {
+        std::lock_guard<std::mutex> lk(email_cache_mutex);
+        auto it = email_cache.find(account);
+        if (it != email_cache.end() && now - it->second.second < kEmailCacheSeconds)
+            return it->second.first;
+    }
+
     try {
         std::unique_ptr<sql::Connection> conn(GetConn());
         std::unique_ptr<sql::PreparedStatement> stmt(
@@ -89,7 +100,12 @@ std::string EmailNotifier::GetUserEmail(const std::string& account) {
         stmt->setString(1, account);
         std::unique_ptr<sql::ResultSet> res(stmt->executeQuery());
         if (res->next()) {
-            return res->getString("email");
+            std::string email = res->getString("email");
+            if (!email.empty()) {
+                std::lock_guard<std::mutex> lk(email_cache_mutex);
+                email_cache[account] = std::make_pair(email, now);
+            }
+            return email;
         }
     }
     catch (sql::SQLException& e) {
@@ -98,6 +114,14 @@ std::string EmailNotifier::GetUserEmail(const std::string& account) {
     return std::string();
 }
 
+void EmailNotifier::UpdateCachedEmail(const std::string& account, const std::string& email) {
+    std::lock_guard<std::mutex> lk(email_cache_mutex);
+    if (email.empty())
+        email_cache.erase(account);
+    else
+        email_cache[account] = std::make_pair(email, std::time(nullptr));
+}
+
 
 bool send_command(SOCKET sock, const std::string& command, const std::string& expected_code) {
     if (send(sock, command.c_str(), command.length(), 0) == SOCKET_ERROR) {
@@ -218,5 +242,41 @@ bool EmailNotifier::SendAlertEmail(const std::string& account, const std::string
     bool result = send_email(subject, body);
     to_email = original_to_email;  // ָԭʼ
 
+    return result;
+}
+
+bool EmailNotifier::SendDigestEmail(const std::string& account, const std::vector<TriggerEvent>& events) {
+    if (events.empty()) {
+        return true;
+    }
+
+    std::string user_email = GetUserEmail(account);
+    if (user_email.empty()) {
+        printf("δҵû %s ַ\n", account.c_str());
+        return false;
+    }
+
+    std::string subject = "ڻԤ֪ͨ - " + std::to_string(events.size()) + " Ԥ" + events[0].symbol;
+    if (events.size() > 1) {
+        subject += " ";
+    }
+    subject += "";
+
+    std::string body = "û: " + account + "\r\n" +
+        "ʱ: " + GetFormattedTime() + "\r\n" +
+        " " + std::to_string(events.size()) + " Ԥ\r\n\r\n";
+    for (size_t i = 0; i < events.size(); ++i) {
+        const TriggerEvent& e = events[i];
+        body += std::to_string(i + 1) + ". Լ: " + e.symbol +
+            "  ۸: " + std::to_string(e.price) +
+            "  ʱ: " + e.exchangeTime +
+            "  ԭ: " + e.reason + "\r\n";
+    }
+
+    std::string original_to_email = to_email;
+    to_email = user_email;
+    bool result = send_email(subject, body);
+    to_email = original_to_email;
+
     return result;
 }
\ No newline at end of file
@@ -1,9 +1,14 @@
 // EmailNotifier.h
 #pragma once
 #include <string>
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+#include <ctime>
 #include <WinSock2.h>
 #include <iostream>
 #include <mysql/jdbc.h>
+#include "TriggerEvent.h"
 
 class EmailNotifier {
 private:
@@ -13,6 +18,10 @@ private:
     std::string from_password;
     std::string to_email;
 
+    // account -> (, ѯʱ)ÿʼһ user 
+    std::unordered_map<std::string, std::pair<std::string, std::time_t>> email_cache;
+    std::mutex email_cache_mutex;
+
     std::string base64_encode(const std::string& input);
     bool send_email(const std::string& subject, const std::string& body);
     std::string GetUserEmail(const std::string& account);
@@ -22,4 +31,8 @@ public:
         const std::string& password, const std::string& to);
     //bool SendAlertEmail(const std::string& instrument, double price, const std::string& reason);
     bool SendAlertEmail(const std::string& account, const std::string& instrument, double price, const std::string& reason);
+    // ͬһ˻ĶϲΪһʼ
+    bool SendDigestEmail(const std::string& account, const std::vector<TriggerEvent>& events);
+    //  binlog ĵã user »棬email ΪʱƳ
+    void UpdateCachedEmail(const std::string& account, const std::string& email);
 };
\ No newline at end of file
@@ -0,0 +1,271 @@
+﻿#pragma once
+#include "AlertRule.h"
+#include "SpscRing.h"
+#include "ThreadTuning.h"
+#include <stdio.h>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <chrono>
+#include <string>
+
+// =========================================================
+// ===========   分片预警判断线程池   ===========
+// =========================================================
+//
+// 每个 worker 独占一个预警分片；生产者（行情会话的 SDK 回调线程）把 tick 放进
+// “生产者 -> 目标 worker” 的专用 SPSC 队列，因此任何一条队列都只有一个生产者和一个消费者，无需加锁。
+// worker 轮流取各条队列（每条一次最多 kBatch 个），没有任务时：
+//   EVAL_IDLE_PARK —— 先自旋 spinUs 微秒，仍无任务再挂起等待生产者唤醒（默认，空闲时不占 CPU）；
+//   EVAL_IDLE_BUSY —— 一直自旋轮询，不挂起（独占隔离核，换取最低的唤醒抖动）。
+// 队列满时生产者让出 CPU 等待（背压到 SDK 回调线程），不丢 tick。
+// 每个 worker 统计 “收到回调 -> 开始判断” 的排队延迟分布，用于对比绑核 / 自旋前后的抖动。
+
+// 交给 worker 的一个 tick（symbol 为定长拷贝，队列元素不含堆内存）
+struct EvalTask
+{
+    TickRecord tick;
+    int instrumentId;
+    char symbol[32];
+};
+
+enum EvalIdleMode
+{
+    EVAL_IDLE_PARK = 0,
+    EVAL_IDLE_BUSY
+};
+
+inline EvalIdleMode ParseEvalIdleMode(const std::string& s)
+{
+    return (s == "busy" || s == "BUSY" || s == "spin") ? EVAL_IDLE_BUSY : EVAL_IDLE_PARK;
+}
+
+struct EvalPoolOptions
+{
+    int workers{ 0 };
+    int producers{ 1 };
+    size_t queueSize{ 1024 };
+    EvalIdleMode idle{ EVAL_IDLE_PARK };
+    int spinUs{ 50 };               // PARK 模式挂起前的自旋时长
+    std::vector<int> cpus;          // worker i 绑到 cpus[i % n]，为空不绑定
+    bool realtime{ false };         // worker 线程提升为 TIME_CRITICAL
+};
+
+class EvalWorkerPool
+{
+public:
+    // 在 worker 线程调用
+    typedef std::function<void(int worker, const EvalTask& task)> Handler;
+
+    ~EvalWorkerPool() { Stop(); }
+
+    void Start(const EvalPoolOptions& options, Handler handler)
+    {
+        if (m_running.load() || options.workers <= 0) return;
+        m_options = options;
+        m_handler = std::move(handler);
+        for (int i = 0; i < options.workers; ++i) {
+            auto w = std::make_unique<Worker>();
+            for (int p = 0; p < options.producers; ++p)
+                w->queues.push_back(std::make_unique<SpscRing<EvalTask>>(options.queueSize));
+            m_workers.push_back(std::move(w));
+        }
+
+        m_running = true;
+        for (int i = 0; i < options.workers; ++i)
+            m_workers[i]->thread = std::thread([this, i]() { Run(i); });
+
+        printf("[EVAL] %d 个判断线程，%d 个生产者，每条队列 %zu 项，空闲策略 %s\n",
+            options.workers, options.producers,
+            m_workers[0]->queues.empty() ? 0 : m_workers[0]->queues[0]->Capacity(),
+            options.idle == EVAL_IDLE_BUSY ? "busy" : "park");
+        fflush(stdout);
+    }
+
+    // 停止前处理完已入队的 tick
+    void Stop()
+    {
+        if (!m_running.exchange(false)) return;
+        for (auto& w : m_workers) {
+            {
+                std::lock_guard<std::mutex> lk(w->mutex);
+            }
+            w->cv.notify_all();
+        }
+        for (auto& w : m_workers)
+            if (w->thread.joinable()) w->thread.join();
+    }
+
+    bool Running() const { return m_running.load(std::memory_order_relaxed); }
+    int Size() const { return (int)m_workers.size(); }
+
+    // 仅由第 producer 个生产者线程调用
+    void Push(int producer, int worker, const EvalTask& task)
+    {
+        Worker& w = *m_workers[worker];
+        SpscRing<EvalTask>& q = *w.queues[producer];
+        if (!q.TryPush(task)) {
+            w.fullWaits.fetch_add(1, std::memory_order_relaxed);
+            while (!q.TryPush(task)) {
+                if (!m_running.load(std::memory_order_relaxed)) return;
+                std::this_thread::yield();
+            }
+        }
+
+        // 与 worker 挂起前的检查配对，保证不会漏掉唤醒
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (w.sleeping.load(std::memory_order_relaxed)) {
+            std::lock_guard<std::mutex> lk(w.mutex);
+            w.cv.notify_one();
+        }
+    }
+
+    // 输出并清零本周期各 worker 的处理量、队列满等待次数与排队延迟分布
+    void Report()
+    {
+        for (size_t i = 0; i < m_workers.size(); ++i) {
+            Worker& w = *m_workers[i];
+            size_t depth = 0;
+            for (auto& q : w.queues) depth += q->Size();
+
+            uint64_t hist[kDelayBuckets];
+            uint64_t total = 0;
+            for (int b = 0; b < kDelayBuckets; ++b) {
+                hist[b] = w.delayHist[b].exchange(0, std::memory_order_relaxed);
+                total += hist[b];
+            }
+
+            printf("[EVAL] worker%zu 处理 %llu 队列满等待 %llu 当前积压 %zu | 排队 p50 %lld us p99 %lld us p99.9 %lld us 最大 %lld us\n", i,
+                (unsigned long long)w.processed.exchange(0, std::memory_order_relaxed),
+                (unsigned long long)w.fullWaits.exchange(0, std::memory_order_relaxed), depth,
+                Percentile(hist, total, 0.50), Percentile(hist, total, 0.99), Percentile(hist, total, 0.999),
+                (long long)w.maxDelayUs.exchange(0, std::memory_order_relaxed));
+        }
+        fflush(stdout);
+    }
+
+private:
+    static const int kBatch = 64;
+    static const int kDelayBuckets = 32;   // 按 2 的幂分桶（微秒）
+
+    struct Worker
+    {
+        std::vector<std::unique_ptr<SpscRing<EvalTask>>> queues;   // 下标 = 生产者
+        std::thread thread;
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::atomic<bool> sleeping{ false };
+        std::atomic<uint64_t> processed{ 0 };
+        std::atomic<uint64_t> fullWaits{ 0 };
+        std::atomic<int64_t> maxDelayUs{ 0 };
+        std::atomic<uint64_t> delayHist[kDelayBuckets];
+
+        Worker() { for (auto& h : delayHist) h.store(0, std::memory_order_relaxed); }
+    };
+
+    static int64_t NowUs()
+    {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    static int Bucket(int64_t us)
+    {
+        int b = 0;
+        while (us > 0 && b < kDelayBuckets - 1) { us >>= 1; b++; }
+        return b;
+    }
+
+    // 返回分位所在桶的上界（微秒）
+    static long long Percentile(const uint64_t* hist, uint64_t total, double q)
+    {
+        if (total == 0) return 0;
+        uint64_t rank = (uint64_t)(total * q);
+        uint64_t seen = 0;
+        for (int b = 0; b < kDelayBuckets; ++b) {
+            seen += hist[b];
+            if (seen > rank) return b == 0 ? 0 : (1LL << b) - 1;
+        }
+        return (1LL << (kDelayBuckets - 1)) - 1;
+    }
+
+    void RecordDelay(Worker& w, int64_t delayUs)
+    {
+        if (delayUs < 0) delayUs = 0;
+        w.delayHist[Bucket(delayUs)].fetch_add(1, std::memory_order_relaxed);
+        if (delayUs > w.maxDelayUs.load(std::memory_order_relaxed))
+            w.maxDelayUs.store(delayUs, std::memory_order_relaxed);
+    }
+
+    bool AnyPending(Worker& w)
+    {
+        for (auto& q : w.queues)
+            if (q->Size() > 0) return true;
+        return false;
+    }
+
+    // 轮流取各条队列；返回是否处理了任务
+    bool Drain(int index, Worker& w, EvalTask& task)
+    {
+        bool any = false;
+        for (auto& q : w.queues) {
+            for (int n = 0; n < kBatch && q->TryPop(task); ++n) {
+                RecordDelay(w, NowUs() - task.tick.recvUs);
+                m_handler(index, task);
+                w.processed.fetch_add(1, std::memory_order_relaxed);
+                any = true;
+            }
+        }
+        return any;
+    }
+
+    void Run(int index)
+    {
+        char name[32];
+        snprintf(name, sizeof(name), "eval%d", index);
+        int cpu = PickCpu(m_options.cpus, (size_t)index);
+        TuneCurrentThread(name, cpu < 0 ? 0 : 1ULL << cpu, m_options.realtime);
+
+        Worker& w = *m_workers[index];
+        EvalTask task;
+        int64_t idleSinceUs = 0;
+        while (m_running.load(std::memory_order_relaxed))
+        {
+            if (Drain(index, w, task)) {
+                idleSinceUs = 0;
+                continue;
+            }
+
+            // 自旋阶段：BUSY 模式一直停留在这里
+            if (m_options.idle == EVAL_IDLE_BUSY) {
+                CpuRelax();
+                continue;
+            }
+            int64_t now = NowUs();
+            if (idleSinceUs == 0) idleSinceUs = now;
+            if (now - idleSinceUs < m_options.spinUs) {
+                CpuRelax();
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lk(w.mutex);
+            w.sleeping.store(true, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (!AnyPending(w) && m_running.load())
+                w.cv.wait_for(lk, std::chrono::milliseconds(100));
+            w.sleeping.store(false, std::memory_order_relaxed);
+            idleSinceUs = 0;
+        }
+
+        while (Drain(index, w, task)) {}
+    }
+
+    EvalPoolOptions m_options;
+    Handler m_handler;
+    std::vector<std::unique_ptr<Worker>> m_workers;
+    std::atomic<bool> m_running{ false };
+};
@@ -0,0 +1,313 @@
+﻿#pragma once
+#include "AlertRule.h"
+#include <string>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include <cmath>
+
+// =========================================================
+// ===========   按合约增量计算的滚动技术指标   ===========
+// =========================================================
+//
+// 规则中可引用：
+//     ma(N)      最近 N 个 tick 的简单移动平均
+//     stdev(N)   最近 N 个 tick 价格的滚动标准差（滑动窗口 Welford）
+//     vwap       当日成交量加权均价（按成交量增量累计）
+//     chg(M)     最近 M 分钟涨跌幅（%），按秒采样
+// 每个指标的更新都是 O(1)（chg 为均摊 O(1)），窗口在创建时一次性分配，内存有上界。
+// 指标只在有预警规则引用时创建，同一合约同一参数的指标在多个预警之间共享。
+
+static const int kIndicatorMaxWindow = 10000;   // ma/stdev 的最大 tick 窗口
+static const int kIndicatorMaxMinutes = 240;    // chg 的最大分钟窗口
+
+class Indicator
+{
+public:
+    virtual ~Indicator() = default;
+
+    // 每个 tick 调用一次（只在行情线程）
+    virtual void Update(const TickRecord& t) = 0;
+
+    // 指标对象本身及其窗口占用的字节数
+    virtual size_t MemoryBytes() const = 0;
+
+    // 尚未预热完成时为 NaN，规则比较结果为 false
+    const double* ValuePtr() const { return &m_value; }
+
+protected:
+    double m_value{ NAN };
+};
+
+// ------------------------- ma(N) -------------------------
+class MovingAverage : public Indicator
+{
+public:
+    explicit MovingAverage(int n) : m_window(n, 0.0) {}
+
+    void Update(const TickRecord& t) override
+    {
+        double x = t.v[TF_LAST];
+        if (std::isnan(x)) return;
+
+        if (m_count == (int)m_window.size())
+            m_sum -= m_window[m_head];
+        else
+            m_count++;
+        m_window[m_head] = x;
+        m_sum += x;
+
+        // 每绕一圈重新求和一次，消除浮点累计误差（均摊 O(1)）
+        if (++m_head == (int)m_window.size()) {
+            m_head = 0;
+            m_sum = 0.0;
+            for (double v : m_window) m_sum += v;
+        }
+
+        if (m_count == (int)m_window.size())
+            m_value = m_sum / m_count;
+    }
+
+    size_t MemoryBytes() const override
+    {
+        return sizeof(*this) + m_window.capacity() * sizeof(double);
+    }
+
+private:
+    std::vector<double> m_window;
+    int m_head{ 0 };
+    int m_count{ 0 };
+    double m_sum{ 0.0 };
+};
+
+// ------------------------- stdev(N) -------------------------
+class RollingStdev : public Indicator
+{
+public:
+    explicit RollingStdev(int n) : m_window(n, 0.0) {}
+
+    void Update(const TickRecord& t) override
+    {
+        double x = t.v[TF_LAST];
+        if (std::isnan(x)) return;
+
+        // 窗口已满：先移除最旧样本（Welford 逆运算）
+        if (m_count == (int)m_window.size()) {
+            double y = m_window[m_head];
+            double delta = y - m_mean;
+            m_count--;
+            m_mean -= delta / m_count;
+            m_m2 -= delta * (y - m_mean);
+        }
+
+        m_window[m_head] = x;
+        if (++m_head == (int)m_window.size()) m_head = 0;
+
+        m_count++;
+        double delta = x - m_mean;
+        m_mean += delta / m_count;
+        m_m2 += delta * (x - m_mean);
+        if (m_m2 < 0.0) m_m2 = 0.0;
+
+        if (m_count == (int)m_window.size())
+            m_value = std::sqrt(m_m2 / (m_count - 1));
+    }
+
+    size_t MemoryBytes() const override
+    {
+        return sizeof(*this) + m_window.capacity() * sizeof(double);
+    }
+
+private:
+    std::vector<double> m_window;
+    int m_head{ 0 };
+    int m_count{ 0 };
+    double m_mean{ 0.0 };
+    double m_m2{ 0.0 };
+};
+
+// ------------------------- vwap -------------------------
+class Vwap : public Indicator
+{
+public:
+    void Update(const TickRecord& t) override
+    {
+        double price = t.v[TF_LAST];
+        double volume = t.v[TF_VOLUME];
+        if (std::isnan(price) || std::isnan(volume)) return;
+
+        // 成交量是当日累计值；回退说明换了交易日，重新累计
+        if (volume < m_lastVolume) {
+            m_notional = 0.0;
+            m_volume = 0.0;
+            m_lastTurnover = -1.0;
+        }
+
+        double dv = volume - m_lastVolume;
+        if (m_lastVolume >= 0.0 && dv > 0.0) {
+            m_notional += TradedPrice(t, price, dv) * dv;
+            m_volume += dv;
+            m_value = m_notional / m_volume;
+        }
+        m_lastVolume = volume;
+        m_lastTurnover = t.v[TF_TURNOVER] >= 0.0 ? t.v[TF_TURNOVER] : -1.0;
+    }
+
+    size_t MemoryBytes() const override { return sizeof(*this); }
+
+private:
+    // 两次快照间的成交均价：已知合约乘数时为 成交额增量 / (成交量增量 × 乘数)，
+    // 否则（或结果超出涨跌停，如交易所成交额口径不同）以最新价近似
+    double TradedPrice(const TickRecord& t, double price, double dv) const
+    {
+        double multiplier = t.v[TF_MULTIPLIER];
+        double turnover = t.v[TF_TURNOVER];
+        if (!(multiplier > 0.0) || !(turnover >= 0.0) || m_lastTurnover < 0.0)
+            return price;
+        double avg = (turnover - m_lastTurnover) / (dv * multiplier);
+        double lo = t.v[TF_LOWER_LIMIT], hi = t.v[TF_UPPER_LIMIT];
+        if (!(avg > 0.0) || (lo <= hi && (avg < lo || avg > hi)))
+            return price;
+        return avg;
+    }
+
+    double m_lastVolume{ -1.0 };
+    double m_lastTurnover{ -1.0 };
+    double m_notional{ 0.0 };
+    double m_volume{ 0.0 };
+};
+
+// ------------------------- chg(M) -------------------------
+class PercentChange : public Indicator
+{
+public:
+    explicit PercentChange(int minutes)
+        : m_span(minutes * 60.0), m_ring(minutes * 60 + 2) {}
+
+    void Update(const TickRecord& t) override
+    {
+        double price = t.v[TF_LAST];
+        if (std::isnan(price) || std::isnan(t.time)) return;
+
+        // 交易所时间回退超过半天视为跨日（夜盘过零点），整体平移
+        double now = t.time + m_dayOffset;
+        if (m_size > 0 && now < back().time - 43200.0) {
+            m_dayOffset += 86400.0;
+            now += 86400.0;
+        }
+
+        // 同一秒内只保留最新价，保证样本数不超过窗口秒数
+        if (m_size > 0 && (long long)back().time == (long long)now) {
+            back().price = price;
+        }
+        else {
+            if (m_size == (int)m_ring.size()) pop();
+            push(now, price);
+        }
+
+        // 基准 = 不晚于 now - span 的最后一个样本
+        double target = now - m_span;
+        while (m_size >= 2 && at(1).time <= target) pop();
+
+        const Sample& base = at(0);
+        if (base.time <= target && base.price != 0.0)
+            m_value = (price - base.price) / base.price * 100.0;
+    }
+
+    size_t MemoryBytes() const override
+    {
+        return sizeof(*this) + m_ring.capacity() * sizeof(Sample);
+    }
+
+private:
+    struct Sample { double time; double price; };
+
+    double m_span;
+    double m_dayOffset{ 0.0 };
+    std::vector<Sample> m_ring;
+    int m_head{ 0 };
+    int m_size{ 0 };
+
+    Sample& at(int i) { return m_ring[(m_head + i) % m_ring.size()]; }
+    Sample& back() { return at(m_size - 1); }
+    void pop() { m_head = (m_head + 1) % (int)m_ring.size(); m_size--; }
+    void push(double time, double price)
+    {
+        Sample& s = m_ring[(m_head + m_size) % m_ring.size()];
+        s.time = time;
+        s.price = price;
+        m_size++;
+    }
+};
+
+// ------------------------- 工厂 -------------------------
+// 参数不合法返回 nullptr
+inline std::shared_ptr<Indicator> CreateIndicator(const std::string& name, int param)
+{
+    if (name == "ma" && param >= 2 && param <= kIndicatorMaxWindow)
+        return std::make_shared<MovingAverage>(param);
+    if (name == "stdev" && param >= 2 && param <= kIndicatorMaxWindow)
+        return std::make_shared<RollingStdev>(param);
+    if (name == "vwap" && param == 0)
+        return std::make_shared<Vwap>();
+    if (name == "chg" && param >= 1 && param <= kIndicatorMaxMinutes)
+        return std::make_shared<PercentChange>(param);
+    return nullptr;
+}
+
+// ------------------------- 单个合约的指标集合 -------------------------
+struct IndicatorSet
+{
+    std::vector<std::shared_ptr<Indicator>> items;
+
+    void Update(const TickRecord& t)
+    {
+        for (auto& ind : items) ind->Update(t);
+    }
+
+    size_t MemoryBytes() const
+    {
+        size_t total = 0;
+        for (const auto& ind : items) total += ind->MemoryBytes();
+        return total;
+    }
+};
+
+// ------------------------- 指标池（reload 线程使用） -------------------------
+// 以 "合约|名称(参数)" 为 key 复用已有指标对象，保留预热状态；
+// 池中只存 weak_ptr，指标的生命周期由引用它的规则决定。
+class IndicatorPool
+{
+public:
+    bool Resolve(const std::string& symbol, const std::string& name, int param, IndicatorRef& out)
+    {
+        std::string key = symbol + "|" + name + "(" + std::to_string(param) + ")";
+
+        std::shared_ptr<Indicator> ind;
+        auto it = m_pool.find(key);
+        if (it != m_pool.end())
+            ind = it->second.lock();
+
+        if (!ind) {
+            ind = CreateIndicator(name, param);
+            if (!ind) return false;
+            m_pool[key] = ind;
+        }
+
+        out.owner = ind;
+        out.value = ind->ValuePtr();
+        return true;
+    }
+
+    // 清理已经没有规则引用的条目
+    void Prune()
+    {
+        for (auto it = m_pool.begin(); it != m_pool.end();) {
+            if (it->second.expired()) it = m_pool.erase(it);
+            else ++it;
+        }
+    }
+
+private:
+    std::unordered_map<std::string, std::weak_ptr<Indicator>> m_pool;
+};
@@ -0,0 +1,251 @@
+﻿#pragma once
+#include "InstrumentRegistry.h"
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include <mutex>
+#include <atomic>
+#include <fstream>
+#include <sstream>
+#include <cstdint>
+#include <cstdlib>
+
+// =========================================================
+// ===========   合约元数据（最小变动价位、乘数、交易时段…）   ===========
+// =========================================================
+//
+// 元数据表按合约代码保存（来自本地 CSV 文件或 DB 表，每日刷新一次），再按合约 id 展开到定长数组：
+// 行情路径上取最小变动价位、合约乘数、交易时段都是一次数组读取，不加锁。
+// 表中没有的合约可以用组播合约表补充最小变动价位与乘数（AddFallback）。
+// 交易时段按原文去重后长期保留，指针在进程生命周期内有效。
+
+// 交易时段：当日分钟位图，例如 "09:00-10:15;10:30-11:30;13:30-15:00;21:00-02:30"（结束早于开始表示跨零点）
+struct TradingSessions
+{
+    static const int kPreOpenMinutes = 5;   // 开盘前集合竞价的快照也视为时段内
+
+    std::string text;
+    uint64_t minutes[23];                   // 1440 位
+
+    bool Contains(int minuteOfDay) const
+    {
+        if (minuteOfDay < 0 || minuteOfDay >= 1440) return false;
+        return (minutes[minuteOfDay >> 6] >> (minuteOfDay & 63)) & 1;
+    }
+
+    // 结束分钟本身也计入（收盘时刻的最后一笔快照）；结束时间可写作 24:00，等同 00:00
+    static bool Parse(const std::string& text, TradingSessions& out)
+    {
+        out.text = text;
+        for (auto& m : out.minutes) m = 0;
+        bool any = false;
+        std::stringstream ss(text);
+        std::string item;
+        while (std::getline(ss, item, ';'))
+        {
+            if (item.find_first_not_of(" \t\r") == std::string::npos)
+                continue;
+            int h1, m1, h2, m2;
+            if (sscanf_s(item.c_str(), " %d:%d-%d:%d", &h1, &m1, &h2, &m2) != 4)
+                return false;
+            if (h1 < 0 || h1 >= 24 || m1 < 0 || m1 >= 60 || h2 < 0 || h2 > 24 || m2 < 0 || m2 >= 60 ||
+                (h2 == 24 && m2 != 0))
+                return false;
+            // end 归一化到 [0, 1440)，否则下面的循环永远到不了 1440
+            int start = (h1 * 60 + m1 - kPreOpenMinutes + 1440) % 1440;
+            int end = (h2 * 60 + m2) % 1440;
+            for (int m = start; m != end; m = (m + 1) % 1440)
+                out.minutes[m >> 6] |= 1ULL << (m & 63);
+            out.minutes[end >> 6] |= 1ULL << (end & 63);
+            any = true;
+        }
+        return any;
+    }
+};
+
+struct InstrumentMeta
+{
+    std::string exchange;
+    double priceTick{ 0.0 };        // 0 未知
+    double multiplier{ 0.0 };       // 0 未知
+    int expireDate{ 0 };            // yyyymmdd，0 未知
+    std::string sessions;           // 交易时段原文，空为未知
+};
+
+class InstrumentMetaStore
+{
+public:
+    InstrumentMetaStore()
+    {
+        for (auto& s : m_slots) {
+            s.priceTick.store(0.0, std::memory_order_relaxed);
+            s.multiplier.store(0.0, std::memory_order_relaxed);
+            s.sessions.store(nullptr, std::memory_order_relaxed);
+        }
+    }
+
+    // 整体替换元数据表（刷新）；之后调用 Sync 展开到数组
+    void Replace(std::unordered_map<std::string, InstrumentMeta> table)
+    {
+        std::lock_guard<std::mutex> lk(m_mutex);
+        m_table.swap(table);
+        m_synced = 0;
+    }
+
+    // 组播合约表等来源的补充：只在元数据表中没有该合约时生效
+    void AddFallback(const std::string& symbol, double priceTick, double multiplier)
+    {
+        std::lock_guard<std::mutex> lk(m_mutex);
+        InstrumentMeta& m = m_fallback[symbol];
+        m.priceTick = priceTick;
+        m.multiplier = multiplier;
+        m_synced = 0;
+    }
+
+    // 把已注册合约的元数据展开到按 id 的数组；只处理上次之后新注册的 id（替换后全部重做）
+    void Sync(const InstrumentRegistry& registry)
+    {
+        std::lock_guard<std::mutex> lk(m_mutex);
+        int n = registry.Size();
+        for (int id = m_synced; id < n; ++id)
+        {
+            const InstrumentMeta* m = FindLocked(registry.Name(id));
+            Slot& s = m_slots[id];
+            s.priceTick.store(m ? m->priceTick : 0.0, std::memory_order_relaxed);
+            s.multiplier.store(m ? m->multiplier : 0.0, std::memory_order_relaxed);
+            s.sessions.store(m ? InternLocked(m->sessions) : nullptr, std::memory_order_release);
+        }
+        m_synced = n;
+    }
+
+    // ---------------- 行情路径（无锁，id 无效时返回未知） ----------------
+    double PriceTick(int id) const
+    {
+        return Valid(id) ? m_slots[id].priceTick.load(std::memory_order_relaxed) : 0.0;
+    }
+
+    double Multiplier(int id) const
+    {
+        return Valid(id) ? m_slots[id].multiplier.load(std::memory_order_relaxed) : 0.0;
+    }
+
+    const TradingSessions* Sessions(int id) const
+    {
+        return Valid(id) ? m_slots[id].sessions.load(std::memory_order_acquire) : nullptr;
+    }
+
+    // 完整元数据（加锁，非行情路径使用）
+    bool Get(const std::string& symbol, InstrumentMeta& out) const
+    {
+        std::lock_guard<std::mutex> lk(m_mutex);
+        const InstrumentMeta* m = FindLocked(symbol);
+        if (m) out = *m;
+        return m != nullptr;
+    }
+
+    size_t Size() const
+    {
+        std::lock_guard<std::mutex> lk(m_mutex);
+        return m_table.size();
+    }
+
+    // CSV：首行为列名（symbol,exchange,price_tick,multiplier,expire_date,sessions，顺序不限，
+    // 只有 symbol 必需），交易时段内各段以 ';' 分隔。失败返回 false
+    static bool LoadFile(const std::string& path, std::unordered_map<std::string, InstrumentMeta>& out)
+    {
+        std::ifstream in(path);
+        if (!in.is_open())
+            return false;
+
+        std::string line;
+        std::vector<std::string> header;
+        if (!std::getline(in, line))
+            return false;
+        SplitCsv(line, header);
+        int col[6];
+        static const char* kColumns[] = { "symbol", "exchange", "price_tick", "multiplier", "expire_date", "sessions" };
+        for (int i = 0; i < 6; ++i) {
+            col[i] = -1;
+            for (size_t j = 0; j < header.size(); ++j)
+                if (header[j] == kColumns[i]) col[i] = (int)j;
+        }
+        if (col[0] < 0)
+            return false;
+
+        std::vector<std::string> f;
+        auto at = [&f](int c) { return c >= 0 && c < (int)f.size() ? f[c] : std::string(); };
+        while (std::getline(in, line))
+        {
+            SplitCsv(line, f);
+            std::string symbol = at(col[0]);
+            if (symbol.empty() || symbol[0] == '#')
+                continue;
+            InstrumentMeta m;
+            m.exchange = at(col[1]);
+            m.priceTick = atof(at(col[2]).c_str());
+            m.multiplier = atof(at(col[3]).c_str());
+            m.expireDate = atoi(at(col[4]).c_str());
+            m.sessions = at(col[5]);
+            out[symbol] = m;
+        }
+        return true;
+    }
+
+private:
+    struct Slot
+    {
+        std::atomic<double> priceTick;
+        std::atomic<double> multiplier;
+        std::atomic<const TradingSessions*> sessions;
+    };
+
+    static bool Valid(int id) { return id >= 0 && id < kMaxInstruments; }
+
+    static void SplitCsv(const std::string& line, std::vector<std::string>& out)
+    {
+        out.clear();
+        std::stringstream ss(line);
+        std::string item;
+        while (std::getline(ss, item, ',')) {
+            size_t b = item.find_first_not_of(" \t\r\"");
+            size_t e = item.find_last_not_of(" \t\r\"");
+            out.push_back(b == std::string::npos ? std::string() : item.substr(b, e - b + 1));
+        }
+    }
+
+    const InstrumentMeta* FindLocked(const std::string& symbol) const
+    {
+        auto it = m_table.find(symbol);
+        if (it != m_table.end()) return &it->second;
+        auto fb = m_fallback.find(symbol);
+        return fb != m_fallback.end() ? &fb->second : nullptr;
+    }
+
+    const TradingSessions* InternLocked(const std::string& text)
+    {
+        if (text.empty())
+            return nullptr;
+        auto it = m_sessions.find(text);
+        if (it != m_sessions.end())
+            return it->second.get();
+        auto s = std::make_unique<TradingSessions>();
+        if (!TradingSessions::Parse(text, *s)) {
+            printf("[INSTRUMENT] 无法解析交易时段 \"%s\"，按未知处理\n", text.c_str());
+            fflush(stdout);
+            m_sessions[text] = nullptr;
+            return nullptr;
+        }
+        const TradingSessions* p = s.get();
+        m_sessions[text] = std::move(s);
+        return p;
+    }
+
+    mutable std::mutex m_mutex;
+    std::unordered_map<std::string, InstrumentMeta> m_table;
+    std::unordered_map<std::string, InstrumentMeta> m_fallback;
+    std::unordered_map<std::string, std::unique_ptr<TradingSessions>> m_sessions;    // 只增不删
+    int m_synced{ 0 };
+    Slot m_slots[kMaxInstruments];
+};
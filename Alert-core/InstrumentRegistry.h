@@ -0,0 +1,90 @@
+﻿#pragma once
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <shared_mutex>
+#include <mutex>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+
+// =========================================================
+// ===========   合约 id 注册表 + 共享最新价表   ===========
+// =========================================================
+//
+// 合约代码在首次出现（加载预警 / 订阅）时分配一个稠密的整数 id，id 永不回收。
+// 最新价按 id 存放在定长原子数组中：行情线程写、任意线程读，均不加锁。
+
+static const int kMaxInstruments = 4096;
+
+class InstrumentRegistry
+{
+public:
+    InstrumentRegistry()
+    {
+        for (int i = 0; i < kMaxInstruments; ++i)
+            m_lastPrices[i].store(NAN, std::memory_order_relaxed);
+    }
+
+    // 查找或分配 id，容量耗尽时返回 -1
+    int GetOrAdd(const std::string& symbol)
+    {
+        {
+            std::shared_lock<std::shared_mutex> lk(m_mutex);
+            auto it = m_ids.find(symbol);
+            if (it != m_ids.end()) return it->second;
+        }
+
+        std::unique_lock<std::shared_mutex> lk(m_mutex);
+        auto it = m_ids.find(symbol);
+        if (it != m_ids.end()) return it->second;
+        if ((int)m_names.size() >= kMaxInstruments) {
+            printf("[REGISTRY] 合约数量超过上限 %d，忽略 %s\n", kMaxInstruments, symbol.c_str());
+            fflush(stdout);
+            return -1;
+        }
+        int id = (int)m_names.size();
+        m_names.push_back(symbol);
+        m_ids.emplace(symbol, id);
+        return id;
+    }
+
+    // 仅查找，不存在返回 -1
+    int Find(const std::string& symbol) const
+    {
+        std::shared_lock<std::shared_mutex> lk(m_mutex);
+        auto it = m_ids.find(symbol);
+        return it == m_ids.end() ? -1 : it->second;
+    }
+
+    std::string Name(int id) const
+    {
+        std::shared_lock<std::shared_mutex> lk(m_mutex);
+        return (id >= 0 && id < (int)m_names.size()) ? m_names[id] : std::string();
+    }
+
+    int Size() const
+    {
+        std::shared_lock<std::shared_mutex> lk(m_mutex);
+        return (int)m_names.size();
+    }
+
+    // ---------------- 最新价表（无锁） ----------------
+    void SetLastPrice(int id, double price)
+    {
+        m_lastPrices[id].store(price, std::memory_order_release);
+    }
+
+    // 尚未收到行情时返回 NaN
+    double LastPrice(int id) const
+    {
+        return m_lastPrices[id].load(std::memory_order_acquire);
+    }
+
+private:
+    mutable std::shared_mutex m_mutex;
+    std::unordered_map<std::string, int> m_ids;
+    std::vector<std::string> m_names;
+
+    std::atomic<double> m_lastPrices[kMaxInstruments];
+};
@@ -6,16 +6,31 @@
 #include <atomic>
 #include <thread>
 #include <chrono>
+#include <mutex>
+#include <condition_variable>
+#include <future>
 #include <windows.h>
 
 std::atomic<bool> g_running{ true };
+std::mutex g_stopMutex;
+std::condition_variable g_stopCv;
+
+// ֪ͨ߳˳ѯ g_running
+static void RequestStop()
+{
+    {
+        std::lock_guard<std::mutex> lk(g_stopMutex);
+        g_running.store(false);
+    }
+    g_stopCv.notify_all();
+}
 
 // ̨źŴ
 BOOL WINAPI ConsoleHandler(DWORD signal)
 {
     if (signal == CTRL_C_EVENT || signal == CTRL_BREAK_EVENT || signal == CTRL_CLOSE_EVENT)
     {
-        g_running.store(false);
+        RequestStop();
         return TRUE;
     }
     return FALSE;
@@ -24,15 +39,16 @@ BOOL WINAPI ConsoleHandler(DWORD signal)
 // Զ֪ͨʵ
 class ServiceNotifier : public INotifier {
 public:
-    void Notify(const std::string& account, const std::string& instrument, double price, const std::string& message) override {
+    bool Notify(const std::string& account, const std::string& instrument, double price, const std::string& message) override {
         printf("[SERVICE ALERT] û=%s Լ=%s ۸=%.2f ԭ=%s\n",
             account.c_str(), instrument.c_str(), price, message.c_str());
         fflush(stdout);
+        return true;
     }
 };
 
 
-// ݿȡҪĵĺԼб
+// ݿȡҪĵĺԼбöʵʱֻȡʵĲ֣
 std::vector<std::string> LoadContractsFromDB()
 {
     std::vector<std::string> contracts;
@@ -40,13 +56,28 @@ std::vector<std::string> LoadContractsFromDB()
     try {
         sql::Connection* conn = GetConn();
         std::unique_ptr<sql::Connection> connPtr(conn);
+        std::string filter = CMduserHandler::GetHandler().PartitionFilter("symbol");
         std::unique_ptr<sql::PreparedStatement> stmt(
-            conn->prepareStatement("SELECT DISTINCT symbol FROM alert_order WHERE state=0")
+            conn->prepareStatement(std::string("SELECT DISTINCT symbol FROM alert_order WHERE state=0") +
+                (filter.empty() ? "" : " AND " + filter))
         );
         std::unique_ptr<sql::ResultSet> res(stmt->executeQuery());
 
         while (res->next()) {
-            contracts.push_back(res->getString("symbol"));
+            std::string symbol = res->getString("symbol");
+
+            // ۲/ȼԤҪȣǺϳƱ
+            std::string legA, legB;
+            char op;
+            if (ParseSyntheticSymbol(symbol, legA, legB, op)) {
+                for (const auto& leg : { legA, legB }) {
+                    if (std::find(contracts.begin(), contracts.end(), leg) == contracts.end())
+                        contracts.push_back(leg);
+                }
+            }
+            else if (std::find(contracts.begin(), contracts.end(), symbol) == contracts.end()) {
+                contracts.push_back(symbol);
+            }
         }
 
         printf("ݿ %zu Լ\n", contracts.size());
@@ -83,37 +114,100 @@ int StartMarketService() {
         // ʼ֪ͨ
         std::shared_ptr<EmailNotifierWrapper> emailWrapper =
             std::make_shared<EmailNotifierWrapper>(emailNotifier);
-        handler.SetNotifier(emailWrapper);
 
-        // ݿҪĵĺԼб
-        std::vector<std::string> contracts = LoadContractsFromDB();
+        // binlog ĵ user ֱӸ仺
+        handler.SetUserEmailSink([emailNotifier](const std::string& account, const std::string& email) {
+            emailNotifier->UpdateCachedEmail(account, email);
+            });
+
+        // ķֲͰȫ ->  -> ˻֪ͨӳٷ
+        Config& cfg = Config::Instance();
+        std::shared_ptr<NotifyRateLimiter> limiter = std::make_shared<NotifyRateLimiter>(
+            RateLimit{ cfg.rateGlobalPerSec, cfg.rateGlobalBurst },
+            RateLimit{ cfg.rateAccountPerSec, cfg.rateAccountBurst });
+        limiter->SetChannel("email", RateLimit{ cfg.rateEmailPerSec, cfg.rateEmailBurst });
+        limiter->SetChannel("webhook", RateLimit{ cfg.rateWebhookPerSec, cfg.rateWebhookBurst });
+        std::shared_ptr<INotifier> emailChannel = std::make_shared<RateLimitedNotifier>(
+            emailWrapper, "email", limiter, (size_t)cfg.rateMaxDeferred);
+
+        //  Webhook ʱʼͬʱ
+        if (!cfg.webhookUrls.empty()) {
+            WebhookNotifier::Options options;
+            std::stringstream urls(cfg.webhookUrls);
+            std::string url;
+            while (std::getline(urls, url, ',')) {
+                url.erase(0, url.find_first_not_of(" \t"));
+                url.erase(url.find_last_not_of(" \t") + 1);
+                if (!url.empty()) options.urls.push_back(url);
+            }
+            options.maxInFlight = cfg.webhookMaxInFlight;
+            options.connectTimeoutMs = cfg.webhookConnectTimeoutMs;
+            options.requestTimeoutMs = cfg.webhookRequestTimeoutMs;
+            options.maxRetries = cfg.webhookMaxRetries;
+
+            std::shared_ptr<CompositeNotifier> composite = std::make_shared<CompositeNotifier>();
+            composite->Add(emailChannel);
+            composite->Add(std::make_shared<RateLimitedNotifier>(
+                std::make_shared<WebhookNotifierWrapper>(std::make_shared<WebhookNotifier>(options)),
+                "webhook", limiter, (size_t)cfg.rateMaxDeferred));
+            handler.SetNotifier(composite);
+            printf(" Webhook ֪ͨ%zu  URL󲢷 %d\n", options.urls.size(), options.maxInFlight);
+            fflush(stdout);
+        }
+        else {
+            handler.SetNotifier(emailChannel);
+        }
+
+        // ǰãỰԼ߳ӡ¼ݿز
+        handler.connect();
+
+        // ʵȵǼǱʵȷ symbolļֻȡһ
+        handler.JoinCluster();
+
+        // мԤҪĵĺԼбԼԪ
+        std::future<void> alertsLoaded = std::async(std::launch::async, [&handler]() { handler.LoadAlerts(); });
+        std::future<void> metaLoaded = std::async(std::launch::async, [&handler]() { handler.RefreshInstrumentMeta(); });
+        std::future<std::vector<std::string>> contractsLoaded = std::async(std::launch::async, LoadContractsFromDB);
 
-        // ݿûкԼʹĬϺԼб
+        std::vector<std::string> contracts = contractsLoaded.get();
+
+        // ݿûкԼʹĬϺԼбʱֻȡʵģ
         if (contracts.empty()) {
             printf("ݿδҵԼʹĬϺԼб\n");
             contracts = {
                 "IF2512", "IH2512", "IC2512", "IM2512",
                 "TS2603", "TF2603", "T2603"
             };
+            contracts.erase(std::remove_if(contracts.begin(), contracts.end(),
+                [&handler](const std::string& s) { return !handler.OwnsSymbol(s); }), contracts.end());
         }
 
-        // Ӳ¼
-        handler.connect();
-        handler.login();
-
-        // ĺԼ
+        // Ԥڴٶģѵ¼ĻỰ·ڵ¼ɹʱ·
+        alertsLoaded.get();
+        metaLoaded.get();
         handler.subscribe(contracts);
 
         // Ԥ߳
         handler.StartAlertReloadThread();
 
+        // Ԥͽӿڣö˿ʱ
+        handler.StartAlertIntake();
+
+        //  binlog ģ ServerId ʱ reload ̲߳ѯ
+        handler.StartBinlogFeed();
+
         // ڶ߳м߼
         std::thread monitorThread([&handler]() {
-            while (g_running.load()) {
-                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            TuneCurrentThread("monitor", CpuMask(ParseCpuList(Config::Instance().threadServiceCpus)), false);
+
+            // ȴֹ֪ͣͨÿ 100ms ѯ
+            {
+                std::unique_lock<std::mutex> lk(g_stopMutex);
+                g_stopCv.wait(lk, []() { return !g_running.load(); });
             }
 
-            // ˳
+            // ˳ȴӳԱעʵ
+            handler.LeaveCluster();
             handler.unsubscribe();
             std::this_thread::sleep_for(std::chrono::milliseconds(200));
             });
@@ -129,5 +223,5 @@ int StartMarketService() {
 }
 
 void StopMarketService() {
-    g_running.store(false);
+    RequestStop();
 }
\ No newline at end of file
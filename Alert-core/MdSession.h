@@ -0,0 +1,684 @@
+﻿#pragma once
+#include "tradeapi/ThostFtdcMdApi.h"
+#include "ThreadTuning.h"
+#include <Windows.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <functional>
+#include <algorithm>
+#include <unordered_map>
+#include <cstring>
+
+// =========================================================
+// ===========   单个行情会话：一个 MdApi + 断线重登状态机   ===========
+// =========================================================
+//
+//   DISCONNECTED --OnFrontConnected--> CONNECTED --ReqUserLogin--> LOGGING_IN
+//   LOGGING_IN --登录成功--> LOGGED_IN --有订阅集合--> SUBSCRIBING --全部分批发出--> READY
+//   任意状态 --OnFrontDisconnected--> DISCONNECTED
+// CTP 会自行重连前置（随后再次 OnFrontConnected），这里负责重新登录和重新订阅。
+// 登录请求失败 / 登录被拒 / 订阅请求被拒（流控返回 -2、-3）都按指数退避 + 随机抖动重试；
+// 所有 ReqXXX 调用都在会话线程发出，不阻塞 SPI 回调线程。
+// 每个会话有独立的流文件目录和 SDK 回调线程，行情通过 TickHandler 交给上层。
+//
+// 传输方式：TCP（默认）、UDP、组播，对应 CreateFtdcMdApi 的 bIsUsingUdp / bIsMulticast。
+// 组播模式登录后查询一次组播合约表（ReqQryMulticastInstrument）并缓存；
+// UDP / 组播模式下若订阅完成后连续 quietFallbackMs 没有行情、且此时应当有行情（feedExpected，
+// 如交易时段内或其他会话仍在收到行情），释放当前 API 并以 TCP 重建会话；休市等整体无行情时只重新计时。
+// 回退后重新登录拿到新的交易日时，恢复为配置的传输方式。
+
+// ------------------------- 行情会话状态 -------------------------
+enum MdSessionState
+{
+    MD_DISCONNECTED = 0,
+    MD_CONNECTED,       // 前置已连接，等待发送登录
+    MD_LOGGING_IN,      // 登录请求已发出
+    MD_LOGGED_IN,       // 已登录，尚无订阅集合
+    MD_SUBSCRIBING,     // 正在分批订阅（可能处于退避等待）
+    MD_READY            // 订阅集合已全部发出
+};
+
+enum SessionAction
+{
+    SESSION_NONE = 0,
+    SESSION_LOGIN,
+    SESSION_QUERY_MULTICAST,    // 组播模式：登录后先查组播合约表，再订阅
+    SESSION_SUBSCRIBE,
+    SESSION_RESTORE_TRANSPORT   // 回退到 TCP 后进入新交易日：以配置的传输方式重建
+};
+
+enum MdTransport
+{
+    MD_TRANSPORT_TCP = 0,
+    MD_TRANSPORT_UDP,
+    MD_TRANSPORT_MULTICAST
+};
+
+// "tcp" / "udp" / "multicast"，无法识别时按 TCP
+inline MdTransport ParseMdTransport(const std::string& s)
+{
+    if (s == "udp" || s == "UDP") return MD_TRANSPORT_UDP;
+    if (s == "multicast" || s == "MULTICAST") return MD_TRANSPORT_MULTICAST;
+    return MD_TRANSPORT_TCP;
+}
+
+inline const char* MdTransportName(MdTransport t)
+{
+    return t == MD_TRANSPORT_UDP ? "udp" : t == MD_TRANSPORT_MULTICAST ? "multicast" : "tcp";
+}
+
+// 组播合约表中的一项
+struct MulticastInstrument
+{
+    int topicId{ 0 };
+    int instrumentNo{ 0 };
+    double codePrice{ 0.0 };
+    int volumeMultiple{ 0 };
+    double priceTick{ 0.0 };
+};
+
+struct SessionMetrics
+{
+    int recoveries;             // 断线后恢复行情的次数
+    double lastRecoveryMs;      // 最近一次 断线 -> 首个行情 耗时
+    double maxRecoveryMs;
+};
+
+struct MdSessionOptions
+{
+    std::string name;           // 日志前缀，如 "front0"
+    std::string front;          // 前置地址
+    std::string flowPath;       // CreateFtdcMdApi 的流文件目录（以 / 结尾，须已存在）
+    std::string brokerId;
+    std::string userId;
+    std::string password;
+    int backoffBaseMs{ 500 };
+    int backoffMaxMs{ 30000 };
+    int subscribeChunk{ 200 };
+
+    MdTransport transport{ MD_TRANSPORT_TCP };
+    int multicastTopicId{ 0 };      // 查询组播合约表时的主题号，0 为全部
+    int quietFallbackMs{ 10000 };   // UDP / 组播无行情多久后改用 TCP，<=0 不回退
+    std::string tcpFallbackFront;   // 回退时使用的 TCP 前置，空则沿用 front
+    // 静默达到 quietFallbackMs 时此刻是否应当有行情（会话线程持锁调用，只应读取无锁状态）；为空时总是回退
+    std::function<bool()> feedExpected;
+
+    int callbackCpu{ -1 };          // SDK 回调线程绑定的核，<0 不绑定
+    uint64_t serviceMask{ 0 };      // 会话线程允许运行的核，0 不限制
+    bool realtime{ false };         // SDK 回调线程提升为 TIME_CRITICAL
+};
+
+class MdSession : public CThostFtdcMdSpi
+{
+public:
+    // 在 SDK 回调线程调用；recvUs 为收到回调时的 steady 时钟（微秒）
+    using TickHandler = std::function<void(int index, const CThostFtdcDepthMarketDataField& d, int64_t recvUs)>;
+    // 登录成功、订阅完成时调用（持有会话锁，只应做通知，不得回调会话）
+    using StateHandler = std::function<void(int index, int state)>;
+
+    MdSession(int index, const MdSessionOptions& options, TickHandler onTick, StateHandler onState = nullptr)
+        : m_index(index), m_options(options), m_onTick(std::move(onTick)), m_onState(std::move(onState)),
+        m_rng(std::random_device{}()) {}
+
+    ~MdSession() { Stop(); }
+
+    int Index() const { return m_index; }
+    const std::string& Name() const { return m_options.name; }
+    const std::string& Front() const { return m_options.front; }
+    int State() const { return m_state.load(); }
+    MdTransport Transport() const { return m_transport.load(); }
+    bool IsLoggedIn() const { return m_isLoggedIn.load(); }
+    // 最近一次收到行情的 steady 时钟（微秒），0 为尚未收到
+    int64_t LastTickUs() const { return m_lastTickUs.load(std::memory_order_relaxed); }
+
+    void Start()
+    {
+        if (m_api) return;
+        m_transport = m_options.transport;
+        m_fallbackDay.clear();
+        m_api = CreateApi(m_options.transport, m_options.front);
+
+        // 登录与（重新）订阅都由会话线程发出，SPI 回调只推进状态
+        m_stop = false;
+        m_thread = std::thread([this]() { SessionLoop(); });
+
+        m_api->Init();
+    }
+
+    void Stop()
+    {
+        {
+            std::lock_guard<std::mutex> lk(m_mutex);
+            m_stop = true;
+        }
+        m_cv.notify_all();
+        if (m_thread.joinable())
+            m_thread.join();
+
+        if (m_api) {
+            m_api->RegisterSpi(nullptr);
+            m_api->Release();
+            m_api = nullptr;
+        }
+    }
+
+    // 设置订阅集合；已登录时立即（重新）订阅，否则登录成功后订阅
+    void SetInstruments(const std::vector<std::string>& instruments)
+    {
+        std::lock_guard<std::mutex> lk(m_mutex);
+        m_instruments = instruments;
+        m_instrumentCStrs.clear();
+        for (auto& s : m_instruments)
+            m_instrumentCStrs.push_back(const_cast<char*>(s.c_str()));
+        m_subscribeCursor = 0;
+        m_subscribeAttempts = 0;
+        if (m_state >= MD_LOGGED_IN && !m_instrumentCStrs.empty()) {
+            m_state = MD_SUBSCRIBING;
+            Schedule(SESSION_SUBSCRIBE, 0);
+        }
+    }
+
+    // 追加订阅合约（已在集合中的忽略）；已就绪时只订阅新增部分，已登录但集合原为空时从头订阅，
+    // 订阅进行中时由当前轮次一并带上
+    void AddInstruments(const std::vector<std::string>& instruments)
+    {
+        std::lock_guard<std::mutex> lk(m_mutex);
+        size_t before = m_instruments.size();
+        for (auto& s : instruments)
+            if (std::find(m_instruments.begin(), m_instruments.end(), s) == m_instruments.end())
+                m_instruments.push_back(s);
+        if (m_instruments.size() == before)
+            return;
+
+        // 追加可能使 string 搬家，指针数组整体重建
+        m_instrumentCStrs.clear();
+        for (auto& s : m_instruments)
+            m_instrumentCStrs.push_back(const_cast<char*>(s.c_str()));
+        if (m_state == MD_READY || m_state == MD_LOGGED_IN) {
+            m_subscribeCursor = m_state == MD_READY ? before : 0;
+            m_subscribeAttempts = 0;
+            m_state = MD_SUBSCRIBING;
+            // 组播模式登录后的合约表查询尚未发出时由它接着订阅，不能覆盖
+            if (m_action != SESSION_QUERY_MULTICAST)
+                Schedule(SESSION_SUBSCRIBE, 0);
+        }
+    }
+
+    // 从集合中移除并退订合约（不在集合中的忽略）；订阅进行中时剩余集合从头重新订阅（重复订阅无害）
+    void RemoveInstruments(const std::vector<std::string>& instruments)
+    {
+        std::lock_guard<std::mutex> lk(m_mutex);
+        std::vector<std::string> removed;
+        for (auto& s : instruments) {
+            auto it = std::find(m_instruments.begin(), m_instruments.end(), s);
+            if (it == m_instruments.end())
+                continue;
+            removed.push_back(s);
+            m_instruments.erase(it);
+        }
+        if (removed.empty())
+            return;
+
+        m_instrumentCStrs.clear();
+        for (auto& s : m_instruments)
+            m_instrumentCStrs.push_back(const_cast<char*>(s.c_str()));
+        if (m_state == MD_SUBSCRIBING)
+            m_subscribeCursor = 0;
+        if (m_api && m_state >= MD_LOGGED_IN) {
+            std::vector<char*> names;
+            for (auto& s : removed)
+                names.push_back(const_cast<char*>(s.c_str()));
+            m_api->UnSubscribeMarketData(names.data(), (int)names.size());
+        }
+    }
+
+    void Unsubscribe()
+    {
+        std::lock_guard<std::mutex> lk(m_mutex);
+        if (m_api && !m_instrumentCStrs.empty())
+            m_api->UnSubscribeMarketData(m_instrumentCStrs.data(), (int)m_instrumentCStrs.size());
+    }
+
+    SessionMetrics GetMetrics()
+    {
+        std::lock_guard<std::mutex> lk(m_mutex);
+        return m_metrics;
+    }
+
+    // 组播合约表每收齐一次加一，调用方据此判断是否需要重新读取
+    uint64_t MulticastTableVersion() const { return m_multicastVersion.load(); }
+
+    // 最近一次查询到的组播合约表（合约代码 -> 组播信息），非组播模式为空
+    std::unordered_map<std::string, MulticastInstrument> GetMulticastInstruments()
+    {
+        std::lock_guard<std::mutex> lk(m_mutex);
+        return m_multicastInstruments;
+    }
+
+    // ---------------- SPI 回调 ----------------
+
+    void OnFrontConnected() override
+    {
+        printf("[%s] OnFrontConnected: connected to front\n", Name().c_str());
+        fflush(stdout);
+
+        // SDK 回调线程由 MdApi 创建，只能在回调里绑核（重连、回退 TCP 后的新线程同样适用）
+        if (m_options.callbackCpu >= 0 || m_options.realtime)
+            TuneCurrentThread(Name().c_str(),
+                m_options.callbackCpu < 0 ? 0 : 1ULL << m_options.callbackCpu, m_options.realtime);
+
+        std::lock_guard<std::mutex> lk(m_mutex);
+        m_state = MD_CONNECTED;
+        m_loginAttempts = 0;
+        Schedule(SESSION_LOGIN, 0);
+    }
+
+    void OnFrontDisconnected(int nReason) override
+    {
+        m_isLoggedIn = false;
+        printf("[%s] OnFrontDisconnected: reason=%d\n", Name().c_str(), nReason);
+        fflush(stdout);
+
+        std::lock_guard<std::mutex> lk(m_mutex);
+        // 恢复前反复断线时保留最早的断线时间
+        if (!m_awaitFirstTick.load())
+            m_disconnectedAt = std::chrono::steady_clock::now();
+        m_awaitFirstTick = true;
+        m_state = MD_DISCONNECTED;
+        m_action = SESSION_NONE;
+    }
+
+    void OnRspUserLogin(CThostFtdcRspUserLoginField* pRspUserLogin,
+        CThostFtdcRspInfoField* pRspInfo,
+        int nRequestID, bool bIsLast) override
+    {
+        if (pRspInfo && pRspInfo->ErrorID != 0) {
+            printf("[%s] OnRspUserLogin failed: %d %s\n", Name().c_str(), pRspInfo->ErrorID,
+                pRspInfo->ErrorMsg ? pRspInfo->ErrorMsg : "");
+            fflush(stdout);
+            m_isLoggedIn = false;
+
+            std::lock_guard<std::mutex> lk(m_mutex);
+            if (m_state == MD_LOGGING_IN)
+                RetryLogin("ErrorID=" + std::to_string(pRspInfo->ErrorID));
+            return;
+        }
+
+        printf("[%s] OnRspUserLogin success. TradingDay=%s, LoginTime=%s\n", Name().c_str(),
+            pRspUserLogin && pRspUserLogin->TradingDay ? pRspUserLogin->TradingDay : "",
+            pRspUserLogin && pRspUserLogin->LoginTime ? pRspUserLogin->LoginTime : "");
+        fflush(stdout);
+        m_isLoggedIn = true;
+
+        std::lock_guard<std::mutex> lk(m_mutex);
+        m_loginAttempts = 0;
+        // 已回退到 TCP：交易日变化（前置日切后重新登录）时恢复配置的传输方式
+        std::string day = pRspUserLogin && pRspUserLogin->TradingDay ? pRspUserLogin->TradingDay : "";
+        if (m_transport != m_options.transport && !day.empty()) {
+            if (m_fallbackDay.empty()) {
+                m_fallbackDay = day;        // 回退时交易日未知，以回退后首次登录为准
+            }
+            else if (day != m_fallbackDay) {
+                Schedule(SESSION_RESTORE_TRANSPORT, 0);
+                return;
+            }
+        }
+        m_tradingDay = day;
+
+        // 已有订阅集合（断线重登，或订阅早于登录设置）时从头重新订阅
+        m_state = MD_LOGGED_IN;
+        if (!m_instrumentCStrs.empty()) {
+            m_state = MD_SUBSCRIBING;
+            m_subscribeCursor = 0;
+            m_subscribeAttempts = 0;
+        }
+        if (m_onState)
+            m_onState(m_index, m_state);
+        if (m_transport == MD_TRANSPORT_MULTICAST)
+            Schedule(SESSION_QUERY_MULTICAST, 0);
+        else if (m_state == MD_SUBSCRIBING)
+            Schedule(SESSION_SUBSCRIBE, 0);
+    }
+
+    // 组播合约表查询响应，收齐（bIsLast）后整体替换缓存
+    void OnRspQryMulticastInstrument(CThostFtdcMulticastInstrumentField* pMulticastInstrument,
+        CThostFtdcRspInfoField* pRspInfo,
+        int nRequestID, bool bIsLast) override
+    {
+        std::lock_guard<std::mutex> lk(m_mutex);
+        if (pRspInfo && pRspInfo->ErrorID != 0) {
+            printf("[%s] OnRspQryMulticastInstrument failed: %d %s\n", Name().c_str(), pRspInfo->ErrorID,
+                pRspInfo->ErrorMsg ? pRspInfo->ErrorMsg : "");
+            fflush(stdout);
+        }
+        else if (pMulticastInstrument) {
+            MulticastInstrument m;
+            m.topicId = pMulticastInstrument->TopicID;
+            m.instrumentNo = pMulticastInstrument->InstrumentNo;
+            m.codePrice = pMulticastInstrument->CodePrice;
+            m.volumeMultiple = pMulticastInstrument->VolumeMultiple;
+            m.priceTick = pMulticastInstrument->PriceTick;
+            m_multicastPending[pMulticastInstrument->InstrumentID] = m;
+        }
+
+        if (bIsLast) {
+            m_multicastInstruments.swap(m_multicastPending);
+            m_multicastPending.clear();
+            m_multicastVersion++;
+            printf("[%s] 组播合约表 %zu 项\n", Name().c_str(), m_multicastInstruments.size());
+            fflush(stdout);
+        }
+    }
+
+    // 订阅/退订的响应（只是打印确认）
+    void OnRspSubMarketData(CThostFtdcSpecificInstrumentField* pSpecificInstrument,
+        CThostFtdcRspInfoField* pRspInfo,
+        int nRequestID, bool bIsLast) override
+    {
+        if (pRspInfo && pRspInfo->ErrorID != 0) {
+            printf("[%s] OnRspSubMarketData failed: %d %s\n", Name().c_str(), pRspInfo->ErrorID,
+                pRspInfo->ErrorMsg ? pRspInfo->ErrorMsg : "");
+        }
+        else if (pSpecificInstrument) {
+            printf("[%s] OnRspSubMarketData success for %s\n", Name().c_str(), pSpecificInstrument->InstrumentID);
+        }
+        else {
+            printf("[%s] OnRspSubMarketData called (no instrument info)\n", Name().c_str());
+        }
+        fflush(stdout);
+    }
+
+    void OnRtnDepthMarketData(CThostFtdcDepthMarketDataField* d) override
+    {
+        if (!d) return;
+        int64_t recvUs = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+
+        m_lastTickUs.store(recvUs, std::memory_order_relaxed);
+        if (m_awaitFirstTick.load(std::memory_order_relaxed) && m_awaitFirstTick.exchange(false))
+            OnFirstTickAfterRecovery();
+
+        m_onTick(m_index, *d, recvUs);
+    }
+
+private:
+    CThostFtdcMdApi* CreateApi(MdTransport transport, const std::string& front)
+    {
+        CThostFtdcMdApi* api = CThostFtdcMdApi::CreateFtdcMdApi(m_options.flowPath.c_str(),
+            transport != MD_TRANSPORT_TCP, transport == MD_TRANSPORT_MULTICAST);
+        api->RegisterSpi(this);
+
+        printf("[%s] Connecting to market data server: %s (%s)\n",
+            Name().c_str(), front.c_str(), MdTransportName(transport));
+        fflush(stdout);
+
+        api->RegisterFront(const_cast<char*>(front.c_str()));
+        return api;
+    }
+
+    // 第 attempt 次重试的等待时间：delay = base * 2^(attempt-1)（不超过 max），再取 [delay/2, delay) 内随机值
+    int64_t BackoffMs(int attempt)
+    {
+        int64_t delay = m_options.backoffBaseMs;
+        for (int i = 1; i < attempt && delay < m_options.backoffMaxMs; ++i)
+            delay *= 2;
+        if (delay > m_options.backoffMaxMs)
+            delay = m_options.backoffMaxMs;
+        if (delay < 2)
+            return delay;
+        std::uniform_int_distribution<int64_t> dist(delay / 2, delay - 1);
+        return dist(m_rng);
+    }
+
+    // 需持有 m_mutex
+    void Schedule(int action, int64_t delayMs)
+    {
+        m_action = action;
+        m_actionAt = std::chrono::steady_clock::now() + std::chrono::milliseconds(delayMs);
+        m_cv.notify_all();
+    }
+
+    void SessionLoop()
+    {
+        if (m_options.serviceMask != 0)
+            TuneCurrentThread((Name() + "-session").c_str(), m_options.serviceMask, false);
+
+        std::unique_lock<std::mutex> lk(m_mutex);
+        while (!m_stop)
+        {
+            auto now = std::chrono::steady_clock::now();
+            auto wake = std::chrono::steady_clock::time_point::max();
+            if (m_action != SESSION_NONE)
+                wake = m_actionAt;
+
+            // UDP / 组播静默检测：订阅完成后（或最后一个 tick、最近一次重新计时后）quietFallbackMs 内没有新行情
+            bool watchQuiet = m_transport != MD_TRANSPORT_TCP && m_options.quietFallbackMs > 0 && m_state == MD_READY;
+            std::chrono::steady_clock::time_point quietAt;
+            if (watchQuiet) {
+                int64_t lastTickUs = m_lastTickUs.load(std::memory_order_relaxed);
+                int64_t readyUs = std::chrono::duration_cast<std::chrono::microseconds>(
+                    m_readyAt.time_since_epoch()).count();
+                quietAt = std::chrono::steady_clock::time_point(std::chrono::microseconds(
+                    (lastTickUs > readyUs ? lastTickUs : readyUs) + m_options.quietFallbackMs * 1000LL));
+                if (quietAt <= now) {
+                    if (!m_options.feedExpected || m_options.feedExpected()) {
+                        FallbackToTcp(lk);
+                        continue;
+                    }
+                    // 休市或各路行情都没有数据：不是这一路 UDP / 组播的问题，重新计时
+                    m_readyAt = now;
+                    quietAt = now + std::chrono::milliseconds(m_options.quietFallbackMs);
+                }
+                if (quietAt < wake) wake = quietAt;
+            }
+
+            if (now < wake) {
+                if (wake == std::chrono::steady_clock::time_point::max())
+                    m_cv.wait(lk);
+                else
+                    m_cv.wait_until(lk, wake);
+                continue;
+            }
+
+            int action = m_action;
+            m_action = SESSION_NONE;
+            if (action == SESSION_LOGIN)
+                DoLogin();
+            else if (action == SESSION_QUERY_MULTICAST)
+                DoQueryMulticast();
+            else if (action == SESSION_SUBSCRIBE)
+                DoSubscribe();
+            else if (action == SESSION_RESTORE_TRANSPORT)
+                RestoreTransport(lk);
+        }
+    }
+
+    // 释放 UDP / 组播 API，以 TCP 重建（传入时持有 m_mutex），本交易日内不再切回
+    void FallbackToTcp(std::unique_lock<std::mutex>& lk)
+    {
+        const std::string& front = m_options.tcpFallbackFront.empty() ? m_options.front : m_options.tcpFallbackFront;
+        printf("[%s] %s 行情 %d ms 无数据，改用 TCP 前置 %s\n", Name().c_str(),
+            MdTransportName(m_transport), m_options.quietFallbackMs, front.c_str());
+        fflush(stdout);
+        m_fallbackDay = m_tradingDay;
+        Rebuild(lk, MD_TRANSPORT_TCP, front);
+    }
+
+    // 回退后进入新的交易日：恢复配置的传输方式（仍无行情时会再次回退）
+    void RestoreTransport(std::unique_lock<std::mutex>& lk)
+    {
+        printf("[%s] 交易日已切换（回退于 %s），恢复 %s 行情 %s\n", Name().c_str(), m_fallbackDay.c_str(),
+            MdTransportName(m_options.transport), m_options.front.c_str());
+        fflush(stdout);
+        m_fallbackDay.clear();
+        Rebuild(lk, m_options.transport, m_options.front);
+    }
+
+    // 释放当前 API 并以指定传输方式重建（传入时持有 m_mutex）。
+    // Release 会等待 SDK 回调线程退出，而回调可能正在等 m_mutex，所以释放与 Init 期间先解锁。
+    void Rebuild(std::unique_lock<std::mutex>& lk, MdTransport transport, const std::string& front)
+    {
+        CThostFtdcMdApi* old = m_api;
+        m_api = nullptr;
+        m_transport = transport;
+        m_state = MD_DISCONNECTED;
+        m_action = SESSION_NONE;
+        m_isLoggedIn = false;
+
+        lk.unlock();
+        old->RegisterSpi(nullptr);
+        old->Release();
+        CThostFtdcMdApi* api = CreateApi(transport, front);
+        lk.lock();
+        m_api = api;
+        lk.unlock();
+        api->Init();
+        lk.lock();
+    }
+
+    // 需持有 m_mutex
+    void DoLogin()
+    {
+        if (m_state != MD_CONNECTED && m_state != MD_LOGGING_IN)
+            return;
+
+        CThostFtdcReqUserLoginField req = { 0 };
+        if (!m_options.brokerId.empty()) {
+            strcpy_s(req.BrokerID, m_options.brokerId.c_str());
+        }
+        if (!m_options.userId.empty()) {
+            strcpy_s(req.UserID, m_options.userId.c_str());
+        }
+        if (!m_options.password.empty()) {
+            strcpy_s(req.Password, m_options.password.c_str());
+        }
+
+        m_state = MD_LOGGING_IN;
+        int rt = m_api->ReqUserLogin(&req, ++m_reqId);
+        printf("[%s] ReqUserLogin returned: %d\n", Name().c_str(), rt);
+        fflush(stdout);
+
+        if (rt != 0)
+            RetryLogin("ReqUserLogin 返回 " + std::to_string(rt));
+    }
+
+    // 需持有 m_mutex
+    void RetryLogin(const std::string& why)
+    {
+        int64_t delay = BackoffMs(++m_loginAttempts);
+        printf("[%s] 登录失败（%s），%lld ms 后第 %d 次重试\n",
+            Name().c_str(), why.c_str(), (long long)delay, m_loginAttempts);
+        fflush(stdout);
+        Schedule(SESSION_LOGIN, delay);
+    }
+
+    // 查询组播合约表，随后继续订阅；查询失败不影响订阅（需持有 m_mutex）
+    void DoQueryMulticast()
+    {
+        if (m_state != MD_LOGGED_IN && m_state != MD_SUBSCRIBING)
+            return;
+
+        CThostFtdcQryMulticastInstrumentField req = { 0 };
+        req.TopicID = m_options.multicastTopicId;
+        int rt = m_api->ReqQryMulticastInstrument(&req, ++m_reqId);
+        if (rt != 0) {
+            printf("[%s] ReqQryMulticastInstrument returned: %d\n", Name().c_str(), rt);
+            fflush(stdout);
+        }
+
+        if (m_state == MD_SUBSCRIBING)
+            DoSubscribe();
+    }
+
+    // 从上次中断处继续分批订阅（需持有 m_mutex）
+    void DoSubscribe()
+    {
+        if (m_state != MD_SUBSCRIBING)
+            return;
+
+        size_t total = m_instrumentCStrs.size();
+        size_t chunk = m_options.subscribeChunk > 0 ? (size_t)m_options.subscribeChunk : total;
+
+        while (m_subscribeCursor < total)
+        {
+            int n = (int)std::min(chunk, total - m_subscribeCursor);
+            int rt = m_api->SubscribeMarketData(m_instrumentCStrs.data() + m_subscribeCursor, n);
+            if (rt != 0) {
+                int64_t delay = BackoffMs(++m_subscribeAttempts);
+                printf("[%s] SubscribeMarketData 返回 %d（从第 %zu/%zu 个合约起），%lld ms 后第 %d 次重试\n",
+                    Name().c_str(), rt, m_subscribeCursor + 1, total, (long long)delay, m_subscribeAttempts);
+                fflush(stdout);
+                Schedule(SESSION_SUBSCRIBE, delay);
+                return;
+            }
+            m_subscribeCursor += n;
+            m_subscribeAttempts = 0;
+        }
+
+        m_state = MD_READY;
+        m_readyAt = std::chrono::steady_clock::now();
+        printf("[%s] 已订阅 %zu 个合约（每批 %zu 个）\n", Name().c_str(), total, chunk);
+        fflush(stdout);
+        if (m_onState)
+            m_onState(m_index, MD_READY);
+    }
+
+    // 断线恢复后的第一个 tick：记录 断线 -> 首个行情 耗时
+    void OnFirstTickAfterRecovery()
+    {
+        std::lock_guard<std::mutex> lk(m_mutex);
+        double ms = std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - m_disconnectedAt).count();
+        m_metrics.recoveries++;
+        m_metrics.lastRecoveryMs = ms;
+        if (ms > m_metrics.maxRecoveryMs)
+            m_metrics.maxRecoveryMs = ms;
+        printf("[%s] 断线 -> 首个行情 %.1f ms（第 %d 次恢复，最长 %.1f ms）\n",
+            Name().c_str(), ms, m_metrics.recoveries, m_metrics.maxRecoveryMs);
+        fflush(stdout);
+    }
+
+    int m_index;
+    MdSessionOptions m_options;
+    TickHandler m_onTick;
+    StateHandler m_onState;
+    CThostFtdcMdApi* m_api{ nullptr };
+
+    // 订阅集合与状态机，均受 m_mutex 保护（m_state 另可无锁读取）
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::thread m_thread;
+    bool m_stop{ false };
+    std::atomic<int> m_state{ MD_DISCONNECTED };
+    std::atomic<bool> m_isLoggedIn{ false };
+    int m_action{ SESSION_NONE };
+    std::chrono::steady_clock::time_point m_actionAt;
+    int m_reqId{ 0 };
+    int m_loginAttempts{ 0 };
+    int m_subscribeAttempts{ 0 };
+    std::vector<std::string> m_instruments;
+    std::vector<char*> m_instrumentCStrs;
+    size_t m_subscribeCursor{ 0 };
+    std::mt19937_64 m_rng;
+
+    // 传输方式（回退后变为 TCP）、组播合约表、静默检测
+    std::atomic<MdTransport> m_transport{ MD_TRANSPORT_TCP };
+    std::unordered_map<std::string, MulticastInstrument> m_multicastInstruments;
+    std::atomic<uint64_t> m_multicastVersion{ 0 };
+    std::unordered_map<std::string, MulticastInstrument> m_multicastPending;
+    std::atomic<int64_t> m_lastTickUs{ 0 };
+    std::chrono::steady_clock::time_point m_readyAt;
+    std::string m_tradingDay;               // 最近一次登录的交易日
+    std::string m_fallbackDay;              // 回退到 TCP 时的交易日
+
+    std::atomic<bool> m_awaitFirstTick{ false };
+    std::chrono::steady_clock::time_point m_disconnectedAt;
+    SessionMetrics m_metrics{ 0, 0.0, 0.0 };
+};
@@ -1,7 +1,27 @@
 ﻿#pragma once
-#include "tradeapi/ThostFtdcMdApi.h"
+#include "MdSession.h"
+#include "TickFanIn.h"
 #include "EmailNotifier.h"
+#include "WebhookNotifier.h"
+#include "RateLimiter.h"
 #include "Config.h"
+#include "AlertRule.h"
+#include "Indicators.h"
+#include "InstrumentRegistry.h"
+#include "SyntheticGraph.h"
+#include "TriggerEvent.h"
+#include "TriggerOutbox.h"
+#include "TriggerLogSink.h"
+#include "NotificationDigest.h"
+#include "EvalWorkers.h"
+#include "AlertSnapshot.h"
+#include "AlertIntake.h"
+#include "BinlogClient.h"
+#include "AlertPartition.h"
+#include "TickBus.h"
+#include "TriggerBus.h"
+#include "TickValidator.h"
+#include "InstrumentMeta.h"
 #include <Windows.h>
 #include <stdio.h>
 #include <vector>
@@ -10,33 +30,109 @@
 #include <sstream>
 #include <memory>
 #include <mutex>
+#include <condition_variable>
 #include <unordered_map>
+#include <unordered_set>
+#include <set>
+#include <random>
 #include <atomic>
 #include <thread>
 #include <functional>
 #include <algorithm>
+#include <future>
 
 
 #include <mysql/jdbc.h>
 #include <cstdlib>
 #include <cstring>
+#include <cfloat>
+#include <cmath>
 using namespace std;
 
 
 
 // ------------------------- Notifier -------------------------
+// 返回通知是否发送成功，结果记入触发历史
 class INotifier {
 public:
-    virtual void Notify(const std::string& account, const std::string& instrument, double price, const std::string& message) = 0;
+    // 通知结果（NotifyResult）：每次 Send 恰好回调一次，可在 Send 返回前回调
+    typedef std::function<void(uint8_t result)> NotifyDone;
+
+    virtual bool Notify(const std::string& account, const std::string& instrument, double price, const std::string& message) = 0;
+
+    // 同一账户的一批触发（通知合并后调用），默认逐条发送；渠道可覆盖为一条摘要
+    virtual bool NotifyDigest(const std::string& account, const std::vector<TriggerEvent>& events) {
+        bool ok = true;
+        for (const auto& e : events)
+            ok = Notify(account, e.symbol, e.price, e.reason) && ok;
+        return ok;
+    }
+
+    // outbox 使用的接口：排队或异步发送的渠道覆盖，发出（或确定失败）后才回调；默认同步发送
+    virtual void Send(const TriggerEvent& e, NotifyDone done) {
+        done(Notify(e.account, e.symbol, e.price, e.reason) ? NOTIFY_OK : NOTIFY_FAILED);
+    }
+
+    virtual void SendDigest(const std::string& account, const std::vector<TriggerEvent>& events, NotifyDone done) {
+        done(NotifyDigest(account, events) ? NOTIFY_OK : NOTIFY_FAILED);
+    }
+
     virtual ~INotifier() = default;
+
+protected:
+    // 在同步接口中等待异步发送的结果（队列已满等非成功结果均按失败返回）
+    static bool WaitSent(const std::function<void(NotifyDone)>& send) {
+        std::shared_ptr<std::promise<uint8_t>> p = std::make_shared<std::promise<uint8_t>>();
+        std::future<uint8_t> f = p->get_future();
+        send([p](uint8_t result) { p->set_value(result); });
+        try {
+            return f.get() == NOTIFY_OK;
+        }
+        catch (const std::future_error&) {
+            return false;       // 退出时排队的通知被丢弃
+        }
+    }
+
+    // 把 n 个子结果汇总为一次回调：有失败即失败，否则有队列已满即 NOTIFY_BUSY
+    struct Gather
+    {
+        std::mutex mutex;
+        size_t remaining;
+        uint8_t result;
+        NotifyDone done;
+    };
+
+    static std::shared_ptr<Gather> MakeGather(size_t n, NotifyDone done) {
+        std::shared_ptr<Gather> g = std::make_shared<Gather>();
+        g->remaining = n;
+        g->result = NOTIFY_OK;
+        g->done = done;
+        return g;
+    }
+
+    static NotifyDone Part(std::shared_ptr<Gather> g) {
+        return [g](uint8_t r) {
+            uint8_t result;
+            {
+                std::lock_guard<std::mutex> lk(g->mutex);
+                if (r == NOTIFY_FAILED || (r == NOTIFY_BUSY && g->result == NOTIFY_OK))
+                    g->result = r;
+                if (--g->remaining > 0)
+                    return;
+                result = g->result;
+            }
+            g->done(result);
+        };
+    }
 };
 
 class ConsoleNotifier : public INotifier {
 public:
-    void Notify(const std::string& account, const std::string& instrument, double price, const std::string& message) override {
+    bool Notify(const std::string& account, const std::string& instrument, double price, const std::string& message) override {
         printf("[ALERT] 用户=%s 合约=%s 价格=%.2f 触发原因=%s\n",
             account.c_str(), instrument.c_str(), price, message.c_str());
         fflush(stdout);
+        return true;
     }
 };
 
@@ -47,14 +143,156 @@ private:
 public:
     EmailNotifierWrapper(std::shared_ptr<EmailNotifier> email) : email_notifier(email) {}
 
-    void Notify(const std::string& account, const std::string& instrument, double price, const std::string& message) override {
+    bool Notify(const std::string& account, const std::string& instrument, double price, const std::string& message) override {
         // 控制台输出
         printf("[ALERT] 用户=%s 合约=%s 价格=%.2f 触发原因=%s\n",
             account.c_str(), instrument.c_str(), price, message.c_str());
         fflush(stdout);
 
         // 发送邮件通知到用户邮箱
-        email_notifier->SendAlertEmail(account, instrument, price, message);
+        return email_notifier->SendAlertEmail(account, instrument, price, message);
+    }
+
+    // 多条触发合并为一封摘要邮件
+    bool NotifyDigest(const std::string& account, const std::vector<TriggerEvent>& events) override {
+        if (events.size() == 1)
+            return Notify(account, events[0].symbol, events[0].price, events[0].reason);
+
+        for (const auto& e : events) {
+            printf("[ALERT] 用户=%s 合约=%s 价格=%.2f 触发原因=%s\n",
+                account.c_str(), e.symbol.c_str(), e.price, e.reason.c_str());
+        }
+        fflush(stdout);
+        return email_notifier->SendDigestEmail(account, events);
+    }
+};
+
+class WebhookNotifierWrapper : public INotifier {
+private:
+    std::shared_ptr<WebhookNotifier> webhook_notifier;
+
+public:
+    WebhookNotifierWrapper(std::shared_ptr<WebhookNotifier> webhook) : webhook_notifier(webhook) {}
+
+    // 同步接口等待所有 URL 的最终结果
+    bool Notify(const std::string& account, const std::string& instrument, double price, const std::string& message) override {
+        TriggerEvent e;
+        e.account = account;
+        e.symbol = instrument;
+        e.price = price;
+        e.reason = message;
+        return WaitSent([this, &e](NotifyDone done) { Send(e, done); });
+    }
+
+    // 非阻塞：入队即返回，所有 URL 返回 2xx（或某个 URL 最终失败）后在网络线程中回调；队列已满时回调 NOTIFY_BUSY
+    void Send(const TriggerEvent& e, NotifyDone done) override {
+        bool queued = webhook_notifier->SendAlert(e.account, e.symbol, e.price, e.reason, [done](bool ok) {
+            done(ok ? NOTIFY_OK : NOTIFY_FAILED);
+        });
+        if (!queued)
+            done(webhook_notifier->HasEndpoints() ? NOTIFY_BUSY : NOTIFY_FAILED);
+    }
+
+    // 每条触发各 POST 一次
+    bool NotifyDigest(const std::string& account, const std::vector<TriggerEvent>& events) override {
+        return WaitSent([this, &account, &events](NotifyDone done) { SendDigest(account, events, done); });
+    }
+
+    void SendDigest(const std::string& account, const std::vector<TriggerEvent>& events, NotifyDone done) override {
+        if (events.empty()) { done(NOTIFY_OK); return; }
+        std::shared_ptr<Gather> g = MakeGather(events.size(), done);
+        for (const auto& e : events)
+            Send(e, Part(g));
+    }
+};
+
+// 限流：三层令牌桶任一不足时通知进入该渠道的延迟队列，实际发出后才回调结果；
+// 队列已满时回调 NOTIFY_BUSY，事件留在 outbox 稍后重试
+class RateLimitedNotifier : public INotifier {
+private:
+    std::shared_ptr<INotifier> channel;
+    std::unique_ptr<DeferredDispatcher> dispatcher;
+
+public:
+    RateLimitedNotifier(std::shared_ptr<INotifier> inner, const std::string& name,
+        std::shared_ptr<NotifyRateLimiter> limiter, size_t maxDeferred)
+        : channel(inner), dispatcher(new DeferredDispatcher(limiter, name, maxDeferred)) {}
+
+    // 先放开渠道：由延迟队列释放最后的引用，异步渠道在途请求的回调仍能访问 dispatcher
+    ~RateLimitedNotifier() {
+        channel.reset();
+        dispatcher.reset();
+    }
+
+    // 同步接口等待实际发出
+    bool Notify(const std::string& account, const std::string& instrument, double price, const std::string& message) override {
+        TriggerEvent e;
+        e.account = account;
+        e.symbol = instrument;
+        e.price = price;
+        e.reason = message;
+        return WaitSent([this, &e](NotifyDone done) { Send(e, done); });
+    }
+
+    bool NotifyDigest(const std::string& account, const std::vector<TriggerEvent>& events) override {
+        return WaitSent([this, &account, &events](NotifyDone done) { SendDigest(account, events, done); });
+    }
+
+    void Send(const TriggerEvent& e, NotifyDone done) override {
+        std::shared_ptr<INotifier> c = channel;
+        dispatcher->Submit(e.account, [c, e](NotifyDone d) {
+            c->Send(e, d);
+        }, done);
+    }
+
+    void SendDigest(const std::string& account, const std::vector<TriggerEvent>& events, NotifyDone done) override {
+        std::shared_ptr<INotifier> c = channel;
+        dispatcher->Submit(account, [c, account, events](NotifyDone d) {
+            c->SendDigest(account, events, d);
+        }, done);
+    }
+
+    DeferredDispatcher::Stats GetStats() {
+        return dispatcher->GetStats();
+    }
+};
+
+// 多渠道：依次通知每个渠道，全部成功才算成功（异步发送时汇总各渠道的回调）
+class CompositeNotifier : public INotifier {
+private:
+    std::vector<std::shared_ptr<INotifier>> channels;
+
+public:
+    void Add(std::shared_ptr<INotifier> channel) {
+        channels.push_back(channel);
+    }
+
+    bool Notify(const std::string& account, const std::string& instrument, double price, const std::string& message) override {
+        bool ok = true;
+        for (auto& c : channels)
+            ok = c->Notify(account, instrument, price, message) && ok;
+        return ok;
+    }
+
+    bool NotifyDigest(const std::string& account, const std::vector<TriggerEvent>& events) override {
+        bool ok = true;
+        for (auto& c : channels)
+            ok = c->NotifyDigest(account, events) && ok;
+        return ok;
+    }
+
+    void Send(const TriggerEvent& e, NotifyDone done) override {
+        if (channels.empty()) { done(NOTIFY_OK); return; }
+        std::shared_ptr<Gather> g = MakeGather(channels.size(), done);
+        for (auto& c : channels)
+            c->Send(e, Part(g));
+    }
+
+    void SendDigest(const std::string& account, const std::vector<TriggerEvent>& events, NotifyDone done) override {
+        if (channels.empty()) { done(NOTIFY_OK); return; }
+        std::shared_ptr<Gather> g = MakeGather(channels.size(), done);
+        for (auto& c : channels)
+            c->SendDigest(account, events, Part(g));
     }
 };
 
@@ -81,6 +319,20 @@ static sql::Connection* GetConn()
 }
 
 // ------------------------- 预警结构体 -------------------------
+enum AlertArmState : uint8_t
+{
+    ALERT_ARMED = 0,        // 已布防，满足条件即触发
+    ALERT_WAIT_REARM = 1    // 已触发，等待条件回撤出迟滞带后重新布防
+};
+
+// 可重复预警的运行期状态，只在 tick 路径修改，不回写 DB
+struct AlertRuntime
+{
+    uint8_t arm_state{ ALERT_ARMED };
+    int fire_count{ 0 };
+    int64_t last_fire_ms{ 0 };      // steady_clock 毫秒
+};
+
 struct AlertOrder
 {
     long orderId;
@@ -90,54 +342,291 @@ struct AlertOrder
     double min_price;
     string trigger_time;
     int state;
+    string rule;        // 表达式规则（可为空）
+    int repeat_max;     // <=1 一次性；N>1 最多触发 N 次；-1 不限次数
+    int cooldown_sec;   // 两次触发之间的最小间隔（秒）
+    double rearm_band;  // 价格需回撤超过该幅度才重新布防（迟滞带）
+    int priority;       // >0 高优先级：通知不等待合并窗口
+
+    // 以下字段在加载时预处理，tick 路径只读
+    time_t trigger_at{ 0 };                             // trigger_time 解析结果，0 表示未设置
+    shared_ptr<const CompiledRule> compiled_rule;       // rule 编译后的字节码
+
+    // 上下限、迟滞带与规则中的价格比较换算为定点整数，按 ticks_unit 缓存；
+    // 单位变化（如刚取得最小变动价位）时在判断线程重算
+    double ticks_unit{ 0.0 };
+    int64_t max_ticks{ 0 };
+    int64_t min_ticks{ 0 };
+    int64_t clear_max_ticks{ 0 };       // 回落到此以下重新布防
+    int64_t clear_min_ticks{ 0 };
+    vector<RulePriceBound> rule_bounds; // compiled_rule 的 RULE_OP_PRICE_CMP 边界（编译结果按文本共享，边界按预警保存）
+
+    AlertRuntime rt;
+
+    void PrepareTicks(double unit)
+    {
+        ticks_unit = unit;
+        max_ticks = TicksAtLeast(max_price, unit);
+        min_ticks = TicksAtMost(min_price, unit);
+        clear_max_ticks = TicksAtMost(max_price - rearm_band, unit);
+        clear_min_ticks = TicksAtLeast(min_price + rearm_band, unit);
+        if (compiled_rule)
+            compiled_rule->PrepareTicks(unit, rule_bounds);
+    }
+
+    // 本次触发后是否已达最大次数（需在 DB 标记 state=1 并移出内存）
+    bool Exhausted() const
+    {
+        return repeat_max >= 0 && rt.fire_count >= (repeat_max > 1 ? repeat_max : 1);
+    }
+};
+
+// ------------------------- 预警簿分片 -------------------------
+// 合约按 id % 分片数 分配到分片，每个分片只由一个线程判断：
+//   [Eval] Workers=0 —— 分片数 = 分区数，由本分区行情会话的 SDK 回调线程直接判断；
+//   [Eval] Workers=N —— 分片数 = N，每个分片一个判断线程，回调线程只负责把 tick 放进目标分片的 SPSC 队列。
+// 价差/比价预警存放在第一条腿所在的分片；另一条腿的 tick 也会投递到该分片，由它计算并判断。
+struct AlertShard
+{
+    unordered_map<string, vector<AlertOrder>> alertMap;
+    unordered_map<string, shared_ptr<IndicatorSet>> indicatorMap;    // 仅包含被规则引用的指标
+
+    // 触发过但未耗尽次数的预警的运行期状态（orderId -> 合约、状态），reload 时据此继承
+    unordered_map<long, pair<string, AlertRuntime>> runtime;
+
+    // 本分片已判断的最新 tick 时间（按合约 id），多前置的 tick 经不同队列到达时丢弃乱序的旧 tick
+    vector<double> lastTickTime = vector<double>(kMaxInstruments, NAN);
+
+    // 只由本分片的判断线程（及 reload 替换时）获取，没有争用
+    mutex mtx;
 };
 
+
 // =========================================================
 // =============      CMduserHandler 主体       =============
 // =========================================================
 
-class CMduserHandler : public CThostFtdcMdSpi {
+class CMduserHandler {
 private:
-    CThostFtdcMdApi* m_mdApi{ nullptr };
+    // 共享内存行情总线（[TickBus] Name 非空时启用），去重后的 tick 发布给本机其他进程；
+    // 由各会话回调线程写入，须在 m_sessions 之前声明以便晚于它析构
+    TickBusWriter m_tickBus;
 
-    vector<string> m_instruments;
-    vector<char*>  m_instrumentCStrs;
+    // 行情会话：每个前置 × 每个分区一个，下标 = 前置序号 * 分区数 + 分区序号；
+    // 同一分区在各前置上订阅相同合约，tick 经 m_fanIn 去重后进入预警判断
+    vector<unique_ptr<MdSession>> m_sessions;
+    unique_ptr<TickFanIn> m_fanIn{ make_unique<TickFanIn>() };
 
     std::shared_ptr<INotifier> m_notifier;
 
-    // 最新行情缓存
-    unordered_map<string, double> m_lastPrices;
-    mutex m_priceMutex;
+    // 合约 id 与最新行情缓存（按 id 的无锁价格表）
+    InstrumentRegistry m_registry;
+
+    // 合约元数据（最小变动价位、乘数、交易时段…），按 id 展开，行情路径无锁读取
+    InstrumentMetaStore m_instruments;
+    int64_t m_instrumentsLoadedMs{ 0 };     // 最近一次成功加载的本地时刻（Unix 毫秒），reload 线程访问
+    int64_t m_instrumentsRetryMs{ 0 };      // 加载失败后下次重试的 steady 时刻
+
+    // 从数据库加载的预警缓存，分片见 AlertShard
+    size_t m_partitions{ 1 };
+    vector<unique_ptr<AlertShard>> m_shards;
 
-    // 从数据库加载的预警缓存
-    unordered_map<string, vector<AlertOrder>> m_alertMap;
-    mutex m_alertMutex;
+    // 价差/比价依赖图（只读快照，reload 时整体替换，用 atomic_load/atomic_store 访问）
+    shared_ptr<const SyntheticGraph> m_synthetics{ make_shared<SyntheticGraph>() };
+
+    // 分片判断线程（[Eval] Workers > 0 时启用），须在 m_shards 之后声明以便先于它析构
+    EvalWorkerPool m_evalPool;
+
+    // 规则编译缓存与指标池，持有 m_bookWriteMutex 时访问
+    unordered_map<string, shared_ptr<const CompiledRule>> m_ruleCache;
+    IndicatorPool m_indicatorPool;
+    size_t m_reportedIndicatorBytes{ 0 };
+
+    // 触发历史（批量写入 alert_trigger_log），须在 m_outbox 之前声明以便晚于它析构
+    TriggerLogSink m_triggerLog;
+
+    // 按账户合并通知（窗口为 0 时不启用，逐条直接通知）
+    NotificationDigest m_digest;
+    bool m_digestEnabled{ false };
+
+    // 共享内存触发事件流（[TriggerBus] Name 非空时启用），由 outbox 投递线程写入，须在 m_outbox 之前声明以便晚于它析构
+    TriggerBusWriter m_triggerBus;
+
+    // 触发事件先落盘到 outbox，再由其后台线程通知并更新 DB
+    TriggerOutbox m_outbox;
+
+    // 行情校验与定点换算（各行情回调线程共用，无内部状态）
+    TickValidator m_tickValidator;
+    bool m_logTicks{ false };                       // [TickCheck] LogTicks
+    // 各会话已导入的组播合约表版本（reload 线程访问）
+    vector<uint64_t> m_multicastVersions;
 
     // 线程控制
     atomic<bool> m_runAlertReload{ false };
     thread m_reloadThread;
 
-    // 连接/登录 状态与请求 id
-    atomic<bool> m_isConnected{ false };
-    atomic<bool> m_isLoggedIn{ false };
-    int m_reqId{ 0 };
+    // 启动协调：会话登录 / 订阅完成、预警首次加载完成时唤醒等待者（替代 Sleep 轮询），并记录各阶段耗时
+    mutex m_startupMutex;
+    condition_variable m_startupCv;
+    int64_t m_connectUs{ 0 };
+    atomic<int64_t> m_firstLoginUs{ 0 };
+    atomic<int64_t> m_alertsLoadedUs{ 0 };
+    atomic<bool> m_alertsLoaded{ false };
+    bool m_startupReported{ false };
+
+    // 预警簿的写入方（DB 全量 / 增量同步、推送接口）互斥；m_orderSymbols 及规则缓存、指标池、合成依赖图的修改都在锁内
+    mutex m_bookWriteMutex;
+    unordered_map<long, string> m_orderSymbols;     // orderId -> 所在 symbol，增量写入据此移除旧版本
+    bool m_bookFetching{ false };                   // DB 查询进行中：推送的变更同时记入 m_pushJournal
+    vector<pair<AlertOrder, bool>> m_pushJournal;   // 查询期间推送 / binlog 的 (预警, 是否保留)，结果安装后按顺序重放
+
+    // 预警推送接口（[Intake] Port > 0 时启用）
+    AlertIntakeServer m_intake;
+
+    // binlog 变更订阅（[Binlog] ServerId > 0 时启用）；接收正常时 reload 线程只做定期全量对账
+    BinlogClient m_binlog;
+    atomic<bool> m_fullReloadRequested{ false };
+    function<void(const string& account, const string& email)> m_userEmailSink;
+
+    // 已订阅合约；首次 subscribe() 之后新出现的合约由 EnsureSubscribed 追加订阅
+    mutex m_subscribeMutex;
+    unordered_set<string> m_subscribed;
+    bool m_subscribeStarted{ false };
+
+    // 多实例分区（[Cluster] Self 非空时启用）：当前负责的哈希区间，交接期间为新旧区间的并集
+    // 各写入方与合约加载据此过滤；只在启动线程和 reload 线程中替换
+    shared_ptr<const PartitionSet> m_owned{ make_shared<PartitionSet>() };
+    PartitionSet m_partitionTarget;                 // 按最新成员列表计算的区间
+    int64_t m_partitionChangedMs{ 0 };              // 成员列表最近一次变化（steady 毫秒）
+
+    // 触发认领（[Claim] Table 非空时启用）：实例名、每批认领的唯一 token（高位随机 + 序号，只由投递线程递增）
+    string m_claimOwner;
+    int64_t m_claimTokenBase{ 0 };
+    int64_t m_claimSeq{ 0 };
+    atomic<uint64_t> m_claimWon{ 0 };
+    atomic<uint64_t> m_claimLost{ 0 };
+    atomic<uint64_t> m_claimTakenOver{ 0 };
+    int64_t m_lastClaimPurgeMs{ 0 };                // 只由 reload 线程访问
+
+    // 快照与增量水位（除 m_bookValid 外只由 reload 线程访问；启动时的 LoadAlerts 先于 reload 线程执行）
+    int64_t m_deltaWatermarkMs{ 0 };                // 已同步到的 DB 时间（Unix 毫秒）
+    int64_t m_lastFullReloadMs{ 0 };                // 上次全量加载（steady 毫秒），0 表示尚未全量加载
+    bool m_bookFromSnapshot{ false };
+    atomic<bool> m_bookValid{ false };              // 预警簿来自成功的加载，才允许写快照
 
 public:
+    static CMduserHandler& GetHandler()
+    {
+        static CMduserHandler instance;
+        return instance;
+    }
 
     CMduserHandler()
     {
         m_notifier = make_shared<ConsoleNotifier>();
         // 加载配置（默认从 config.ini 或环境变量）
         Config::Instance().Load();
+        Config& cfg = Config::Instance();
+
+        m_partitions = cfg.mdPartitions < 1 ? 1 : (cfg.mdPartitions > 32 ? 32 : cfg.mdPartitions);
+        int workers = cfg.evalWorkers < 0 ? 0 : (cfg.evalWorkers > 32 ? 32 : cfg.evalWorkers);
+        size_t shards = workers > 0 ? (size_t)workers : m_partitions;
+        for (size_t i = 0; i < shards; ++i)
+            m_shards.push_back(make_unique<AlertShard>());
+
+        m_triggerLog.Start([]() { return GetConn(); }, cfg.triggerLogBatchSize, cfg.triggerLogLingerMs);
+        m_tickValidator.Configure(cfg.tickMaxAgeSec);
+        m_logTicks = cfg.tickLog != 0;
+
+        if (!cfg.tickBusName.empty() && !m_tickBus.Open(cfg.tickBusName, (uint32_t)max(cfg.tickBusCapacity, 1))) {
+            printf("[TICKBUS] 行情总线不可用，仅在本进程内判断\n");
+            fflush(stdout);
+        }
+        if (!cfg.triggerBusName.empty() && !m_triggerBus.Open(cfg.triggerBusName, (uint32_t)max(cfg.triggerBusCapacity, 1))) {
+            printf("[TRIGGERBUS] 触发事件流不可用，下游需改为查询 DB\n");
+            fflush(stdout);
+        }
+
+        m_digestEnabled = cfg.digestWindowMs > 0;
+        if (m_digestEnabled) {
+            m_digest.Start(cfg.digestWindowMs, cfg.digestMaxItems,
+                [this](const string& account, const vector<TriggerEvent>& events, NotificationDigest::FlushDone done) {
+                    m_notifier->SendDigest(account, events, done);
+                },
+                [this](const TriggerEvent& e, uint8_t result) {
+                    // 逐条送回 outbox：成功的确认，失败的退避后重新进入合并窗口
+                    m_outbox.CompleteNotify(e.seq, result);
+                });
+        }
+
+        // 多实例同时判断同一批预警时，先在 DB 认领再通知；需在 Open() 之前设置
+        bool claims = !cfg.claimTable.empty();
+        if (claims) {
+            m_claimOwner = cfg.clusterSelf.empty() ? ComputerName() : cfg.clusterSelf;
+            std::random_device rd;
+            m_claimTokenBase = (int64_t)((((uint64_t)rd() << 32) | rd()) & 0x7FFFFFFF00000000ULL);
+            m_outbox.SetClaimHandlers(
+                [this](const vector<TriggerEvent*>& events, vector<uint8_t>& results) {
+                    ClaimTriggers(events, results);
+                },
+                [this](const TriggerEvent& e) {
+                    return ConfirmTriggerClaim(e);
+                },
+                [this](const TriggerEvent& e) {
+                    return ReleaseTriggerClaim(e);
+                });
+            printf("[CLAIM] 已启用触发认领：实例 %s，认领表 %s，租约 %d 秒\n",
+                m_claimOwner.c_str(), cfg.claimTable.c_str(), cfg.claimLeaseSec);
+            fflush(stdout);
+        }
+
+        // 恢复上次未完成的触发事件并启动投递线程
+        if (!m_outbox.Open(cfg.outboxPath)) {
+            printf("[OUTBOX ERROR] outbox 不可用，触发事件不具备崩溃保护\n");
+            fflush(stdout);
+        }
+        m_outbox.Start(
+            [this](const TriggerEvent& e) {
+                // 已认领（启用认领时）、即将通知的触发交给下游进程；重放的事件由下游按 (orderId, fireSeq) 去重
+                if (m_triggerBus.IsOpen())
+                    m_triggerBus.Publish(e);
+                // 合并窗口内的触发由 m_digest 稍后统一发送，发送结果经 CompleteNotify 送回；
+                // 送回之前事件在 outbox 中保持未确认，窗口期间进程崩溃时重启后重发
+                if (m_digestEnabled) {
+                    m_digest.Submit(e);
+                    return (uint8_t)NOTIFY_PENDING;
+                }
+                // 限流排队的通知实际发出后才送回结果；失败时由 outbox 退避重试，
+                // 最终结果（成功或放弃）经下面的回调记入历史
+                uint64_t seq = e.seq;
+                m_notifier->Send(e, [this, seq](uint8_t result) {
+                    m_outbox.CompleteNotify(seq, result);
+                });
+                return (uint8_t)NOTIFY_PENDING;
+            },
+            [this, claims](const TriggerEvent& e) {
+                return claims ? MarkClaimNotified(e) : MarkAlertTriggered(e.orderId);
+            },
+            [this](const TriggerEvent& e, bool ok) {
+                m_triggerLog.Record(e, ok, WallMs() - e.detectMs);
+            });
     }
 
     ~CMduserHandler()
     {
+        // 先停行情会话，不再产生新的触发
+        for (auto& session : m_sessions)
+            session->Stop();
+        m_intake.Stop();
+        m_binlog.Stop();
+        m_evalPool.Stop();
         StopAlertReloadThread();
-        if (m_mdApi) {
-            m_mdApi->Release();
-            m_mdApi = nullptr;
-        }
+        SaveSnapshot();
+        m_outbox.Stop();
+        m_digest.Stop();
+        // 释放通知渠道（等待在途的异步通知结束），它们的完成回调会访问 outbox 与 digest
+        m_notifier.reset();
+        m_triggerLog.Stop();
     }
 
     void SetNotifier(shared_ptr<INotifier> n)
@@ -145,6 +634,12 @@ public:
         m_notifier = n;
     }
 
+    // binlog 中 user 表的变更（邮箱为空表示删除）交给邮件通知的邮箱缓存
+    void SetUserEmailSink(function<void(const string& account, const string& email)> sink)
+    {
+        m_userEmailSink = sink;
+    }
+
     // =====================================================
     // =============== 1. 启动/停止 DB 预警加载线程 ============
     // =====================================================
@@ -152,14 +647,119 @@ public:
     {
         m_runAlertReload = true;
         m_reloadThread = thread([this]() {
+            TuneCurrentThread("reload", CpuMask(ParseCpuList(Config::Instance().threadServiceCpus)), false);
+            int64_t lastFanInReport = SteadyMs();
+            int64_t lastSnapshot = SteadyMs();
+            // 启动时已由 LoadAlerts 从 DB 加载过则从下一轮开始；从快照恢复的立即与 DB 对账
+            bool loadNow = !m_alertsLoaded.load() || m_bookFromSnapshot;
             while (m_runAlertReload.load())
             {
-                ReloadAlertsFromDB();
+                // 分区归属变化后立即全量加载，收缩时再退订不再负责的合约
+                bool repartitioned = loadNow && RefreshCluster();
+                if (repartitioned)
+                    m_fullReloadRequested = true;
+                if (loadNow)
+                    SyncAlertsFromDB();
+                if (repartitioned)
+                    ReleaseUnownedSubscriptions();
+                if (!Config::Instance().claimTable.empty())
+                    TakeOverExpiredClaims();
+                ImportMulticastInstruments();
+                if (InstrumentMetaDue())
+                    RefreshInstrumentMeta();
+                m_instruments.Sync(m_registry);
+                loadNow = true;
                 this_thread::sleep_for(chrono::seconds(3));
+
+                int intervalSec = Config::Instance().snapshotIntervalSec;
+                if (intervalSec > 0 && SteadyMs() - lastSnapshot >= intervalSec * 1000LL) {
+                    lastSnapshot = SteadyMs();
+                    SaveSnapshot();
+                }
+
+                // 每分钟输出一次各前置的首达占比与落后分布（多前置时）、各判断线程的处理量
+                if (SteadyMs() - lastFanInReport >= 60000) {
+                    lastFanInReport = SteadyMs();
+                    m_tickValidator.Report();
+                    m_fanIn->Report();
+                    if (m_evalPool.Running())
+                        m_evalPool.Report();
+                    if (m_intake.Running())
+                        m_intake.Report();
+                    if (m_tickBus.IsOpen())
+                        m_tickBus.Report();
+                    if (m_triggerBus.IsOpen())
+                        m_triggerBus.Report();
+                    if (Config::Instance().binlogServerId > 0)
+                        m_binlog.Report();
+                    if (!Config::Instance().claimTable.empty()) {
+                        printf("[CLAIM] 认领成功 %llu，被其他实例认领 %llu，接管过期认领 %llu\n",
+                            (unsigned long long)m_claimWon.exchange(0), (unsigned long long)m_claimLost.exchange(0),
+                            (unsigned long long)m_claimTakenOver.exchange(0));
+                        fflush(stdout);
+                    }
+                }
             }
             });
     }
 
+    // 首次加载预警（启动时与连接前置、登录并行执行），完成后才下发订阅，保证首个 tick 到达时预警已在内存
+    // 有可用快照时直接从快照恢复，并先做一次增量同步（已配置 DeltaColumn 时），全量对账交给 reload 线程
+    void LoadAlerts()
+    {
+        if (LoadSnapshot()) {
+            if (m_lastFullReloadMs > 0)
+                DeltaSyncFromDB();
+        }
+        else {
+            ReloadAlertsFromDB();
+        }
+        m_alertsLoadedUs = SteadyUs();
+        {
+            lock_guard<mutex> lk(m_startupMutex);
+            m_alertsLoaded = true;
+        }
+        m_startupCv.notify_all();
+    }
+
+    // 启动预警推送接口（[Intake] Port 为 0 时不启用），在首次加载与订阅之后调用
+    void StartAlertIntake()
+    {
+        Config& cfg = Config::Instance();
+        if (cfg.intakePort <= 0)
+            return;
+        m_intake.Start(cfg.intakeBind, cfg.intakePort,
+            [this](const vector<IntakeCommand>& batch, vector<string>& errors) {
+                ApplyIntakeBatch(batch, errors);
+            });
+    }
+
+    // 启动 binlog 变更订阅（[Binlog] ServerId 为 0 时不启用），在首次加载之后调用
+    void StartBinlogFeed()
+    {
+        Config& cfg = Config::Instance();
+        if (cfg.binlogServerId <= 0)
+            return;
+        BinlogClient::Options o;
+        o.host = cfg.dbHost;
+        o.port = cfg.dbPort;
+        o.user = cfg.binlogUser.empty() ? cfg.dbUser : cfg.binlogUser;
+        o.password = cfg.binlogUser.empty() ? cfg.dbPassword : cfg.binlogPassword;
+        o.schema = cfg.dbSchema;
+        o.tables = { "alert_order", "user" };
+        o.serverId = (uint32_t)cfg.binlogServerId;
+        o.heartbeatSec = cfg.binlogHeartbeatSec;
+        m_binlog.Start(o,
+            [this](const string& table, bool deleted, const vector<BinlogRow>& rows) {
+                OnBinlogRows(table, deleted, rows);
+            },
+            [this](bool resumed) {
+                // 从当前位置新开始时，此前的变更可能遗漏，由 reload 线程立即全量对账
+                if (!resumed)
+                    m_fullReloadRequested = true;
+            });
+    }
+
     void StopAlertReloadThread()
     {
         m_runAlertReload = false;
@@ -168,354 +768,1929 @@ public:
     }
 
     // ===================== 从数据库读取预警单 =====================
+    // 配置了 [Reload] DeltaColumn 时平时只拉取变更行，每 FullReloadSec 秒做一次全量对账（捕获被删除的行）
+    void SyncAlertsFromDB()
+    {
+        Config& cfg = Config::Instance();
+
+        // binlog 新开始订阅、分区归属变化、快照来自分区之前的归属时要求全量加载
+        bool full = m_fullReloadRequested.exchange(false);
+
+        // binlog 接收正常：变更已实时应用，只在要求时及每 FullReloadSec 秒全量对账
+        if (m_binlog.Streaming()) {
+            bool due = full ||
+                (cfg.reloadFullSec > 0 && SteadyMs() - m_lastFullReloadMs >= cfg.reloadFullSec * 1000LL);
+            if (due)
+                ReloadAlertsFromDB();
+            return;
+        }
+
+        bool delta = !full && !cfg.reloadDeltaColumn.empty() && m_lastFullReloadMs > 0 &&
+            (cfg.reloadFullSec <= 0 || SteadyMs() - m_lastFullReloadMs < cfg.reloadFullSec * 1000LL);
+        if (delta)
+            DeltaSyncFromDB();
+        else
+            ReloadAlertsFromDB();
+    }
+
+    // 先读出全部行再持锁安装，DB 查询期间推送接口不被阻塞；启用分区时只查询本实例负责的 symbol
     void ReloadAlertsFromDB()
     {
+        vector<AlertOrder> rows;
+        int64_t dbNow = 0;
+        BeginBookFetch();
         try {
             unique_ptr<sql::Connection> conn(GetConn());
+            bool delta = !Config::Instance().reloadDeltaColumn.empty();
+            dbNow = delta ? QueryDbNowMs(*conn) : 0;
+
+            string filter = PartitionFilter("symbol");
             unique_ptr<sql::PreparedStatement> stmt(
-                conn->prepareStatement(
-                    "SELECT orderId, account, symbol, max_price, min_price, trigger_time, state "
-                    "FROM alert_order WHERE state=0"
-                )
+                conn->prepareStatement(string("SELECT ") + kAlertColumns + " FROM alert_order WHERE state=0" +
+                    (filter.empty() ? "" : " AND " + filter))
             );
             unique_ptr<sql::ResultSet> res(stmt->executeQuery());
-
-            unordered_map<string, vector<AlertOrder>> tmp;
-
             while (res->next())
             {
-                AlertOrder a;
-                a.orderId = res->getInt("orderId");
-                a.account = res->getString("account");
-                a.symbol = res->getString("symbol");
-                a.max_price = res->getDouble("max_price");
-                a.min_price = res->getDouble("min_price");
-                a.trigger_time = res->getString("trigger_time");  // 加载时间字段
-                a.state = res->getInt("state");
-
-                tmp[a.symbol].push_back(a);
+                rows.emplace_back();
+                ReadAlertRow(*res, rows.back());
             }
-
-            lock_guard<mutex> lk(m_alertMutex);
-            m_alertMap.swap(tmp);
         }
         catch (sql::SQLException& e) {
             printf("[DB ERROR] ReloadAlerts: %s\n", e.what());
             fflush(stdout);
+            lock_guard<mutex> lk(m_bookWriteMutex);
+            m_bookFetching = false;
+            m_pushJournal.clear();
+            return;
+        }
+
+        vector<string> symbols;
+        {
+            lock_guard<mutex> lk(m_bookWriteMutex);
+            unordered_map<string, vector<AlertOrder>> tmp;
+            unordered_map<string, shared_ptr<const CompiledRule>> usedRules;
+            auto synthetics = make_shared<SyntheticGraph>();
+            unordered_map<string, shared_ptr<IndicatorSet>> indicators;
+
+            m_indicatorPool.Prune();
+
+            for (auto& a : rows)
+            {
+                if (!PrepareAlert(a, usedRules, *synthetics, indicators))
+                    continue;
+                tmp[a.symbol].push_back(std::move(a));
+            }
+
+            // 只保留本轮仍被引用的规则
+            m_ruleCache.swap(usedRules);
+            ReportIndicatorMemory(indicators);
+
+            for (const auto& kv : tmp)
+                symbols.push_back(kv.first);
+            InstallAlertBook(tmp, indicators, synthetics, false);
+            ReplayPushJournal();
+            m_lastFullReloadMs = SteadyMs();
+            m_deltaWatermarkMs = dbNow;
+            m_bookValid = true;
         }
+        // 分区扩大后接手的合约在这里追加订阅
+        EnsureSubscribed(symbols);
     }
 
-    // ===================== 更新数据库状态（触发预警） =====================
-    void MarkAlertTriggered(long orderId)
+    // 增量同步：读取 DeltaColumn >= 水位 - kDeltaOverlapMs 的所有行（含 state!=0），逐条替换或移除
+    // 同一行重复应用结果不变，因此水位往前多取一段，覆盖提交时间晚于变更时间的事务
+    void DeltaSyncFromDB()
     {
+        const string& column = Config::Instance().reloadDeltaColumn;
+        vector<AlertOrder> rows;
+        int64_t dbNow = 0;
+        BeginBookFetch();
         try {
             unique_ptr<sql::Connection> conn(GetConn());
+            dbNow = QueryDbNowMs(*conn);
+
             unique_ptr<sql::PreparedStatement> stmt(
-                conn->prepareStatement("UPDATE alert_order SET state=1 WHERE orderId=?")
+                conn->prepareStatement(string("SELECT ") + kAlertColumns + " FROM alert_order WHERE "
+                    + column + " >= FROM_UNIXTIME(? / 1000)")
             );
-            stmt->setInt(1, orderId);
-            stmt->execute();
+            stmt->setInt64(1, m_deltaWatermarkMs - kDeltaOverlapMs);
+            unique_ptr<sql::ResultSet> res(stmt->executeQuery());
+            while (res->next())
+            {
+                rows.emplace_back();
+                ReadAlertRow(*res, rows.back());
+            }
         }
-        catch (...) {
-            printf("[DB ERROR] 更新预警状态失败\n");
+        catch (sql::SQLException& e) {
+            // 可能是列不存在或连接中断：下一轮改做全量加载
+            printf("[DB ERROR] DeltaSync: %s\n", e.what());
             fflush(stdout);
+            m_lastFullReloadMs = 0;
+            lock_guard<mutex> lk(m_bookWriteMutex);
+            m_bookFetching = false;
+            m_pushJournal.clear();
+            return;
         }
-    }
-
-    // =====================================================
-    // =============== 2. 行情 API 相关（你原来就有） ==========
-    // =====================================================
-    void connect()
-    {
-        if (m_mdApi) return;
-        m_mdApi = CThostFtdcMdApi::CreateFtdcMdApi();
-        m_mdApi->RegisterSpi(this);
-
-        // 使用配置中的地址
-        Config& cfg = Config::Instance();
-        std::string addrStr = cfg.mdAddress;
-        printf("Connecting to market data server: %s\n", addrStr.c_str());
-        fflush(stdout);
-
-        m_mdApi->RegisterFront(const_cast<char*>(addrStr.c_str()));
-        m_mdApi->Init();
-        printf("Market data API initialized\n");
-        fflush(stdout);
 
-        // 不在这里直接调用 ReqUserLogin，改在 OnFrontConnected 中处理。
-    }
+        unordered_set<long> pending;
+        for (const auto& p : m_outbox.PendingFinalOrders())
+            pending.insert(p.first);
 
-    // 仍保留 login 接口：如果外部调用，会等待登录成功（最长等待若干秒）
-    void login(int timeoutSeconds = 10)
-    {
-        int waited = 0;
-        while (!m_isLoggedIn.load() && waited < timeoutSeconds * 10)
+        vector<string> symbols;
+        size_t upserted = 0, removed = 0;
         {
-            Sleep(100);
-            waited++;
+            lock_guard<mutex> lk(m_bookWriteMutex);
+            // 出现新的合成合约时复制一份依赖图再修改，结束后整体替换
+            shared_ptr<SyntheticGraph> graph;
+            for (auto& a : rows)
+            {
+                bool keep = a.state == 0 && !pending.count(a.orderId) && OwnsSymbol(a.symbol) &&
+                    PrepareDeltaAlert(a, graph);
+                if (keep)
+                    symbols.push_back(a.symbol);
+                if (ApplyAlertDelta(a, keep)) {
+                    if (keep) upserted++;
+                    else removed++;
+                }
+            }
+            if (graph)
+                std::atomic_store(&m_synthetics, shared_ptr<const SyntheticGraph>(graph));
+            ReplayPushJournal();
         }
+        m_deltaWatermarkMs = dbNow;
+        EnsureSubscribed(symbols);
 
-        if (m_isLoggedIn.load()) {
-            printf("Login successful (confirmed)\n");
-            fflush(stdout);
-        }
-        else {
-            printf("Login not confirmed within timeout\n");
+        if (upserted || removed) {
+            printf("[DELTA] 同步 %zu 条变更，移除 %zu 条\n", upserted, removed);
             fflush(stdout);
         }
     }
 
-    void subscribe(const vector<string>& contracts)
+    // ===================== 预警推送接口 =====================
+    // 一批推送命令（在推送线程调用）：与 DB 同步共用 m_bookWriteMutex，按顺序逐条替换 / 移除
+    // DB 查询进行中时同时记入 m_pushJournal，查询结果安装后重放，避免较旧的 DB 行覆盖较新的推送
+    void ApplyIntakeBatch(const vector<IntakeCommand>& batch, vector<string>& errors)
     {
-        // 等待登录确认（简单等待，避免在未登录前订阅）
-        int waited = 0;
-        while (!m_isLoggedIn.load() && waited < 50) // 5 秒
-        {
-            Sleep(100);
-            waited++;
-        }
+        unordered_set<long> pending;
+        for (const auto& p : m_outbox.PendingFinalOrders())
+            pending.insert(p.first);
 
-        if (!m_isLoggedIn.load()) {
-            printf("Warning: subscribe called before login confirmed\n");
-            fflush(stdout);
+        vector<string> symbols;
+        {
+            lock_guard<mutex> lk(m_bookWriteMutex);
+            shared_ptr<SyntheticGraph> graph;
+            for (size_t i = 0; i < batch.size(); ++i)
+            {
+                const IntakeCommand& cmd = batch[i];
+                AlertOrder a;
+                a.orderId = cmd.orderId;
+                a.account = cmd.account;
+                a.symbol = cmd.symbol;
+                a.max_price = cmd.maxPrice;
+                a.min_price = cmd.minPrice;
+                a.trigger_time = cmd.triggerTime;
+                a.state = 0;
+                a.rule = cmd.rule;
+                a.repeat_max = cmd.repeatMax;
+                a.cooldown_sec = cmd.cooldownSec;
+                a.rearm_band = cmd.rearmBand;
+                a.priority = cmd.priority;
+
+                // 不属于本实例的预警按删除处理（后台可以把同一推送发给所有实例）
+                bool keep = cmd.op == IntakeCommand::INTAKE_UPSERT && OwnsSymbol(a.symbol);
+                if (keep && pending.count(a.orderId)) {
+                    errors[i] = "已触发完成，等待写库";
+                    continue;
+                }
+                if (keep)
+                    symbols.push_back(a.symbol);
+                if (!ApplyPushedAlert(a, keep, graph) && keep)
+                    errors[i] = "规则或合约无效";
+            }
+            if (graph)
+                std::atomic_store(&m_synthetics, shared_ptr<const SyntheticGraph>(graph));
         }
+        EnsureSubscribed(symbols);
+    }
 
-        m_instruments = contracts;
-        m_instrumentCStrs.clear();
-
-        // 添加输出，显示即将订阅的合约
-        printf("Subscribing to %zu instruments:\n", contracts.size());
-        for (const auto& contract : contracts) {
-            printf("  - %s\n", contract.c_str());
+    // ===================== binlog 变更 =====================
+    // 在 binlog 线程调用：alert_order 的行按 orderId 替换 / 移除（与增量同步相同），user 的行更新邮箱缓存
+    void OnBinlogRows(const string& table, bool deleted, const vector<BinlogRow>& rows)
+    {
+        if (table == "user") {
+            if (m_userEmailSink)
+                for (const auto& r : rows)
+                    m_userEmailSink(r.Get("account"), deleted ? string() : r.Get("email"));
+            return;
         }
-        fflush(stdout);
 
-        for (auto& s : m_instruments)
-            m_instrumentCStrs.push_back(const_cast<char*>(s.c_str()));
+        unordered_set<long> pending;
+        for (const auto& p : m_outbox.PendingFinalOrders())
+            pending.insert(p.first);
 
-        int result = 0;
-        while ((result = m_mdApi->SubscribeMarketData(m_instrumentCStrs.data(),
-            (int)m_instrumentCStrs.size())) != 0)
+        vector<string> symbols;
         {
-            printf("SubscribeMarketData failed with code: %d, retrying...\n", result);
-            fflush(stdout);
-            Sleep(1000);
+            lock_guard<mutex> lk(m_bookWriteMutex);
+            shared_ptr<SyntheticGraph> graph;
+            for (const auto& r : rows)
+            {
+                AlertOrder a;
+                ReadBinlogAlert(r, a);
+                bool keep = !deleted && a.state == 0 && !pending.count(a.orderId) && OwnsSymbol(a.symbol);
+                if (keep)
+                    symbols.push_back(a.symbol);
+                ApplyPushedAlert(a, keep, graph);
+            }
+            if (graph)
+                std::atomic_store(&m_synthetics, shared_ptr<const SyntheticGraph>(graph));
         }
-
-        printf("Successfully subscribed to market data\n");
-        fflush(stdout);
+        EnsureSubscribed(symbols);
     }
 
-    void unsubscribe()
+    static void ReadBinlogAlert(const BinlogRow& r, AlertOrder& a)
     {
-        if (m_mdApi)
-            m_mdApi->UnSubscribeMarketData(m_instrumentCStrs.data(),
-                (int)m_instrumentCStrs.size());
+        a.orderId = r.GetLong("orderId");
+        a.account = r.Get("account");
+        a.symbol = r.Get("symbol");
+        a.max_price = r.GetDouble("max_price");
+        a.min_price = r.GetDouble("min_price");
+        a.trigger_time = r.Get("trigger_time");
+        a.state = r.GetInt("state");
+        a.rule = r.Get("rule");
+        a.repeat_max = r.GetInt("repeat_max");
+        a.cooldown_sec = r.GetInt("cooldown_sec");
+        a.rearm_band = r.GetDouble("rearm_band");
+        a.priority = r.GetInt("priority");
     }
 
-    // =====================================================
-    // =============== 3. 行情回调处理 ========================
-    // =====================================================
-
-    // 确认与前置机建立连接后触发（在这里发送登录请求）
-    void OnFrontConnected() override
+    // 应用一条推送 / binlog 来的变更（持有 m_bookWriteMutex）；DB 查询进行中时同时记入 m_pushJournal
+    // 返回是否保留在预警簿中（预处理失败时移除旧版本）
+    bool ApplyPushedAlert(AlertOrder& a, bool keep, shared_ptr<SyntheticGraph>& graph)
     {
-        m_isConnected = true;
-        printf("OnFrontConnected: connected to front\n");
-        fflush(stdout);
-
-        // 发起登录请求（使用配置）
-        CThostFtdcReqUserLoginField req = { 0 };
-
-        Config& cfg = Config::Instance();
-        if (!cfg.brokerId.empty()) {
-            strcpy_s(req.BrokerID, cfg.brokerId.c_str());
-        }
-        if (!cfg.userId.empty()) {
-            strcpy_s(req.UserID, cfg.userId.c_str());
-        }
-        if (!cfg.password.empty()) {
-            strcpy_s(req.Password, cfg.password.c_str());
-        }
-
-        m_reqId++;
-        int rt = m_mdApi->ReqUserLogin(&req, m_reqId);
-        printf("ReqUserLogin returned: %d\n", rt);
-        fflush(stdout);
+        if (m_bookFetching)
+            m_pushJournal.emplace_back(a, keep);
+        keep = keep && PrepareDeltaAlert(a, graph);
+        ApplyAlertDelta(a, keep);
+        return keep;
     }
 
-    void OnFrontDisconnected(int nReason) override
+    // 开始一次 DB 查询：此后的推送同时记入 m_pushJournal
+    void BeginBookFetch()
     {
-        m_isConnected = false;
-        m_isLoggedIn = false;
-        printf("OnFrontDisconnected: reason=%d\n", nReason);
-        fflush(stdout);
+        lock_guard<mutex> lk(m_bookWriteMutex);
+        m_pushJournal.clear();
+        m_bookFetching = true;
     }
 
-    // 登录响应
-    void OnRspUserLogin(CThostFtdcRspUserLoginField* pRspUserLogin,
-        CThostFtdcRspInfoField* pRspInfo,
-        int nRequestID, bool bIsLast) override
+    // 查询结果安装后按顺序重放期间的推送（持有 m_bookWriteMutex 调用）
+    void ReplayPushJournal()
     {
-        if (pRspInfo && pRspInfo->ErrorID != 0) {
-            printf("OnRspUserLogin failed: %d %s\n", pRspInfo->ErrorID,
-                pRspInfo->ErrorMsg ? pRspInfo->ErrorMsg : "");
-            fflush(stdout);
-            m_isLoggedIn = false;
+        m_bookFetching = false;
+        if (m_pushJournal.empty())
             return;
+        shared_ptr<SyntheticGraph> graph;
+        for (auto& e : m_pushJournal)
+        {
+            AlertOrder& a = e.first;
+            bool keep = e.second && PrepareDeltaAlert(a, graph);
+            ApplyAlertDelta(a, keep);
         }
-
-        printf("OnRspUserLogin success. TradingDay=%s, LoginTime=%s\n",
-            pRspUserLogin && pRspUserLogin->TradingDay ? pRspUserLogin->TradingDay : "",
-            pRspUserLogin && pRspUserLogin->LoginTime ? pRspUserLogin->LoginTime : "");
+        if (graph)
+            std::atomic_store(&m_synthetics, shared_ptr<const SyntheticGraph>(graph));
+        printf("[BOOK] DB 查询期间收到 %zu 条推送 / binlog 变更，已重放\n", m_pushJournal.size());
         fflush(stdout);
-        m_isLoggedIn = true;
+        m_pushJournal.clear();
     }
 
-    // 订阅/退订的响应（只是打印确认）
-    void OnRspSubMarketData(CThostFtdcSpecificInstrumentField* pSpecificInstrument,
-        CThostFtdcRspInfoField* pRspInfo,
-        int nRequestID, bool bIsLast) override
+    // 增量写入前的预处理（持有 m_bookWriteMutex）：规则沿用 m_ruleCache；出现新的合成合约时
+    // 把当前依赖图复制到 graph 再修改，由调用方最后整体发布
+    bool PrepareDeltaAlert(AlertOrder& a, shared_ptr<SyntheticGraph>& graph)
     {
-        if (pRspInfo && pRspInfo->ErrorID != 0) {
-            printf("OnRspSubMarketData failed: %d %s\n", pRspInfo->ErrorID,
-                pRspInfo->ErrorMsg ? pRspInfo->ErrorMsg : "");
-        }
-        else if (pSpecificInstrument) {
-            printf("OnRspSubMarketData success for %s\n", pSpecificInstrument->InstrumentID);
-        }
-        else {
-            printf("OnRspSubMarketData called (no instrument info)\n");
-        }
-        fflush(stdout);
+        string legA, legB;
+        char op;
+        if (ParseSyntheticSymbol(a.symbol, legA, legB, op) && !graph)
+            graph = make_shared<SyntheticGraph>(*std::atomic_load(&m_synthetics));
+        SyntheticGraph scratch;
+        unordered_map<string, shared_ptr<IndicatorSet>> unusedIndicators;
+        return PrepareAlert(a, m_ruleCache, graph ? *graph : scratch, unusedIndicators);
     }
 
-    // 行情下发回调
-    void OnRtnDepthMarketData(CThostFtdcDepthMarketDataField* d) override
+    // 用 a 替换同 orderId 的旧版本（keep=false 时只移除），保留其运行期状态；返回是否有变化（持有 m_bookWriteMutex）
+    bool ApplyAlertDelta(AlertOrder& a, bool keep)
     {
-        if (!d) return;
-
-        printf("Received market data for %s: LastPrice=%.2f\n",
-            d->InstrumentID, d->LastPrice);
-        fflush(stdout);
+        bool changed = false;
+        auto old = m_orderSymbols.find(a.orderId);
+        if (old != m_orderSymbols.end())
+        {
+            AlertShard& shard = *m_shards[ShardIndexOfSymbol(old->second)];
+            lock_guard<mutex> lk(shard.mtx);
+            auto bucket = shard.alertMap.find(old->second);
+            if (bucket != shard.alertMap.end()) {
+                auto& vec = bucket->second;
+                for (auto it = vec.begin(); it != vec.end(); ++it) {
+                    if (it->orderId == a.orderId) {
+                        if (keep && old->second == a.symbol)
+                            a.rt = it->rt;
+                        vec.erase(it);
+                        changed = true;
+                        break;
+                    }
+                }
+                if (vec.empty())
+                    shard.alertMap.erase(bucket);
+            }
+            shard.runtime.erase(a.orderId);
+            m_orderSymbols.erase(old);
+        }
+        if (!keep)
+            return changed;
+
+        AlertShard& shard = *m_shards[ShardIndexOfSymbol(a.symbol)];
+        lock_guard<mutex> lk(shard.mtx);
+        if (a.compiled_rule && !a.compiled_rule->inputs.empty())
+            CollectIndicators(shard.indicatorMap, a.symbol, *a.compiled_rule);
+        if (HasRuntime(a.rt))
+            shard.runtime[a.orderId] = make_pair(a.symbol, a.rt);
+        m_orderSymbols[a.orderId] = a.symbol;
+        shard.alertMap[a.symbol].push_back(std::move(a));
+        return true;
+    }
 
-        string symbol = d->InstrumentID;
-        double price = d->LastPrice;
-        // 改为带换行并立即 flush，避免缓冲导致看不到输出
-        //printf("成功启动预警程序-缓存\n");
-        //fflush(stdout);
-        // 更新行情缓存
+    static constexpr const char* kAlertColumns =
+        "orderId, account, symbol, max_price, min_price, trigger_time, state, rule, "
+        "repeat_max, cooldown_sec, rearm_band, priority";
+    static const int64_t kDeltaOverlapMs = 5000;
+
+    static void ReadAlertRow(sql::ResultSet& res, AlertOrder& a)
+    {
+        a.orderId = res.getInt("orderId");
+        a.account = res.getString("account");
+        a.symbol = res.getString("symbol");
+        a.max_price = res.getDouble("max_price");
+        a.min_price = res.getDouble("min_price");
+        a.trigger_time = res.getString("trigger_time");  // 加载时间字段
+        a.state = res.getInt("state");
+        a.rule = res.getString("rule");
+        a.repeat_max = res.getInt("repeat_max");
+        a.cooldown_sec = res.getInt("cooldown_sec");
+        a.rearm_band = res.getDouble("rearm_band");
+        a.priority = res.getInt("priority");
+    }
+
+    // DB 当前时间（Unix 毫秒），增量水位统一使用 DB 时钟，不受本机时钟偏差影响
+    static int64_t QueryDbNowMs(sql::Connection& conn)
+    {
+        unique_ptr<sql::Statement> stmt(conn.createStatement());
+        unique_ptr<sql::ResultSet> res(stmt->executeQuery(
+            "SELECT CAST(UNIX_TIMESTAMP(NOW(3)) * 1000 AS SIGNED) AS now_ms"));
+        return res->next() ? res->getInt64("now_ms") : 0;
+    }
+
+    // 加载阶段预处理：解析触发时间、编译规则、登记合约 / 合成合约；预警无效时返回 false
+    bool PrepareAlert(AlertOrder& a, unordered_map<string, shared_ptr<const CompiledRule>>& usedRules,
+        SyntheticGraph& synthetics, unordered_map<string, shared_ptr<IndicatorSet>>& indicators)
+    {
+        a.trigger_at = ParseTriggerTime(a.trigger_time);
+
+        if (!a.rule.empty()) {
+            a.compiled_rule = GetCompiledRule(a.symbol, a.rule, usedRules);
+            if (!a.compiled_rule) {
+                // 规则无效的预警不进入内存，避免按残缺条件误触发
+                return false;
+            }
+            if (!a.compiled_rule->inputs.empty())
+                CollectIndicators(indicators, a.symbol, *a.compiled_rule);
+        }
+
+        // 合成合约（价差/比价）在加载时把两条腿解析为合约 id
+        string legA, legB;
+        char op;
+        if (ParseSyntheticSymbol(a.symbol, legA, legB, op))
+            return synthetics.Add(a.symbol, m_registry);
+        m_registry.GetOrAdd(a.symbol);
+        return true;
+    }
+
+    static bool HasRuntime(const AlertRuntime& rt)
+    {
+        return rt.fire_count > 0 || rt.arm_state != ALERT_ARMED;
+    }
+
+    // 按分片拆开后逐个替换，每次只锁一个分片；seedRuntime 为真时（快照恢复）把记录自带的运行期状态登记到分片
+    void InstallAlertBook(unordered_map<string, vector<AlertOrder>>& tmp,
+        unordered_map<string, shared_ptr<IndicatorSet>>& indicators,
+        const shared_ptr<SyntheticGraph>& synthetics, bool seedRuntime)
+    {
+        m_orderSymbols.clear();
+        for (const auto& kv : tmp)
+            for (const auto& a : kv.second)
+                m_orderSymbols[a.orderId] = kv.first;
+
+        vector<unordered_map<string, vector<AlertOrder>>> shardAlerts(m_shards.size());
+        vector<unordered_map<string, shared_ptr<IndicatorSet>>> shardIndicators(m_shards.size());
+        for (auto& kv : tmp)
+            shardAlerts[ShardIndexOfSymbol(kv.first)].emplace(kv.first, std::move(kv.second));
+        for (auto& kv : indicators)
+            shardIndicators[ShardIndexOfSymbol(kv.first)].emplace(kv.first, std::move(kv.second));
+
+        std::atomic_store(&m_synthetics, shared_ptr<const SyntheticGraph>(synthetics));
+        for (size_t i = 0; i < m_shards.size(); ++i)
         {
-            lock_guard<mutex> lk(m_priceMutex);
-            m_lastPrices[symbol] = price;
+            AlertShard& shard = *m_shards[i];
+            lock_guard<mutex> lk(shard.mtx);
+            ExcludePendingTriggers(shardAlerts[i]);
+            if (seedRuntime) {
+                for (const auto& kv : shardAlerts[i])
+                    for (const auto& a : kv.second)
+                        if (HasRuntime(a.rt))
+                            shard.runtime[a.orderId] = make_pair(kv.first, a.rt);
+            }
+            InheritAlertRuntime(shard, shardAlerts[i]);
+            shard.alertMap.swap(shardAlerts[i]);
+            shard.indicatorMap.swap(shardIndicators[i]);
+        }
+    }
+
+    // ===================== 多实例分区 =====================
+    // 本实例是否负责该预警（按 alert_order.symbol，合成合约按合成名称）
+    bool OwnsSymbol(const string& symbol) const
+    {
+        return std::atomic_load(&m_owned)->Owns(symbol);
+    }
+
+    // 本实例负责范围的 SQL 条件；未启用分区时为空
+    string PartitionFilter(const char* column) const
+    {
+        return std::atomic_load(&m_owned)->SqlFilter(column);
+    }
+
+    // 启动时在首次加载之前调用：登记本实例并计算负责的区间
+    void JoinCluster()
+    {
+        Config& cfg = Config::Instance();
+        if (cfg.clusterSelf.empty())
+            return;
+
+        vector<string> members;
+        if (cfg.clusterTable.empty() || !QueryClusterMembers(members)) {
+            if (!cfg.clusterTable.empty())
+                printf("[CLUSTER] 读取成员表失败，暂按 [Cluster] Instances 分区\n");
+            members = SplitList(cfg.clusterInstances);
+        }
+        m_partitionTarget = HashRing::Build(members, cfg.clusterSelf, cfg.clusterVirtualNodes);
+        m_partitionChangedMs = SteadyMs();
+        std::atomic_store(&m_owned, make_shared<const PartitionSet>(m_partitionTarget));
+        printf("[CLUSTER] 本实例 %s，成员 %s，负责 %.1f%% 的哈希空间（%zu 个区间）\n",
+            cfg.clusterSelf.c_str(), JoinList(members).c_str(), m_partitionTarget.Share() * 100,
+            m_partitionTarget.ranges.size());
+        fflush(stdout);
+    }
+
+    // 退出时注销，其余实例在下一轮立即接手（不必等心跳过期）
+    void LeaveCluster()
+    {
+        Config& cfg = Config::Instance();
+        if (cfg.clusterSelf.empty() || cfg.clusterTable.empty())
+            return;
+        try {
+            unique_ptr<sql::Connection> conn(GetConn());
+            unique_ptr<sql::PreparedStatement> stmt(
+                conn->prepareStatement("DELETE FROM " + cfg.clusterTable + " WHERE instance=?")
+            );
+            stmt->setString(1, cfg.clusterSelf);
+            stmt->executeUpdate();
+        }
+        catch (sql::SQLException& e) {
+            printf("[DB ERROR] LeaveCluster: %s\n", e.what());
+            fflush(stdout);
+        }
+    }
+
+    // reload 线程每轮调用：续心跳并按最新成员列表重算；负责范围变化时返回 true（随后需全量加载）
+    // 新得到的区间立即接手；失去的区间在成员列表稳定 HandoffSec 秒后才释放，留给新负责的实例完成加载
+    bool RefreshCluster()
+    {
+        Config& cfg = Config::Instance();
+        if (cfg.clusterSelf.empty() || cfg.clusterTable.empty())
+            return false;
+
+        vector<string> members;
+        if (!QueryClusterMembers(members))
+            return false;   // DB 不可用时保持现状
+
+        PartitionSet target = HashRing::Build(members, cfg.clusterSelf, cfg.clusterVirtualNodes);
+        shared_ptr<const PartitionSet> owned = std::atomic_load(&m_owned);
+        if (target != m_partitionTarget) {
+            printf("[CLUSTER] 成员变为 %s，负责 %.1f%% -> %.1f%% 的哈希空间\n",
+                JoinList(members).c_str(), m_partitionTarget.Share() * 100, target.Share() * 100);
+            fflush(stdout);
+            m_partitionTarget = target;
+            m_partitionChangedMs = SteadyMs();
+            PartitionSet next = owned->Union(target);
+            if (next == *owned)
+                return false;
+            std::atomic_store(&m_owned, make_shared<const PartitionSet>(next));
+            return true;
         }
 
-        // 执行预警判断
-        CheckAlert(symbol, price);
+        if (*owned != target && SteadyMs() - m_partitionChangedMs >= cfg.clusterHandoffSec * 1000LL) {
+            printf("[CLUSTER] 交接期结束，释放 %.1f%% 的哈希空间\n", (owned->Share() - target.Share()) * 100);
+            fflush(stdout);
+            std::atomic_store(&m_owned, make_shared<const PartitionSet>(target));
+            return true;
+        }
+        return false;
     }
 
-    // 根据 symbol 和 price 判断预警
+    // 在成员表中续本实例的心跳，并读出心跳未过期的成员
+    bool QueryClusterMembers(vector<string>& members)
+    {
+        Config& cfg = Config::Instance();
+        try {
+            unique_ptr<sql::Connection> conn(GetConn());
+            unique_ptr<sql::PreparedStatement> beat(
+                conn->prepareStatement("INSERT INTO " + cfg.clusterTable + " (instance, heartbeat_at) VALUES (?, NOW(3)) "
+                    "ON DUPLICATE KEY UPDATE heartbeat_at=NOW(3)")
+            );
+            beat->setString(1, cfg.clusterSelf);
+            beat->executeUpdate();
 
-    // 根据 symbol 和 price 判断预警
-    void CheckAlert(const string& symbol, double price)
+            unique_ptr<sql::PreparedStatement> stmt(
+                conn->prepareStatement("SELECT instance FROM " + cfg.clusterTable +
+                    " WHERE heartbeat_at >= NOW(3) - INTERVAL ? SECOND")
+            );
+            stmt->setInt(1, cfg.clusterLeaseSec);
+            unique_ptr<sql::ResultSet> res(stmt->executeQuery());
+            members.clear();
+            while (res->next())
+                members.push_back(res->getString("instance"));
+            return true;
+        }
+        catch (sql::SQLException& e) {
+            printf("[DB ERROR] Cluster: %s\n", e.what());
+            fflush(stdout);
+            return false;
+        }
+    }
+
+    // 负责范围收缩后退订不再需要的合约：本实例不再负责、且预警簿（含合成合约的腿）也不再引用
+    // 持有 m_bookWriteMutex 判断引用，持有 m_subscribeMutex 退订，与写入方随后的 EnsureSubscribed 不冲突
+    void ReleaseUnownedSubscriptions()
     {
-        vector<AlertOrder> alerts;
+        lock_guard<mutex> bookLock(m_bookWriteMutex);
+        unordered_set<string> referenced;
+        for (const auto& kv : m_orderSymbols)
+        {
+            string legA, legB;
+            char op;
+            if (ParseSyntheticSymbol(kv.second, legA, legB, op)) {
+                referenced.insert(legA);
+                referenced.insert(legB);
+            }
+            else {
+                referenced.insert(kv.second);
+            }
+        }
 
+        shared_ptr<const PartitionSet> owned = std::atomic_load(&m_owned);
+        vector<vector<string>> parts(m_partitions);
+        size_t removed = 0;
+        lock_guard<mutex> lk(m_subscribeMutex);
+        for (auto it = m_subscribed.begin(); it != m_subscribed.end();)
         {
-            lock_guard<mutex> lk(m_alertMutex);
-            auto it = m_alertMap.find(symbol);
-            if (it == m_alertMap.end())
-                return;
-            alerts = it->second; // 拷贝，避免长时间持锁
+            if (referenced.count(*it) || owned->Owns(*it)) {
+                ++it;
+                continue;
+            }
+            parts[PartitionOf(m_registry.GetOrAdd(*it))].push_back(*it);
+            it = m_subscribed.erase(it);
+            removed++;
+        }
+        if (removed == 0)
+            return;
+
+        for (size_t i = 0; i < m_sessions.size(); ++i)
+            if (!parts[i % m_partitions].empty())
+                m_sessions[i]->RemoveInstruments(parts[i % m_partitions]);
+        printf("[SUBSCRIBE] 退订 %zu 个不再负责的合约\n", removed);
+        fflush(stdout);
+    }
+
+    // 组播模式下会话查询到的组播合约表带有最小变动价位与合约乘数，收齐后补充到元数据（reload 线程调用）
+    void ImportMulticastInstruments()
+    {
+        lock_guard<mutex> lk(m_subscribeMutex);
+        m_multicastVersions.resize(m_sessions.size(), 0);
+        for (size_t i = 0; i < m_sessions.size(); ++i)
+        {
+            uint64_t version = m_sessions[i]->MulticastTableVersion();
+            if (version == m_multicastVersions[i])
+                continue;
+            m_multicastVersions[i] = version;
+
+            size_t imported = 0;
+            for (const auto& kv : m_sessions[i]->GetMulticastInstruments()) {
+                if (kv.second.priceTick > 0) {
+                    m_instruments.AddFallback(kv.first, kv.second.priceTick, kv.second.volumeMultiple);
+                    imported++;
+                }
+            }
+            printf("[%s] 从组播合约表导入 %zu 个合约的最小变动价位与乘数\n", m_sessions[i]->Name().c_str(), imported);
+            fflush(stdout);
+        }
+    }
+
+    // =====================================================
+    // 合约元数据：[Instruments] Table（DB）优先，失败或未配置时读 File（CSV）；
+    // 启动时加载，此后每天本地 RefreshTime 之后刷新一次，失败 10 分钟后重试
+    // =====================================================
+    void RefreshInstrumentMeta()
+    {
+        Config& cfg = Config::Instance();
+        if (cfg.instrumentsTable.empty() && cfg.instrumentsFile.empty())
+            return;
+
+        unordered_map<string, InstrumentMeta> table;
+        string source;
+        if (!cfg.instrumentsTable.empty() && LoadInstrumentMetaFromDB(cfg.instrumentsTable, table))
+            source = cfg.instrumentsTable;
+        else if (!cfg.instrumentsFile.empty()) {
+            table.clear();
+            if (InstrumentMetaStore::LoadFile(cfg.instrumentsFile, table))
+                source = cfg.instrumentsFile;
+            else
+                printf("[INSTRUMENT] 无法读取元数据文件 %s\n", cfg.instrumentsFile.c_str());
+        }
+        if (source.empty()) {
+            m_instrumentsRetryMs = SteadyMs() + 600 * 1000LL;
+            printf("[INSTRUMENT] 合约元数据加载失败，沿用%s数据，10 分钟后重试\n",
+                m_instrumentsLoadedMs > 0 ? "上次的" : "（无）");
+            fflush(stdout);
+            return;
+        }
+
+        size_t n = table.size();
+        m_instruments.Replace(std::move(table));
+        m_instruments.Sync(m_registry);
+        m_instrumentsLoadedMs = WallMs();
+        printf("[INSTRUMENT] 从 %s 加载 %zu 个合约的元数据\n", source.c_str(), n);
+        fflush(stdout);
+    }
+
+    bool LoadInstrumentMetaFromDB(const string& tableName, unordered_map<string, InstrumentMeta>& out)
+    {
+        try {
+            unique_ptr<sql::Connection> conn(GetConn());
+            unique_ptr<sql::Statement> stmt(conn->createStatement());
+            unique_ptr<sql::ResultSet> res(stmt->executeQuery(
+                "SELECT symbol, exchange, price_tick, multiplier, expire_date, sessions FROM " + tableName));
+            while (res->next()) {
+                InstrumentMeta m;
+                m.exchange = res->isNull("exchange") ? string() : string(res->getString("exchange"));
+                m.priceTick = res->isNull("price_tick") ? 0.0 : (double)res->getDouble("price_tick");
+                m.multiplier = res->isNull("multiplier") ? 0.0 : (double)res->getDouble("multiplier");
+                m.expireDate = res->isNull("expire_date") ? 0 : res->getInt("expire_date");
+                m.sessions = res->isNull("sessions") ? string() : string(res->getString("sessions"));
+                out[res->getString("symbol")] = m;
+            }
+            return true;
+        }
+        catch (sql::SQLException& e) {
+            printf("[DB ERROR] LoadInstrumentMetaFromDB: %s\n", e.what());
+            fflush(stdout);
+            return false;
         }
+    }
 
-        // 记录已触发的 orderId，循环结束后在内存中删除它们
-        vector<long> triggeredIds;
-        triggeredIds.reserve(4);
+    // 最近一个已过去的刷新时刻晚于上次加载时需要刷新
+    bool InstrumentMetaDue()
+    {
+        Config& cfg = Config::Instance();
+        if ((cfg.instrumentsTable.empty() && cfg.instrumentsFile.empty()) || SteadyMs() < m_instrumentsRetryMs)
+            return false;
 
-        // 获取当前时间 - 使用安全的 localtime_s
+        int hh = 8, mm = 30;
+        sscanf_s(cfg.instrumentsRefreshTime.c_str(), "%d:%d", &hh, &mm);
         time_t now = time(0);
-        tm local_tm = { 0 };
-        localtime_s(&local_tm, &now);  // 使用 localtime_s 替代 localtime
-        char time_buffer[20];
-        strftime(time_buffer, sizeof(time_buffer), "%Y-%m-%d %H:%M:%S", &local_tm);
-        string current_time_str = string(time_buffer);
+        struct tm lt;
+        localtime_s(&lt, &now);
+        lt.tm_hour = hh;
+        lt.tm_min = mm;
+        lt.tm_sec = 0;
+        int64_t scheduledMs = (int64_t)mktime(&lt) * 1000;
+        if (scheduledMs > WallMs())
+            scheduledMs -= 86400 * 1000LL;
+        return m_instrumentsLoadedMs < scheduledMs;
+    }
+
+    static vector<string> SplitList(const string& text)
+    {
+        vector<string> items;
+        stringstream ss(text);
+        string item;
+        while (getline(ss, item, ',')) {
+            item.erase(0, item.find_first_not_of(" \t"));
+            item.erase(item.find_last_not_of(" \t") + 1);
+            if (!item.empty()) items.push_back(item);
+        }
+        return items;
+    }
+
+    static string JoinList(vector<string> items)
+    {
+        std::sort(items.begin(), items.end());
+        string text;
+        for (const auto& item : items)
+            text += (text.empty() ? "" : ",") + item;
+        return text.empty() ? "-" : text;
+    }
 
-        for (auto& a : alerts)
+    // ===================== 预警簿快照 =====================
+    // 从快照恢复预警簿；快照不可用时返回 false
+    bool LoadSnapshot()
+    {
+        Config& cfg = Config::Instance();
+        if (cfg.snapshotPath.empty())
+            return false;
+
+        int64_t start = SteadyMs();
+        AlertSnapshotData data;
+        string error;
+        if (!AlertSnapshot::Read(cfg.snapshotPath, data, error)) {
+            printf("[SNAPSHOT] 未使用快照 %s：%s，从数据库加载\n", cfg.snapshotPath.c_str(), error.c_str());
+            fflush(stdout);
+            return false;
+        }
+
+        lock_guard<mutex> lk(m_bookWriteMutex);
+        // 按快照中的顺序登记合约，使合约 id 与分片归属和写快照时一致
+        for (const auto& name : data.instruments)
+            m_registry.GetOrAdd(name);
+
+        unordered_map<string, vector<AlertOrder>> tmp;
+        unordered_map<string, shared_ptr<const CompiledRule>> usedRules;
+        auto synthetics = make_shared<SyntheticGraph>();
+        unordered_map<string, shared_ptr<IndicatorSet>> indicators;
+        int64_t wallToSteady = SteadyMs() - WallMs();
+        size_t count = 0;
+        shared_ptr<const PartitionSet> owned = std::atomic_load(&m_owned);
+        for (const auto& b : data.buckets)
         {
-            bool triggered = false;
-            string reason;
+            // 快照可能写于另一种分区归属：不再负责的丢弃，新负责的由随后的全量加载补齐
+            if (!owned->Owns(b.symbol))
+                continue;
+            for (const auto& s : b.alerts)
+            {
+                AlertOrder a;
+                a.orderId = s.orderId;
+                a.account = s.account;
+                a.symbol = b.symbol;
+                a.max_price = s.max_price;
+                a.min_price = s.min_price;
+                a.trigger_time = s.trigger_time;
+                a.state = s.state;
+                a.rule = s.rule;
+                a.repeat_max = s.repeat_max;
+                a.cooldown_sec = s.cooldown_sec;
+                a.rearm_band = s.rearm_band;
+                a.priority = s.priority;
+                a.rt.arm_state = s.arm_state;
+                a.rt.fire_count = s.fire_count;
+                a.rt.last_fire_ms = s.last_fire_wall_ms ? s.last_fire_wall_ms + wallToSteady : 0;
+                if (!PrepareAlert(a, usedRules, *synthetics, indicators))
+                    continue;
+                tmp[a.symbol].push_back(a);
+                count++;
+            }
+        }
+
+        m_ruleCache.swap(usedRules);
+        ReportIndicatorMemory(indicators);
+        InstallAlertBook(tmp, indicators, synthetics, true);
+        m_bookFromSnapshot = true;
+        m_bookValid = true;
+
+        // 快照带有水位且启用了增量同步：以快照为基线，只补拉之后的变更
+        if (!cfg.reloadDeltaColumn.empty() && data.watermarkMs > 0) {
+            m_deltaWatermarkMs = data.watermarkMs;
+            m_lastFullReloadMs = SteadyMs();
+        }
+        if (!owned->all)
+            m_fullReloadRequested = true;
 
-            // 价格预警判断
-            if (a.max_price > 0 && price >= a.max_price) {
-                triggered = true;
-                reason = ">= 上限 " + to_string(a.max_price);
+        printf("[SNAPSHOT] 从 %s 恢复 %zu 条预警（快照写于 %.1f 秒前），耗时 %lld ms\n",
+            cfg.snapshotPath.c_str(), count, (WallMs() - data.createdMs) / 1000.0,
+            (long long)(SteadyMs() - start));
+        fflush(stdout);
+        return true;
+    }
+
+    // 把当前预警簿（含运行期状态与合约注册表）写入快照；逐个分片加锁拷贝
+    void SaveSnapshot()
+    {
+        const string& path = Config::Instance().snapshotPath;
+        if (path.empty() || !m_bookValid.load())
+            return;
+
+        int64_t start = SteadyMs();
+        AlertSnapshotData data;
+        data.createdMs = WallMs();
+        data.watermarkMs = m_deltaWatermarkMs;
+        int count = m_registry.Size();
+        for (int i = 0; i < count; ++i)
+            data.instruments.push_back(m_registry.Name(i));
+
+        int64_t steadyToWall = WallMs() - SteadyMs();
+        size_t alerts = 0;
+        for (auto& sp : m_shards)
+        {
+            lock_guard<mutex> lk(sp->mtx);
+            for (const auto& kv : sp->alertMap)
+            {
+                SnapshotBucket b;
+                b.symbol = kv.first;
+                for (const auto& a : kv.second)
+                {
+                    SnapshotAlert s;
+                    s.orderId = a.orderId;
+                    s.account = a.account;
+                    s.max_price = a.max_price;
+                    s.min_price = a.min_price;
+                    s.trigger_time = a.trigger_time;
+                    s.state = a.state;
+                    s.rule = a.rule;
+                    s.repeat_max = a.repeat_max;
+                    s.cooldown_sec = a.cooldown_sec;
+                    s.rearm_band = a.rearm_band;
+                    s.priority = a.priority;
+                    s.arm_state = a.rt.arm_state;
+                    s.fire_count = a.rt.fire_count;
+                    s.last_fire_wall_ms = a.rt.fire_count > 0 ? a.rt.last_fire_ms + steadyToWall : 0;
+                    b.alerts.push_back(std::move(s));
+                }
+                alerts += b.alerts.size();
+                data.buckets.push_back(std::move(b));
             }
-            if (a.min_price > 0 && price <= a.min_price) {
-                triggered = true;
-                reason = "<= 下限 " + to_string(a.min_price);
+        }
+
+        if (AlertSnapshot::Write(path, data)) {
+            printf("[SNAPSHOT] 已写入 %zu 条预警 -> %s，耗时 %lld ms\n",
+                alerts, path.c_str(), (long long)(SteadyMs() - start));
+            fflush(stdout);
+        }
+    }
+
+    // 已最终触发、但 outbox 尚未（或刚刚）把 state=1 写入 DB 的预警不能重新载入（需持有对应分片的锁）
+    void ExcludePendingTriggers(unordered_map<string, vector<AlertOrder>>& fresh)
+    {
+        for (const auto& p : m_outbox.PendingFinalOrders())
+        {
+            auto bucket = fresh.find(p.second);
+            if (bucket == fresh.end())
+                continue;
+
+            auto& vec = bucket->second;
+            vec.erase(std::remove_if(vec.begin(), vec.end(),
+                [&](const AlertOrder& x) { return x.orderId == p.first; }), vec.end());
+            if (vec.empty())
+                fresh.erase(bucket);
+        }
+    }
+
+    // 把内存中的触发次数/布防状态带入新加载的预警（需持有 shard.mtx）
+    // 已从 DB 消失的预警同时丢弃其运行期状态
+    static void InheritAlertRuntime(AlertShard& shard, unordered_map<string, vector<AlertOrder>>& fresh)
+    {
+        auto& runtime = shard.runtime;
+        for (auto it = runtime.begin(); it != runtime.end();)
+        {
+            bool found = false;
+            auto bucket = fresh.find(it->second.first);
+            if (bucket != fresh.end()) {
+                for (auto& a : bucket->second) {
+                    if (a.orderId == it->first) {
+                        a.rt = it->second.second;
+                        found = true;
+                        break;
+                    }
+                }
+            }
+            if (found) ++it;
+            else it = runtime.erase(it);
+        }
+    }
+
+    // 合约 id 所在分片 / 行情分区（id 无效时归入 0 号）
+    size_t ShardIndexOf(int id) const
+    {
+        return id < 0 ? 0 : (size_t)id % m_shards.size();
+    }
+
+    size_t PartitionOf(int id) const
+    {
+        return id < 0 ? 0 : (size_t)id % m_partitions;
+    }
+
+    // 普通合约按自身 id；价差/比价按第一条腿的 id
+    size_t ShardIndexOfSymbol(const string& symbol) const
+    {
+        string legA, legB;
+        char op;
+        if (ParseSyntheticSymbol(symbol, legA, legB, op))
+            return ShardIndexOf(m_registry.Find(legA));
+        return ShardIndexOf(m_registry.Find(symbol));
+    }
+
+    // 取出（或编译）规则；编译失败返回空指针
+    // 不含指标的规则按文本在所有合约间共享；含指标的规则绑定了该合约的指标对象，按 "合约|文本" 缓存
+    shared_ptr<const CompiledRule> GetCompiledRule(const string& symbol, const string& text,
+        unordered_map<string, shared_ptr<const CompiledRule>>& usedRules)
+    {
+        const string symbolKey = symbol + "|" + text;
+        const string* keys[] = { &text, &symbolKey };
+        for (const string* key : keys)
+        {
+            auto used = usedRules.find(*key);
+            if (used != usedRules.end())
+                return used->second;
+
+            auto cached = m_ruleCache.find(*key);
+            if (cached != m_ruleCache.end()) {
+                usedRules[*key] = cached->second;
+                return cached->second;
             }
+        }
+
+        shared_ptr<const CompiledRule> rule;
+        auto compiled = make_shared<CompiledRule>();
+        string error;
+        IndicatorResolver resolver = [this, &symbol](const string& name, int param, IndicatorRef& out) {
+            return m_indicatorPool.Resolve(symbol, name, param, out);
+        };
+        if (!RuleCompiler::Compile(text, *compiled, error, resolver)) {
+            printf("[RULE ERROR] 规则 \"%s\" 编译失败: %s\n", text.c_str(), error.c_str());
+            fflush(stdout);
+        }
+        else {
+            rule = compiled;
+        }
+
+        // 失败的规则同样缓存（空指针），避免每轮 reload 重复编译与刷日志
+        usedRules[(rule && !rule->inputs.empty()) ? symbolKey : text] = rule;
+        return rule;
+    }
+
+    // 把规则引用的指标并入该合约的指标集合（同一对象只加入一次）
+    static void CollectIndicators(unordered_map<string, shared_ptr<IndicatorSet>>& indicators,
+        const string& symbol, const CompiledRule& rule)
+    {
+        auto& set = indicators[symbol];
+        if (!set) set = make_shared<IndicatorSet>();
+        for (const auto& ind : rule.inputs) {
+            if (std::find(set->items.begin(), set->items.end(), ind) == set->items.end())
+                set->items.push_back(ind);
+        }
+    }
+
+    // 指标内存有变化时打印一次
+    void ReportIndicatorMemory(const unordered_map<string, shared_ptr<IndicatorSet>>& indicators)
+    {
+        size_t count = 0, bytes = 0;
+        for (const auto& kv : indicators) {
+            count += kv.second->items.size();
+            bytes += kv.second->MemoryBytes();
+        }
+        if (bytes == m_reportedIndicatorBytes) return;
+        m_reportedIndicatorBytes = bytes;
+
+        printf("[INDICATOR] %zu 个合约, %zu 个指标, 占用 %.1f KB\n",
+            indicators.size(), count, bytes / 1024.0);
+        fflush(stdout);
+    }
 
-            if (!a.trigger_time.empty()) {
-                // 解析预警时间
-                tm trigger_tm = { 0 };
+    // 解析 "YYYY-MM-DD HH:MM:SS"，失败返回 0
+    static time_t ParseTriggerTime(const string& s)
+    {
+        if (s.empty()) return 0;
+
+        tm trigger_tm = { 0 };
+        int result = sscanf_s(s.c_str(), "%d-%d-%d %d:%d:%d",
+            &trigger_tm.tm_year, &trigger_tm.tm_mon, &trigger_tm.tm_mday,
+            &trigger_tm.tm_hour, &trigger_tm.tm_min, &trigger_tm.tm_sec);
+        if (result != 6) return 0;
+
+        trigger_tm.tm_year -= 1900;
+        trigger_tm.tm_mon -= 1;
+        trigger_tm.tm_isdst = -1;
+        return mktime(&trigger_tm);
+    }
 
-                // 使用 sscanf_s 替代 sscanf
-                int result = sscanf_s(a.trigger_time.c_str(), "%d-%d-%d %d:%d:%d",
-                    &trigger_tm.tm_year, &trigger_tm.tm_mon, &trigger_tm.tm_mday,
-                    &trigger_tm.tm_hour, &trigger_tm.tm_min, &trigger_tm.tm_sec);
+    // ===================== 更新数据库状态（触发预警） =====================
+    // 由 outbox 投递线程调用，失败返回 false 由 outbox 退避重试
+    bool MarkAlertTriggered(long orderId)
+    {
+        try {
+            unique_ptr<sql::Connection> conn(GetConn());
+            unique_ptr<sql::PreparedStatement> stmt(
+                conn->prepareStatement("UPDATE alert_order SET state=1 WHERE orderId=?")
+            );
+            stmt->setInt(1, orderId);
+            stmt->execute();
+            return true;
+        }
+        catch (sql::SQLException& e) {
+            printf("[DB ERROR] 更新预警状态失败 orderId=%ld: %s\n", orderId, e.what());
+            fflush(stdout);
+            return false;
+        }
+    }
 
-                if (result == 6) {
-                    trigger_tm.tm_year -= 1900;
-                    trigger_tm.tm_mon -= 1;
+    // ===================== 触发认领（多实例去重） =====================
+    // 由 outbox 投递线程调用：一批触发在一个事务内认领，认领成功的才通知。
+    // 事务先锁定这批预警在 alert_order 中的行，同一预警的认领在各实例间串行，再按 DB 中的共享状态裁决：
+    //   - 最终触发以 state 0 -> 1 为准，并发实例在行锁上排队，之后读到 state=1；
+    //   - 可重复预警的中间次数不使用各实例自己的触发计数（启动时间不同会不一致），而是与认领表中该预警
+    //     最近一次认领（任一实例）比较检测时间：间隔不足冷却时间（至少 kClaimRepeatWindowMs）视为同一次穿越，
+    //     认领失败；否则认领成功，序号取认领表中该预警的最大序号 + 1。
+    // 认领成功的事件连同通知内容带租约写入认领表，通知后标记 notified=1；租约过期仍未通知的由存活实例接管
+    static const int kMaxClaimHandoffs = 3;
+    static const int64_t kClaimRepeatWindowMs = 1000;
+
+    void ClaimTriggers(const vector<TriggerEvent*>& events, vector<uint8_t>& results)
+    {
+        const string& table = Config::Instance().claimTable;
+        results.assign(events.size(), CLAIM_RETRY);
+        int64_t token = m_claimTokenBase + (++m_claimSeq);
+        try {
+            unique_ptr<sql::Connection> conn(GetConn());
+            conn->setAutoCommit(false);
+            try {
+                unique_ptr<sql::Statement> stmt(conn->createStatement());
+                string allIds;
+                for (auto* e : events)
+                    allIds += (allIds.empty() ? "" : ",") + std::to_string(e->orderId);
+
+                // 锁定预警行；已删除或已结束（state 非 0）的预警不再通知
+                unordered_map<long, int64_t> windowMs;
+                {
+                    unique_ptr<sql::ResultSet> res(stmt->executeQuery(
+                        "SELECT orderId, cooldown_sec FROM alert_order WHERE orderId IN (" + allIds + ") AND state=0 FOR UPDATE"));
+                    while (res->next()) {
+                        int64_t cooldownMs = res->getInt64("cooldown_sec") * 1000;
+                        windowMs[(long)res->getInt64("orderId")] = cooldownMs > kClaimRepeatWindowMs ? cooldownMs : kClaimRepeatWindowMs;
+                    }
+                }
 
-                    time_t trigger_time_t = mktime(&trigger_tm);
-                    time_t current_time_t = time(0);
+                // 各预警最近一次认领（在上面的行锁保护下读取）
+                struct LastClaim { int seq; int64_t detectMs; };
+                unordered_map<long, LastClaim> last;
+                {
+                    unique_ptr<sql::ResultSet> res(stmt->executeQuery(
+                        "SELECT orderId, MAX(fire_seq) AS seq, MAX(detect_ms) AS last_ms FROM " + table +
+                        " WHERE orderId IN (" + allIds + ") GROUP BY orderId"));
+                    while (res->next())
+                        last[(long)res->getInt64("orderId")] = LastClaim{ res->getInt("seq"), res->getInt64("last_ms") };
+                }
 
-                    if (current_time_t >= trigger_time_t) {
-                        triggered = true;
-                        reason = "到达预定时间 " + a.trigger_time;
+                vector<const TriggerEvent*> finals, repeats;
+                string finalIds;
+                for (auto* e : events) {
+                    auto w = windowMs.find(e->orderId);
+                    if (w == windowMs.end())
+                        continue;
+                    auto l = last.find(e->orderId);
+                    bool sameCrossing = l != last.end() && l->second.detectMs > 0 &&
+                        std::llabs(e->detectMs - l->second.detectMs) < w->second;
+                    if (e->final) {
+                        // 达到最大次数即结束预警；这次穿越已由其他实例按中间次数通知过的，不再通知
+                        finalIds += (finalIds.empty() ? "" : ",") + std::to_string(e->orderId);
+                        windowMs.erase(w);
+                        if (sameCrossing)
+                            continue;
+                        e->claimSeq = 0;
+                        finals.push_back(e);
                     }
+                    else if (!sameCrossing) {
+                        LastClaim& lc = last[e->orderId];
+                        lc.seq = max(lc.seq, 0) + 1;
+                        lc.detectMs = e->detectMs;
+                        e->claimSeq = lc.seq;
+                        repeats.push_back(e);
+                    }
+                }
+                if (!finalIds.empty())
+                    stmt->executeUpdate("UPDATE alert_order SET state=1 WHERE orderId IN (" + finalIds + ")");
+
+                // 最终触发覆盖旧的认领记录（预警被重新打开后再次触发）
+                InsertClaims(*conn, finals, token, false,
+                    " ON DUPLICATE KEY UPDATE owner=VALUES(owner), token=VALUES(token), lease_until=VALUES(lease_until), "
+                    "notified=0, handoffs=0, account=VALUES(account), symbol=VALUES(symbol), price=VALUES(price), "
+                    "reason=VALUES(reason), detect_ms=VALUES(detect_ms)");
+                InsertClaims(*conn, repeats, token, true, "");
+
+                // 本批 token 写入的行即为认领成功的事件
+                set<pair<long, int>> won;
+                unique_ptr<sql::PreparedStatement> q(conn->prepareStatement(
+                    "SELECT orderId, fire_seq FROM " + table + " WHERE orderId IN (" + allIds + ") AND token=?"));
+                q->setInt64(1, token);
+                unique_ptr<sql::ResultSet> res(q->executeQuery());
+                while (res->next())
+                    won.insert(make_pair((long)res->getInt64("orderId"), res->getInt("fire_seq")));
+                conn->commit();
+
+                for (size_t i = 0; i < events.size(); ++i) {
+                    bool ok = events[i]->claimSeq >= 0 && won.count(make_pair(events[i]->orderId, events[i]->claimSeq)) > 0;
+                    results[i] = ok ? CLAIM_WON : CLAIM_LOST;
+                    (ok ? m_claimWon : m_claimLost).fetch_add(1);
                 }
             }
+            catch (sql::SQLException&) {
+                conn->rollback();
+                throw;
+            }
+        }
+        catch (sql::SQLException& e) {
+            for (auto* ev : events) ev->claimSeq = -1;
+            printf("[DB ERROR] 认领 %zu 个触发失败: %s\n", events.size(), e.what());
+            fflush(stdout);
+        }
+    }
+
+    void InsertClaims(sql::Connection& conn, const vector<const TriggerEvent*>& events, int64_t token,
+        bool ignore, const string& onDuplicate)
+    {
+        if (events.empty())
+            return;
+        Config& cfg = Config::Instance();
+        string row = "(?, ?, ?, ?, NOW(3) + INTERVAL " + std::to_string(cfg.claimLeaseSec) + " SECOND, 0, ?, ?, ?, ?, ?)";
+        string sql = string("INSERT ") + (ignore ? "IGNORE " : "") + "INTO " + cfg.claimTable +
+            " (orderId, fire_seq, owner, token, lease_until, notified, account, symbol, price, reason, detect_ms) VALUES ";
+        for (size_t i = 0; i < events.size(); ++i)
+            sql += (i ? "," : "") + row;
+        sql += onDuplicate;
+
+        unique_ptr<sql::PreparedStatement> stmt(conn.prepareStatement(sql));
+        int k = 1;
+        for (auto* e : events) {
+            stmt->setInt64(k++, e->orderId);
+            stmt->setInt(k++, ClaimSeq(*e));
+            stmt->setString(k++, m_claimOwner);
+            stmt->setInt64(k++, token);
+            stmt->setString(k++, e->account);
+            stmt->setString(k++, e->symbol);
+            stmt->setDouble(k++, e->price);
+            stmt->setString(k++, e->reason);
+            stmt->setInt64(k++, e->detectMs);
+        }
+        stmt->executeUpdate();
+    }
+
+    // 认领表中的序号：最终触发固定为 0，中间次数为认领时分配的共享序号
+    // （升级前写入 outbox 的已认领事件没有 claimSeq，沿用当时的本地触发计数）
+    static int ClaimSeq(const TriggerEvent& e)
+    {
+        if (e.final) return 0;
+        return e.claimSeq >= 0 ? e.claimSeq : e.fireSeq;
+    }
+
+    // 崩溃恢复出的已认领事件：续租成功（仍归本实例且未通知）才通知
+    uint8_t ConfirmTriggerClaim(const TriggerEvent& e)
+    {
+        Config& cfg = Config::Instance();
+        try {
+            unique_ptr<sql::Connection> conn(GetConn());
+            unique_ptr<sql::PreparedStatement> stmt(
+                conn->prepareStatement("UPDATE " + cfg.claimTable + " SET lease_until=NOW(3) + INTERVAL " +
+                    std::to_string(cfg.claimLeaseSec) + " SECOND WHERE orderId=? AND fire_seq=? AND owner=? AND notified=0")
+            );
+            stmt->setInt64(1, e.orderId);
+            stmt->setInt(2, ClaimSeq(e));
+            stmt->setString(3, m_claimOwner);
+            return stmt->executeUpdate() > 0 ? CLAIM_WON : CLAIM_LOST;
+        }
+        catch (sql::SQLException& ex) {
+            printf("[DB ERROR] 确认认领失败 orderId=%ld: %s\n", e.orderId, ex.what());
+            fflush(stdout);
+            return CLAIM_RETRY;
+        }
+    }
+
+    // 本实例放弃通知（重试耗尽）：租约立即过期，由存活实例接管重试；
+    // 累计释放 kMaxClaimHandoffs 次后标记为放弃（notified=2），不再接管
+    bool ReleaseTriggerClaim(const TriggerEvent& e)
+    {
+        Config& cfg = Config::Instance();
+        try {
+            unique_ptr<sql::Connection> conn(GetConn());
+            unique_ptr<sql::PreparedStatement> stmt(
+                conn->prepareStatement("UPDATE " + cfg.claimTable + " SET lease_until=NOW(3), handoffs=handoffs+1, "
+                    "notified=IF(handoffs >= " + std::to_string(kMaxClaimHandoffs) + ", 2, 0) "
+                    "WHERE orderId=? AND fire_seq=? AND owner=? AND notified=0")
+            );
+            stmt->setInt64(1, e.orderId);
+            stmt->setInt(2, ClaimSeq(e));
+            stmt->setString(3, m_claimOwner);
+            stmt->executeUpdate();
+            return true;
+        }
+        catch (sql::SQLException& ex) {
+            printf("[DB ERROR] 释放认领失败 orderId=%ld: %s\n", e.orderId, ex.what());
+            fflush(stdout);
+            return false;
+        }
+    }
 
-            if (triggered)
+    // 通知已发出：标记认领记录，存活实例不再接管
+    bool MarkClaimNotified(const TriggerEvent& e)
+    {
+        try {
+            unique_ptr<sql::Connection> conn(GetConn());
+            unique_ptr<sql::PreparedStatement> stmt(
+                conn->prepareStatement("UPDATE " + Config::Instance().claimTable + " SET notified=1 WHERE orderId=? AND fire_seq=?")
+            );
+            stmt->setInt64(1, e.orderId);
+            stmt->setInt(2, ClaimSeq(e));
+            stmt->executeUpdate();
+            return true;
+        }
+        catch (sql::SQLException& ex) {
+            printf("[DB ERROR] 标记已通知失败 orderId=%ld: %s\n", e.orderId, ex.what());
+            fflush(stdout);
+            return false;
+        }
+    }
+
+    // reload 线程每轮调用：接管租约已过期仍未通知的认领（认领方崩溃或与 DB 失联），逐条续租成功后交给 outbox 通知
+    void TakeOverExpiredClaims()
+    {
+        Config& cfg = Config::Instance();
+        vector<TriggerEvent> events;
+        try {
+            unique_ptr<sql::Connection> conn(GetConn());
+            unique_ptr<sql::Statement> stmt(conn->createStatement());
+            unique_ptr<sql::ResultSet> res(stmt->executeQuery(
+                "SELECT orderId, fire_seq, owner, account, symbol, price, reason, detect_ms FROM " + cfg.claimTable +
+                " WHERE notified=0 AND lease_until < NOW(3) LIMIT 100"));
+
+            unique_ptr<sql::PreparedStatement> take(
+                conn->prepareStatement("UPDATE " + cfg.claimTable + " SET owner=?, lease_until=NOW(3) + INTERVAL " +
+                    std::to_string(cfg.claimLeaseSec) + " SECOND WHERE orderId=? AND fire_seq=? AND notified=0 AND lease_until < NOW(3)")
+            );
+            while (res->next())
             {
-                // 先通知并在 DB 标记
-                m_notifier->Notify(a.account, symbol, price, reason);
-                MarkAlertTriggered(a.orderId);
+                TriggerEvent e;
+                e.orderId = (long)res->getInt64("orderId");
+                e.fireSeq = res->getInt("fire_seq");
+                e.claimSeq = e.fireSeq;
+                e.final = e.fireSeq == 0;
+                e.account = res->getString("account");
+                e.symbol = res->getString("symbol");
+                e.price = res->getDouble("price");
+                e.reason = res->getString("reason");
+                e.detectMs = res->getInt64("detect_ms");
+                string from = res->getString("owner");
+
+                take->setString(1, m_claimOwner);
+                take->setInt64(2, e.orderId);
+                take->setInt(3, e.fireSeq);
+                if (take->executeUpdate() == 0)
+                    continue;       // 已被其他实例接管或刚刚通知
+                printf("[CLAIM] 接管 %s 未通知的触发 orderId=%ld fire_seq=%d\n", from.c_str(), e.orderId, e.fireSeq);
+                events.push_back(std::move(e));
+            }
+
+            // 每小时清理一次通知完成（或放弃）超过一天的认领记录
+            if (SteadyMs() - m_lastClaimPurgeMs >= 3600 * 1000LL) {
+                m_lastClaimPurgeMs = SteadyMs();
+                stmt->executeUpdate("DELETE FROM " + cfg.claimTable +
+                    " WHERE notified<>0 AND lease_until < NOW(3) - INTERVAL 1 DAY LIMIT 10000");
+            }
+        }
+        catch (sql::SQLException& e) {
+            printf("[DB ERROR] TakeOverExpiredClaims: %s\n", e.what());
+        }
+        fflush(stdout);
+
+        m_claimTakenOver.fetch_add(events.size());
+        m_outbox.AppendClaimed(events);
+    }
+
+    static string ComputerName()
+    {
+        char name[MAX_COMPUTERNAME_LENGTH + 1] = { 0 };
+        DWORD size = sizeof(name);
+        return GetComputerNameA(name, &size) ? string(name, size) : string("alert-core");
+    }
+
+    // =====================================================
+    // =============== 2. 行情 API 相关（你原来就有） ==========
+    // =====================================================
+
+    // [MarketData] Address 可用逗号分隔多个前置：同一快照哪个前置先到用哪个，单个前置断开时其余前置继续供数。
+    // [MarketData] Partitions = K 时每个前置再拆成 K 个会话，各订阅一部分合约，K 个 SDK 回调线程并行判断预警。
+    // 每个会话都有独立的流文件目录与回调线程。
+    void connect()
+    {
+        if (!m_sessions.empty()) return;
+        m_connectUs = SteadyUs();
+
+        Config& cfg = Config::Instance();
+        vector<string> fronts;
+        stringstream ss(cfg.mdAddress);
+        string front;
+        while (getline(ss, front, ',')) {
+            front.erase(0, front.find_first_not_of(" \t"));
+            front.erase(front.find_last_not_of(" \t") + 1);
+            if (!front.empty()) fronts.push_back(front);
+        }
+        if (fronts.size() > (size_t)kMaxFronts) {
+            printf("[MD] 前置数量 %zu 超过上限 %d，只使用前 %d 个\n", fronts.size(), kMaxFronts, kMaxFronts);
+            fronts.resize(kMaxFronts);
+        }
+
+        // CTP 的 .con 流文件按目录区分，多个 MdApi 不能共用同一目录
+        CreateDirectoryA(cfg.mdFlowDir.c_str(), nullptr);
+
+        vector<int> callbackCpus = ParseCpuList(cfg.threadCallbackCpus);
+        uint64_t serviceMask = CpuMask(ParseCpuList(cfg.threadServiceCpus));
+        if (cfg.threadRealtime != 0)
+            RaiseProcessPriority();
+
+        size_t partitions = m_partitions;
+        vector<string> names;
+        for (size_t i = 0; i < fronts.size() * partitions; ++i)
+        {
+            size_t f = i / partitions, k = i % partitions;
+            MdSessionOptions o;
+            o.name = "front" + to_string(f);
+            if (partitions > 1) o.name += "-p" + to_string(k);
+            o.front = fronts[f];
+            o.flowPath = cfg.mdFlowDir + "/" + o.name + "/";
+            CreateDirectoryA(o.flowPath.c_str(), nullptr);
+            o.brokerId = cfg.brokerId;
+            o.userId = cfg.userId;
+            o.password = cfg.password;
+            o.backoffBaseMs = cfg.sessionBackoffBaseMs;
+            o.backoffMaxMs = cfg.sessionBackoffMaxMs;
+            o.subscribeChunk = cfg.sessionSubscribeChunk;
+            o.transport = ParseMdTransport(cfg.mdTransport);
+            o.multicastTopicId = cfg.mdMulticastTopicId;
+            o.quietFallbackMs = cfg.mdQuietFallbackMs;
+            o.tcpFallbackFront = cfg.mdTcpFallbackAddress;
+            o.feedExpected = [this, i]() { return FeedExpected((int)i); };
+            o.callbackCpu = PickCpu(callbackCpus, i);
+            o.serviceMask = serviceMask;
+            o.realtime = cfg.threadRealtime != 0;
+
+            if (k == 0)
+                names.push_back("front" + to_string(f) + "(" + o.front + ")");
+            m_sessions.push_back(make_unique<MdSession>((int)i, o,
+                [this](int index, const CThostFtdcDepthMarketDataField& d, int64_t recvUs) {
+                    OnTick(index, d, recvUs);
+                },
+                [this](int index, int state) {
+                    OnSessionState(index, state);
+                }));
+        }
+        m_fanIn->SetFronts(names);
+
+        // 判断线程须在会话开始回调之前就绪
+        if (cfg.evalWorkers > 0) {
+            EvalPoolOptions eo;
+            eo.workers = (int)m_shards.size();
+            eo.producers = (int)m_sessions.size();
+            eo.queueSize = (size_t)cfg.evalQueueSize;
+            eo.idle = ParseEvalIdleMode(cfg.evalIdle);
+            eo.spinUs = cfg.evalSpinUs;
+            eo.cpus = ParseCpuList(cfg.threadEvalCpus);
+            eo.realtime = cfg.threadRealtime != 0;
+            m_evalPool.Start(eo,
+                [this](int worker, const EvalTask& task) {
+                    EvaluateTick((size_t)worker, task.instrumentId, task.symbol, task.tick);
+                });
+        }
+
+        for (auto& session : m_sessions)
+            session->Start();
+        printf("Market data API initialized (%zu fronts x %zu partitions)\n", fronts.size(), partitions);
+        fflush(stdout);
+
+        // 不在这里直接调用 ReqUserLogin，由各会话在 OnFrontConnected 后登录。
+    }
+
+    bool AnyLoggedIn() const
+    {
+        for (const auto& session : m_sessions)
+            if (session->IsLoggedIn()) return true;
+        return false;
+    }
+
+    // 仍保留 login 接口：如果外部调用，会等待任一前置登录成功（最长等待若干秒）
+    void login(int timeoutSeconds = 10)
+    {
+        {
+            unique_lock<mutex> lk(m_startupMutex);
+            m_startupCv.wait_for(lk, chrono::seconds(timeoutSeconds), [this]() { return AnyLoggedIn(); });
+        }
 
-                // 立即记录，需要在内存中移除，避免短时间重复触发
-                triggeredIds.push_back(a.orderId);
+        if (AnyLoggedIn()) {
+            printf("Login successful (confirmed)\n");
+            fflush(stdout);
+        }
+        else {
+            printf("Login not confirmed within timeout\n");
+            fflush(stdout);
+        }
+    }
+
+    // 设置订阅集合；登录后由各会话分批订阅，断线重登后自动重新订阅同一集合
+    void subscribe(const vector<string>& contracts)
+    {
+        // 添加输出，显示即将订阅的合约
+        printf("Subscribing to %zu instruments:\n", contracts.size());
+        for (const auto& contract : contracts) {
+            printf("  - %s\n", contract.c_str());
+        }
+        fflush(stdout);
+
+        // 按合约 id 分区（未启用判断线程时与预警簿分片一致）
+        size_t partitions = m_partitions;
+        vector<vector<string>> parts(partitions);
+        for (const auto& s : contracts)
+            parts[PartitionOf(m_registry.GetOrAdd(s))].push_back(s);
+        m_instruments.Sync(m_registry);     // 新合约的元数据在首个 tick 之前就位
+        {
+            lock_guard<mutex> lk(m_subscribeMutex);
+            m_subscribed.insert(contracts.begin(), contracts.end());
+            m_subscribeStarted = true;
+        }
+        for (size_t i = 0; i < m_sessions.size(); ++i)
+            m_sessions[i]->SetInstruments(parts[i % partitions]);
+
+        if (partitions > 1) {
+            for (size_t k = 0; k < partitions; ++k)
+                printf("  partition %zu: %zu instruments\n", k, parts[k].size());
+            fflush(stdout);
+        }
+
+        // 等待首次订阅完成（最长 5 秒），未完成的会话由其会话线程继续重试；没有分到合约的会话登录即算完成
+        size_t ready = 0;
+        auto allReady = [&]() {
+            ready = 0;
+            for (size_t i = 0; i < m_sessions.size(); ++i) {
+                int state = m_sessions[i]->State();
+                if (state == MD_READY || (state == MD_LOGGED_IN && parts[i % partitions].empty()))
+                    ready++;
             }
+            return ready == m_sessions.size();
+        };
+        {
+            unique_lock<mutex> lk(m_startupMutex);
+            m_startupCv.wait_for(lk, chrono::seconds(5), allReady);
+        }
+        ReportStartup(ready);
+
+        if (ready > 0) {
+            printf("Successfully subscribed to market data (%zu/%zu sessions)\n", ready, m_sessions.size());
         }
+        else {
+            printf("Warning: subscription not completed yet, session threads will keep retrying\n");
+        }
+        fflush(stdout);
+    }
 
-        // 如果有触发项，移除内存缓存中的对应条目（线程安全）
-        if (!triggeredIds.empty())
+    // 增量加入的预警引用了尚未订阅的合约时追加订阅（合成合约订阅两条腿）；首次 subscribe() 之前不处理
+    void EnsureSubscribed(const vector<string>& symbols)
+    {
+        vector<vector<string>> parts(m_partitions);
+        size_t added = 0;
         {
-            lock_guard<mutex> lk(m_alertMutex);
-            auto it = m_alertMap.find(symbol);
-            if (it != m_alertMap.end())
+            lock_guard<mutex> lk(m_subscribeMutex);
+            if (!m_subscribeStarted)
+                return;
+            for (const auto& symbol : symbols)
             {
-                auto& vec = it->second;
-                vec.erase(std::remove_if(vec.begin(), vec.end(),
-                    [&](const AlertOrder& x) {
-                        return std::find(triggeredIds.begin(), triggeredIds.end(), x.orderId) != triggeredIds.end();
-                    }), vec.end());
+                string legA, legB;
+                char op;
+                vector<string> legs;
+                if (ParseSyntheticSymbol(symbol, legA, legB, op))
+                    legs = { legA, legB };
+                else
+                    legs = { symbol };
+                for (const auto& s : legs) {
+                    if (m_subscribed.insert(s).second) {
+                        parts[PartitionOf(m_registry.GetOrAdd(s))].push_back(s);
+                        added++;
+                    }
+                }
+            }
+        }
+        if (added == 0)
+            return;
 
-                if (vec.empty())
-                    m_alertMap.erase(it);
+        m_instruments.Sync(m_registry);
+        for (size_t i = 0; i < m_sessions.size(); ++i)
+            if (!parts[i % m_partitions].empty())
+                m_sessions[i]->AddInstruments(parts[i % m_partitions]);
+        printf("[SUBSCRIBE] 追加订阅 %zu 个合约\n", added);
+        fflush(stdout);
+    }
+
+    // 登录成功 / 订阅完成时由会话调用（持有会话锁），只做记录与唤醒
+    // UDP / 组播静默回退的前提（会话线程持会话锁调用，只读无锁状态）：
+    // 其他会话仍在收到行情，说明只是这一路失效；都没有行情时按该会话所订阅分区的合约交易时段判断，
+    // 有合约开盘已超过集合竞价的几分钟才算应有行情。这些合约都没有交易时段时无法区分休市，按应有行情处理
+    bool FeedExpected(int index)
+    {
+        int64_t quietUs = Config::Instance().mdQuietFallbackMs * 1000LL;
+        int64_t now = SteadyUs();
+        for (const auto& session : m_sessions) {
+            int64_t last = session->LastTickUs();
+            if (session->Index() != index && last > 0 && now - last < quietUs)
+                return true;
+        }
+
+        time_t t = time(nullptr);
+        tm local = { 0 };
+        localtime_s(&local, &t);
+        int minute = local.tm_hour * 60 + local.tm_min;
+        int opened = (minute - TradingSessions::kPreOpenMinutes + 1440) % 1440;
+        bool known = false;
+        for (int id = 0, n = m_registry.Size(); id < n; ++id) {
+            if (PartitionOf(id) != (size_t)index % m_partitions)
+                continue;
+            const TradingSessions* sessions = m_instruments.Sessions(id);
+            if (!sessions) continue;
+            known = true;
+            if (sessions->Contains(minute) && sessions->Contains(opened))
+                return true;
+        }
+        return !known;
+    }
+
+    void OnSessionState(int index, int state)
+    {
+        if (state == MD_LOGGED_IN || state == MD_SUBSCRIBING) {
+            int64_t none = 0;
+            m_firstLoginUs.compare_exchange_strong(none, SteadyUs());
+        }
+        {
+            lock_guard<mutex> lk(m_startupMutex);
+        }
+        m_startupCv.notify_all();
+    }
+
+    // 首次订阅后输出启动各阶段耗时（以开始连接前置为起点）
+    void ReportStartup(size_t ready)
+    {
+        if (m_startupReported || m_connectUs == 0) return;
+        m_startupReported = true;
+
+        auto since = [this](int64_t us) { return us > 0 ? (us - m_connectUs) / 1000.0 : -1.0; };
+        printf("[STARTUP] 首个会话登录 %.1f ms，预警加载完成 %.1f ms，订阅就绪 %.1f ms（%zu/%zu 个会话）\n",
+            since(m_firstLoginUs.load()), since(m_alertsLoadedUs.load()), since(SteadyUs()),
+            ready, m_sessions.size());
+        fflush(stdout);
+    }
+
+    void unsubscribe()
+    {
+        for (auto& session : m_sessions)
+            session->Unsubscribe();
+    }
+
+    size_t SessionCount() const { return m_sessions.size(); }
+
+    SessionMetrics GetSessionMetrics(size_t index)
+    {
+        return m_sessions[index]->GetMetrics();
+    }
+
+    // =====================================================
+    // =============== 3. 行情回调处理 ========================
+    // =====================================================
+
+    // 去重后的 tick 写入共享内存行情总线（字段与 TickRecord 的 TF_LAST..TF_LOWER_LIMIT 一一对应）
+    void PublishTick(int id, const char* symbol, const TickRecord& tick, int msOfDay)
+    {
+        TickBusTick t;
+        t.last = tick.v[TF_LAST];
+        t.bid = tick.v[TF_BID];
+        t.ask = tick.v[TF_ASK];
+        t.bidVolume = tick.v[TF_BID_VOLUME];
+        t.askVolume = tick.v[TF_ASK_VOLUME];
+        t.volume = tick.v[TF_VOLUME];
+        t.turnover = tick.v[TF_TURNOVER];
+        t.openInterest = tick.v[TF_OPEN_INTEREST];
+        t.open = tick.v[TF_OPEN];
+        t.high = tick.v[TF_HIGH];
+        t.low = tick.v[TF_LOW];
+        t.preClose = tick.v[TF_PRE_CLOSE];
+        t.preSettlement = tick.v[TF_PRE_SETTLEMENT];
+        t.upperLimit = tick.v[TF_UPPER_LIMIT];
+        t.lowerLimit = tick.v[TF_LOWER_LIMIT];
+        t.msOfDay = msOfDay;
+        m_tickBus.Publish(id, symbol, t);
+    }
+
+    // 各会话的 SDK 回调线程调用：先按快照去重，只有首次到达的快照进入预警判断
+    void OnTick(int session, const CThostFtdcDepthMarketDataField& d, int64_t recvUs)
+    {
+        int front = session / (int)m_partitions;
+        string symbol = d.InstrumentID;
+        TickRecord tick;
+        NormalizeTick(d, tick);
+        tick.recvUs = recvUs;
+
+        int id = m_registry.Find(symbol);
+        if (id < 0)
+            id = m_registry.GetOrAdd(symbol);
+
+        // 字段校验并换算定点价格；无效、时间偏差过大或不在交易时段的快照不参与去重与判断
+        if (m_tickValidator.Check(tick, m_instruments.PriceTick(id), m_instruments.Sessions(id), WallMs()) != TICK_OK)
+            return;
+        double multiplier = m_instruments.Multiplier(id);
+        tick.v[TF_MULTIPLIER] = multiplier > 0.0 ? multiplier : NAN;
+
+        int msOfDay = std::isnan(tick.time) ? -1 : (int)llround(tick.time * 1000.0);
+        if (m_fanIn->Offer(id, front, msOfDay, d.Volume, recvUs) != TickFanIn::TICK_FIRST)
+            return;
+
+        // 逐笔控制台输出会阻塞回调线程，只在调试时打开
+        if (m_logTicks) {
+            printf("Received market data for %s: LastPrice=%.2f\n",
+                d.InstrumentID, d.LastPrice);
+            fflush(stdout);
+        }
+
+        // 更新行情缓存
+        if (id >= 0 && !std::isnan(tick.v[TF_LAST]))
+            m_registry.SetLastPrice(id, tick.v[TF_LAST]);
+
+        if (m_tickBus.IsOpen())
+            PublishTick(id, d.InstrumentID, tick, msOfDay);
+
+        // 目标分片：合约自身所在分片 + 依赖它的价差/比价所在分片（位掩码，分片数不超过 32）
+        uint64_t targets = 1ULL << ShardIndexOf(id);
+        shared_ptr<const SyntheticGraph> graph = std::atomic_load(&m_synthetics);
+        if (const vector<int>* deps = graph->Dependents(id)) {
+            for (int index : *deps)
+                targets |= 1ULL << ShardIndexOf(graph->Node(index).legA);
+        }
+
+        if (m_evalPool.Running()) {
+            EvalTask task;
+            task.tick = tick;
+            task.instrumentId = id;
+            strncpy_s(task.symbol, d.InstrumentID, _TRUNCATE);
+            for (size_t i = 0; i < m_shards.size(); ++i)
+                if (targets & (1ULL << i))
+                    m_evalPool.Push(session, (int)i, task);
+        }
+        else {
+            for (size_t i = 0; i < m_shards.size(); ++i)
+                if (targets & (1ULL << i))
+                    EvaluateTick(i, id, symbol, tick);
+        }
+    }
+
+    // 在分片 shardIndex 内判断一个 tick：
+    // 合约属于本分片时判断它自己的预警，再重算依赖它、且存放在本分片的价差/比价并判断其预警
+    void EvaluateTick(size_t shardIndex, int id, const string& symbol, const TickRecord& tick)
+    {
+        AlertShard& shard = *m_shards[shardIndex];
+        shared_ptr<const SyntheticGraph> graph = std::atomic_load(&m_synthetics);
+        const vector<int>* deps = id >= 0 ? graph->Dependents(id) : nullptr;
+
+        lock_guard<mutex> lk(shard.mtx);
+        if (ShardIndexOf(id) == shardIndex) {
+            // 多前置时同一合约的 tick 可能经不同队列乱序到达，比已判断的更旧（且不是跨日）则丢弃
+            if (id >= 0 && !std::isnan(tick.time)) {
+                double& last = shard.lastTickTime[id];
+                if (tick.time < last && last - tick.time < 600.0)
+                    return;
+                last = tick.time;
+            }
+            CheckAlert(shard, symbol, tick);
+        }
+
+        if (!deps) return;
+        for (int index : *deps)
+        {
+            const SyntheticInstrument& s = graph->Node(index);
+            if (ShardIndexOf(s.legA) != shardIndex)
+                continue;
+
+            double value;
+            if (!SyntheticGraph::Compute(s, m_registry, value))
+                continue;
+
+            // 合成合约只有 last 有意义，其余字段置为缺失
+            TickRecord t;
+            for (double& v : t.v) v = NAN;
+            t.v[TF_LAST] = value;
+            t.v[TF_PRICE_TICK] = tick.v[TF_PRICE_TICK];
+            t.time = tick.time;
+            t.recvUs = tick.recvUs;
+            t.priceUnit = kSyntheticPriceUnit;
+            t.lastTicks = PriceToTicks(value, kSyntheticPriceUnit);
+            t.bidTicks = kNoTicks;
+            t.askTicks = kNoTicks;
+            CheckAlert(shard, s.name, t);
+        }
+    }
+
+    // CTP 用 DBL_MAX 表示缺失字段，统一转换为 NaN
+    static double NormalizePrice(double v)
+    {
+        return (v == DBL_MAX || v == -DBL_MAX) ? NAN : v;
+    }
+
+    static void NormalizeTick(const CThostFtdcDepthMarketDataField& d, TickRecord& t)
+    {
+        t.v[TF_LAST] = NormalizePrice(d.LastPrice);
+        t.v[TF_BID] = NormalizePrice(d.BidPrice1);
+        t.v[TF_ASK] = NormalizePrice(d.AskPrice1);
+        t.v[TF_BID_VOLUME] = d.BidVolume1;
+        t.v[TF_ASK_VOLUME] = d.AskVolume1;
+        t.v[TF_VOLUME] = d.Volume;
+        t.v[TF_TURNOVER] = NormalizePrice(d.Turnover);
+        t.v[TF_OPEN_INTEREST] = NormalizePrice(d.OpenInterest);
+        t.v[TF_OPEN] = NormalizePrice(d.OpenPrice);
+        t.v[TF_HIGH] = NormalizePrice(d.HighestPrice);
+        t.v[TF_LOW] = NormalizePrice(d.LowestPrice);
+        t.v[TF_PRE_CLOSE] = NormalizePrice(d.PreClosePrice);
+        t.v[TF_PRE_SETTLEMENT] = NormalizePrice(d.PreSettlementPrice);
+        t.v[TF_UPPER_LIMIT] = NormalizePrice(d.UpperLimitPrice);
+        t.v[TF_LOWER_LIMIT] = NormalizePrice(d.LowerLimitPrice);
+        // 价差、最小变动价位与定点价格由 TickValidator 填充
+        t.v[TF_SPREAD] = NAN;
+        t.v[TF_PRICE_TICK] = 1.0;
+        t.v[TF_MULTIPLIER] = NAN;
+        t.lastTicks = t.bidTicks = t.askTicks = kNoTicks;
+        t.priceUnit = kFallbackPriceUnit;
+
+        int hh = 0, mm = 0, ss = 0;
+        if (sscanf_s(d.UpdateTime, "%d:%d:%d", &hh, &mm, &ss) == 3)
+            t.time = hh * 3600 + mm * 60 + ss + d.UpdateMillisec / 1000.0;
+        else
+            t.time = NAN;
+    }
+
+    enum AlertEvalResult { ALERT_EVAL_NONE, ALERT_EVAL_REARMED, ALERT_EVAL_FIRED };
+
+    static int64_t SteadyMs()
+    {
+        return chrono::duration_cast<chrono::milliseconds>(
+            chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    static int64_t SteadyUs()
+    {
+        return chrono::duration_cast<chrono::microseconds>(
+            chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    static int64_t WallMs()
+    {
+        return chrono::duration_cast<chrono::milliseconds>(
+            chrono::system_clock::now().time_since_epoch()).count();
+    }
+
+    // 交易所时间（当日秒数）格式化为 "HH:MM:SS.mmm"
+    static string FormatExchangeTime(double t)
+    {
+        if (std::isnan(t)) return string();
+        long long ms = (long long)(t * 1000.0 + 0.5);
+        char buf[16];
+        snprintf(buf, sizeof(buf), "%02lld:%02lld:%02lld.%03lld",
+            ms / 3600000 % 24, ms / 60000 % 60, ms / 1000 % 60, ms % 1000);
+        return buf;
+    }
+
+    // 单条预警的状态机：
+    //   ARMED --任一条件满足且已过冷却期--> 触发，进入 WAIT_REARM
+    //   WAIT_REARM --价格回撤出 rearm_band、规则/时间条件不再满足--> ARMED
+    static AlertEvalResult EvaluateAlert(AlertOrder& a, const TickRecord& tick,
+        time_t now, int64_t nowMs, string& reason)
+    {
+        // 价格判断只比较定点整数
+        if (a.ticks_unit != tick.priceUnit)
+            a.PrepareTicks(tick.priceUnit);
+        int64_t price = tick.lastTicks;
+        bool hasPrice = price != kNoTicks;
+        bool hitMax = a.max_price > 0 && hasPrice && price >= a.max_ticks;
+        bool hitMin = a.min_price > 0 && hasPrice && price <= a.min_ticks;
+        bool hitTime = a.trigger_at != 0 && now >= a.trigger_at;     // trigger_time 已在加载时解析
+        bool hitRule = a.compiled_rule && a.compiled_rule->Eval(tick, a.rule_bounds.data());
+
+        if (a.rt.arm_state == ALERT_WAIT_REARM)
+        {
+            bool clearMax = !(a.max_price > 0) || (hasPrice && price <= a.clear_max_ticks);
+            bool clearMin = !(a.min_price > 0) || (hasPrice && price >= a.clear_min_ticks);
+            if (clearMax && clearMin && !hitTime && !hitRule) {
+                a.rt.arm_state = ALERT_ARMED;
+                return ALERT_EVAL_REARMED;
             }
+            return ALERT_EVAL_NONE;
         }
+
+        if (!(hitMax || hitMin || hitTime || hitRule))
+            return ALERT_EVAL_NONE;
+        if (a.rt.fire_count > 0 && nowMs - a.rt.last_fire_ms < a.cooldown_sec * 1000LL)
+            return ALERT_EVAL_NONE;
+
+        if (hitMax) reason = ">= 上限 " + to_string(a.max_price);
+        if (hitMin) reason = "<= 下限 " + to_string(a.min_price);
+        if (hitTime) reason = "到达预定时间 " + a.trigger_time;
+        if (hitRule) reason = "满足规则 " + a.rule;
+
+        a.rt.fire_count++;
+        a.rt.last_fire_ms = nowMs;
+        a.rt.arm_state = ALERT_WAIT_REARM;
+
+        if (a.repeat_max < 0 || a.repeat_max > 1)
+            reason += "（第 " + to_string(a.rt.fire_count) + " 次）";
+        return ALERT_EVAL_FIRED;
+    }
+
+    // 根据 symbol 和归一化行情判断预警（需持有 shard.mtx）
+    // 原地推进每条预警的状态机（不拷贝预警列表），触发事件交给 outbox 异步落盘、通知与更新 DB
+    void CheckAlert(AlertShard& shard, const string& symbol, const TickRecord& tick)
+    {
+        vector<TriggerEvent> fired;
+        time_t now = time(0);
+        int64_t nowMs = SteadyMs();
+        int64_t wallMs = WallMs();
+
+        auto it = shard.alertMap.find(symbol);
+        if (it == shard.alertMap.end())
+            return;
+
+        // 先增量更新指标，再用最新指标值判断规则
+        auto ind = shard.indicatorMap.find(symbol);
+        if (ind != shard.indicatorMap.end())
+            ind->second->Update(tick);
+
+        bool anyExhausted = false;
+        for (auto& a : it->second)
+        {
+            string reason;
+            AlertEvalResult r = EvaluateAlert(a, tick, now, nowMs, reason);
+            if (r == ALERT_EVAL_NONE)
+                continue;
+
+            bool exhausted = a.Exhausted();
+            if (r == ALERT_EVAL_FIRED) {
+                TriggerEvent e;
+                e.orderId = a.orderId;
+                e.fireSeq = a.rt.fire_count;
+                e.final = exhausted;
+                e.priority = (uint8_t)(a.priority > 0 ? (a.priority < 255 ? a.priority : 255) : 0);
+                e.account = a.account;
+                e.symbol = symbol;
+                e.price = tick.v[TF_LAST];
+                e.reason = reason;
+                e.detectMs = wallMs;
+                e.exchangeTime = FormatExchangeTime(tick.time);
+                e.detectLatencyUs = (int32_t)(SteadyUs() - tick.recvUs);
+                fired.push_back(std::move(e));
+            }
+
+            // 状态变化只记在内存，重新布防不访问 DB
+            if (exhausted) {
+                shard.runtime.erase(a.orderId);
+                anyExhausted = true;
+            }
+            else {
+                shard.runtime[a.orderId] = make_pair(symbol, a.rt);
+            }
+        }
+
+        // 达到最大次数的预警立即从内存移除，避免短时间重复触发
+        if (anyExhausted)
+        {
+            auto& vec = it->second;
+            vec.erase(std::remove_if(vec.begin(), vec.end(),
+                [](const AlertOrder& x) { return x.Exhausted(); }), vec.end());
+
+            if (vec.empty())
+                shard.alertMap.erase(it);
+        }
+
+        // 在分片锁内登记，保证并发的 reload 能看到这些待写 DB 的最终触发
+        m_outbox.Append(fired);
     }
 
     // 获取最新价（用于心跳打印）
     bool GetLastPrice(const string& ins, double& out)
     {
-        lock_guard<mutex> lk(m_priceMutex);
-        auto it = m_lastPrices.find(ins);
-        if (it == m_lastPrices.end()) return false;
-        out = it->second;
+        int id = m_registry.Find(ins);
+        if (id < 0) return false;
+        double p = m_registry.LastPrice(id);
+        if (std::isnan(p)) return false;
+        out = p;
         return true;
     }
 };
@@ -0,0 +1,206 @@
+﻿#pragma once
+#include "TriggerEvent.h"
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <functional>
+#include <chrono>
+#include <atomic>
+#include <memory>
+
+// =========================================================
+// ===========   通知合并：按账户汇总为摘要   ===========
+// =========================================================
+//
+// 同一账户在窗口期（从该账户第一条未发送的触发开始计时）内的触发合并为一条通知。
+// 以下情况立即发送该账户已积攒的全部触发：
+//   - 收到高优先级（priority > 0）的触发
+//   - 积攒条数达到 maxItems
+// 行情跳空时一个账户的几十条预警只产生一封邮件（一次邮箱查询、一次 SMTP 会话）。
+// 发送在独立线程中串行执行，Submit() 不会被慢速的通知渠道阻塞。
+// 每条触发的发送结果经完成回调逐条送回（outbox 据此确认或重试）；退出时尚未发送的触发不再发送，
+// 它们在 outbox 中仍未确认，下次启动重发。
+
+class NotificationDigest
+{
+public:
+    // 一批触发的发送结果（NotifyResult），可在任意线程、也可在 FlushHandler 返回前调用，只调用一次
+    typedef std::function<void(uint8_t result)> FlushDone;
+    // 发送一个账户的一批触发（按触发顺序）
+    typedef std::function<void(const std::string& account, const std::vector<TriggerEvent>& events, FlushDone done)> FlushHandler;
+    // 逐条送回发送结果
+    typedef std::function<void(const TriggerEvent& e, uint8_t result)> Completion;
+
+    ~NotificationDigest()
+    {
+        Stop();
+    }
+
+    void Start(int windowMs, int maxItems, FlushHandler flush, Completion done)
+    {
+        m_windowMs = windowMs > 0 ? windowMs : 0;
+        m_maxItems = maxItems > 0 ? maxItems : 1;
+        m_flush = flush;
+        m_done = done;
+        m_stop = false;
+        m_thread = std::thread([this]() { run(); });
+    }
+
+    // 退出时丢弃积攒的触发（由 outbox 下次启动重发）
+    void Stop()
+    {
+        {
+            std::lock_guard<std::mutex> lk(m_mutex);
+            m_stop = true;
+        }
+        m_cv.notify_all();
+        if (m_thread.joinable()) m_thread.join();
+    }
+
+    void Submit(const TriggerEvent& e)
+    {
+        bool wake;      // 新窗口或需立即发送：发送线程需重新计算等待时间
+        {
+            std::lock_guard<std::mutex> lk(m_mutex);
+            Bucket& b = m_buckets[e.account];
+            wake = b.events.empty();
+            if (wake)
+                b.deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(m_windowMs);
+            b.events.push_back(e);
+            if (e.priority > 0 || (int)b.events.size() >= m_maxItems) {
+                b.deadline = std::chrono::steady_clock::time_point::min();
+                wake = true;
+            }
+            m_submitted++;
+        }
+        if (wake) m_cv.notify_one();
+    }
+
+private:
+    struct Bucket
+    {
+        std::vector<TriggerEvent> events;
+        std::chrono::steady_clock::time_point deadline;
+    };
+
+    static const int64_t kReportMs = 60000;
+
+    int m_windowMs{ 0 };
+    int m_maxItems{ 50 };
+    FlushHandler m_flush;
+    Completion m_done;
+
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::unordered_map<std::string, Bucket> m_buckets;
+    bool m_stop{ false };
+    std::thread m_thread;
+
+    // 统计（m_submitted 受 m_mutex 保护，m_messages 仅发送线程访问，失败数由完成回调累加）
+    size_t m_submitted{ 0 };
+    size_t m_messages{ 0 };
+    std::atomic<size_t> m_failedMessages{ 0 };
+
+    void run()
+    {
+        auto lastReport = std::chrono::steady_clock::now();
+        for (;;)
+        {
+            std::vector<std::pair<std::string, std::vector<TriggerEvent>>> due;
+            bool stopping;
+            {
+                std::unique_lock<std::mutex> lk(m_mutex);
+                auto next = std::chrono::steady_clock::now() + std::chrono::milliseconds(kReportMs);
+                for (const auto& kv : m_buckets) {
+                    if (kv.second.deadline < next) next = kv.second.deadline;
+                }
+                m_cv.wait_until(lk, next, [this, next]() {
+                    if (m_stop) return true;
+                    for (const auto& kv : m_buckets) {
+                        if (kv.second.deadline < next) return true;     // 有新的更早到期的账户
+                    }
+                    return false;
+                });
+
+                stopping = m_stop;
+                if (stopping) {
+                    size_t left = 0;
+                    for (const auto& kv : m_buckets) left += kv.second.events.size();
+                    if (left > 0) {
+                        printf("[DIGEST] 退出时 %zu 条触发尚未发送，下次启动由 outbox 重发\n", left);
+                        fflush(stdout);
+                    }
+                    m_buckets.clear();
+                }
+                auto now = std::chrono::steady_clock::now();
+                for (auto it = m_buckets.begin(); it != m_buckets.end();) {
+                    if (it->second.deadline <= now) {
+                        due.emplace_back(it->first, std::move(it->second.events));
+                        it = m_buckets.erase(it);
+                    }
+                    else {
+                        ++it;
+                    }
+                }
+            }
+
+            // 发送线程来不及取走时一个账户可能积攒超过 maxItems 条，按 maxItems 拆分
+            for (const auto& d : due) {
+                const auto& events = d.second;
+                if (events.size() <= (size_t)m_maxItems) {
+                    send(d.first, events);
+                    continue;
+                }
+                for (size_t i = 0; i < events.size(); i += m_maxItems) {
+                    size_t end = i + m_maxItems < events.size() ? i + m_maxItems : events.size();
+                    send(d.first, std::vector<TriggerEvent>(events.begin() + i, events.begin() + end));
+                }
+            }
+
+            if (stopping)
+                break;
+
+            auto now = std::chrono::steady_clock::now();
+            if (now - lastReport >= std::chrono::milliseconds(kReportMs)) {
+                report(std::chrono::duration<double>(now - lastReport).count());
+                lastReport = now;
+            }
+        }
+    }
+
+    void send(const std::string& account, const std::vector<TriggerEvent>& events)
+    {
+        m_messages++;
+        std::shared_ptr<std::vector<TriggerEvent>> batch = std::make_shared<std::vector<TriggerEvent>>(events);
+        m_flush(account, *batch, [this, batch](uint8_t result) {
+            if (result != NOTIFY_OK)
+                m_failedMessages++;
+            if (m_done) {
+                for (const auto& e : *batch)
+                    m_done(e, result);
+            }
+        });
+    }
+
+    void report(double seconds)
+    {
+        size_t submitted;
+        {
+            std::lock_guard<std::mutex> lk(m_mutex);
+            submitted = m_submitted;
+            m_submitted = 0;
+        }
+        if (submitted == 0 && m_messages == 0)
+            return;
+
+        printf("[DIGEST] %.0fs 内 %zu 条触发合并为 %zu 条通知（%.1f 条/通知），发送失败 %zu 条\n",
+            seconds, submitted, m_messages, m_messages ? (double)submitted / m_messages : 0.0,
+            m_failedMessages.exchange(0));
+        fflush(stdout);
+        m_messages = 0;
+    }
+};
@@ -0,0 +1,402 @@
+﻿#pragma once
+#include "TriggerEvent.h"
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include <deque>
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <functional>
+#include <chrono>
+#include <algorithm>
+#include <array>
+
+// =========================================================
+// ===========   通知限流：分层令牌桶 + 延迟队列   ===========
+// =========================================================
+//
+// 每条通知（合并后的一封摘要算一条）需要同时从三层桶各取一个令牌：
+//     全局  ->  渠道（email / webhook ...）  ->  渠道内的账户
+// 任一层不足则整条不取（不会白白消耗上层令牌），通知进入该渠道的延迟队列，
+// 由后台线程在令牌恢复后按账户轮转发出，同一账户内保持先后顺序。
+// 延迟队列已满时拒绝新的通知（NOTIFY_BUSY），由调用方（outbox）稍后重试，不丢弃已排队的通知。
+// 速率 <= 0 表示该层不限流。
+
+static inline int64_t RateNowUs()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+struct RateLimit
+{
+    double perSec;      // 令牌恢复速率
+    double burst;       // 桶容量（允许的突发条数）
+};
+
+// ------------------------- 令牌桶 -------------------------
+class TokenBucket
+{
+public:
+    TokenBucket() : TokenBucket(RateLimit{ 0.0, 1.0 }) {}
+
+    explicit TokenBucket(const RateLimit& limit)
+        : m_rate(limit.perSec), m_burst(limit.burst >= 1.0 ? limit.burst : 1.0), m_tokens(m_burst) {}
+
+    bool Unlimited() const { return m_rate <= 0.0; }
+
+    void Refill(int64_t nowUs)
+    {
+        if (m_lastUs != 0 && nowUs > m_lastUs) {
+            m_tokens += (nowUs - m_lastUs) * m_rate / 1e6;
+            if (m_tokens > m_burst) m_tokens = m_burst;
+        }
+        m_lastUs = nowUs;
+    }
+
+    bool HasToken() const { return Unlimited() || m_tokens >= 1.0; }
+    void Take() { if (!Unlimited()) m_tokens -= 1.0; }
+    bool Full() const { return Unlimited() || m_tokens >= m_burst; }
+
+    // 距离下一个令牌的时间
+    int64_t WaitUs() const
+    {
+        if (HasToken()) return 0;
+        return (int64_t)((1.0 - m_tokens) / m_rate * 1e6) + 1;
+    }
+
+    double Tokens() const { return m_tokens; }
+    double Rate() const { return m_rate; }
+    double Burst() const { return m_burst; }
+    int64_t LastUs() const { return m_lastUs; }
+
+private:
+    double m_rate;
+    double m_burst;
+    double m_tokens;
+    int64_t m_lastUs{ 0 };
+};
+
+// ------------------------- 分层限流器（各渠道共享） -------------------------
+class NotifyRateLimiter
+{
+public:
+    enum Level { LEVEL_GLOBAL = 0, LEVEL_CHANNEL = 1, LEVEL_ACCOUNT = 2 };
+
+    struct BucketState
+    {
+        std::string name;
+        double tokens;
+        double burst;
+        double perSec;
+    };
+
+    NotifyRateLimiter(const RateLimit& global, const RateLimit& account)
+        : m_global(global), m_accountLimit(account) {}
+
+    void SetChannel(const std::string& channel, const RateLimit& limit)
+    {
+        std::lock_guard<std::mutex> lk(m_mutex);
+        m_channels[channel] = TokenBucket(limit);
+    }
+
+    // 三层都有令牌时一并扣除并返回 true；否则不扣除，waitUs 给出最早可重试的时间
+    bool TryAcquire(const std::string& channel, const std::string& account, int64_t& waitUs)
+    {
+        int64_t now = RateNowUs();
+        std::lock_guard<std::mutex> lk(m_mutex);
+
+        TokenBucket& c = m_channels[channel];
+        auto it = m_accounts.find(channel + "|" + account);
+        if (it == m_accounts.end())
+            it = m_accounts.emplace(channel + "|" + account, AccountBucket{ TokenBucket(m_accountLimit), now }).first;
+        TokenBucket& a = it->second.bucket;
+
+        TokenBucket* levels[] = { &m_global, &c, &a };
+        waitUs = 0;
+        for (int i = 0; i < 3; ++i) {
+            levels[i]->Refill(now);
+            if (!levels[i]->HasToken()) {
+                int64_t w = levels[i]->WaitUs();
+                if (w > waitUs) waitUs = w;
+                m_limited[channel][i]++;
+            }
+        }
+        if (waitUs > 0)
+            return false;
+
+        for (auto* b : levels) b->Take();
+        it->second.lastUsedUs = now;
+        prune(now);
+        return true;
+    }
+
+    // 全局与各渠道桶的当前状态，以及未满的账户桶数量
+    std::vector<BucketState> Snapshot(size_t& accountsThrottled)
+    {
+        int64_t now = RateNowUs();
+        std::lock_guard<std::mutex> lk(m_mutex);
+
+        std::vector<BucketState> out;
+        m_global.Refill(now);
+        out.push_back(BucketState{ "global", m_global.Tokens(), m_global.Burst(), m_global.Rate() });
+        for (auto& kv : m_channels) {
+            kv.second.Refill(now);
+            out.push_back(BucketState{ kv.first, kv.second.Tokens(), kv.second.Burst(), kv.second.Rate() });
+        }
+
+        accountsThrottled = 0;
+        for (auto& kv : m_accounts) {
+            kv.second.bucket.Refill(now);
+            if (!kv.second.bucket.HasToken()) accountsThrottled++;
+        }
+        return out;
+    }
+
+    // 该渠道的通知被各层桶挡住的次数（取出后清零）
+    std::array<size_t, 3> TakeLimitedCounts(const std::string& channel)
+    {
+        std::lock_guard<std::mutex> lk(m_mutex);
+        std::array<size_t, 3> counts = m_limited[channel];
+        m_limited[channel] = std::array<size_t, 3>{};
+        return counts;
+    }
+
+private:
+    static const int64_t kAccountIdleUs = 600LL * 1000 * 1000;     // 已回满且 10 分钟未用的账户桶回收
+
+    std::mutex m_mutex;
+    TokenBucket m_global;
+    RateLimit m_accountLimit;
+    std::unordered_map<std::string, TokenBucket> m_channels;
+    struct AccountBucket
+    {
+        TokenBucket bucket;
+        int64_t lastUsedUs;
+    };
+    std::unordered_map<std::string, AccountBucket> m_accounts;     // key = 渠道|账户
+    std::unordered_map<std::string, std::array<size_t, 3>> m_limited;
+    int64_t m_lastPruneUs{ 0 };
+
+    void prune(int64_t now)
+    {
+        if (now - m_lastPruneUs < kAccountIdleUs)
+            return;
+        m_lastPruneUs = now;
+        for (auto it = m_accounts.begin(); it != m_accounts.end();) {
+            it->second.bucket.Refill(now);
+            if (now - it->second.lastUsedUs > kAccountIdleUs && it->second.bucket.Full())
+                it = m_accounts.erase(it);
+            else
+                ++it;
+        }
+    }
+};
+
+// ------------------------- 单个渠道的延迟发送队列 -------------------------
+class DeferredDispatcher
+{
+public:
+    // 发送结果（NotifyResult），每条通知恰好一次；退出时仍在排队的通知不再回调
+    typedef std::function<void(uint8_t result)> Done;
+    // 实际发送，完成后调用 done（可在返回前调用，也可由异步渠道稍后调用）
+    typedef std::function<void(Done done)> Job;
+
+    struct Stats
+    {
+        size_t deferred;        // 当前排队条数
+        size_t peakDeferred;    // 本统计周期内的最大排队条数
+        size_t accounts;        // 有积压的账户数
+        size_t deferredTotal;   // 本周期新进入队列的条数
+        size_t sentLater;       // 本周期从队列发出的条数
+        size_t failedLater;     // 其中发送失败的条数
+        size_t rejected;        // 队列已满被拒绝（由调用方稍后重试）的条数
+    };
+
+    DeferredDispatcher(std::shared_ptr<NotifyRateLimiter> limiter, const std::string& channel, size_t maxDeferred)
+        : m_limiter(limiter), m_channel(channel), m_maxDeferred(maxDeferred)
+    {
+        m_thread = std::thread([this]() { run(); });
+    }
+
+    ~DeferredDispatcher()
+    {
+        {
+            std::lock_guard<std::mutex> lk(m_mutex);
+            m_stop = true;
+        }
+        m_cv.notify_all();
+        if (m_thread.joinable()) m_thread.join();
+        // 排队的任务可能持有异步渠道的最后引用，在成员仍有效时释放（其在途请求的回调会访问本对象）
+        m_queues.clear();
+    }
+
+    // 令牌充足且该账户没有积压时在调用线程直接发送；否则排队，发出后回调实际结果；
+    // 队列已满时立即以 NOTIFY_BUSY 回调
+    void Submit(const std::string& account, Job job, Done done)
+    {
+        {
+            std::unique_lock<std::mutex> lk(m_mutex);
+            int64_t waitUs;
+            if (m_queues.count(account) || !m_limiter->TryAcquire(m_channel, account, waitUs)) {
+                if (m_deferred >= m_maxDeferred) {
+                    m_stats.rejected++;
+                    lk.unlock();
+                    done(NOTIFY_BUSY);
+                    return;
+                }
+                enqueue(account, Pending{ std::move(job), std::move(done) });
+                m_cv.notify_one();
+                return;
+            }
+        }
+        std::lock_guard<std::mutex> send(m_sendMutex);
+        job(done);
+    }
+
+    Stats GetStats()
+    {
+        std::lock_guard<std::mutex> lk(m_mutex);
+        Stats st = m_stats;
+        st.deferred = m_deferred;
+        st.accounts = m_queues.size();
+        return st;
+    }
+
+    const std::string& Channel() const { return m_channel; }
+
+private:
+    static const int64_t kMaxWaitUs = 1000 * 1000;
+    static const int64_t kReportUs = 60LL * 1000 * 1000;
+
+    std::shared_ptr<NotifyRateLimiter> m_limiter;
+    std::string m_channel;
+    size_t m_maxDeferred;
+
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    struct Pending
+    {
+        Job job;
+        Done done;
+    };
+    std::unordered_map<std::string, std::deque<Pending>> m_queues;
+    std::deque<std::string> m_order;        // 有积压的账户，轮转发送
+    size_t m_deferred{ 0 };
+    Stats m_stats{};
+    bool m_stop{ false };
+
+    std::mutex m_sendMutex;                 // 同一渠道的发送串行执行（通知渠道本身不保证线程安全）
+    std::thread m_thread;
+
+    // 需持有 m_mutex
+    void enqueue(const std::string& account, Pending p)
+    {
+        auto& q = m_queues[account];
+        if (q.empty())
+            m_order.push_back(account);
+        q.push_back(std::move(p));
+        m_deferred++;
+        m_stats.deferredTotal++;
+        if (m_deferred > m_stats.peakDeferred)
+            m_stats.peakDeferred = m_deferred;
+    }
+
+    void run()
+    {
+        int64_t lastReport = RateNowUs();
+        std::unique_lock<std::mutex> lk(m_mutex);
+        while (!m_stop)
+        {
+            // 依次尝试每个有积压的账户，取到令牌就发出其最早的一条
+            Pending job;
+            int64_t minWait = kMaxWaitUs;
+            for (size_t n = m_order.size(); n > 0 && !job.job; --n)
+            {
+                std::string account = m_order.front();
+                m_order.pop_front();
+
+                int64_t waitUs;
+                auto& q = m_queues[account];
+                if (m_limiter->TryAcquire(m_channel, account, waitUs)) {
+                    job = std::move(q.front());
+                    q.pop_front();
+                    m_deferred--;
+                }
+                else if (waitUs < minWait) {
+                    minWait = waitUs;
+                }
+
+                if (q.empty()) m_queues.erase(account);
+                else m_order.push_back(account);
+            }
+
+            if (job.job) {
+                m_stats.sentLater++;
+                lk.unlock();
+                {
+                    Done done = std::move(job.done);
+                    std::lock_guard<std::mutex> send(m_sendMutex);
+                    job.job([this, done](uint8_t result) {
+                        if (result != NOTIFY_OK) {
+                            std::lock_guard<std::mutex> lk2(m_mutex);
+                            m_stats.failedLater++;
+                        }
+                        done(result);
+                    });
+                }
+                lk.lock();
+            }
+            else {
+                m_cv.wait_for(lk, std::chrono::microseconds(minWait));
+            }
+
+            int64_t now = RateNowUs();
+            if (now - lastReport >= kReportUs) {
+                report((now - lastReport) / 1e6);
+                lastReport = now;
+            }
+        }
+
+        if (m_deferred > 0) {
+            printf("[RATE] %s 退出时仍有 %zu 条延迟通知未发送，下次启动由 outbox 重发\n", m_channel.c_str(), m_deferred);
+            fflush(stdout);
+        }
+    }
+
+    // 需持有 m_mutex
+    void report(double seconds)
+    {
+        Stats st = m_stats;
+        st.deferred = m_deferred;
+        m_stats = Stats{};
+        m_stats.peakDeferred = m_deferred;
+        if (st.deferredTotal == 0 && st.deferred == 0 && st.rejected == 0)
+            return;
+
+        size_t throttledAccounts = 0;
+        std::vector<NotifyRateLimiter::BucketState> buckets = m_limiter->Snapshot(throttledAccounts);
+        std::array<size_t, 3> limited = m_limiter->TakeLimitedCounts(m_channel);
+
+        std::string bucketText;
+        for (const auto& b : buckets) {
+            if (b.name != "global" && b.name != m_channel) continue;
+            char buf[128];
+            if (b.perSec > 0)
+                snprintf(buf, sizeof(buf), " %s=%.1f/%.0f(%.2f/s)", b.name.c_str(), b.tokens, b.burst, b.perSec);
+            else
+                snprintf(buf, sizeof(buf), " %s=不限", b.name.c_str());
+            bucketText += buf;
+        }
+
+        printf("[RATE] %s %.0fs 内延迟 %zu 条、稍后发出 %zu 条（失败 %zu）、队列满拒绝 %zu 条，当前积压 %zu（峰值 %zu，%zu 个账户）；"
+            "令牌%s；受限账户 %zu，受限次数 全局/渠道/账户=%zu/%zu/%zu\n",
+            m_channel.c_str(), seconds, st.deferredTotal, st.sentLater, st.failedLater, st.rejected,
+            st.deferred, st.peakDeferred, m_queues.size(), bucketText.c_str(), throttledAccounts,
+            limited[0], limited[1], limited[2]);
+        fflush(stdout);
+    }
+};
@@ -0,0 +1,287 @@
+﻿#pragma once
+#include <Windows.h>
+#include <stdio.h>
+#include <string>
+#include <atomic>
+#include <functional>
+#include <type_traits>
+#include <cstdint>
+#include <cstring>
+#include <chrono>
+
+// =========================================================
+// ===========   共享内存环形缓冲（一写多读，跨进程）   ===========
+// =========================================================
+//
+// 行情总线（TickBus.h）与触发事件流（TriggerBus.h）共用的底层结构。
+// 命名共享内存（CreateFileMapping）内依次是：头部、调用方自定义区（如合约目录）、2 的幂个槽位。
+//
+// 写端：以 fetch_add 领取序号 n（可多线程同时写），写入槽位 n & mask。槽位的 seq 先置 2n+1（写入中），
+//       写完置 2n+2（已发布），读端据此判断槽位是否为所等的那一条、拷贝期间是否被覆盖（seqlock）。
+//       写端从不等待读端。
+// 读端：各自维护读游标，只读共享内存，每条消息没有系统调用；落后超过环容量（被覆盖）时跳到较新的
+//       位置并报告丢失条数。写端重启后头部的 generation 加一，读端可据此丢弃依赖旧进程的缓存。
+//
+// 槽位内容 T 必须可按字节拷贝；读端以头部的 magic / version / slotSize / extraBytes 校验兼容性。
+
+struct alignas(64) ShmRingHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t capacity;              // 槽位数（2 的幂）
+    uint32_t slotSize;
+    uint32_t extraBytes;            // 自定义区大小
+    uint32_t writerPid;
+    std::atomic<uint32_t> generation;
+    uint32_t reserved;
+    int64_t startedMs;              // 写端启动时刻（Unix 毫秒）
+    alignas(64) std::atomic<uint64_t> writeSeq;     // 已领取的序号数（下一条的序号）
+    char pad[56];
+};
+
+template<typename T>
+struct alignas(64) ShmRingSlot
+{
+    std::atomic<uint64_t> seq;      // 2n+1 写入中，2n+2 已发布第 n 条
+    T value;
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "共享内存中的原子变量必须无锁");
+
+enum ShmRingPollResult
+{
+    SHMRING_EMPTY = 0,      // 暂无新数据
+    SHMRING_OK,             // 读到一条
+    SHMRING_OVERRUN         // 落后超过环容量，已跳过 lost 条，继续 Poll 即可
+};
+
+inline int64_t ShmRingNowUs()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+inline size_t ShmRingExtraBytes(size_t extraBytes)
+{
+    return (extraBytes + 63) & ~(size_t)63;
+}
+
+// ------------------------- 写端 -------------------------
+template<typename T>
+class ShmRingWriter
+{
+    static_assert(std::is_trivially_copyable<T>::value, "槽位内容必须可按字节拷贝");
+public:
+    typedef ShmRingSlot<T> Slot;
+    // 映射完成后、对读端可见之前调用，用于初始化自定义区
+    typedef std::function<void(void* extra)> InitExtra;
+
+    ~ShmRingWriter() { Close(); }
+
+    // 创建（或接续已有的同名同规格）共享内存；capacity 向上取整为 2 的幂。tag 为日志前缀
+    bool Open(const std::string& name, uint32_t magic, uint32_t version, uint32_t capacity,
+        size_t extraBytes, const char* tag, InitExtra init = InitExtra())
+    {
+        uint32_t n = 1024;
+        while (n < capacity && n < (1u << 24)) n <<= 1;
+        extraBytes = ShmRingExtraBytes(extraBytes);
+        size_t bytes = sizeof(ShmRingHeader) + extraBytes + sizeof(Slot) * (size_t)n;
+
+        m_mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE,
+            (DWORD)((uint64_t)bytes >> 32), (DWORD)(bytes & 0xFFFFFFFF), name.c_str());
+        if (!m_mapping) {
+            printf("%s 创建共享内存 %s 失败（错误 %lu）\n", tag, name.c_str(), (unsigned long)GetLastError());
+            fflush(stdout);
+            return false;
+        }
+        bool existed = GetLastError() == ERROR_ALREADY_EXISTS;
+        void* view = MapViewOfFile(m_mapping, FILE_MAP_ALL_ACCESS, 0, 0, bytes);
+        if (!view) {
+            printf("%s 映射共享内存 %s 失败（错误 %lu）\n", tag, name.c_str(), (unsigned long)GetLastError());
+            fflush(stdout);
+            Close();
+            return false;
+        }
+        m_header = (ShmRingHeader*)view;
+        m_extra = (char*)(m_header + 1);
+        m_slots = (Slot*)(m_extra + extraBytes);
+
+        // 读端仍持有上次的共享内存（写端重启）：规格一致则接续序号，否则无法复用
+        if (existed && m_header->magic == magic) {
+            if (m_header->version != version || m_header->capacity != n ||
+                m_header->slotSize != sizeof(Slot) || m_header->extraBytes != extraBytes) {
+                printf("%s 共享内存 %s 已被其他规格占用（容量 %u），请先关闭读端\n",
+                    tag, name.c_str(), m_header->capacity);
+                fflush(stdout);
+                Close();
+                return false;
+            }
+        }
+        else {
+            m_header->version = version;
+            m_header->capacity = n;
+            m_header->slotSize = sizeof(Slot);
+            m_header->extraBytes = (uint32_t)extraBytes;
+            m_header->writeSeq.store(0, std::memory_order_relaxed);
+        }
+        m_header->writerPid = GetCurrentProcessId();
+        m_header->startedMs = ShmRingNowUs() / 1000;
+        if (init)
+            init(m_extra);
+        m_header->generation.fetch_add(1, std::memory_order_release);
+        std::atomic_thread_fence(std::memory_order_release);
+        m_header->magic = magic;
+
+        m_mask = n - 1;
+        printf("%s 共享内存 %s：%u 个槽位，%.1f MB%s\n", tag, name.c_str(), n, bytes / 1048576.0,
+            existed ? "（接续已有共享内存）" : "");
+        fflush(stdout);
+        return true;
+    }
+
+    void Close()
+    {
+        if (m_header) UnmapViewOfFile(m_header);
+        if (m_mapping) CloseHandle(m_mapping);
+        m_header = nullptr;
+        m_mapping = NULL;
+    }
+
+    bool IsOpen() const { return m_header != nullptr; }
+    void* Extra() const { return m_extra; }
+
+    // 可由多个线程同时调用；返回本条的序号
+    uint64_t Publish(const T& value)
+    {
+        uint64_t n = m_header->writeSeq.fetch_add(1, std::memory_order_relaxed);
+        Slot& slot = m_slots[n & m_mask];
+        slot.seq.store(2 * n + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        memcpy(&slot.value, &value, sizeof(T));
+        slot.seq.store(2 * n + 2, std::memory_order_release);
+        m_published.fetch_add(1, std::memory_order_relaxed);
+        return n;
+    }
+
+    // 本周期发布条数（取后清零）与累计序号
+    uint64_t TakePublished() { return m_published.exchange(0, std::memory_order_relaxed); }
+    uint64_t WriteSeq() const { return m_header->writeSeq.load(std::memory_order_relaxed); }
+
+private:
+    HANDLE m_mapping{ NULL };
+    ShmRingHeader* m_header{ nullptr };
+    char* m_extra{ nullptr };
+    Slot* m_slots{ nullptr };
+    uint64_t m_mask{ 0 };
+    std::atomic<uint64_t> m_published{ 0 };
+};
+
+// ------------------------- 读端 -------------------------
+template<typename T>
+class ShmRingReader
+{
+public:
+    typedef ShmRingSlot<T> Slot;
+
+    ~ShmRingReader() { Close(); }
+
+    // 打开已存在的共享内存；fromOldest 为真时从环中仍有效的最旧一条开始，否则只读之后发布的
+    bool Attach(const std::string& name, uint32_t magic, uint32_t version, size_t extraBytes, bool fromOldest)
+    {
+        m_mapping = OpenFileMappingA(FILE_MAP_READ, FALSE, name.c_str());
+        if (!m_mapping)
+            return false;
+        void* view = MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+        if (!view) {
+            Close();
+            return false;
+        }
+        m_header = (const ShmRingHeader*)view;
+        if (m_header->magic != magic || m_header->version != version ||
+            m_header->slotSize != sizeof(Slot) || m_header->extraBytes != ShmRingExtraBytes(extraBytes)) {
+            Close();
+            return false;
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        m_extra = (const char*)(m_header + 1);
+        m_slots = (const Slot*)(m_extra + m_header->extraBytes);
+        m_capacity = m_header->capacity;
+        m_mask = m_capacity - 1;
+        m_generation = m_header->generation.load(std::memory_order_acquire);
+
+        uint64_t head = m_header->writeSeq.load(std::memory_order_acquire);
+        m_next = fromOldest && head > m_capacity ? head - m_capacity : (fromOldest ? 0 : head);
+        return true;
+    }
+
+    void Close()
+    {
+        if (m_header) UnmapViewOfFile(m_header);
+        if (m_mapping) CloseHandle(m_mapping);
+        m_header = nullptr;
+        m_mapping = NULL;
+    }
+
+    bool IsAttached() const { return m_header != nullptr; }
+    const void* Extra() const { return m_extra; }
+
+    // 读取下一条；只访问共享内存
+    ShmRingPollResult Poll(T& out, uint64_t& lost)
+    {
+        lost = 0;
+        uint64_t head = m_header->writeSeq.load(std::memory_order_acquire);
+        if (m_next >= head) {
+            // 写端重建了共享内存（未接续）时序号从 0 重新开始
+            if (m_next > head) m_next = head;
+            return SHMRING_EMPTY;
+        }
+        if (head - m_next > m_capacity)
+            return Skip(head, lost);
+
+        const Slot& slot = m_slots[m_next & m_mask];
+        uint64_t want = 2 * m_next + 2;
+        uint64_t before = slot.seq.load(std::memory_order_acquire);
+        if (before < want)
+            return SHMRING_EMPTY;       // 已领取序号但尚未写完
+        if (before > want)
+            return Skip(m_header->writeSeq.load(std::memory_order_acquire), lost);
+
+        memcpy(&out, &slot.value, sizeof(T));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.seq.load(std::memory_order_relaxed) != before)
+            return Skip(m_header->writeSeq.load(std::memory_order_acquire), lost);
+        m_next++;
+        return SHMRING_OK;
+    }
+
+    // 下一条将读取的序号
+    uint64_t Position() const { return m_next; }
+
+    uint32_t Generation() const { return m_header->generation.load(std::memory_order_acquire); }
+    bool WriterRestarted() const { return Generation() != m_generation; }
+    void AcknowledgeRestart() { m_generation = Generation(); }
+    uint64_t Overruns() const { return m_overruns; }
+
+private:
+    // 被覆盖：跳到较新的位置（留出半个环的余量，避免紧接着再次被覆盖）
+    ShmRingPollResult Skip(uint64_t head, uint64_t& lost)
+    {
+        uint64_t target = head > m_capacity / 2 ? head - m_capacity / 2 : 0;
+        if (target <= m_next)
+            target = m_next + 1;
+        lost = target - m_next;
+        m_overruns += lost;
+        m_next = target;
+        return SHMRING_OVERRUN;
+    }
+
+    HANDLE m_mapping{ NULL };
+    const ShmRingHeader* m_header{ nullptr };
+    const char* m_extra{ nullptr };
+    const Slot* m_slots{ nullptr };
+    uint64_t m_capacity{ 0 };
+    uint64_t m_mask{ 0 };
+    uint64_t m_next{ 0 };
+    uint64_t m_overruns{ 0 };
+    uint32_t m_generation{ 0 };
+};
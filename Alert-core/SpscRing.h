@@ -0,0 +1,69 @@
+﻿#pragma once
+#include <atomic>
+#include <vector>
+#include <cstddef>
+
+// ------------------------- 单生产者单消费者环形队列 -------------------------
+// 容量向上取整为 2 的幂。生产者、消费者各自缓存对方的下标，只有缓存判定满/空时才读对方的原子变量，
+// 两端的下标分别独占缓存行，避免伪共享。
+template <typename T>
+class SpscRing
+{
+public:
+    explicit SpscRing(size_t capacity)
+    {
+        size_t n = 2;
+        while (n < capacity) n <<= 1;
+        m_buf.resize(n);
+        m_mask = n - 1;
+    }
+
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    // 仅生产者线程调用；队列满返回 false
+    bool TryPush(const T& v)
+    {
+        size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail - m_headCache > m_mask) {
+            m_headCache = m_head.load(std::memory_order_acquire);
+            if (tail - m_headCache > m_mask)
+                return false;
+        }
+        m_buf[tail & m_mask] = v;
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // 仅消费者线程调用；队列空返回 false
+    bool TryPop(T& out)
+    {
+        size_t head = m_head.load(std::memory_order_relaxed);
+        if (head == m_tailCache) {
+            m_tailCache = m_tail.load(std::memory_order_acquire);
+            if (head == m_tailCache)
+                return false;
+        }
+        out = m_buf[head & m_mask];
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // 任意线程调用，结果为近似值
+    size_t Size() const
+    {
+        return m_tail.load(std::memory_order_acquire) - m_head.load(std::memory_order_acquire);
+    }
+
+    size_t Capacity() const { return m_mask + 1; }
+
+private:
+    std::vector<T> m_buf;
+    size_t m_mask{ 0 };
+
+    alignas(64) std::atomic<size_t> m_head{ 0 };    // 消费者写
+    size_t m_tailCache{ 0 };                        // 消费者缓存的 tail
+
+    alignas(64) std::atomic<size_t> m_tail{ 0 };    // 生产者写
+    size_t m_headCache{ 0 };                        // 生产者缓存的 head
+};
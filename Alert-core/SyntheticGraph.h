@@ -0,0 +1,125 @@
+﻿#pragma once
+#include "InstrumentRegistry.h"
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cctype>
+#include <cmath>
+
+// =========================================================
+// ===========   跨合约价差 / 比价：合成合约依赖图   ===========
+// =========================================================
+//
+// alert_order.symbol 支持两种合成写法：
+//     IF2512-IF2603   价差 = 腿 A 最新价 - 腿 B 最新价
+//     rb2601/hc2601   比价 = 腿 A 最新价 / 腿 B 最新价
+// 加载时把两条腿解析为合约 id，并建立 "腿 id -> 依赖它的合成合约" 的反向索引。
+// 任一条腿来 tick 时只重算受影响的合成值，腿价格从共享最新价表无锁读取。
+
+enum SyntheticOp : char
+{
+    SYN_SPREAD = '-',
+    SYN_RATIO = '/'
+};
+
+struct SyntheticInstrument
+{
+    std::string name;   // 原始写法，同时作为 m_alertMap 的 key
+    int legA{ -1 };
+    int legB{ -1 };
+    char op{ SYN_SPREAD };
+};
+
+// 解析 "A-B" / "A/B"；普通合约返回 false
+inline bool ParseSyntheticSymbol(const std::string& symbol,
+    std::string& legA, std::string& legB, char& op)
+{
+    size_t pos = symbol.find_first_of("-/");
+    if (pos == std::string::npos || pos == 0 || pos + 1 >= symbol.size())
+        return false;
+    if (symbol.find_first_of("-/", pos + 1) != std::string::npos)
+        return false;
+
+    auto trim = [](const std::string& s) {
+        size_t b = 0, e = s.size();
+        while (b < e && isspace((unsigned char)s[b])) b++;
+        while (e > b && isspace((unsigned char)s[e - 1])) e--;
+        return s.substr(b, e - b);
+    };
+
+    legA = trim(symbol.substr(0, pos));
+    legB = trim(symbol.substr(pos + 1));
+    op = symbol[pos];
+    return !legA.empty() && !legB.empty();
+}
+
+class SyntheticGraph
+{
+public:
+    // 加载阶段：注册一个合成合约（同名只注册一次）
+    bool Add(const std::string& name, InstrumentRegistry& registry)
+    {
+        if (m_index.count(name))
+            return true;
+
+        std::string a, b;
+        char op;
+        if (!ParseSyntheticSymbol(name, a, b, op))
+            return false;
+
+        SyntheticInstrument s;
+        s.name = name;
+        s.op = op;
+        s.legA = registry.GetOrAdd(a);
+        s.legB = registry.GetOrAdd(b);
+        if (s.legA < 0 || s.legB < 0)
+            return false;
+
+        int index = (int)m_nodes.size();
+        m_nodes.push_back(s);
+        m_index.emplace(name, index);
+
+        int maxLeg = s.legA > s.legB ? s.legA : s.legB;
+        if ((int)m_dependents.size() <= maxLeg)
+            m_dependents.resize(maxLeg + 1);
+        m_dependents[s.legA].push_back(index);
+        if (s.legB != s.legA)
+            m_dependents[s.legB].push_back(index);
+        return true;
+    }
+
+    // tick 路径：依赖该合约的合成合约下标，没有时返回 nullptr
+    const std::vector<int>* Dependents(int instrumentId) const
+    {
+        if (instrumentId < 0 || instrumentId >= (int)m_dependents.size())
+            return nullptr;
+        const auto& v = m_dependents[instrumentId];
+        return v.empty() ? nullptr : &v;
+    }
+
+    const SyntheticInstrument& Node(int index) const { return m_nodes[index]; }
+    bool Empty() const { return m_nodes.empty(); }
+
+    // 任一条腿尚无行情、或比价分母为 0 时返回 false
+    static bool Compute(const SyntheticInstrument& s, const InstrumentRegistry& registry, double& out)
+    {
+        double a = registry.LastPrice(s.legA);
+        double b = registry.LastPrice(s.legB);
+        if (std::isnan(a) || std::isnan(b))
+            return false;
+
+        if (s.op == SYN_RATIO) {
+            if (b == 0.0) return false;
+            out = a / b;
+        }
+        else {
+            out = a - b;
+        }
+        return true;
+    }
+
+private:
+    std::vector<SyntheticInstrument> m_nodes;
+    std::unordered_map<std::string, int> m_index;
+    std::vector<std::vector<int>> m_dependents;
+};
@@ -0,0 +1,83 @@
+﻿#pragma once
+#include <Windows.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstdlib>
+
+// ------------------------- 线程绑核 / 优先级 -------------------------
+// [Threads] 中的 CPU 列表写作 "2,3,6-7"（逻辑处理器编号，从 0 开始，上限 63）。
+// 延迟敏感线程（SDK 回调、判断线程）逐个绑到列表中的单个核上；
+// 其余后台线程（reload、会话状态机、监控）整体限制在 ServiceCpus 内，避免抢占隔离核。
+
+// 解析 CPU 列表；非法项忽略
+inline std::vector<int> ParseCpuList(const std::string& text)
+{
+    std::vector<int> cpus;
+    size_t pos = 0;
+    while (pos < text.size()) {
+        size_t comma = text.find(',', pos);
+        if (comma == std::string::npos) comma = text.size();
+        std::string item = text.substr(pos, comma - pos);
+        pos = comma + 1;
+
+        if (item.find_first_of("0123456789") == std::string::npos)
+            continue;
+
+        int first, last;
+        size_t dash = item.find('-');
+        if (dash == std::string::npos) {
+            first = last = atoi(item.c_str());
+        }
+        else {
+            first = atoi(item.substr(0, dash).c_str());
+            last = atoi(item.substr(dash + 1).c_str());
+        }
+        for (int c = first; c >= 0 && c <= last && c < 64; ++c)
+            cpus.push_back(c);
+    }
+    return cpus;
+}
+
+inline uint64_t CpuMask(const std::vector<int>& cpus)
+{
+    uint64_t mask = 0;
+    for (int c : cpus) mask |= 1ULL << c;
+    return mask;
+}
+
+// 第 index 个延迟敏感线程使用的核（列表为空返回 -1，不绑定）
+inline int PickCpu(const std::vector<int>& cpus, size_t index)
+{
+    return cpus.empty() ? -1 : cpus[index % cpus.size()];
+}
+
+// 把当前线程限制在 mask 内（0 不限制），realtime 时提升为 TIME_CRITICAL；失败只打印日志
+inline void TuneCurrentThread(const char* name, uint64_t mask, bool realtime)
+{
+    if (mask != 0 && SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)mask) == 0) {
+        printf("[THREAD] %s 设置 CPU 亲和性 0x%llx 失败，错误码 %lu\n",
+            name, (unsigned long long)mask, (unsigned long)GetLastError());
+        fflush(stdout);
+    }
+    if (realtime && !SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_TIME_CRITICAL)) {
+        printf("[THREAD] %s 提升优先级失败，错误码 %lu\n", name, (unsigned long)GetLastError());
+        fflush(stdout);
+    }
+}
+
+// 进程提升为 HIGH_PRIORITY_CLASS（不用 REALTIME_PRIORITY_CLASS，以免饿死系统线程与网络栈）
+inline void RaiseProcessPriority()
+{
+    if (!SetPriorityClass(GetCurrentProcess(), HIGH_PRIORITY_CLASS)) {
+        printf("[THREAD] 提升进程优先级失败，错误码 %lu\n", (unsigned long)GetLastError());
+        fflush(stdout);
+    }
+}
+
+// 自旋等待时的 CPU 提示（x86 为 pause），降低功耗与对超线程兄弟核的干扰
+inline void CpuRelax()
+{
+    YieldProcessor();
+}
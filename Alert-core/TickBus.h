@@ -0,0 +1,146 @@
+﻿#pragma once
+#include "ShmRing.h"
+#include <stdio.h>
+#include <string>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+
+// =========================================================
+// ===========   共享内存行情总线（一写多读）   ===========
+// =========================================================
+//
+// 本机其他进程（风控、图表等）直接读取本进程收到的归一化行情，不必各自再开 CTP 会话。
+// 环形缓冲见 ShmRing.h；自定义区为合约目录（下标 = 合约 id）。
+// 合约 id 与上次运行不一定相同：写端重启时目录清空重建，读端看到 generation 变化后应丢弃缓存的合约名。
+
+static const uint32_t kTickBusMagic = 0x53554254;      // "TBUS"
+static const uint32_t kTickBusVersion = 1;
+static const uint32_t kTickBusMaxSymbols = 4096;       // 与 InstrumentRegistry 的容量一致
+
+// 一条行情（价格类字段缺失为 NaN）
+struct TickBusTick
+{
+    double last, bid, ask;
+    double bidVolume, askVolume, volume, turnover, openInterest;
+    double open, high, low, preClose, preSettlement, upperLimit, lowerLimit;
+    int32_t msOfDay;        // 交易所时间（当日毫秒），无效为 -1
+    int32_t symbolId;       // 合约目录下标
+    int64_t publishUs;      // 发布时刻（Unix 微秒），读端据此统计延迟
+};
+
+struct TickBusSymbol
+{
+    std::atomic<uint32_t> state;    // 0 空，1 写入中，2 可用
+    char name[32];
+    uint32_t reserved;
+};
+
+static const size_t kTickBusDirectoryBytes = sizeof(TickBusSymbol) * kTickBusMaxSymbols;
+
+// 与旧名称保持一致，取值同 ShmRingPollResult
+enum TickBusPollResult
+{
+    TICKBUS_EMPTY = SHMRING_EMPTY,
+    TICKBUS_OK = SHMRING_OK,
+    TICKBUS_OVERRUN = SHMRING_OVERRUN
+};
+
+// ------------------------- 写端 -------------------------
+class TickBusWriter
+{
+public:
+    bool Open(const std::string& name, uint32_t capacity)
+    {
+        if (!m_ring.Open(name, kTickBusMagic, kTickBusVersion, capacity, kTickBusDirectoryBytes, "[TICKBUS]",
+            [](void* extra) {
+                TickBusSymbol* symbols = (TickBusSymbol*)extra;
+                for (uint32_t i = 0; i < kTickBusMaxSymbols; ++i)
+                    symbols[i].state.store(0, std::memory_order_relaxed);
+            }))
+            return false;
+        m_symbols = (TickBusSymbol*)m_ring.Extra();
+        return true;
+    }
+
+    void Close() { m_ring.Close(); }
+    bool IsOpen() const { return m_ring.IsOpen(); }
+
+    // 可由多个线程同时调用
+    void Publish(int symbolId, const char* symbol, TickBusTick& tick)
+    {
+        if (symbolId < 0 || symbolId >= (int)kTickBusMaxSymbols)
+            return;
+        EnsureSymbol(symbolId, symbol);
+        tick.symbolId = symbolId;
+        tick.publishUs = ShmRingNowUs();
+        m_ring.Publish(tick);
+    }
+
+    void Report()
+    {
+        if (!m_ring.IsOpen()) return;
+        unsigned long long published = m_ring.TakePublished();
+        printf("[TICKBUS] 发布 %llu 条，累计序号 %llu\n", published, (unsigned long long)m_ring.WriteSeq());
+        fflush(stdout);
+    }
+
+private:
+    // 合约首次发布前登记名称；并发的首次发布只有一个线程写入，其余等待写完
+    void EnsureSymbol(int id, const char* symbol)
+    {
+        TickBusSymbol& s = m_symbols[id];
+        if (s.state.load(std::memory_order_acquire) == 2)
+            return;
+        uint32_t expected = 0;
+        if (s.state.compare_exchange_strong(expected, 1, std::memory_order_acq_rel)) {
+            strncpy_s(s.name, symbol, _TRUNCATE);
+            s.state.store(2, std::memory_order_release);
+            return;
+        }
+        while (s.state.load(std::memory_order_acquire) != 2)
+            std::this_thread::yield();
+    }
+
+    ShmRingWriter<TickBusTick> m_ring;
+    TickBusSymbol* m_symbols{ nullptr };
+};
+
+// ------------------------- 读端（供其他进程包含本头文件使用） -------------------------
+class TickBusReader
+{
+public:
+    // 打开已存在的共享内存；fromOldest 为真时从环中仍有效的最旧一条开始，否则只读之后发布的
+    bool Attach(const std::string& name, bool fromOldest = false)
+    {
+        if (!m_ring.Attach(name, kTickBusMagic, kTickBusVersion, kTickBusDirectoryBytes, fromOldest))
+            return false;
+        m_symbols = (const TickBusSymbol*)m_ring.Extra();
+        return true;
+    }
+
+    void Close() { m_ring.Close(); }
+
+    // 读取下一条；只访问共享内存
+    TickBusPollResult Poll(TickBusTick& out, uint64_t& lost) { return (TickBusPollResult)m_ring.Poll(out, lost); }
+
+    // 合约名；未登记或写端已重启（generation 变化）时返回 nullptr
+    const char* Symbol(int id) const
+    {
+        if (id < 0 || id >= (int)kTickBusMaxSymbols)
+            return nullptr;
+        if (m_symbols[id].state.load(std::memory_order_acquire) != 2)
+            return nullptr;
+        return m_symbols[id].name;
+    }
+
+    uint32_t Generation() const { return m_ring.Generation(); }
+    bool WriterRestarted() const { return m_ring.WriterRestarted(); }
+    void AcknowledgeRestart() { m_ring.AcknowledgeRestart(); }
+    uint64_t Overruns() const { return m_ring.Overruns(); }
+
+private:
+    ShmRingReader<TickBusTick> m_ring;
+    const TickBusSymbol* m_symbols{ nullptr };
+};
@@ -0,0 +1,178 @@
+﻿#pragma once
+#include "InstrumentRegistry.h"
+#include <string>
+#include <vector>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+
+// =========================================================
+// ===========   多前置行情汇聚：tick 去重 + 前置领先/落后统计   ===========
+// =========================================================
+//
+// 同一合约的同一笔快照会从每个前置各到一次，以 (合约, UpdateTime, UpdateMillisec, Volume) 判重：
+// 最先到达的前置胜出并进入预警判断，后到的只用于统计它比胜出前置晚了多少。
+// 比当前已接受快照更旧的 tick（慢前置的积压）直接丢弃，不会让行情“倒退”。
+// 每个合约一个槽位，临界区只有几次比较和赋值，用自旋锁保护。
+
+static const int kMaxFronts = 8;
+
+class TickFanIn
+{
+public:
+    enum Verdict
+    {
+        TICK_FIRST,         // 首次到达，进入预警判断
+        TICK_DUPLICATE,     // 其他前置已送达同一快照
+        TICK_STALE          // 比已接受的快照更旧
+    };
+
+    void SetFronts(const std::vector<std::string>& names)
+    {
+        m_names = names;
+        if (m_names.size() > (size_t)kMaxFronts)
+            m_names.resize(kMaxFronts);
+    }
+
+    // msOfDay 为交易所时间的当日毫秒数，解析失败（<0）或合约 id 无效时不判重
+    Verdict Offer(int instrumentId, int front, int msOfDay, int volume, int64_t recvUs)
+    {
+        FrontStats& fs = m_stats[front];
+        fs.received.fetch_add(1, std::memory_order_relaxed);
+        if (instrumentId < 0 || instrumentId >= kMaxInstruments || msOfDay < 0) {
+            fs.first.fetch_add(1, std::memory_order_relaxed);
+            return TICK_FIRST;
+        }
+
+        // 高 32 位为当日毫秒数 + 1（保证非 0），低 32 位为成交量
+        uint64_t key = ((uint64_t)(msOfDay + 1) << 32) | (uint32_t)volume;
+
+        Slot& s = m_slots[instrumentId];
+        while (s.lock.test_and_set(std::memory_order_acquire)) {}
+
+        Verdict v;
+        int winner = -1;
+        int64_t lagUs = 0;
+        if (s.key == 0 || key > s.key || NewTradingDay(s.key, key)) {
+            s.key = key;
+            s.firstRecvUs = recvUs;
+            s.firstFront = front;
+            v = TICK_FIRST;
+        }
+        else if (key == s.key) {
+            winner = s.firstFront;
+            lagUs = recvUs - s.firstRecvUs;
+            v = TICK_DUPLICATE;
+        }
+        else {
+            v = TICK_STALE;
+        }
+        s.lock.clear(std::memory_order_release);
+
+        if (v == TICK_FIRST) {
+            fs.first.fetch_add(1, std::memory_order_relaxed);
+        }
+        else if (v == TICK_DUPLICATE) {
+            fs.duplicate.fetch_add(1, std::memory_order_relaxed);
+            if (winner != front && lagUs >= 0) {
+                fs.lagHist[Bucket(lagUs)].fetch_add(1, std::memory_order_relaxed);
+                m_stats[winner].leadUs.fetch_add(lagUs, std::memory_order_relaxed);
+                m_stats[winner].leadCount.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+        else {
+            fs.stale.fetch_add(1, std::memory_order_relaxed);
+        }
+        return v;
+    }
+
+    // 输出并清零本周期各前置的统计（单前置时不输出）
+    void Report()
+    {
+        if (m_names.size() < 2) return;
+
+        for (size_t i = 0; i < m_names.size(); ++i)
+        {
+            FrontStats& fs = m_stats[i];
+            uint64_t received = fs.received.exchange(0, std::memory_order_relaxed);
+            uint64_t first = fs.first.exchange(0, std::memory_order_relaxed);
+            uint64_t duplicate = fs.duplicate.exchange(0, std::memory_order_relaxed);
+            uint64_t stale = fs.stale.exchange(0, std::memory_order_relaxed);
+            int64_t leadUs = fs.leadUs.exchange(0, std::memory_order_relaxed);
+            uint64_t leadCount = fs.leadCount.exchange(0, std::memory_order_relaxed);
+
+            uint64_t hist[kLagBuckets];
+            uint64_t lagCount = 0;
+            for (int b = 0; b < kLagBuckets; ++b) {
+                hist[b] = fs.lagHist[b].exchange(0, std::memory_order_relaxed);
+                lagCount += hist[b];
+            }
+
+            printf("[FANIN] %s 收到 %llu 首达 %.1f%% 重复 %llu 过期 %llu | 领先均值 %.0f us | 落后 p50 %lld us p99 %lld us\n",
+                m_names[i].c_str(), (unsigned long long)received,
+                received ? first * 100.0 / received : 0.0,
+                (unsigned long long)duplicate, (unsigned long long)stale,
+                leadCount ? (double)leadUs / leadCount : 0.0,
+                Percentile(hist, lagCount, 0.50), Percentile(hist, lagCount, 0.99));
+        }
+        fflush(stdout);
+    }
+
+private:
+    static const int kLagBuckets = 32;   // 按 2 的幂分桶（微秒）
+
+    struct alignas(64) Slot
+    {
+        std::atomic_flag lock = ATOMIC_FLAG_INIT;
+        uint64_t key{ 0 };
+        int64_t firstRecvUs{ 0 };
+        int firstFront{ -1 };
+    };
+
+    struct alignas(64) FrontStats
+    {
+        std::atomic<uint64_t> received{ 0 };
+        std::atomic<uint64_t> first{ 0 };
+        std::atomic<uint64_t> duplicate{ 0 };
+        std::atomic<uint64_t> stale{ 0 };
+        std::atomic<int64_t> leadUs{ 0 };       // 作为胜出前置，领先其他前置的累计时间
+        std::atomic<uint64_t> leadCount{ 0 };
+        std::atomic<uint64_t> lagHist[kLagBuckets];
+
+        FrontStats() { for (auto& h : lagHist) h.store(0, std::memory_order_relaxed); }
+    };
+
+    // 时间“倒退”但其实是新的一段行情：
+    //   早 12 小时以上 —— 夜盘跨零点；
+    //   早 10 分钟以上且成交量回落 —— 换了交易日（开盘前的快照常带着上一交易日的时间）
+    static bool NewTradingDay(uint64_t oldKey, uint64_t newKey)
+    {
+        int64_t back = (int64_t)(oldKey >> 32) - (int64_t)(newKey >> 32);
+        if (back > 43200000) return true;
+        return back > 600000 && (uint32_t)newKey < (uint32_t)oldKey;
+    }
+
+    static int Bucket(int64_t us)
+    {
+        int b = 0;
+        while (us > 0 && b < kLagBuckets - 1) { us >>= 1; b++; }
+        return b;
+    }
+
+    // 返回分位所在桶的上界（微秒）
+    static long long Percentile(const uint64_t* hist, uint64_t total, double q)
+    {
+        if (total == 0) return 0;
+        uint64_t rank = (uint64_t)(total * q);
+        uint64_t seen = 0;
+        for (int b = 0; b < kLagBuckets; ++b) {
+            seen += hist[b];
+            if (seen > rank) return b == 0 ? 0 : (1LL << b) - 1;
+        }
+        return (1LL << (kLagBuckets - 1)) - 1;
+    }
+
+    std::vector<std::string> m_names;
+    Slot m_slots[kMaxInstruments];
+    FrontStats m_stats[kMaxFronts];
+};
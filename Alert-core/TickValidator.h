@@ -0,0 +1,159 @@
+﻿#pragma once
+#include "AlertRule.h"
+#include "InstrumentMeta.h"
+#include <stdio.h>
+#include <atomic>
+#include <cstdint>
+#include <cmath>
+#include <ctime>
+
+// =========================================================
+// ===========   行情校验与定点换算   ===========
+// =========================================================
+//
+// NormalizeTick 之后、去重（TickFanIn）之前执行，只有通过校验的快照进入去重与预警判断：
+//   整条丢弃 —— 交易所时间无法解析；与本机时钟相差超过 MaxAgeSec（登录时推送的上一交易时段快照、
+//               非交易时段的残留快照）；已知交易时段时不在时段内；最新价与买卖价全部缺失；
+//               最新价超出涨跌停或不在价位网格上。
+//   字段置为缺失（NaN） —— 价格 <= 0、数量为负；买卖价超出涨跌停、不在价位网格上或买价高于卖价。
+// 通过后把最新价与买卖价换算为定点整数（单位为最小变动价位，未知时为 kFallbackPriceUnit），
+// 价差由整数相减得到。同一快照重复到达、比已接受快照更旧的 tick 由 TickFanIn 丢弃。
+//
+// 无内部状态（只有计数器），可由多个行情回调线程同时调用。
+
+enum TickCheck : uint8_t
+{
+    TICK_OK = 0,
+    TICK_BAD_TIME,          // 交易所时间无法解析
+    TICK_OUT_OF_SESSION,    // 与本机时钟相差过大，或不在合约的交易时段内
+    TICK_NO_PRICE,          // 最新价与买卖价全部缺失
+    TICK_BAD_PRICE,         // 最新价超出涨跌停
+    TICK_OFF_GRID,          // 最新价不是最小变动价位的整数倍
+    TICK_CHECK_COUNT
+};
+
+class TickValidator
+{
+public:
+    TickValidator()
+    {
+        for (auto& c : m_counts) c.store(0, std::memory_order_relaxed);
+
+        // 本机时区偏移：交易所时间为北京时间，默认本机也是
+        time_t now = time(0);
+        struct tm lt, gt;
+        localtime_s(&lt, &now);
+        gmtime_s(&gt, &now);
+        m_utcOffsetMs = (int64_t)difftime(mktime(&lt), mktime(&gt)) * 1000;
+    }
+
+    // maxAgeSec <= 0 不检查时间偏差（如回放历史行情的仿真环境）
+    void Configure(int maxAgeSec)
+    {
+        m_maxAgeMs = maxAgeSec > 0 ? maxAgeSec * 1000LL : 0;
+    }
+
+    // priceTick 为合约的最小变动价位（<=0 未知），sessions 为交易时段（nullptr 未知）；wallMs 为本机 Unix 毫秒
+    TickCheck Check(TickRecord& t, double priceTick, const TradingSessions* sessions, int64_t wallMs)
+    {
+        TickCheck r = Validate(t, priceTick, sessions, wallMs);
+        m_counts[r].fetch_add(1, std::memory_order_relaxed);
+        return r;
+    }
+
+    // 输出并清零本周期的通过 / 丢弃计数
+    void Report()
+    {
+        uint64_t n[TICK_CHECK_COUNT];
+        uint64_t dropped = 0;
+        for (int i = 0; i < TICK_CHECK_COUNT; ++i) {
+            n[i] = m_counts[i].exchange(0, std::memory_order_relaxed);
+            if (i != TICK_OK) dropped += n[i];
+        }
+        unsigned long long fixed = m_fieldFixes.exchange(0, std::memory_order_relaxed);
+        if (n[TICK_OK] == 0 && dropped == 0)
+            return;
+        printf("[TICK] 通过 %llu，丢弃 %llu（时间无效 %llu，时间偏差或时段外 %llu，无价格 %llu，超出涨跌停 %llu，不在价位上 %llu），修正字段 %llu\n",
+            (unsigned long long)n[TICK_OK], (unsigned long long)dropped,
+            (unsigned long long)n[TICK_BAD_TIME], (unsigned long long)n[TICK_OUT_OF_SESSION],
+            (unsigned long long)n[TICK_NO_PRICE], (unsigned long long)n[TICK_BAD_PRICE],
+            (unsigned long long)n[TICK_OFF_GRID], fixed);
+        fflush(stdout);
+    }
+
+private:
+    static const int64_t kDayMs = 86400000;
+
+    static bool OnGrid(double price, double unit)
+    {
+        double x = price / unit;
+        return std::fabs(x - std::nearbyint(x)) <= 1e-6;
+    }
+
+    TickCheck Validate(TickRecord& t, double priceTick, const TradingSessions* sessions, int64_t wallMs)
+    {
+        if (std::isnan(t.time))
+            return TICK_BAD_TIME;
+        if (sessions && !sessions->Contains((int)(t.time / 60.0)))
+            return TICK_OUT_OF_SESSION;
+        if (m_maxAgeMs > 0) {
+            int64_t local = ((wallMs + m_utcOffsetMs) % kDayMs + kDayMs) % kDayMs;
+            int64_t diff = std::llabs(local - (int64_t)std::llround(t.time * 1000.0));
+            if (diff > kDayMs / 2) diff = kDayMs - diff;    // 跨零点
+            if (diff > m_maxAgeMs)
+                return TICK_OUT_OF_SESSION;
+        }
+
+        int fixes = 0;
+        static const uint8_t kPrices[] = { TF_LAST, TF_BID, TF_ASK, TF_OPEN, TF_HIGH, TF_LOW,
+            TF_PRE_CLOSE, TF_PRE_SETTLEMENT, TF_UPPER_LIMIT, TF_LOWER_LIMIT };
+        static const uint8_t kQuantities[] = { TF_BID_VOLUME, TF_ASK_VOLUME, TF_VOLUME, TF_TURNOVER, TF_OPEN_INTEREST };
+        for (uint8_t f : kPrices) {
+            if (t.v[f] <= 0.0) { t.v[f] = NAN; fixes++; }
+        }
+        for (uint8_t f : kQuantities) {
+            if (t.v[f] < 0.0) { t.v[f] = NAN; fixes++; }
+        }
+
+        bool grid = priceTick > 0.0;
+        double unit = grid ? priceTick : kFallbackPriceUnit;
+        double lo = t.v[TF_LOWER_LIMIT], hi = t.v[TF_UPPER_LIMIT];
+        bool limits = lo <= hi;
+        double slack = unit * 1e-6;
+        auto valid = [&](double p) {
+            return !(limits && (p < lo - slack || p > hi + slack)) && !(grid && !OnGrid(p, unit));
+        };
+
+        double& bid = t.v[TF_BID];
+        double& ask = t.v[TF_ASK];
+        if (!std::isnan(bid) && !valid(bid)) { bid = NAN; fixes++; }
+        if (!std::isnan(ask) && !valid(ask)) { ask = NAN; fixes++; }
+        if (bid > ask) { bid = NAN; ask = NAN; fixes++; }
+
+        double last = t.v[TF_LAST];
+        TickCheck r = TICK_OK;
+        if (std::isnan(last) && std::isnan(bid) && std::isnan(ask))
+            r = TICK_NO_PRICE;
+        else if (!std::isnan(last) && limits && (last < lo - slack || last > hi + slack))
+            r = TICK_BAD_PRICE;
+        else if (!std::isnan(last) && grid && !OnGrid(last, unit))
+            r = TICK_OFF_GRID;
+        if (fixes)
+            m_fieldFixes.fetch_add(fixes, std::memory_order_relaxed);
+        if (r != TICK_OK)
+            return r;
+
+        t.priceUnit = unit;
+        t.lastTicks = PriceToTicks(last, unit);
+        t.bidTicks = PriceToTicks(bid, unit);
+        t.askTicks = PriceToTicks(ask, unit);
+        t.v[TF_SPREAD] = (t.bidTicks != kNoTicks && t.askTicks != kNoTicks) ? (t.askTicks - t.bidTicks) * unit : NAN;
+        t.v[TF_PRICE_TICK] = grid ? priceTick : 1.0;
+        return TICK_OK;
+    }
+
+    int64_t m_maxAgeMs{ 0 };
+    int64_t m_utcOffsetMs{ 0 };
+    std::atomic<uint64_t> m_counts[TICK_CHECK_COUNT];
+    std::atomic<uint64_t> m_fieldFixes{ 0 };
+};
@@ -0,0 +1,119 @@
+﻿#pragma once
+#include "ShmRing.h"
+#include "TriggerEvent.h"
+#include <stdio.h>
+#include <string>
+#include <cstdint>
+#include <cstring>
+
+// =========================================================
+// ===========   共享内存触发事件流（一写多读）   ===========
+// =========================================================
+//
+// 推送、审计等下游进程直接读取本进程的触发事件，不必轮询 alert_order 的 state=1。
+// 环形缓冲见 ShmRing.h。事件在 outbox 投递线程通知前写入（启用触发认领时只有认领成功的实例写入），
+// 崩溃重启后 outbox 重放的事件会再写一次，下游按 (orderId, fireSeq) 去重。
+
+static const uint32_t kTriggerBusMagic = 0x42475254;    // "TRGB"
+static const uint32_t kTriggerBusVersion = 1;
+
+// 一次触发（字符串为 0 结尾的定长拷贝，超长截断）
+struct TriggerBusEvent
+{
+    int64_t orderId;
+    int32_t fireSeq;            // 第几次触发，从 1 开始
+    uint8_t final;              // 已达最大次数，预警随之失效
+    uint8_t priority;
+    uint8_t truncated;          // reason 被截断
+    uint8_t reserved;
+    double price;
+    int64_t outboxSeq;          // outbox 序号
+    int64_t detectMs;           // 检测到触发的本地时间（Unix 毫秒）
+    int64_t publishUs;          // 写入本流的时刻（Unix 微秒）
+    int32_t detectLatencyUs;    // 收到 tick 到判定触发的耗时（微秒）
+    char exchangeTime[16];      // 触发 tick 的交易所时间 "HH:MM:SS.mmm"
+    char account[64];
+    char symbol[32];
+    char reason[256];
+};
+
+enum TriggerBusPollResult
+{
+    TRIGGERBUS_EMPTY = SHMRING_EMPTY,
+    TRIGGERBUS_OK = SHMRING_OK,
+    TRIGGERBUS_OVERRUN = SHMRING_OVERRUN
+};
+
+// ------------------------- 写端 -------------------------
+class TriggerBusWriter
+{
+public:
+    bool Open(const std::string& name, uint32_t capacity)
+    {
+        return m_ring.Open(name, kTriggerBusMagic, kTriggerBusVersion, capacity, 0, "[TRIGGERBUS]");
+    }
+
+    void Close() { m_ring.Close(); }
+    bool IsOpen() const { return m_ring.IsOpen(); }
+
+    // 可由多个线程同时调用
+    void Publish(const TriggerEvent& e)
+    {
+        TriggerBusEvent out;
+        memset(&out, 0, sizeof(out));
+        out.orderId = e.orderId;
+        out.fireSeq = e.fireSeq;
+        out.final = e.final ? 1 : 0;
+        out.priority = e.priority;
+        out.truncated = e.reason.size() >= sizeof(out.reason) ? 1 : 0;
+        out.price = e.price;
+        out.outboxSeq = (int64_t)e.seq;
+        out.detectMs = e.detectMs;
+        out.detectLatencyUs = e.detectLatencyUs;
+        strncpy_s(out.exchangeTime, e.exchangeTime.c_str(), _TRUNCATE);
+        strncpy_s(out.account, e.account.c_str(), _TRUNCATE);
+        strncpy_s(out.symbol, e.symbol.c_str(), _TRUNCATE);
+        strncpy_s(out.reason, e.reason.c_str(), _TRUNCATE);
+        out.publishUs = ShmRingNowUs();
+        m_ring.Publish(out);
+    }
+
+    void Report()
+    {
+        if (!m_ring.IsOpen()) return;
+        unsigned long long published = m_ring.TakePublished();
+        printf("[TRIGGERBUS] 发布 %llu 条，累计序号 %llu\n", published, (unsigned long long)m_ring.WriteSeq());
+        fflush(stdout);
+    }
+
+private:
+    ShmRingWriter<TriggerBusEvent> m_ring;
+};
+
+// ------------------------- 读端（供其他进程包含本头文件使用） -------------------------
+class TriggerBusReader
+{
+public:
+    // 打开已存在的共享内存；fromOldest 为真时从环中仍有效的最旧一条开始，否则只读之后发布的
+    bool Attach(const std::string& name, bool fromOldest = false)
+    {
+        return m_ring.Attach(name, kTriggerBusMagic, kTriggerBusVersion, 0, fromOldest);
+    }
+
+    void Close() { m_ring.Close(); }
+
+    // 读取下一条；只访问共享内存
+    TriggerBusPollResult Poll(TriggerBusEvent& out, uint64_t& lost)
+    {
+        return (TriggerBusPollResult)m_ring.Poll(out, lost);
+    }
+
+    // 下一条将读取的序号；下游保存后可在重连时判断是否有缺口
+    uint64_t Position() const { return m_ring.Position(); }
+    bool WriterRestarted() const { return m_ring.WriterRestarted(); }
+    void AcknowledgeRestart() { m_ring.AcknowledgeRestart(); }
+    uint64_t Overruns() const { return m_ring.Overruns(); }
+
+private:
+    ShmRingReader<TriggerBusEvent> m_ring;
+};
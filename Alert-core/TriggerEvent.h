@@ -0,0 +1,32 @@
+﻿#pragma once
+#include <string>
+#include <cstdint>
+
+// ------------------------- 触发事件 -------------------------
+// 由 CheckAlert 产生，经 outbox 落盘后再交给 DB 与通知渠道
+struct TriggerEvent
+{
+    uint64_t seq{ 0 };          // outbox 序号，Append 时分配
+    long orderId{ 0 };
+    int fireSeq{ 0 };           // 第几次触发，从 1 开始；(orderId, fireSeq) 唯一标识一次触发
+    bool final{ false };        // 已达最大次数，需要在 DB 标记 state=1
+    uint8_t priority{ 0 };      // >0 为高优先级，通知不参与合并等待
+    std::string account;
+    std::string symbol;
+    double price{ 0.0 };
+    std::string reason;
+    int64_t detectMs{ 0 };      // 检测到触发的本地时间（Unix 毫秒）
+    std::string exchangeTime;   // 触发 tick 的交易所时间 "HH:MM:SS.mmm"
+    int32_t detectLatencyUs{ 0 };   // 收到 tick 到判定触发的耗时（微秒）
+    int32_t claimSeq{ -1 };     // 认领表中的序号（多实例共享），认领成功时由 DB 给出；-1 表示尚未认领
+};
+
+// 通知结果：异步渠道先返回 NOTIFY_PENDING，实际结果稍后经完成回调给出；
+// NOTIFY_BUSY 表示渠道队列已满、尚未发送，稍后重试且不计入失败次数
+enum NotifyResult : uint8_t
+{
+    NOTIFY_FAILED = 0,
+    NOTIFY_OK = 1,
+    NOTIFY_PENDING = 2,
+    NOTIFY_BUSY = 3
+};
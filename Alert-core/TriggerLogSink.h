@@ -0,0 +1,260 @@
+﻿#pragma once
+#include "TriggerEvent.h"
+#include <mysql/jdbc.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <functional>
+#include <chrono>
+
+// =========================================================
+// ===========   触发历史：批量写入 alert_trigger_log   ===========
+// =========================================================
+//
+// 每个触发事件在通知完成后记录一行：触发价、交易所时间、检测延迟、通知结果。
+// Record() 只入队；后台线程攒满 batchSize 行或最早一行等待超过 lingerMs 后，
+// 用一条多行 INSERT ... VALUES (...),(...) 写入，整批只有一次网络往返和一次提交。
+// DB 不可用时保留缓冲区并退避重试，积压超过 kMaxPending 时丢弃最旧的行。
+//
+// 每分钟打印一次写入统计，其中 "DB 速率" = 写入行数 / 执行 INSERT 的耗时，即持续写入能力。
+
+class TriggerLogSink
+{
+public:
+    typedef std::function<sql::Connection*()> ConnFactory;
+
+    ~TriggerLogSink()
+    {
+        Stop();
+    }
+
+    void Start(ConnFactory factory, int batchSize, int lingerMs)
+    {
+        m_factory = factory;
+        m_batchSize = batchSize > 0 ? (batchSize < kMaxBatch ? batchSize : kMaxBatch) : 1;
+        m_lingerMs = lingerMs >= 0 ? lingerMs : 0;
+        m_stop = false;
+        m_running = true;
+        m_thread = std::thread([this]() { run(); });
+    }
+
+    // 退出前尽量写完缓冲区（只尝试一次）
+    void Stop()
+    {
+        {
+            std::lock_guard<std::mutex> lk(m_mutex);
+            m_stop = true;
+            m_running = false;
+        }
+        m_cv.notify_all();
+        if (m_thread.joinable()) m_thread.join();
+    }
+
+    // notifyOk：通知渠道是否发送成功；notifyDelayMs：从检测到通知完成的耗时
+    void Record(const TriggerEvent& ev, bool notifyOk, int64_t notifyDelayMs)
+    {
+        bool wake;
+        {
+            std::lock_guard<std::mutex> lk(m_mutex);
+            if (!m_running)
+                return;
+            if (m_rows.size() >= kMaxPending) {
+                m_rows.pop_front();
+                m_dropped++;
+            }
+            m_rows.push_back(Row{ ev, notifyOk, (int32_t)notifyDelayMs, std::chrono::steady_clock::now() });
+            wake = m_rows.size() >= (size_t)m_batchSize;
+        }
+        if (wake) m_cv.notify_one();
+    }
+
+private:
+    struct Row
+    {
+        TriggerEvent ev;
+        bool notifyOk;
+        int32_t notifyDelayMs;
+        std::chrono::steady_clock::time_point queuedAt;
+    };
+
+    static const size_t kMaxPending = 100000;
+    static const int kMaxBatch = 1000;              // 11 列 * 1000 行，远低于 prepared statement 占位符上限
+    static const int kColumns = 11;
+    static const int64_t kMaxRetryMs = 30000;
+    static const int64_t kReportMs = 60000;
+
+    ConnFactory m_factory;
+    int m_batchSize{ 200 };
+    int m_lingerMs{ 200 };
+
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::deque<Row> m_rows;
+    size_t m_dropped{ 0 };
+    bool m_stop{ false };
+    bool m_running{ false };
+    std::thread m_thread;
+
+    // 以下仅后台线程访问
+    std::unique_ptr<sql::Connection> m_conn;
+    std::unique_ptr<sql::PreparedStatement> m_fullStmt;     // batchSize 行的语句，复用
+
+    struct Stats
+    {
+        size_t rows{ 0 };
+        size_t batches{ 0 };
+        double dbMs{ 0.0 };
+    } m_stats;
+
+    static std::string buildInsert(size_t rows)
+    {
+        std::string sql =
+            "INSERT INTO alert_trigger_log (orderId, fire_seq, account, symbol, trigger_price, reason, "
+            "exchange_time, detect_time, detect_latency_us, notify_ok, notify_delay_ms) VALUES ";
+        sql.reserve(sql.size() + rows * 48);
+        for (size_t i = 0; i < rows; ++i) {
+            if (i) sql += ',';
+            sql += "(?,?,?,?,?,?,?,FROM_UNIXTIME(?/1000),?,?,?)";
+        }
+        return sql;
+    }
+
+    void run()
+    {
+        auto lastReport = std::chrono::steady_clock::now();
+        int attempts = 0;
+
+        for (;;)
+        {
+            std::vector<Row> batch;
+            {
+                std::unique_lock<std::mutex> lk(m_mutex);
+                if (m_rows.empty()) {
+                    m_cv.wait_for(lk, std::chrono::milliseconds(kReportMs),
+                        [this]() { return m_stop || !m_rows.empty(); });
+                }
+                if (!m_rows.empty() && !m_stop) {
+                    // 攒批：满一批立即写，否则最多等到第一行入队后 lingerMs
+                    auto deadline = m_rows.front().queuedAt + std::chrono::milliseconds(m_lingerMs);
+                    m_cv.wait_until(lk, deadline, [this]() {
+                        return m_stop || m_rows.size() >= (size_t)m_batchSize;
+                    });
+                }
+                if (m_rows.empty() && m_stop)
+                    break;
+
+                size_t n = m_rows.size() < (size_t)m_batchSize ? m_rows.size() : (size_t)m_batchSize;
+                batch.assign(std::make_move_iterator(m_rows.begin()),
+                    std::make_move_iterator(m_rows.begin() + n));
+                m_rows.erase(m_rows.begin(), m_rows.begin() + n);
+            }
+
+            if (!batch.empty() && !write(batch)) {
+                std::unique_lock<std::mutex> lk(m_mutex);
+                if (m_stop) {
+                    printf("[TRIGGER LOG] 退出时仍有 %zu 行未写入，已丢弃\n", batch.size() + m_rows.size());
+                    fflush(stdout);
+                    break;
+                }
+                // 放回队首，保持时间顺序
+                m_rows.insert(m_rows.begin(), std::make_move_iterator(batch.begin()),
+                    std::make_move_iterator(batch.end()));
+                while (m_rows.size() > kMaxPending) {
+                    m_rows.pop_front();
+                    m_dropped++;
+                }
+                attempts++;
+                int64_t backoff = 500LL << (attempts < 6 ? attempts : 6);
+                m_cv.wait_for(lk, std::chrono::milliseconds(backoff < kMaxRetryMs ? backoff : kMaxRetryMs),
+                    [this]() { return m_stop; });
+            }
+            else if (!batch.empty()) {
+                attempts = 0;
+            }
+
+            auto now = std::chrono::steady_clock::now();
+            if (now - lastReport >= std::chrono::milliseconds(kReportMs)) {
+                report(std::chrono::duration<double>(now - lastReport).count());
+                lastReport = now;
+            }
+        }
+    }
+
+    bool write(const std::vector<Row>& batch)
+    {
+        auto begin = std::chrono::steady_clock::now();
+        try {
+            if (!m_conn) {
+                m_conn.reset(m_factory());
+                m_fullStmt.reset();
+            }
+
+            sql::PreparedStatement* stmt;
+            std::unique_ptr<sql::PreparedStatement> partial;
+            if (batch.size() == (size_t)m_batchSize) {
+                if (!m_fullStmt)
+                    m_fullStmt.reset(m_conn->prepareStatement(buildInsert(batch.size())));
+                stmt = m_fullStmt.get();
+            }
+            else {
+                partial.reset(m_conn->prepareStatement(buildInsert(batch.size())));
+                stmt = partial.get();
+            }
+
+            int i = 1;
+            for (const auto& r : batch) {
+                stmt->setInt(i++, (int)r.ev.orderId);
+                stmt->setInt(i++, r.ev.fireSeq);
+                stmt->setString(i++, r.ev.account);
+                stmt->setString(i++, r.ev.symbol);
+                stmt->setDouble(i++, r.ev.price);
+                stmt->setString(i++, r.ev.reason);
+                stmt->setString(i++, r.ev.exchangeTime);
+                stmt->setInt64(i++, r.ev.detectMs);
+                stmt->setInt(i++, r.ev.detectLatencyUs);
+                stmt->setInt(i++, r.notifyOk ? 1 : 0);
+                stmt->setInt(i++, r.notifyDelayMs);
+            }
+            stmt->executeUpdate();
+        }
+        catch (sql::SQLException& e) {
+            printf("[DB ERROR] 写入触发历史失败（%zu 行）: %s\n", batch.size(), e.what());
+            fflush(stdout);
+            m_fullStmt.reset();
+            m_conn.reset();
+            return false;
+        }
+
+        m_stats.rows += batch.size();
+        m_stats.batches++;
+        m_stats.dbMs += std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - begin).count();
+        return true;
+    }
+
+    void report(double seconds)
+    {
+        size_t backlog, dropped;
+        {
+            std::lock_guard<std::mutex> lk(m_mutex);
+            backlog = m_rows.size();
+            dropped = m_dropped;
+            m_dropped = 0;
+        }
+        if (m_stats.rows == 0 && backlog == 0 && dropped == 0)
+            return;
+
+        printf("[TRIGGER LOG] %.0fs 内写入 %zu 行 / %zu 批（平均 %.1f 行/批），DB 速率 %.0f 行/秒，积压 %zu，丢弃 %zu\n",
+            seconds, m_stats.rows, m_stats.batches,
+            m_stats.batches ? (double)m_stats.rows / m_stats.batches : 0.0,
+            m_stats.dbMs > 0 ? m_stats.rows * 1000.0 / m_stats.dbMs : 0.0,
+            backlog, dropped);
+        fflush(stdout);
+        m_stats = Stats();
+    }
+};
@@ -0,0 +1,741 @@
+﻿#pragma once
+#include "TriggerEvent.h"
+#include "Crc32.h"
+#include <Windows.h>
+#include <io.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include <deque>
+#include <unordered_map>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+#include <functional>
+#include <chrono>
+#include <cstring>
+#include <algorithm>
+
+// =========================================================
+// ===========   触发事件 outbox（本地预写日志）   ===========
+// =========================================================
+//
+// 触发 -> Append（tick 线程，仅入队）
+//      -> writer 线程批量写入并 fsync（组提交）
+//      -> delivery 线程先通知、再写 DB，各自成功后追加确认记录
+// DB 不可用时通知照常发出，DB 更新按退避重试；进程崩溃后由 Open() 从文件恢复未完成的事件。
+// 同一事件的通知与 DB 更新分别确认，重放时不会重复通知已确认的事件；DB 更新本身幂等。
+// 通知失败按同样的退避重试，连续失败 kMaxNotifyAttempts 次后放弃；成功或放弃时调用一次结果回调（记入触发历史）。
+// 异步渠道（通知合并、限流队列等）返回 NOTIFY_PENDING，实际结果由 CompleteNotify() 送回，此前事件不会重发、也不确认。
+// NOTIFY_BUSY（渠道队列已满）按退避稍后重试，不计入失败次数。
+//
+// 设置了认领回调（多实例部署）时，delivery 线程先批量认领，只有认领成功的事件才通知，通知后再在 DB 确认；
+// 被其他实例认领（或 DB 中已不是待触发）的事件直接结束。崩溃恢复出的已认领事件、通知失败后的重试，
+// 通知前都先确认认领仍归本实例（同时续租）。放弃通知时释放认领，由存活实例接管重试。
+//
+// 文件由若干记录组成：[magic u32][type u16][len u16][crc32 u32][payload len 字节]
+// 文件尾部的半条记录（写入中途崩溃）在恢复时截断。
+
+// 认领结果；CLAIM_RETRY 同时表示尚未认领
+enum TriggerClaimResult : uint8_t
+{
+    CLAIM_RETRY = 0,
+    CLAIM_WON = 1,
+    CLAIM_LOST = 2
+};
+
+class TriggerOutbox
+{
+public:
+    typedef std::function<bool(const TriggerEvent&)> Handler;
+    // 返回 NotifyResult
+    typedef std::function<uint8_t(const TriggerEvent&)> NotifyHandler;
+    // 一批事件一次认领，results 与 events 一一对应；认领成功时填入 claimSeq
+    typedef std::function<void(const std::vector<TriggerEvent*>& events, std::vector<uint8_t>& results)> ClaimHandler;
+    // 恢复出的已认领事件在通知前确认认领仍归本实例
+    typedef std::function<uint8_t(const TriggerEvent&)> ConfirmHandler;
+    // 通知的最终结果（成功，或重试耗尽后放弃），每个事件在本实例至多一次
+    typedef std::function<void(const TriggerEvent&, bool ok)> OutcomeHandler;
+
+    ~TriggerOutbox()
+    {
+        Stop();
+    }
+
+    // 启用认领，需在 Open() 之前调用；此时 markTriggered 改为“已通知”的确认，
+    // release 在放弃通知时释放认领（返回 false 稍后重试）
+    void SetClaimHandlers(ClaimHandler claim, ConfirmHandler confirm, Handler release)
+    {
+        m_claim = claim;
+        m_confirm = confirm;
+        m_release = release;
+    }
+
+    // 打开并恢复 outbox，未完成的事件在 Start() 后重新投递
+    bool Open(const std::string& path)
+    {
+        m_path = path;
+        auto begin = std::chrono::steady_clock::now();
+
+        std::unordered_map<uint64_t, Delivery> recovered;
+        size_t records = recoverFile(recovered);
+
+        std::vector<Delivery> pending;
+        for (auto& kv : recovered) {
+            if (finished(kv.second))
+                continue;
+            kv.second.confirm = m_claim && kv.second.claim == CLAIM_WON && !kv.second.notified;
+            pending.push_back(kv.second);
+        }
+        std::sort(pending.begin(), pending.end(),
+            [](const Delivery& a, const Delivery& b) { return a.ev.seq < b.ev.seq; });
+
+        // 只保留未完成的事件重写文件，防止无限增长
+        if (!rewriteFile(pending))
+            return false;
+
+        double ms = std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - begin).count();
+        printf("[OUTBOX] 恢复 %zu 条记录，未完成事件 %zu 个，耗时 %.1f ms（%.0f 条/秒）\n",
+            records, pending.size(), ms, ms > 0 ? records * 1000.0 / ms : 0.0);
+        fflush(stdout);
+
+        std::lock_guard<std::mutex> lk(m_mutex);
+        for (auto& d : pending) {
+            if (d.ev.final)
+                m_finals[d.ev.orderId] = FinalState{ d.ev.symbol, finalInDb(d) ? nowMs() : 0 };
+            m_deliverQueue.push_back(d);
+            m_outstanding++;
+        }
+        return true;
+    }
+
+    void Start(NotifyHandler notify, Handler markTriggered, OutcomeHandler outcome = OutcomeHandler())
+    {
+        m_notify = notify;
+        m_markTriggered = markTriggered;
+        m_outcome = outcome;
+        m_stop = false;
+        m_writer = std::thread([this]() { writerLoop(); });
+        m_deliverer = std::thread([this]() { deliveryLoop(); });
+    }
+
+    void Stop()
+    {
+        {
+            std::lock_guard<std::mutex> lk(m_mutex);
+            m_stop = true;
+        }
+        m_writeCv.notify_all();
+        m_deliverCv.notify_all();
+        if (m_writer.joinable()) m_writer.join();
+        if (m_deliverer.joinable()) m_deliverer.join();
+        if (m_file) {
+            fclose(m_file);
+            m_file = nullptr;
+        }
+    }
+
+    // tick 路径：分配序号并排队，等待组提交；调用方可持有自己的锁
+    void Append(std::vector<TriggerEvent>& events)
+    {
+        if (events.empty()) return;
+        {
+            std::lock_guard<std::mutex> lk(m_mutex);
+            for (auto& ev : events) {
+                ev.seq = ++m_nextSeq;
+                if (ev.final)
+                    m_finals[ev.orderId] = FinalState{ ev.symbol, 0 };
+                m_outstanding++;
+                m_writeQueue.push_back(Entry{ OUTBOX_EVENT, ev });
+            }
+        }
+        m_writeCv.notify_one();
+    }
+
+    // 异步通知的结果（可在任意线程调用）；seq 为通知时事件的 outbox 序号
+    void CompleteNotify(uint64_t seq, uint8_t result)
+    {
+        {
+            std::lock_guard<std::mutex> lk(m_mutex);
+            m_completions.push_back(std::make_pair(seq, result));
+        }
+        m_deliverCv.notify_one();
+    }
+
+    // 接管其他实例认领后未通知的事件：已认领（DB 中的 state 已更新），只需通知并确认
+    void AppendClaimed(std::vector<TriggerEvent>& events)
+    {
+        if (events.empty()) return;
+        {
+            std::lock_guard<std::mutex> lk(m_mutex);
+            for (auto& ev : events) {
+                ev.seq = ++m_nextSeq;
+                m_outstanding++;
+                m_writeQueue.push_back(Entry{ OUTBOX_EVENT, ev, CLAIM_WON });
+            }
+        }
+        m_writeCv.notify_one();
+    }
+
+    // reload 路径：最终触发尚未写入 DB（或写入不足 kFinalRetainMs）的预警，
+    // 加载时需要排除，否则 DB 中仍是 state=0 的行会被重新载入并再次触发
+    std::vector<std::pair<long, std::string>> PendingFinalOrders()
+    {
+        std::vector<std::pair<long, std::string>> out;
+        int64_t now = nowMs();
+
+        std::lock_guard<std::mutex> lk(m_mutex);
+        for (auto it = m_finals.begin(); it != m_finals.end();) {
+            if (it->second.dbAckMs != 0 && now - it->second.dbAckMs > kFinalRetainMs) {
+                it = m_finals.erase(it);
+                continue;
+            }
+            out.emplace_back(it->first, it->second.symbol);
+            ++it;
+        }
+        return out;
+    }
+
+private:
+    enum RecordType : uint16_t
+    {
+        OUTBOX_EVENT = 1,
+        OUTBOX_ACK_NOTIFY = 2,
+        OUTBOX_ACK_DB = 3,
+        OUTBOX_ACK_CLAIM = 4        // 认领结果（CLAIM_WON / CLAIM_LOST）
+    };
+
+    static const uint32_t kMagic = 0x31424F54;                   // "TOB1"
+    static const int64_t kFinalRetainMs = 30000;                 // 覆盖若干个 reload 周期
+    static const int64_t kCompactBytes = 4 * 1024 * 1024;
+    static const int64_t kMaxRetryMs = 30000;
+    static const int kMaxNotifyAttempts = 6;                     // 约 1.5 分钟内的退避重试
+    static const size_t kClaimBatch = 200;                       // 每个认领事务最多的事件数
+
+#pragma pack(push, 1)
+    struct RecordHeader
+    {
+        uint32_t magic;
+        uint16_t type;
+        uint16_t length;
+        uint32_t crc;
+    };
+#pragma pack(pop)
+
+    struct Entry
+    {
+        uint16_t type;
+        TriggerEvent ev;        // ACK 记录只使用 ev.seq
+        uint8_t claim{ CLAIM_RETRY };   // ACK_CLAIM 的结果；EVENT 为 CLAIM_WON 时表示接管来的已认领事件
+    };
+
+    struct Delivery
+    {
+        TriggerEvent ev;
+        bool notified{ false };
+        bool dbDone{ false };
+        uint8_t claim{ CLAIM_RETRY };
+        bool confirm{ false };  // 恢复出的已认领事件或通知失败后的重试，通知前需确认
+        int attempts{ 0 };
+        int notifyFailures{ 0 };
+        bool gaveUp{ false };   // 通知重试已耗尽；认领模式下等待释放认领
+        bool pending{ false };  // 异步通知已发出，等待 CompleteNotify
+        int64_t nextRetryMs{ 0 };
+    };
+
+    struct FinalState
+    {
+        std::string symbol;
+        int64_t dbAckMs;        // 0 表示尚未写入 DB
+    };
+
+    std::string m_path;
+    FILE* m_file{ nullptr };
+    int64_t m_fileBytes{ 0 };
+
+    std::mutex m_mutex;
+    std::condition_variable m_writeCv;
+    std::condition_variable m_deliverCv;
+    std::vector<Entry> m_writeQueue;
+    std::deque<Delivery> m_deliverQueue;
+    std::vector<std::pair<uint64_t, uint8_t>> m_completions;
+    std::unordered_map<long, FinalState> m_finals;
+    uint64_t m_nextSeq{ 0 };
+    size_t m_outstanding{ 0 };
+    bool m_stop{ false };
+
+    NotifyHandler m_notify;
+    Handler m_markTriggered;
+    OutcomeHandler m_outcome;
+    ClaimHandler m_claim;
+    ConfirmHandler m_confirm;
+    Handler m_release;
+    std::thread m_writer;
+    std::thread m_deliverer;
+
+    // 被其他实例认领的事件无需通知；否则通知与 DB 都确认后才算完成
+    static bool finished(const Delivery& d)
+    {
+        return d.claim == CLAIM_LOST || (d.notified && d.dbDone);
+    }
+
+    // 最终触发的 state=1 已在 DB 中：未启用认领时看 DB 确认，启用时认领有结果即可（成功时事务内已更新）
+    bool finalInDb(const Delivery& d) const
+    {
+        return m_claim ? d.claim != CLAIM_RETRY : d.dbDone;
+    }
+
+    static int64_t nowMs()
+    {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    // ---------------- 编解码 ----------------
+    template <typename T>
+    static void put(std::string& buf, T v)
+    {
+        buf.append((const char*)&v, sizeof(T));
+    }
+
+    static void putStr(std::string& buf, const std::string& s)
+    {
+        uint16_t n = (uint16_t)(s.size() > 0xFFFF ? 0xFFFF : s.size());
+        put(buf, n);
+        buf.append(s.data(), n);
+    }
+
+    struct Cursor
+    {
+        const char* p;
+        const char* end;
+
+        // 字段缺失（旧版本记录）时保留默认值
+        template <typename T>
+        void get(T& v)
+        {
+            if (end - p < (ptrdiff_t)sizeof(T)) { p = end; return; }
+            memcpy(&v, p, sizeof(T));
+            p += sizeof(T);
+        }
+
+        void getStr(std::string& s)
+        {
+            uint16_t n = 0;
+            get(n);
+            if (end - p < n) { p = end; return; }
+            s.assign(p, n);
+            p += n;
+        }
+    };
+
+    static void encode(const Entry& e, std::string& buf)
+    {
+        std::string payload;
+        put(payload, e.ev.seq);
+        if (e.type == OUTBOX_EVENT) {
+            put(payload, (int64_t)e.ev.orderId);
+            put(payload, (int32_t)e.ev.fireSeq);
+            put(payload, (uint8_t)(e.ev.final ? 1 : 0));
+            put(payload, e.ev.price);
+            put(payload, e.ev.detectMs);
+            putStr(payload, e.ev.account);
+            putStr(payload, e.ev.symbol);
+            putStr(payload, e.ev.reason);
+            // 新字段只能追加在末尾，旧记录解码时保留默认值
+            putStr(payload, e.ev.exchangeTime);
+            put(payload, e.ev.detectLatencyUs);
+            put(payload, e.ev.priority);
+            put(payload, e.ev.claimSeq);
+        }
+        else if (e.type == OUTBOX_ACK_CLAIM) {
+            put(payload, e.claim);
+            put(payload, e.ev.claimSeq);
+        }
+
+        RecordHeader h;
+        h.magic = kMagic;
+        h.type = e.type;
+        h.length = (uint16_t)payload.size();
+        h.crc = Crc32(payload.data(), payload.size());
+        buf.append((const char*)&h, sizeof(h));
+        buf.append(payload);
+    }
+
+    static void decodeEvent(Cursor& c, TriggerEvent& ev)
+    {
+        int64_t orderId = 0;
+        int32_t fireSeq = 0;
+        uint8_t final = 0;
+        c.get(ev.seq);
+        c.get(orderId);
+        c.get(fireSeq);
+        c.get(final);
+        c.get(ev.price);
+        c.get(ev.detectMs);
+        c.getStr(ev.account);
+        c.getStr(ev.symbol);
+        c.getStr(ev.reason);
+        c.getStr(ev.exchangeTime);
+        c.get(ev.detectLatencyUs);
+        c.get(ev.priority);
+        c.get(ev.claimSeq);
+        ev.orderId = (long)orderId;
+        ev.fireSeq = fireSeq;
+        ev.final = final != 0;
+    }
+
+    // ---------------- 恢复 ----------------
+    // 顺序扫描整个文件，遇到损坏或不完整的记录即停止
+    size_t recoverFile(std::unordered_map<uint64_t, Delivery>& out)
+    {
+        FILE* fp = nullptr;
+        if (fopen_s(&fp, m_path.c_str(), "rb") != 0 || !fp)
+            return 0;
+
+        std::string data;
+        _fseeki64(fp, 0, SEEK_END);
+        int64_t size = _ftelli64(fp);
+        _fseeki64(fp, 0, SEEK_SET);
+        if (size > 0) {
+            data.resize((size_t)size);
+            data.resize(fread(&data[0], 1, (size_t)size, fp));
+        }
+        fclose(fp);
+
+        size_t records = 0;
+        size_t off = 0;
+        while (off + sizeof(RecordHeader) <= data.size())
+        {
+            RecordHeader h;
+            memcpy(&h, data.data() + off, sizeof(h));
+            const char* payload = data.data() + off + sizeof(h);
+            if (h.magic != kMagic || off + sizeof(h) + h.length > data.size() ||
+                Crc32(payload, h.length) != h.crc)
+                break;
+
+            Cursor c{ payload, payload + h.length };
+            if (h.type == OUTBOX_EVENT) {
+                Delivery d;
+                decodeEvent(c, d.ev);
+                d.dbDone = !m_claim && !d.ev.final;     // 非最终触发不需要更新 DB；认领模式下都要确认已通知
+                out[d.ev.seq] = d;
+            }
+            else {
+                uint64_t seq = 0;
+                c.get(seq);
+                auto it = out.find(seq);
+                if (it != out.end()) {
+                    if (h.type == OUTBOX_ACK_NOTIFY) it->second.notified = true;
+                    else if (h.type == OUTBOX_ACK_DB) it->second.dbDone = true;
+                    else if (h.type == OUTBOX_ACK_CLAIM) {
+                        c.get(it->second.claim);
+                        c.get(it->second.ev.claimSeq);
+                    }
+                }
+            }
+
+            off += sizeof(h) + h.length;
+            records++;
+        }
+
+        for (const auto& kv : out) {
+            if (kv.first > m_nextSeq) m_nextSeq = kv.first;
+        }
+
+        if (off < data.size()) {
+            printf("[OUTBOX] 文件尾部 %zu 字节不完整或损坏，已丢弃\n", data.size() - off);
+            fflush(stdout);
+        }
+        return records;
+    }
+
+    // 写临时文件后替换原文件，保证任意时刻崩溃都不会丢失未完成事件
+    bool rewriteFile(const std::vector<Delivery>& pending)
+    {
+        std::string buf;
+        for (const auto& d : pending) {
+            encode(Entry{ OUTBOX_EVENT, d.ev }, buf);
+            if (d.claim != CLAIM_RETRY) encode(Entry{ OUTBOX_ACK_CLAIM, d.ev, d.claim }, buf);
+            if (d.notified) encode(Entry{ OUTBOX_ACK_NOTIFY, d.ev }, buf);
+            if (d.dbDone && (d.ev.final || m_claim)) encode(Entry{ OUTBOX_ACK_DB, d.ev }, buf);
+        }
+
+        std::string tmpPath = m_path + ".tmp";
+        FILE* fp = nullptr;
+        if (fopen_s(&fp, tmpPath.c_str(), "wb") != 0 || !fp) {
+            printf("[OUTBOX ERROR] 无法创建 %s\n", tmpPath.c_str());
+            fflush(stdout);
+            return false;
+        }
+        bool ok = buf.empty() || fwrite(buf.data(), 1, buf.size(), fp) == buf.size();
+        ok = ok && fflush(fp) == 0 && _commit(_fileno(fp)) == 0;
+        fclose(fp);
+        if (!ok || !MoveFileExA(tmpPath.c_str(), m_path.c_str(),
+            MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH)) {
+            printf("[OUTBOX ERROR] 重写 %s 失败\n", m_path.c_str());
+            fflush(stdout);
+            return false;
+        }
+
+        if (fopen_s(&m_file, m_path.c_str(), "ab") != 0 || !m_file) {
+            printf("[OUTBOX ERROR] 无法打开 %s\n", m_path.c_str());
+            fflush(stdout);
+            m_file = nullptr;
+            return false;
+        }
+        m_fileBytes = (int64_t)buf.size();
+        return true;
+    }
+
+    // ---------------- writer：组提交 ----------------
+    void writerLoop()
+    {
+        std::string buf;
+        for (;;)
+        {
+            std::vector<Entry> batch;
+            {
+                std::unique_lock<std::mutex> lk(m_mutex);
+                m_writeCv.wait(lk, [this]() { return m_stop || !m_writeQueue.empty(); });
+                if (m_writeQueue.empty())
+                    break;
+                batch.swap(m_writeQueue);
+            }
+
+            buf.clear();
+            bool hasEvents = false;
+            for (const auto& e : batch) {
+                encode(e, buf);
+                if (e.type == OUTBOX_EVENT && e.claim == CLAIM_WON)
+                    encode(Entry{ OUTBOX_ACK_CLAIM, e.ev, CLAIM_WON }, buf);
+                hasEvents |= e.type == OUTBOX_EVENT;
+            }
+
+            // 确认记录丢失只会导致重放一次幂等操作，因此只有新事件需要 fsync
+            bool ok = m_file && fwrite(buf.data(), 1, buf.size(), m_file) == buf.size()
+                && fflush(m_file) == 0;
+            if (ok && hasEvents)
+                ok = _commit(_fileno(m_file)) == 0;
+            if (!ok) {
+                printf("[OUTBOX ERROR] 写入 %s 失败，事件仍会投递但不具备崩溃保护\n", m_path.c_str());
+                fflush(stdout);
+            }
+
+            std::lock_guard<std::mutex> lk(m_mutex);
+            m_fileBytes += (int64_t)buf.size();
+            for (auto& e : batch) {
+                if (e.type == OUTBOX_EVENT) {
+                    Delivery d;
+                    d.ev = std::move(e.ev);
+                    d.dbDone = !m_claim && !d.ev.final;
+                    d.claim = e.claim;
+                    m_deliverQueue.push_back(std::move(d));
+                }
+            }
+            if (hasEvents)
+                m_deliverCv.notify_one();
+
+            // 全部事件都已完成时截断文件
+            if (m_outstanding == 0 && m_writeQueue.empty() && m_fileBytes > kCompactBytes && m_file) {
+                fclose(m_file);
+                m_file = nullptr;
+                if (fopen_s(&m_file, m_path.c_str(), "wb") != 0)
+                    m_file = nullptr;
+                m_fileBytes = 0;
+            }
+        }
+    }
+
+    // ---------------- delivery：（认领）+ 通知 + DB，失败退避重试 ----------------
+    void deliveryLoop()
+    {
+        std::vector<Delivery> retry;
+        for (;;)
+        {
+            std::deque<Delivery> batch;
+            std::vector<std::pair<uint64_t, uint8_t>> completions;
+            {
+                std::unique_lock<std::mutex> lk(m_mutex);
+                m_deliverCv.wait_for(lk, std::chrono::seconds(1),
+                    [this]() { return m_stop || !m_deliverQueue.empty() || !m_completions.empty(); });
+                if (m_stop)
+                    break;      // 未完成的事件（含等待异步结果的）留在文件中，下次启动恢复
+                batch.swap(m_deliverQueue);
+                completions.swap(m_completions);
+            }
+
+            // 异步通知的结果：成功的立即继续（更新 DB），失败的按退避重试
+            if (!completions.empty()) {
+                std::unordered_map<uint64_t, uint8_t> results(completions.begin(), completions.end());
+                std::vector<Entry> acks;
+                for (auto& d : retry) {
+                    auto it = d.pending ? results.find(d.ev.seq) : results.end();
+                    if (it == results.end())
+                        continue;
+                    d.pending = false;
+                    onNotifyResult(d, it->second, acks);
+                    if (d.notified || d.gaveUp) d.nextRetryMs = 0;
+                    else scheduleRetry(d);
+                }
+                pushAcks(acks);
+            }
+
+            // 新事件与到期的重试一起认领，每个事务最多 kClaimBatch 个
+            if (m_claim) {
+                int64_t due = nowMs();
+                std::vector<Delivery*> work;
+                for (auto& d : batch)
+                    if (d.claim == CLAIM_RETRY) work.push_back(&d);
+                for (auto& d : retry)
+                    if (d.claim == CLAIM_RETRY && d.nextRetryMs <= due) work.push_back(&d);
+                for (size_t i = 0; i < work.size(); i += kClaimBatch)
+                    claimBatch(work.data() + i, std::min(kClaimBatch, work.size() - i));
+            }
+
+            for (auto& d : batch) {
+                if (!deliver(d)) retry.push_back(std::move(d));
+            }
+
+            int64_t now = nowMs();
+            for (size_t i = 0; i < retry.size();) {
+                if (!retry[i].pending && retry[i].nextRetryMs <= now && deliver(retry[i])) {
+                    retry[i] = std::move(retry.back());
+                    retry.pop_back();
+                }
+                else {
+                    ++i;
+                }
+            }
+        }
+    }
+
+    // 认领一批事件；结果与通知、DB 确认一样追加确认记录，失败的留待重试
+    void claimBatch(Delivery** items, size_t count)
+    {
+        std::vector<TriggerEvent*> events;
+        for (size_t i = 0; i < count; ++i)
+            events.push_back(&items[i]->ev);
+        std::vector<uint8_t> results;
+        m_claim(events, results);
+
+        std::vector<Entry> acks;
+        for (size_t i = 0; i < count && i < results.size(); ++i) {
+            if (results[i] == CLAIM_RETRY)
+                continue;
+            items[i]->claim = results[i];
+            acks.push_back(Entry{ OUTBOX_ACK_CLAIM, items[i]->ev, results[i] });
+        }
+        pushAcks(acks);
+    }
+
+    // 一次通知的结果：成功确认并回调；失败计数，达到上限时放弃；队列已满只等待重试
+    void onNotifyResult(Delivery& d, uint8_t result, std::vector<Entry>& acks)
+    {
+        if (result == NOTIFY_PENDING) {
+            d.pending = true;
+            return;
+        }
+        if (result == NOTIFY_BUSY) {
+            if (m_claim) d.confirm = true;
+            return;
+        }
+        if (result == NOTIFY_OK) {
+            d.notified = true;
+            acks.push_back(Entry{ OUTBOX_ACK_NOTIFY, d.ev });
+            if (m_outcome) m_outcome(d.ev, true);
+        }
+        else if (++d.notifyFailures >= kMaxNotifyAttempts) {
+            printf("[OUTBOX] 触发 orderId=%ld fire_seq=%d 通知连续失败 %d 次，放弃%s\n", d.ev.orderId, d.ev.fireSeq,
+                d.notifyFailures, m_claim ? "并释放认领" : "");
+            fflush(stdout);
+            d.gaveUp = true;
+            if (m_outcome) m_outcome(d.ev, false);
+            // 未启用认领时按已通知确认，继续更新 DB，事件就此结束
+            if (!m_claim) {
+                d.notified = true;
+                acks.push_back(Entry{ OUTBOX_ACK_NOTIFY, d.ev });
+            }
+        }
+        else if (m_claim) {
+            d.confirm = true;       // 重试前续租，期间被接管则不再重试
+        }
+    }
+
+    void pushAcks(std::vector<Entry>& acks)
+    {
+        if (acks.empty())
+            return;
+        {
+            std::lock_guard<std::mutex> lk(m_mutex);
+            for (auto& a : acks) m_writeQueue.push_back(std::move(a));
+        }
+        m_writeCv.notify_one();
+    }
+
+    // 返回 true 表示事件已完成（通知与 DB 都已确认，或被其他实例认领）
+    bool deliver(Delivery& d)
+    {
+        std::vector<Entry> acks;
+
+        // 启用认领时：认领成功才通知，通知后才确认；恢复出的已认领事件先确认认领仍归本实例
+        bool mayNotify = !m_claim || d.claim == CLAIM_WON;
+        if (mayNotify && d.confirm && !d.notified) {
+            uint8_t r = m_confirm ? m_confirm(d.ev) : (uint8_t)CLAIM_WON;
+            if (r == CLAIM_WON) {
+                d.confirm = false;
+            }
+            else {
+                mayNotify = false;
+                if (r == CLAIM_LOST) {
+                    d.claim = CLAIM_LOST;
+                    acks.push_back(Entry{ OUTBOX_ACK_CLAIM, d.ev, CLAIM_LOST });
+                }
+            }
+        }
+
+        if (mayNotify && !d.notified && !d.gaveUp && m_notify)
+            onNotifyResult(d, m_notify(d.ev), acks);
+        if (d.pending) {
+            pushAcks(acks);
+            return false;       // 等待异步结果，不计入重试
+        }
+        // 认领模式下放弃通知：释放认领（不标记已通知），由存活实例接管后重试
+        if (m_claim && d.gaveUp && d.claim == CLAIM_WON && (!m_release || m_release(d.ev))) {
+            d.claim = CLAIM_LOST;
+            acks.push_back(Entry{ OUTBOX_ACK_CLAIM, d.ev, CLAIM_LOST });
+        }
+        if ((!m_claim || d.notified) && !d.dbDone && m_markTriggered && m_markTriggered(d.ev)) {
+            d.dbDone = true;
+            acks.push_back(Entry{ OUTBOX_ACK_DB, d.ev });
+        }
+
+        bool done = finished(d);
+        {
+            std::lock_guard<std::mutex> lk(m_mutex);
+            for (auto& a : acks) m_writeQueue.push_back(std::move(a));
+            if (d.ev.final && finalInDb(d)) {
+                auto it = m_finals.find(d.ev.orderId);
+                if (it != m_finals.end() && it->second.dbAckMs == 0)
+                    it->second.dbAckMs = nowMs();
+            }
+            if (done && m_outstanding > 0)
+                m_outstanding--;
+        }
+        if (!acks.empty())
+            m_writeCv.notify_one();
+
+        if (!done)
+            scheduleRetry(d);
+        return done;
+    }
+
+    static void scheduleRetry(Delivery& d)
+    {
+        d.attempts++;
+        int64_t backoff = 1000LL << (d.attempts < 5 ? d.attempts : 5);
+        d.nextRetryMs = nowMs() + (backoff < kMaxRetryMs ? backoff : kMaxRetryMs);
+    }
+};
@@ -0,0 +1,697 @@
+// WebhookNotifier.cpp
+#include "WebhookNotifier.h"
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#include <stdio.h>
+#include <ctime>
+#include <chrono>
+#include <algorithm>
+
+#pragma comment(lib, "ws2_32.lib")
+
+static const int64_t kIdleTimeoutUs = 60LL * 1000 * 1000;     // ӱ 60 
+static const int64_t kReportUs = 60LL * 1000 * 1000;
+static const size_t kLatencySamples = 8192;
+
+int64_t WebhookNotifier::NowUs()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static std::string JsonEscape(const std::string& s)
+{
+    std::string out;
+    out.reserve(s.size() + 8);
+    for (unsigned char ch : s) {
+        switch (ch) {
+        case '"': out += "\\\""; break;
+        case '\\': out += "\\\\"; break;
+        case '\n': out += "\\n"; break;
+        case '\r': out += "\\r"; break;
+        case '\t': out += "\\t"; break;
+        default:
+            if (ch < 0x20) {
+                char buf[8];
+                snprintf(buf, sizeof(buf), "\\u%04x", ch);
+                out += buf;
+            }
+            else {
+                out += (char)ch;
+            }
+        }
+    }
+    return out;
+}
+
+static void SetNonBlocking(SOCKET s)
+{
+    u_long mode = 1;
+    ioctlsocket(s, FIONBIO, &mode);
+}
+
+WebhookNotifier::WebhookNotifier(const Options& options)
+    : m_opt(options)
+{
+    if (m_opt.maxInFlight < 1) m_opt.maxInFlight = 1;
+    if (m_opt.maxRetries < 0) m_opt.maxRetries = 0;
+
+    WSADATA wsaData;
+    WSAStartup(MAKEWORD(2, 2), &wsaData);
+
+    for (const auto& url : m_opt.urls) {
+        std::unique_ptr<Endpoint> ep(new Endpoint());
+        if (parseUrl(url, *ep)) {
+            m_endpoints.push_back(std::move(ep));
+        }
+        else {
+            printf("[WEBHOOK ERROR] ޷ URL: %s֧ http://host[:port]/path\n", url.c_str());
+            fflush(stdout);
+        }
+    }
+
+    // ͨ 127.0.0.1 ˿ڵ UDP socket 
+    m_wakeRecv = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    m_wakeSend = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    sockaddr_in local = {};
+    local.sin_family = AF_INET;
+    local.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    local.sin_port = 0;
+    socklen_t len = sizeof(local);
+    if (m_wakeRecv == INVALID_SOCKET || m_wakeSend == INVALID_SOCKET ||
+        bind(m_wakeRecv, (sockaddr*)&local, sizeof(local)) != 0 ||
+        getsockname(m_wakeRecv, (sockaddr*)&local, &len) != 0 ||
+        connect(m_wakeSend, (sockaddr*)&local, sizeof(local)) != 0) {
+        printf("[WEBHOOK ERROR] ޷ socket\n");
+        fflush(stdout);
+    }
+    SetNonBlocking(m_wakeRecv);
+    SetNonBlocking(m_wakeSend);
+
+    m_thread = std::thread([this]() { run(); });
+}
+
+WebhookNotifier::~WebhookNotifier()
+{
+    m_stop = true;
+    wake();
+    if (m_thread.joinable()) m_thread.join();
+
+    for (auto& c : m_conns) closeConn(c.get());
+    if (m_wakeRecv != INVALID_SOCKET) closesocket(m_wakeRecv);
+    if (m_wakeSend != INVALID_SOCKET) closesocket(m_wakeSend);
+    WSACleanup();
+}
+
+bool WebhookNotifier::parseUrl(const std::string& url, Endpoint& ep)
+{
+    const std::string scheme = "http://";
+    if (url.compare(0, scheme.size(), scheme) != 0)
+        return false;
+
+    size_t hostBegin = scheme.size();
+    size_t pathBegin = url.find('/', hostBegin);
+    std::string hostPort = url.substr(hostBegin, pathBegin == std::string::npos ? std::string::npos : pathBegin - hostBegin);
+    ep.path = pathBegin == std::string::npos ? "/" : url.substr(pathBegin);
+
+    size_t colon = hostPort.rfind(':');
+    if (colon != std::string::npos) {
+        ep.host = hostPort.substr(0, colon);
+        ep.port = hostPort.substr(colon + 1);
+    }
+    else {
+        ep.host = hostPort;
+        ep.port = "80";
+    }
+    ep.url = url;
+    return !ep.host.empty() && !ep.port.empty();
+}
+
+// ״ʱһΣʧܺԱ½
+bool WebhookNotifier::resolve(Endpoint& ep)
+{
+    if (ep.addrLen > 0)
+        return true;
+
+    addrinfo hints = {};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_protocol = IPPROTO_TCP;
+    addrinfo* result = nullptr;
+    if (getaddrinfo(ep.host.c_str(), ep.port.c_str(), &hints, &result) != 0 || !result)
+        return false;
+
+    memcpy(&ep.addr, result->ai_addr, result->ai_addrlen);
+    ep.addrLen = (int)result->ai_addrlen;
+    freeaddrinfo(result);
+    return true;
+}
+
+bool WebhookNotifier::SendAlert(const std::string& account, const std::string& instrument,
+    double price, const std::string& reason, Completion done)
+{
+    std::time_t now = std::time(nullptr);
+    std::tm local_tm = { 0 };
+    localtime_s(&local_tm, &now);
+    char timeBuf[32];
+    std::strftime(timeBuf, sizeof(timeBuf), "%Y-%m-%d %H:%M:%S", &local_tm);
+
+    char priceBuf[32];
+    snprintf(priceBuf, sizeof(priceBuf), "%.6g", price);
+
+    std::string json = "{\"account\":\"" + JsonEscape(account) +
+        "\",\"symbol\":\"" + JsonEscape(instrument) +
+        "\",\"price\":" + priceBuf +
+        ",\"reason\":\"" + JsonEscape(reason) +
+        "\",\"time\":\"" + timeBuf + "\"}";
+    return Post(json, done);
+}
+
+bool WebhookNotifier::Post(const std::string& json, Completion done)
+{
+    if (m_endpoints.empty())
+        return false;
+    if (m_backlog.load() + m_endpoints.size() > (size_t)m_opt.maxQueue) {
+        m_dropped += m_endpoints.size();
+        return false;
+    }
+
+    auto body = std::make_shared<const std::string>(json);
+    std::shared_ptr<Group> group;
+    if (done) {
+        group = std::make_shared<Group>();
+        group->remaining = m_endpoints.size();
+        group->done = done;
+    }
+    int64_t now = NowUs();
+    {
+        std::lock_guard<std::mutex> lk(m_mutex);
+        for (auto& ep : m_endpoints) {
+            Request r;
+            r.ep = ep.get();
+            r.body = body;
+            r.group = group;
+            r.enqueueUs = now;
+            m_incoming.push_back(std::move(r));
+        }
+    }
+    m_backlog += m_endpoints.size();
+    wake();
+    return true;
+}
+
+void WebhookNotifier::wake()
+{
+    if (!m_wakePending.exchange(true))
+        send(m_wakeSend, "w", 1, 0);
+}
+
+WebhookNotifier::Stats WebhookNotifier::GetStats()
+{
+    Stats st;
+    std::vector<double> samples;
+    {
+        std::lock_guard<std::mutex> lk(m_statsMutex);
+        st.succeeded = m_succeeded;
+        st.failed = m_failed;
+        st.retries = m_retries;
+        samples = m_latencyMs;
+    }
+    st.dropped = m_dropped.load();
+    st.backlog = m_backlog.load();
+    st.connections = 0;
+    for (const auto& ep : m_endpoints) st.connections += ep->open;     // ֵȡ
+
+    st.p50Ms = st.p99Ms = 0.0;
+    if (!samples.empty()) {
+        size_t i50 = samples.size() / 2;
+        size_t i99 = samples.size() * 99 / 100;
+        std::nth_element(samples.begin(), samples.begin() + i50, samples.end());
+        st.p50Ms = samples[i50];
+        std::nth_element(samples.begin(), samples.begin() + i99, samples.end());
+        st.p99Ms = samples[i99];
+    }
+    return st;
+}
+
+// =========================================================
+// ߳
+// =========================================================
+void WebhookNotifier::run()
+{
+    std::vector<WSAPOLLFD> fds;
+    std::vector<Conn*> fdConns;
+    int64_t lastReport = NowUs();
+
+    while (!m_stop.load())
+    {
+        int64_t now = NowUs();
+        {
+            std::lock_guard<std::mutex> lk(m_mutex);
+            for (auto& r : m_incoming) m_pending.push_back(std::move(r));
+            m_incoming.clear();
+        }
+        dispatch(now);
+
+        // װ poll ϣͬʱĳʱʱ
+        fds.clear();
+        fdConns.clear();
+        WSAPOLLFD wfd = {};
+        wfd.fd = m_wakeRecv;
+        wfd.events = POLLRDNORM;
+        fds.push_back(wfd);
+        fdConns.push_back(nullptr);
+
+        int64_t next = now + 1000 * 1000;
+        for (auto& c : m_conns) {
+            WSAPOLLFD pfd = {};
+            pfd.fd = c->s;
+            switch (c->state) {
+            case CONN_CONNECTING:
+            case CONN_WRITING: pfd.events = POLLWRNORM; break;
+            case CONN_READING:
+            case CONN_IDLE: pfd.events = POLLRDNORM; break;
+            default: continue;
+            }
+            fds.push_back(pfd);
+            fdConns.push_back(c.get());
+            if (c->state != CONN_IDLE && c->deadlineUs < next) next = c->deadlineUs;
+        }
+        for (const auto& r : m_retry) {
+            if (r.notBeforeUs < next) next = r.notBeforeUs;
+        }
+
+        int timeoutMs = next > now ? (int)((next - now + 999) / 1000) : 0;
+        int n = WSAPoll(fds.data(), (ULONG)fds.size(), timeoutMs);
+
+        now = NowUs();
+        if (n > 0) {
+            if (fds[0].revents) {
+                char buf[256];
+                while (recv(m_wakeRecv, buf, sizeof(buf), 0) > 0) {}
+                m_wakePending = false;
+            }
+            for (size_t i = 1; i < fds.size(); ++i) {
+                if (fds[i].revents)
+                    onEvent(fdConns[i], fds[i].revents, now);
+            }
+        }
+
+        checkTimeouts(now);
+
+        // ѹرյ
+        m_conns.erase(std::remove_if(m_conns.begin(), m_conns.end(),
+            [](const std::unique_ptr<Conn>& c) { return c->state == CONN_CLOSED; }), m_conns.end());
+
+        if (now - lastReport >= kReportUs) {
+            report((now - lastReport) / 1e6);
+            lastReport = now;
+        }
+    }
+}
+
+void WebhookNotifier::dispatch(int64_t now)
+{
+    // ڵŵ
+    for (size_t i = 0; i < m_retry.size();) {
+        if (m_retry[i].notBeforeUs <= now) {
+            m_pending.push_front(std::move(m_retry[i]));
+            m_retry[i] = std::move(m_retry.back());
+            m_retry.pop_back();
+        }
+        else {
+            ++i;
+        }
+    }
+
+    while (m_inFlight < m_opt.maxInFlight && !m_pending.empty())
+    {
+        Request r = std::move(m_pending.front());
+        m_pending.pop_front();
+        Endpoint* ep = r.ep;
+
+        Conn* c = nullptr;
+        if (!ep->idle.empty()) {
+            c = ep->idle.back();
+            ep->idle.pop_back();
+            c->reused = true;
+        }
+        else {
+            c = openConn(ep, now);
+            if (!c) {
+                retryOrFail(std::move(r), "ʧ", now);
+                continue;
+            }
+        }
+
+        c->wire = "POST " + ep->path + " HTTP/1.1\r\n"
+            "Host: " + ep->host + (ep->port == "80" ? "" : ":" + ep->port) + "\r\n"
+            "Content-Type: application/json\r\n"
+            "Content-Length: " + std::to_string(r.body->size()) + "\r\n"
+            "Connection: keep-alive\r\n\r\n" + *r.body;
+        c->req = std::move(r);
+        c->hasReq = true;
+        c->sent = 0;
+        c->in.clear();
+        m_inFlight++;
+
+        if (c->state == CONN_CONNECTING) {
+            c->deadlineUs = now + m_opt.connectTimeoutMs * 1000LL;
+        }
+        else {
+            c->state = CONN_WRITING;
+            c->deadlineUs = now + m_opt.requestTimeoutMs * 1000LL;
+            trySend(c, now);
+        }
+    }
+}
+
+WebhookNotifier::Conn* WebhookNotifier::openConn(Endpoint* ep, int64_t now)
+{
+    if (!resolve(*ep))
+        return nullptr;
+
+    SOCKET s = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (s == INVALID_SOCKET)
+        return nullptr;
+    SetNonBlocking(s);
+    int one = 1;
+    setsockopt(s, IPPROTO_TCP, TCP_NODELAY, (const char*)&one, sizeof(one));
+
+    std::unique_ptr<Conn> c(new Conn());
+    c->s = s;
+    c->ep = ep;
+    if (connect(s, (sockaddr*)&ep->addr, ep->addrLen) == 0) {
+        c->state = CONN_WRITING;
+    }
+    else {
+        int err = WSAGetLastError();
+        if (err != WSAEWOULDBLOCK && err != WSAEINPROGRESS) {
+            closesocket(s);
+            ep->addrLen = 0;
+            return nullptr;
+        }
+        c->state = CONN_CONNECTING;
+    }
+
+    ep->open++;
+    m_conns.push_back(std::move(c));
+    return m_conns.back().get();
+}
+
+void WebhookNotifier::onEvent(Conn* c, short revents, int64_t now)
+{
+    switch (c->state) {
+    case CONN_CONNECTING:
+    {
+        int err = 0;
+        socklen_t len = sizeof(err);
+        getsockopt(c->s, SOL_SOCKET, SO_ERROR, (char*)&err, &len);
+        if (err != 0 || (revents & (POLLERR | POLLHUP))) {
+            c->ep->addrLen = 0;
+            connFailed(c, "ʧ", now);
+            return;
+        }
+        c->state = CONN_WRITING;
+        c->deadlineUs = now + m_opt.requestTimeoutMs * 1000LL;
+        trySend(c, now);
+        break;
+    }
+    case CONN_WRITING:
+        if (revents & (POLLERR | POLLHUP | POLLNVAL)) connFailed(c, "ʧ", now);
+        else trySend(c, now);
+        break;
+    case CONN_READING:
+        tryRecv(c, now);
+        break;
+    case CONN_IDLE:
+        // ӿɶԶ˹رջݣٸ
+        closeConn(c);
+        break;
+    default:
+        break;
+    }
+}
+
+void WebhookNotifier::trySend(Conn* c, int64_t now)
+{
+    while (c->sent < c->wire.size()) {
+        int n = send(c->s, c->wire.data() + c->sent, (int)(c->wire.size() - c->sent), 0);
+        if (n > 0) {
+            c->sent += n;
+            continue;
+        }
+        if (n == SOCKET_ERROR && WSAGetLastError() == WSAEWOULDBLOCK)
+            return;
+        connFailed(c, "ʧ", now);
+        return;
+    }
+    c->state = CONN_READING;
+}
+
+void WebhookNotifier::tryRecv(Conn* c, int64_t now)
+{
+    char buf[4096];
+    bool eof = false;
+    for (;;) {
+        int n = recv(c->s, buf, sizeof(buf), 0);
+        if (n > 0) {
+            c->in.append(buf, n);
+            continue;
+        }
+        if (n == 0) {
+            eof = true;
+            break;
+        }
+        if (WSAGetLastError() == WSAEWOULDBLOCK)
+            break;
+        connFailed(c, "ʧ", now);
+        return;
+    }
+
+    int status = 0;
+    bool keepAlive = false;
+    ParseResult pr = parseResponse(c, eof, status, keepAlive);
+    if (pr == PARSE_COMPLETE)
+        finish(c, status, keepAlive && !eof, now);
+    else if (pr == PARSE_BAD || eof)
+        connFailed(c, eof ? "ӱԶ˹ر" : "Ӧʽ", now);
+}
+
+// ֻҪжӦǷԼ״̬룬Ӧ屾
+WebhookNotifier::ParseResult WebhookNotifier::parseResponse(const Conn* c, bool eof, int& status, bool& keepAlive)
+{
+    const std::string& in = c->in;
+    size_t hdrEnd = in.find("\r\n\r\n");
+    if (hdrEnd == std::string::npos)
+        return in.size() > 64 * 1024 ? PARSE_BAD : PARSE_INCOMPLETE;
+
+    int minor = 1;
+    if (sscanf_s(in.c_str(), "HTTP/1.%d %d", &minor, &status) != 2)
+        return PARSE_BAD;
+    keepAlive = minor >= 1;
+
+    long long contentLength = -1;
+    bool chunked = false;
+    size_t pos = in.find("\r\n") + 2;
+    while (pos < hdrEnd) {
+        size_t eol = in.find("\r\n", pos);
+        std::string line = in.substr(pos, eol - pos);
+        pos = eol + 2;
+
+        size_t colon = line.find(':');
+        if (colon == std::string::npos) continue;
+        std::string name = line.substr(0, colon);
+        std::string value = line.substr(colon + 1);
+        std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+        std::transform(value.begin(), value.end(), value.begin(), ::tolower);
+        value.erase(0, value.find_first_not_of(' '));
+
+        if (name == "content-length") contentLength = atoll(value.c_str());
+        else if (name == "transfer-encoding") chunked = value.find("chunked") != std::string::npos;
+        else if (name == "connection") {
+            if (value.find("close") != std::string::npos) keepAlive = false;
+            else if (value.find("keep-alive") != std::string::npos) keepAlive = true;
+        }
+    }
+
+    size_t body = hdrEnd + 4;
+    if (status == 204 || status == 304 || (status >= 100 && status < 200))
+        return PARSE_COMPLETE;
+
+    if (chunked) {
+        size_t p = body;
+        for (;;) {
+            size_t eol = in.find("\r\n", p);
+            if (eol == std::string::npos) return PARSE_INCOMPLETE;
+            unsigned long long size = strtoull(in.c_str() + p, nullptr, 16);
+            p = eol + 2;
+            if (size == 0) {
+                // ܴ trailerԿн
+                if (in.compare(p, 2, "\r\n") == 0) return PARSE_COMPLETE;
+                return in.find("\r\n\r\n", p) != std::string::npos ? PARSE_COMPLETE : PARSE_INCOMPLETE;
+            }
+            if (in.size() < p + size + 2) return PARSE_INCOMPLETE;
+            p += (size_t)size + 2;
+        }
+    }
+    if (contentLength >= 0)
+        return in.size() >= body + (size_t)contentLength ? PARSE_COMPLETE : PARSE_INCOMPLETE;
+
+    // ޳ҲǷֿ飺Ӧֱӹر
+    keepAlive = false;
+    return eof ? PARSE_COMPLETE : PARSE_INCOMPLETE;
+}
+
+void WebhookNotifier::finish(Conn* c, int status, bool keepAlive, int64_t now)
+{
+    Request r = std::move(c->req);
+    c->hasReq = false;
+    m_inFlight--;
+
+    if (keepAlive) {
+        c->state = CONN_IDLE;
+        c->idleSinceUs = now;
+        c->in.clear();
+        c->ep->idle.push_back(c);
+    }
+    else {
+        closeConn(c);
+    }
+
+    if (status >= 200 && status < 300) {
+        {
+            std::lock_guard<std::mutex> lk(m_statsMutex);
+            m_succeeded++;
+            double ms = (now - r.enqueueUs) / 1000.0;
+            if (m_latencyMs.size() < kLatencySamples) m_latencyMs.push_back(ms);
+            else m_latencyMs[m_latencyPos++ % kLatencySamples] = ms;
+            m_backlog--;
+        }
+        complete(r, true);
+        return;
+    }
+
+    // ˴ԣ 4xx Ϊ
+    if (status >= 500 || status == 429 || status == 408) {
+        retryOrFail(std::move(r), ("HTTP " + std::to_string(status)).c_str(), now);
+        return;
+    }
+
+    printf("[WEBHOOK ERROR] %s  HTTP %d\n", r.ep->url.c_str(), status);
+    fflush(stdout);
+    {
+        std::lock_guard<std::mutex> lk(m_statsMutex);
+        m_failed++;
+        m_backlog--;
+    }
+    complete(r, false);
+}
+
+void WebhookNotifier::connFailed(Conn* c, const char* why, int64_t now)
+{
+    bool stale = c->reused && c->in.empty();
+    bool hasReq = c->hasReq;
+    Request r = std::move(c->req);
+    c->hasReq = false;
+    closeConn(c);
+    if (!hasReq)
+        return;
+
+    m_inFlight--;
+    // õ keep-alive ǡñԶ˹رգطһΣԴ
+    if (stale && !r.staleRetried) {
+        r.staleRetried = true;
+        m_pending.push_front(std::move(r));
+        return;
+    }
+    retryOrFail(std::move(r), why, now);
+}
+
+void WebhookNotifier::retryOrFail(Request r, const char* why, int64_t now)
+{
+    if (r.attempt < m_opt.maxRetries) {
+        r.attempt++;
+        // ָ˱ܣ [0.5, 1.5) ӣͬʱ
+        m_rng ^= m_rng << 13;
+        m_rng ^= m_rng >> 7;
+        m_rng ^= m_rng << 17;
+        double jitter = 0.5 + (m_rng >> 11) * (1.0 / 9007199254740992.0);
+        int64_t backoffUs = (int64_t)(m_opt.retryBaseMs * 1000.0 * (1LL << (r.attempt - 1)) * jitter);
+        r.notBeforeUs = now + backoffUs;
+        m_retry.push_back(std::move(r));
+        std::lock_guard<std::mutex> lk(m_statsMutex);
+        m_retries++;
+        return;
+    }
+
+    printf("[WEBHOOK ERROR] %s ʧܣ%s %d \n", r.ep->url.c_str(), why, r.attempt);
+    fflush(stdout);
+    {
+        std::lock_guard<std::mutex> lk(m_statsMutex);
+        m_failed++;
+        m_backlog--;
+    }
+    complete(r, false);
+}
+
+// һ URL սԤ URL нص
+void WebhookNotifier::complete(Request& r, bool ok)
+{
+    if (!r.group)
+        return;
+    std::shared_ptr<Group> g = std::move(r.group);
+    if (!ok) g->ok = false;
+    if (--g->remaining == 0 && g->done)
+        g->done(g->ok);
+}
+
+void WebhookNotifier::closeConn(Conn* c)
+{
+    if (c->state == CONN_CLOSED)
+        return;
+    if (c->state == CONN_IDLE) {
+        auto& idle = c->ep->idle;
+        idle.erase(std::remove(idle.begin(), idle.end(), c), idle.end());
+    }
+    closesocket(c->s);
+    c->s = INVALID_SOCKET;
+    c->state = CONN_CLOSED;
+    c->ep->open--;
+}
+
+void WebhookNotifier::checkTimeouts(int64_t now)
+{
+    for (auto& p : m_conns) {
+        Conn* c = p.get();
+        if (c->state == CONN_CLOSED)
+            continue;
+        if (c->state == CONN_IDLE) {
+            if (now - c->idleSinceUs > kIdleTimeoutUs) closeConn(c);
+        }
+        else if (now >= c->deadlineUs) {
+            if (c->state == CONN_CONNECTING) c->ep->addrLen = 0;
+            connFailed(c, c->state == CONN_CONNECTING ? "ӳʱ" : "ʱ", now);
+        }
+    }
+}
+
+void WebhookNotifier::report(double seconds)
+{
+    Stats st = GetStats();
+    uint64_t done;
+    {
+        std::lock_guard<std::mutex> lk(m_statsMutex);
+        done = m_succeeded + m_failed;
+        m_succeeded = m_failed = m_retries = 0;
+        m_latencyMs.clear();
+        m_latencyPos = 0;
+    }
+    if (done == 0 && st.backlog == 0)
+        return;
+
+    printf("[WEBHOOK] %.0fs ڳɹ %llu ʧ %llu  %llu%.1f /룩p50 %.1f msp99 %.1f msѹ %zu %zu\n",
+        seconds, (unsigned long long)st.succeeded, (unsigned long long)st.failed,
+        (unsigned long long)st.retries, done / seconds, st.p50Ms, st.p99Ms, st.backlog, st.connections);
+    fflush(stdout);
+}
@@ -0,0 +1,160 @@
+﻿// WebhookNotifier.h
+#pragma once
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <functional>
+#include <cstdint>
+#include <WinSock2.h>
+
+// =========================================================
+// ===========   Webhook 通知（非阻塞 HTTP/1.1 客户端）   ===========
+// =========================================================
+//
+// SendAlert() 只把 JSON 请求放入队列即返回，由单个网络线程用非阻塞 socket + WSAPoll 驱动：
+//   - 每个 host:port 一个连接池，响应完成后连接保持 keep-alive 供后续请求复用
+//   - 同时在途的请求数不超过 maxInFlight
+//   - 连接超时、请求超时；失败（连接错误 / 超时 / 5xx / 429）按指数退避 + 随机抖动重试
+// 每条预警的最终结果（所有 URL 都返回 2xx 才算成功）经完成回调在网络线程中给出；
+// 退出时尚未完成的请求不再回调。
+// 仅支持 http://，https 需要在前面放一个本地反向代理。
+
+class WebhookNotifier {
+public:
+    struct Options {
+        std::vector<std::string> urls;  // 每条预警向每个 URL 各 POST 一次
+        int maxInFlight = 16;
+        int connectTimeoutMs = 2000;
+        int requestTimeoutMs = 5000;
+        int maxRetries = 3;
+        int retryBaseMs = 200;
+        int maxQueue = 100000;          // 未完成请求上限，超出时 SendAlert 返回 false
+    };
+
+    struct Stats {
+        uint64_t succeeded;
+        uint64_t failed;
+        uint64_t retries;
+        uint64_t dropped;
+        size_t backlog;                 // 排队 + 在途
+        size_t connections;
+        double p50Ms;                   // 入队到收到 2xx 响应，最近若干个请求
+        double p99Ms;
+    };
+
+    // 一条预警在所有 URL 上的最终结果，在网络线程中调用一次
+    typedef std::function<void(bool ok)> Completion;
+
+    explicit WebhookNotifier(const Options& options);
+    ~WebhookNotifier();
+
+    // 非阻塞：序列化为 JSON 后入队，队列已满或没有可用 URL 时返回 false（不回调）
+    bool SendAlert(const std::string& account, const std::string& instrument, double price, const std::string& reason,
+        Completion done = Completion());
+
+    // 向所有 URL POST 一个 JSON 字符串
+    bool Post(const std::string& json, Completion done = Completion());
+
+    bool HasEndpoints() const { return !m_endpoints.empty(); }
+
+    Stats GetStats();
+
+private:
+    enum ConnState { CONN_CONNECTING, CONN_WRITING, CONN_READING, CONN_IDLE, CONN_CLOSED };
+    enum ParseResult { PARSE_INCOMPLETE, PARSE_COMPLETE, PARSE_BAD };
+
+    struct Endpoint;
+
+    // 同一条预警发往各 URL 的请求共享，仅网络线程访问
+    struct Group {
+        size_t remaining = 0;
+        bool ok = true;
+        Completion done;
+    };
+
+    struct Request {
+        Endpoint* ep = nullptr;
+        std::shared_ptr<const std::string> body;
+        std::shared_ptr<Group> group;
+        int attempt = 0;
+        bool staleRetried = false;      // 已因复用的 keep-alive 连接被对端关闭而重发过一次
+        int64_t enqueueUs = 0;
+        int64_t notBeforeUs = 0;
+    };
+
+    struct Conn {
+        SOCKET s = INVALID_SOCKET;
+        Endpoint* ep = nullptr;
+        ConnState state = CONN_CONNECTING;
+        bool hasReq = false;
+        bool reused = false;
+        Request req;
+        std::string wire;
+        size_t sent = 0;
+        std::string in;
+        int64_t deadlineUs = 0;
+        int64_t idleSinceUs = 0;
+    };
+
+    struct Endpoint {
+        std::string url;
+        std::string host;
+        std::string port;
+        std::string path;
+        sockaddr_storage addr;
+        int addrLen = 0;
+        std::vector<Conn*> idle;
+        int open = 0;
+    };
+
+    Options m_opt;
+    std::vector<std::unique_ptr<Endpoint>> m_endpoints;
+
+    std::mutex m_mutex;
+    std::vector<Request> m_incoming;
+    std::atomic<size_t> m_backlog{ 0 };
+    std::atomic<bool> m_wakePending{ false };
+    std::atomic<bool> m_stop{ false };
+    SOCKET m_wakeRecv = INVALID_SOCKET;     // 本机 UDP 自连接，用于唤醒 WSAPoll
+    SOCKET m_wakeSend = INVALID_SOCKET;
+    std::thread m_thread;
+
+    // 以下仅网络线程访问
+    std::deque<Request> m_pending;
+    std::vector<Request> m_retry;
+    std::vector<std::unique_ptr<Conn>> m_conns;
+    int m_inFlight = 0;
+    uint64_t m_rng = 0x9E3779B97F4A7C15ull;
+
+    // 统计
+    std::mutex m_statsMutex;
+    uint64_t m_succeeded = 0;
+    uint64_t m_failed = 0;
+    uint64_t m_retries = 0;
+    std::atomic<uint64_t> m_dropped{ 0 };
+    std::vector<double> m_latencyMs;        // 环形，最多 kLatencySamples 个
+    size_t m_latencyPos = 0;
+
+    static int64_t NowUs();
+    bool parseUrl(const std::string& url, Endpoint& ep);
+    bool resolve(Endpoint& ep);
+    void wake();
+    void run();
+    void dispatch(int64_t now);
+    Conn* openConn(Endpoint* ep, int64_t now);
+    void onEvent(Conn* c, short revents, int64_t now);
+    void trySend(Conn* c, int64_t now);
+    void tryRecv(Conn* c, int64_t now);
+    ParseResult parseResponse(const Conn* c, bool eof, int& status, bool& keepAlive);
+    void finish(Conn* c, int status, bool keepAlive, int64_t now);
+    void connFailed(Conn* c, const char* why, int64_t now);
+    void retryOrFail(Request r, const char* why, int64_t now);
+    void complete(Request& r, bool ok);
+    void closeConn(Conn* c);
+    void checkTimeouts(int64_t now);
+    void report(double seconds);
+};
@@ -1,525 +1,356 @@
-#pragma once
-#include "tradeapi/ThostFtdcMdApi.h"
-#include "EmailNotifier.h"
 #include "Config.h"
-#include <Windows.h>
-#include <stdio.h>
-#include <vector>
-#include <string>
 #include <fstream>
-#include <sstream>
-#include <memory>
-#include <mutex>
-#include <unordered_map>
-#include <atomic>
-#include <thread>
-#include <functional>
-#include <algorithm>
-
-
-#include <mysql/jdbc.h>
+#include <cstdio>
 #include <cstdlib>
-#include <cstring>
-using namespace std;
-
-
 
-// ------------------------- Notifier -------------------------
-class INotifier {
-public:
-    virtual void Notify(const std::string& account, const std::string& instrument, double price, const std::string& message) = 0;
-    virtual ~INotifier() = default;
-};
-
-class ConsoleNotifier : public INotifier {
-public:
-    void Notify(const std::string& account, const std::string& instrument, double price, const std::string& message) override {
-        printf("[ALERT] û=%s Լ=%s ۸=%.2f ԭ=%s\n",
-            account.c_str(), instrument.c_str(), price, message.c_str());
-        fflush(stdout);
-    }
-};
+Config& Config::Instance()
+{
+    static Config instance;
+    return instance;
+}
 
-class EmailNotifierWrapper : public INotifier {
-private:
-    std::shared_ptr<EmailNotifier> email_notifier;
+Config::Config()
+{
+    loadDefaults();
+}
 
-public:
-    EmailNotifierWrapper(std::shared_ptr<EmailNotifier> email) : email_notifier(email) {}
+// ȼ > ļ > Ĭֵ
+void Config::Load(const std::string& filePath)
+{
+    loadDefaults();
+    loadFromFile(filePath);
+    loadFromEnv();
+}
 
-    void Notify(const std::string& account, const std::string& instrument, double price, const std::string& message) override {
-        // ̨
-        printf("[ALERT] û=%s Լ=%s ۸=%.2f ԭ=%s\n",
-            account.c_str(), instrument.c_str(), price, message.c_str());
-        fflush(stdout);
+void Config::loadDefaults()
+{
+    mdAddress = "tcp://182.254.243.31:30011";
+    mdFlowDir = "md_flow";
+    mdPartitions = 1;
+    mdTransport = "tcp";
+    mdMulticastTopicId = 0;
+    mdQuietFallbackMs = 10000;
+    mdTcpFallbackAddress.clear();
+    brokerId.clear();
+    userId.clear();
+    password.clear();
+
+    sessionBackoffBaseMs = 500;
+    sessionBackoffMaxMs = 30000;
+    sessionSubscribeChunk = 200;
+
+    tickMaxAgeSec = 300;
+    tickLog = 0;
+
+    instrumentsTable.clear();
+    instrumentsFile.clear();
+    instrumentsRefreshTime = "08:30";
+
+    evalWorkers = 0;
+    evalQueueSize = 1024;
+    evalIdle = "park";
+    evalSpinUs = 50;
+
+    threadCallbackCpus.clear();
+    threadEvalCpus.clear();
+    threadServiceCpus.clear();
+    threadRealtime = 0;
+
+    dbHost = "127.0.0.1";
+    dbPort = 3306;
+    dbUser = "root";
+    dbPassword.clear();
+    dbSchema = "futurescloudsentinel";
+
+    outboxPath = "trigger_outbox.wal";
+
+    snapshotPath = "alert_book.snap";
+    snapshotIntervalSec = 30;
+
+    reloadDeltaColumn.clear();
+    reloadFullSec = 300;
+
+    intakeBind = "127.0.0.1";
+    intakePort = 0;
+
+    binlogServerId = 0;
+    binlogHeartbeatSec = 5;
+    binlogUser.clear();
+    binlogPassword.clear();
+
+    clusterSelf.clear();
+    clusterInstances.clear();
+    clusterTable.clear();
+    clusterVirtualNodes = 128;
+    clusterLeaseSec = 15;
+    clusterHandoffSec = 10;
+
+    claimTable.clear();
+    claimLeaseSec = 30;
+
+    tickBusName.clear();
+    tickBusCapacity = 65536;
+
+    triggerBusName.clear();
+    triggerBusCapacity = 4096;
+
+    triggerLogBatchSize = 200;
+    triggerLogLingerMs = 200;
+
+    webhookUrls.clear();
+    webhookMaxInFlight = 16;
+    webhookConnectTimeoutMs = 2000;
+    webhookRequestTimeoutMs = 5000;
+    webhookMaxRetries = 3;
+
+    digestWindowMs = 3000;
+    digestMaxItems = 50;
+
+    rateGlobalPerSec = 20;
+    rateGlobalBurst = 100;
+    rateEmailPerSec = 1;
+    rateEmailBurst = 30;
+    rateWebhookPerSec = 0;
+    rateWebhookBurst = 100;
+    rateAccountPerSec = 0.2;
+    rateAccountBurst = 10;
+    rateMaxDeferred = 100000;
+}
 
-        // ʼ֪ͨû
-        email_notifier->SendAlertEmail(account, instrument, price, message);
+void Config::loadFromEnv()
+{
+    static const struct { const char* env; const char* section; const char* key; } kEnvMap[] = {
+        { "MD_ADDRESS",  "MarketData", "Address" },
+        { "MD_BROKERID", "MarketData", "BrokerID" },
+        { "MD_USERID",   "MarketData", "UserID" },
+        { "MD_PASSWORD", "MarketData", "Password" },
+        { "MD_FLOW_DIR", "MarketData", "FlowDir" },
+        { "MD_PARTITIONS", "MarketData", "Partitions" },
+        { "MD_TRANSPORT",  "MarketData", "Transport" },
+        { "MD_MULTICAST_TOPIC",      "MarketData", "MulticastTopicID" },
+        { "MD_QUIET_FALLBACK_MS",    "MarketData", "QuietFallbackMs" },
+        { "MD_TCP_FALLBACK_ADDRESS", "MarketData", "TcpFallbackAddress" },
+        { "MD_BACKOFF_BASE_MS", "Session", "BackoffBaseMs" },
+        { "MD_BACKOFF_MAX_MS",  "Session", "BackoffMaxMs" },
+        { "MD_SUBSCRIBE_CHUNK", "Session", "SubscribeChunk" },
+        { "TICK_MAX_AGE_SEC", "TickCheck", "MaxAgeSec" },
+        { "TICK_LOG",         "TickCheck", "LogTicks" },
+        { "INSTRUMENTS_TABLE",        "Instruments", "Table" },
+        { "INSTRUMENTS_FILE",         "Instruments", "File" },
+        { "INSTRUMENTS_REFRESH_TIME", "Instruments", "RefreshTime" },
+        { "EVAL_WORKERS",    "Eval", "Workers" },
+        { "EVAL_QUEUE_SIZE", "Eval", "QueueSize" },
+        { "EVAL_IDLE",       "Eval", "Idle" },
+        { "EVAL_SPIN_US",    "Eval", "SpinUs" },
+        { "THREAD_CALLBACK_CPUS", "Threads", "CallbackCpus" },
+        { "THREAD_EVAL_CPUS",     "Threads", "EvalCpus" },
+        { "THREAD_SERVICE_CPUS",  "Threads", "ServiceCpus" },
+        { "THREAD_REALTIME",      "Threads", "Realtime" },
+        { "DB_HOST",     "Database",   "Host" },
+        { "DB_PORT",     "Database",   "Port" },
+        { "DB_USER",     "Database",   "User" },
+        { "DB_PASSWORD", "Database",   "Password" },
+        { "DB_SCHEMA",   "Database",   "Schema" },
+        { "OUTBOX_PATH", "Outbox",     "Path" },
+        { "SNAPSHOT_PATH",         "Snapshot", "Path" },
+        { "SNAPSHOT_INTERVAL_SEC", "Snapshot", "IntervalSec" },
+        { "RELOAD_DELTA_COLUMN",   "Reload",   "DeltaColumn" },
+        { "RELOAD_FULL_SEC",       "Reload",   "FullReloadSec" },
+        { "INTAKE_BIND",           "Intake",   "Bind" },
+        { "INTAKE_PORT",           "Intake",   "Port" },
+        { "BINLOG_SERVER_ID",      "Binlog",   "ServerId" },
+        { "BINLOG_HEARTBEAT_SEC",  "Binlog",   "HeartbeatSec" },
+        { "BINLOG_USER",           "Binlog",   "User" },
+        { "BINLOG_PASSWORD",       "Binlog",   "Password" },
+        { "CLUSTER_SELF",          "Cluster",  "Self" },
+        { "CLUSTER_INSTANCES",     "Cluster",  "Instances" },
+        { "CLUSTER_TABLE",         "Cluster",  "Table" },
+        { "CLUSTER_VNODES",        "Cluster",  "VirtualNodes" },
+        { "CLUSTER_LEASE_SEC",     "Cluster",  "LeaseSec" },
+        { "CLUSTER_HANDOFF_SEC",   "Cluster",  "HandoffSec" },
+        { "CLAIM_TABLE",           "Claim",    "Table" },
+        { "CLAIM_LEASE_SEC",       "Claim",    "LeaseSec" },
+        { "TICKBUS_NAME",          "TickBus",  "Name" },
+        { "TICKBUS_CAPACITY",      "TickBus",  "Capacity" },
+        { "TRIGGERBUS_NAME",       "TriggerBus", "Name" },
+        { "TRIGGERBUS_CAPACITY",   "TriggerBus", "Capacity" },
+        { "TRIGGER_LOG_BATCH_SIZE", "TriggerLog", "BatchSize" },
+        { "TRIGGER_LOG_LINGER_MS",  "TriggerLog", "LingerMs" },
+        { "WEBHOOK_URL",                "Webhook", "Url" },
+        { "WEBHOOK_MAX_INFLIGHT",       "Webhook", "MaxInFlight" },
+        { "WEBHOOK_CONNECT_TIMEOUT_MS", "Webhook", "ConnectTimeoutMs" },
+        { "WEBHOOK_REQUEST_TIMEOUT_MS", "Webhook", "RequestTimeoutMs" },
+        { "WEBHOOK_MAX_RETRIES",        "Webhook", "MaxRetries" },
+        { "NOTIFY_DIGEST_WINDOW_MS", "Notify", "DigestWindowMs" },
+        { "NOTIFY_DIGEST_MAX_ITEMS", "Notify", "DigestMaxItems" },
+        { "RATE_GLOBAL_PER_SEC",  "RateLimit", "GlobalPerSec" },
+        { "RATE_GLOBAL_BURST",    "RateLimit", "GlobalBurst" },
+        { "RATE_EMAIL_PER_SEC",   "RateLimit", "EmailPerSec" },
+        { "RATE_EMAIL_BURST",     "RateLimit", "EmailBurst" },
+        { "RATE_WEBHOOK_PER_SEC", "RateLimit", "WebhookPerSec" },
+        { "RATE_WEBHOOK_BURST",   "RateLimit", "WebhookBurst" },
+        { "RATE_ACCOUNT_PER_SEC", "RateLimit", "AccountPerSec" },
+        { "RATE_ACCOUNT_BURST",   "RateLimit", "AccountBurst" },
+        { "RATE_MAX_DEFERRED",    "RateLimit", "MaxDeferred" },
+    };
+
+    for (const auto& e : kEnvMap) {
+        char* value = nullptr;
+        size_t len = 0;
+        if (_dupenv_s(&value, &len, e.env) == 0 && value) {
+            apply(e.section, e.key, value);
+            free(value);
+        }
     }
-};
+}
 
-// ------------------------- DB  -------------------------
-static sql::Connection* GetConn()
+void Config::loadFromFile(const std::string& filePath)
 {
-    // ȷѼ
-    Config& cfg = Config::Instance();
+    std::ifstream in(filePath);
+    if (!in) {
+        printf("[CONFIG] δҵļ %sʹĬֵ뻷\n", filePath.c_str());
+        fflush(stdout);
+        return;
+    }
 
-    std::string host = cfg.dbHost;
-    int port = cfg.dbPort;
-    std::string user = cfg.dbUser;
-    std::string password = cfg.dbPassword;
-    std::string schema = cfg.dbSchema;
+    std::string line, section;
+    while (std::getline(in, line)) {
+        line = trim(line);
+        if (line.empty() || line[0] == ';' || line[0] == '#')
+            continue;
 
-    std::ostringstream oss;
-    oss << "tcp://" << host << ":" << port;
-    std::string url = oss.str();
+        if (line.front() == '[' && line.back() == ']') {
+            section = trim(line.substr(1, line.size() - 2));
+            continue;
+        }
 
-    sql::Driver* driver = get_driver_instance();
-    sql::Connection* conn = driver->connect(url, user, password);
-    conn->setSchema(schema);
-    return conn;
+        size_t eq = line.find('=');
+        if (eq == std::string::npos)
+            continue;
+        apply(section, trim(line.substr(0, eq)), trim(line.substr(eq + 1)));
+    }
 }
 
-// ------------------------- Ԥṹ -------------------------
-struct AlertOrder
+void Config::apply(const std::string& section, const std::string& key, const std::string& value)
 {
-    long orderId;
-    string account;     //  account ֶ
-    string symbol;
-    double max_price;
-    double min_price;
-    string trigger_time;
-    int state;
-};
-
-// =========================================================
-// =============      CMduserHandler        =============
-// =========================================================
-
-class CMduserHandler : public CThostFtdcMdSpi {
-private:
-    CThostFtdcMdApi* m_mdApi{ nullptr };
-
-    vector<string> m_instruments;
-    vector<char*>  m_instrumentCStrs;
-
-    std::shared_ptr<INotifier> m_notifier;
-
-    // 黺
-    unordered_map<string, double> m_lastPrices;
-    mutex m_priceMutex;
-
-    // ݿصԤ
-    unordered_map<string, vector<AlertOrder>> m_alertMap;
-    mutex m_alertMutex;
-
-    // ߳̿
-    atomic<bool> m_runAlertReload{ false };
-    thread m_reloadThread;
-
-    // /¼ ״̬ id
-    atomic<bool> m_isConnected{ false };
-    atomic<bool> m_isLoggedIn{ false };
-    int m_reqId{ 0 };
-
-public:
-
-    CMduserHandler()
-    {
-        m_notifier = make_shared<ConsoleNotifier>();
-        // ãĬϴ config.ini 򻷾
-        Config::Instance().Load();
+    if (section == "MarketData") {
+        if (key == "Address") mdAddress = value;
+        else if (key == "BrokerID") brokerId = value;
+        else if (key == "UserID") userId = value;
+        else if (key == "Password") password = value;
+        else if (key == "FlowDir") mdFlowDir = value;
+        else if (key == "Partitions") mdPartitions = atoi(value.c_str());
+        else if (key == "Transport") mdTransport = value;
+        else if (key == "MulticastTopicID") mdMulticastTopicId = atoi(value.c_str());
+        else if (key == "QuietFallbackMs") mdQuietFallbackMs = atoi(value.c_str());
+        else if (key == "TcpFallbackAddress") mdTcpFallbackAddress = value;
     }
-
-    ~CMduserHandler()
-    {
-        StopAlertReloadThread();
-        if (m_mdApi) {
-            m_mdApi->Release();
-            m_mdApi = nullptr;
-        }
+    else if (section == "Session") {
+        if (key == "BackoffBaseMs") sessionBackoffBaseMs = atoi(value.c_str());
+        else if (key == "BackoffMaxMs") sessionBackoffMaxMs = atoi(value.c_str());
+        else if (key == "SubscribeChunk") sessionSubscribeChunk = atoi(value.c_str());
     }
-
-    void SetNotifier(shared_ptr<INotifier> n)
-    {
-        m_notifier = n;
+    else if (section == "TickCheck") {
+        if (key == "MaxAgeSec") tickMaxAgeSec = atoi(value.c_str());
+        else if (key == "LogTicks") tickLog = atoi(value.c_str());
     }
-
-    // =====================================================
-    // =============== 1. /ֹͣ DB Ԥ߳ ============
-    // =====================================================
-    void StartAlertReloadThread()
-    {
-        m_runAlertReload = true;
-        m_reloadThread = thread([this]() {
-            while (m_runAlertReload.load())
-            {
-                ReloadAlertsFromDB();
-                this_thread::sleep_for(chrono::seconds(3));
-            }
-            });
+    else if (section == "Instruments") {
+        if (key == "Table") instrumentsTable = value;
+        else if (key == "File") instrumentsFile = value;
+        else if (key == "RefreshTime") instrumentsRefreshTime = value;
     }
-
-    void StopAlertReloadThread()
-    {
-        m_runAlertReload = false;
-        if (m_reloadThread.joinable())
-            m_reloadThread.join();
+    else if (section == "Eval") {
+        if (key == "Workers") evalWorkers = atoi(value.c_str());
+        else if (key == "QueueSize") evalQueueSize = atoi(value.c_str());
+        else if (key == "Idle") evalIdle = value;
+        else if (key == "SpinUs") evalSpinUs = atoi(value.c_str());
     }
-
-    // ===================== ݿȡԤ =====================
-    void ReloadAlertsFromDB()
-    {
-        try {
-            unique_ptr<sql::Connection> conn(GetConn());
-            unique_ptr<sql::PreparedStatement> stmt(
-                conn->prepareStatement(
-                    "SELECT orderId, account, symbol, max_price, min_price, trigger_time, state "
-                    "FROM alert_order WHERE state=0"
-                )
-            );
-            unique_ptr<sql::ResultSet> res(stmt->executeQuery());
-
-            unordered_map<string, vector<AlertOrder>> tmp;
-
-            while (res->next())
-            {
-                AlertOrder a;
-                a.orderId = res->getInt("orderId");
-                a.account = res->getString("account");
-                a.symbol = res->getString("symbol");
-                a.max_price = res->getDouble("max_price");
-                a.min_price = res->getDouble("min_price");
-                a.trigger_time = res->getString("trigger_time");  // ʱֶ
-                a.state = res->getInt("state");
-
-                tmp[a.symbol].push_back(a);
-            }
-
-            lock_guard<mutex> lk(m_alertMutex);
-            m_alertMap.swap(tmp);
-        }
-        catch (sql::SQLException& e) {
-            printf("[DB ERROR] ReloadAlerts: %s\n", e.what());
-            fflush(stdout);
-        }
+    else if (section == "Threads") {
+        if (key == "CallbackCpus") threadCallbackCpus = value;
+        else if (key == "EvalCpus") threadEvalCpus = value;
+        else if (key == "ServiceCpus") threadServiceCpus = value;
+        else if (key == "Realtime") threadRealtime = atoi(value.c_str());
     }
-
-    // ===================== ݿ״̬Ԥ =====================
-    void MarkAlertTriggered(long orderId)
-    {
-        try {
-            unique_ptr<sql::Connection> conn(GetConn());
-            unique_ptr<sql::PreparedStatement> stmt(
-                conn->prepareStatement("UPDATE alert_order SET state=1 WHERE orderId=?")
-            );
-            stmt->setInt(1, orderId);
-            stmt->execute();
-        }
-        catch (...) {
-            printf("[DB ERROR] Ԥ״̬ʧ\n");
-            fflush(stdout);
-        }
+    else if (section == "Database") {
+        if (key == "Host") dbHost = value;
+        else if (key == "Port") dbPort = atoi(value.c_str());
+        else if (key == "User") dbUser = value;
+        else if (key == "Password") dbPassword = value;
+        else if (key == "Schema") dbSchema = value;
     }
-
-    // =====================================================
-    // =============== 2.  API أԭУ ==========
-    // =====================================================
-    void connect()
-    {
-        if (m_mdApi) return;
-        m_mdApi = CThostFtdcMdApi::CreateFtdcMdApi();
-        m_mdApi->RegisterSpi(this);
-
-        // ʹеĵַ
-        Config& cfg = Config::Instance();
-        std::string addrStr = cfg.mdAddress;
-        printf("Connecting to market data server: %s\n", addrStr.c_str());
-        fflush(stdout);
-
-        m_mdApi->RegisterFront(const_cast<char*>(addrStr.c_str()));
-        m_mdApi->Init();
-        printf("Market data API initialized\n");
-        fflush(stdout);
-
-        // ֱӵ ReqUserLogin OnFrontConnected д
+    else if (section == "Outbox") {
+        if (key == "Path") outboxPath = value;
     }
-
-    // Ա login ӿڣⲿãȴ¼ɹȴ룩
-    void login(int timeoutSeconds = 10)
-    {
-        int waited = 0;
-        while (!m_isLoggedIn.load() && waited < timeoutSeconds * 10)
-        {
-            Sleep(100);
-            waited++;
-        }
-
-        if (m_isLoggedIn.load()) {
-            printf("Login successful (confirmed)\n");
-            fflush(stdout);
-        }
-        else {
-            printf("Login not confirmed within timeout\n");
-            fflush(stdout);
-        }
+    else if (section == "Snapshot") {
+        if (key == "Path") snapshotPath = value;
+        else if (key == "IntervalSec") snapshotIntervalSec = atoi(value.c_str());
     }
-
-    void subscribe(const vector<string>& contracts)
-    {
-        // ȴ¼ȷϣ򵥵ȴδ¼ǰģ
-        int waited = 0;
-        while (!m_isLoggedIn.load() && waited < 50) // 5 
-        {
-            Sleep(100);
-            waited++;
-        }
-
-        if (!m_isLoggedIn.load()) {
-            printf("Warning: subscribe called before login confirmed\n");
-            fflush(stdout);
-        }
-
-        m_instruments = contracts;
-        m_instrumentCStrs.clear();
-
-        // ʾĵĺԼ
-        printf("Subscribing to %zu instruments:\n", contracts.size());
-        for (const auto& contract : contracts) {
-            printf("  - %s\n", contract.c_str());
-        }
-        fflush(stdout);
-
-        for (auto& s : m_instruments)
-            m_instrumentCStrs.push_back(const_cast<char*>(s.c_str()));
-
-        int result = 0;
-        while ((result = m_mdApi->SubscribeMarketData(m_instrumentCStrs.data(),
-            (int)m_instrumentCStrs.size())) != 0)
-        {
-            printf("SubscribeMarketData failed with code: %d, retrying...\n", result);
-            fflush(stdout);
-            Sleep(1000);
-        }
-
-        printf("Successfully subscribed to market data\n");
-        fflush(stdout);
+    else if (section == "Reload") {
+        if (key == "DeltaColumn") reloadDeltaColumn = value;
+        else if (key == "FullReloadSec") reloadFullSec = atoi(value.c_str());
     }
-
-    void unsubscribe()
-    {
-        if (m_mdApi)
-            m_mdApi->UnSubscribeMarketData(m_instrumentCStrs.data(),
-                (int)m_instrumentCStrs.size());
+    else if (section == "Intake") {
+        if (key == "Bind") intakeBind = value;
+        else if (key == "Port") intakePort = atoi(value.c_str());
     }
-
-    // =====================================================
-    // =============== 3. ص ========================
-    // =====================================================
-
-    // ȷǰûӺ󴥷﷢͵¼
-    void OnFrontConnected() override
-    {
-        m_isConnected = true;
-        printf("OnFrontConnected: connected to front\n");
-        fflush(stdout);
-
-        // ¼ʹã
-        CThostFtdcReqUserLoginField req = { 0 };
-
-        Config& cfg = Config::Instance();
-        if (!cfg.brokerId.empty()) {
-            strcpy_s(req.BrokerID, cfg.brokerId.c_str());
-        }
-        if (!cfg.userId.empty()) {
-            strcpy_s(req.UserID, cfg.userId.c_str());
-        }
-        if (!cfg.password.empty()) {
-            strcpy_s(req.Password, cfg.password.c_str());
-        }
-
-        m_reqId++;
-        int rt = m_mdApi->ReqUserLogin(&req, m_reqId);
-        printf("ReqUserLogin returned: %d\n", rt);
-        fflush(stdout);
+    else if (section == "Binlog") {
+        if (key == "ServerId") binlogServerId = atoi(value.c_str());
+        else if (key == "HeartbeatSec") binlogHeartbeatSec = atoi(value.c_str());
+        else if (key == "User") binlogUser = value;
+        else if (key == "Password") binlogPassword = value;
     }
-
-    void OnFrontDisconnected(int nReason) override
-    {
-        m_isConnected = false;
-        m_isLoggedIn = false;
-        printf("OnFrontDisconnected: reason=%d\n", nReason);
-        fflush(stdout);
+    else if (section == "Cluster") {
+        if (key == "Self") clusterSelf = value;
+        else if (key == "Instances") clusterInstances = value;
+        else if (key == "Table") clusterTable = value;
+        else if (key == "VirtualNodes") clusterVirtualNodes = atoi(value.c_str());
+        else if (key == "LeaseSec") clusterLeaseSec = atoi(value.c_str());
+        else if (key == "HandoffSec") clusterHandoffSec = atoi(value.c_str());
     }
-
-    // ¼Ӧ
-    void OnRspUserLogin(CThostFtdcRspUserLoginField* pRspUserLogin,
-        CThostFtdcRspInfoField* pRspInfo,
-        int nRequestID, bool bIsLast) override
-    {
-        if (pRspInfo && pRspInfo->ErrorID != 0) {
-            printf("OnRspUserLogin failed: %d %s\n", pRspInfo->ErrorID,
-                pRspInfo->ErrorMsg ? pRspInfo->ErrorMsg : "");
-            fflush(stdout);
-            m_isLoggedIn = false;
-            return;
-        }
-
-        printf("OnRspUserLogin success. TradingDay=%s, LoginTime=%s\n",
-            pRspUserLogin && pRspUserLogin->TradingDay ? pRspUserLogin->TradingDay : "",
-            pRspUserLogin && pRspUserLogin->LoginTime ? pRspUserLogin->LoginTime : "");
-        fflush(stdout);
-        m_isLoggedIn = true;
+    else if (section == "Claim") {
+        if (key == "Table") claimTable = value;
+        else if (key == "LeaseSec") claimLeaseSec = atoi(value.c_str());
     }
-
-    // /˶ӦֻǴӡȷϣ
-    void OnRspSubMarketData(CThostFtdcSpecificInstrumentField* pSpecificInstrument,
-        CThostFtdcRspInfoField* pRspInfo,
-        int nRequestID, bool bIsLast) override
-    {
-        if (pRspInfo && pRspInfo->ErrorID != 0) {
-            printf("OnRspSubMarketData failed: %d %s\n", pRspInfo->ErrorID,
-                pRspInfo->ErrorMsg ? pRspInfo->ErrorMsg : "");
-        }
-        else if (pSpecificInstrument) {
-            printf("OnRspSubMarketData success for %s\n", pSpecificInstrument->InstrumentID);
-        }
-        else {
-            printf("OnRspSubMarketData called (no instrument info)\n");
-        }
-        fflush(stdout);
+    else if (section == "TickBus") {
+        if (key == "Name") tickBusName = value;
+        else if (key == "Capacity") tickBusCapacity = atoi(value.c_str());
     }
-
-    // ·ص
-    void OnRtnDepthMarketData(CThostFtdcDepthMarketDataField* d) override
-    {
-        if (!d) return;
-
-        printf("Received market data for %s: LastPrice=%.2f\n",
-            d->InstrumentID, d->LastPrice);
-        fflush(stdout);
-
-        string symbol = d->InstrumentID;
-        double price = d->LastPrice;
-        // Ϊв flush⻺嵼¿
-        //printf("ɹԤ-\n");
-        //fflush(stdout);
-        // 黺
-        {
-            lock_guard<mutex> lk(m_priceMutex);
-            m_lastPrices[symbol] = price;
-        }
-
-        // ִԤж
-        CheckAlert(symbol, price);
+    else if (section == "TriggerBus") {
+        if (key == "Name") triggerBusName = value;
+        else if (key == "Capacity") triggerBusCapacity = atoi(value.c_str());
     }
-
-    //  symbol  price жԤ
-
-    //  symbol  price жԤ
-    void CheckAlert(const string& symbol, double price)
-    {
-        vector<AlertOrder> alerts;
-
-        {
-            lock_guard<mutex> lk(m_alertMutex);
-            auto it = m_alertMap.find(symbol);
-            if (it == m_alertMap.end())
-                return;
-            alerts = it->second; // ⳤʱ
-        }
-
-        // ¼Ѵ orderIdѭڴɾ
-        vector<long> triggeredIds;
-        triggeredIds.reserve(4);
-
-        // ȡǰʱ - ʹðȫ localtime_s
-        time_t now = time(0);
-        tm local_tm = { 0 };
-        localtime_s(&local_tm, &now);  // ʹ localtime_s  localtime
-        char time_buffer[20];
-        strftime(time_buffer, sizeof(time_buffer), "%Y-%m-%d %H:%M:%S", &local_tm);
-        string current_time_str = string(time_buffer);
-
-        for (auto& a : alerts)
-        {
-            bool triggered = false;
-            string reason;
-
-            // ۸Ԥж
-            if (a.max_price > 0 && price >= a.max_price) {
-                triggered = true;
-                reason = ">=  " + to_string(a.max_price);
-            }
-            if (a.min_price > 0 && price <= a.min_price) {
-                triggered = true;
-                reason = "<=  " + to_string(a.min_price);
-            }
-
-            if (!a.trigger_time.empty()) {
-                // Ԥʱ
-                tm trigger_tm = { 0 };
-
-                // ʹ sscanf_s  sscanf
-                int result = sscanf_s(a.trigger_time.c_str(), "%d-%d-%d %d:%d:%d",
-                    &trigger_tm.tm_year, &trigger_tm.tm_mon, &trigger_tm.tm_mday,
-                    &trigger_tm.tm_hour, &trigger_tm.tm_min, &trigger_tm.tm_sec);
-
-                if (result == 6) {
-                    trigger_tm.tm_year -= 1900;
-                    trigger_tm.tm_mon -= 1;
-
-                    time_t trigger_time_t = mktime(&trigger_tm);
-                    time_t current_time_t = time(0);
-
-                    if (current_time_t >= trigger_time_t) {
-                        triggered = true;
-                        reason = "Ԥʱ " + a.trigger_time;
-                    }
-                }
-            }
-
-            if (triggered)
-            {
-                // ֪ͨ DB 
-                m_notifier->Notify(a.account, symbol, price, reason);
-                MarkAlertTriggered(a.orderId);
-
-                // ¼ҪڴƳʱظ
-                triggeredIds.push_back(a.orderId);
-            }
-        }
-
-        // дƳڴ滺еĶӦĿ̰߳ȫ
-        if (!triggeredIds.empty())
-        {
-            lock_guard<mutex> lk(m_alertMutex);
-            auto it = m_alertMap.find(symbol);
-            if (it != m_alertMap.end())
-            {
-                auto& vec = it->second;
-                vec.erase(std::remove_if(vec.begin(), vec.end(),
-                    [&](const AlertOrder& x) {
-                        return std::find(triggeredIds.begin(), triggeredIds.end(), x.orderId) != triggeredIds.end();
-                    }), vec.end());
-
-                if (vec.empty())
-                    m_alertMap.erase(it);
-            }
-        }
+    else if (section == "TriggerLog") {
+        if (key == "BatchSize") triggerLogBatchSize = atoi(value.c_str());
+        else if (key == "LingerMs") triggerLogLingerMs = atoi(value.c_str());
     }
-
-    // ȡ¼ۣӡ
-    bool GetLastPrice(const string& ins, double& out)
-    {
-        lock_guard<mutex> lk(m_priceMutex);
-        auto it = m_lastPrices.find(ins);
-        if (it == m_lastPrices.end()) return false;
-        out = it->second;
-        return true;
+    else if (section == "Webhook") {
+        if (key == "Url") webhookUrls = value;
+        else if (key == "MaxInFlight") webhookMaxInFlight = atoi(value.c_str());
+        else if (key == "ConnectTimeoutMs") webhookConnectTimeoutMs = atoi(value.c_str());
+        else if (key == "RequestTimeoutMs") webhookRequestTimeoutMs = atoi(value.c_str());
+        else if (key == "MaxRetries") webhookMaxRetries = atoi(value.c_str());
+    }
+    else if (section == "Notify") {
+        if (key == "DigestWindowMs") digestWindowMs = atoi(value.c_str());
+        else if (key == "DigestMaxItems") digestMaxItems = atoi(value.c_str());
     }
-};
+    else if (section == "RateLimit") {
+        if (key == "GlobalPerSec") rateGlobalPerSec = atof(value.c_str());
+        else if (key == "GlobalBurst") rateGlobalBurst = atof(value.c_str());
+        else if (key == "EmailPerSec") rateEmailPerSec = atof(value.c_str());
+        else if (key == "EmailBurst") rateEmailBurst = atof(value.c_str());
+        else if (key == "WebhookPerSec") rateWebhookPerSec = atof(value.c_str());
+        else if (key == "WebhookBurst") rateWebhookBurst = atof(value.c_str());
+        else if (key == "AccountPerSec") rateAccountPerSec = atof(value.c_str());
+        else if (key == "AccountBurst") rateAccountBurst = atof(value.c_str());
+        else if (key == "MaxDeferred") rateMaxDeferred = atoi(value.c_str());
+    }
+}
 
-class MduserHandler
+std::string Config::trim(const std::string& s)
 {
-};
\ No newline at end of file
+    size_t b = s.find_first_not_of(" \t\r\n");
+    if (b == std::string::npos) return std::string();
+    size_t e = s.find_last_not_of(" \t\r\n");
+    return s.substr(b, e - b + 1);
+}
@@ -0,0 +1,160 @@
+// EvalWorkersBench.cpp
+// Ƭж߳չԻ׼̣ Alert-core ̣
+//  [Eval] Workers=N ͬķƬʽinstrumentId % N EvalWorkerPool
+//  1 / 2 / 4 / 8 ж̴߳ͬһ tickʱԵ̵߳ļٱȡ
+//
+// ÷EvalWorkersBench [ticks=400000] [instruments=512] [producers=1] [idle=park|busy]
+//
+// ÿԼһ last > ma(20) + 2 * stdev(20) AND volume > 10 AND last >= 4050
+// ָ򰴺ԼֻƬ̷߳ʣʱһ£
+// ж߳кټ٣ӦڲС
+#include "../AlertRule.h"
+#include "../Indicators.h"
+#include "../EvalWorkers.h"
+#include <stdio.h>
+#include <cstdlib>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <chrono>
+
+static const char* kBenchRule = "last > ma(20) + 2 * stdev(20) AND volume > 10 AND last >= 4050";
+
+// Լж״̬
+struct BenchInstrument
+{
+    std::shared_ptr<IndicatorSet> indicators;
+    CompiledRule rule;
+    std::vector<RulePriceBound> bounds;     // 㵥λ̶Ϊ 1
+};
+
+// ÿ worker ļи
+struct alignas(64) BenchCounter
+{
+    std::atomic<uint64_t> done{ 0 };
+    uint64_t hits{ 0 };
+};
+
+static double NowMs()
+{
+    return std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static int64_t NowUs()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static EvalTask MakeTask(long seq, int instruments)
+{
+    EvalTask t;
+    for (double& v : t.tick.v) v = NAN;
+    t.instrumentId = (int)(seq % instruments);
+    //  4000~4099 䲨Լÿ 1000  tick һ +200 ڴ
+    t.tick.v[TF_LAST] = 4000 + (double)(seq * 7919 % 100) + (seq % 997 == 0 ? 200 : 0);
+    t.tick.v[TF_VOLUME] = (double)seq;
+    t.tick.v[TF_PRICE_TICK] = 1.0;
+    t.tick.time = seq * 0.001;
+    t.tick.priceUnit = 1.0;
+    t.tick.lastTicks = PriceToTicks(t.tick.v[TF_LAST], t.tick.priceUnit);
+    t.tick.bidTicks = t.tick.askTicks = kNoTicks;
+    t.tick.recvUs = NowUs();
+    snprintf(t.symbol, sizeof(t.symbol), "c%d", t.instrumentId);
+    return t;
+}
+
+// غʱ룩hits Ϊʱ߳Ӧһ£
+static double RunOnce(int workers, long ticks, int instruments, int producers, EvalIdleMode idle, uint64_t& hits)
+{
+    IndicatorPool indicatorPool;
+    std::vector<BenchInstrument> book(instruments);
+    for (int id = 0; id < instruments; ++id) {
+        std::string symbol = "c" + std::to_string(id);
+        IndicatorResolver resolver = [&](const std::string& name, int param, IndicatorRef& out) {
+            return indicatorPool.Resolve(symbol, name, param, out);
+        };
+        std::string error;
+        if (!RuleCompiler::Compile(kBenchRule, book[id].rule, error, resolver)) {
+            printf("[BENCH ERROR] ʧ: %s\n", error.c_str());
+            exit(1);
+        }
+        book[id].rule.PrepareTicks(1.0, book[id].bounds);
+        book[id].indicators = std::make_shared<IndicatorSet>();
+        for (auto& ind : book[id].rule.inputs)
+            book[id].indicators->items.push_back(ind);
+    }
+
+    std::vector<BenchCounter> counters(workers);
+    EvalPoolOptions options;
+    options.workers = workers;
+    options.producers = producers;
+    options.idle = idle;
+
+    EvalWorkerPool pool;
+    pool.Start(options, [&](int w, const EvalTask& task) {
+        BenchInstrument& ins = book[task.instrumentId];
+        ins.indicators->Update(task.tick);
+        if (ins.rule.Eval(task.tick, ins.bounds.data())) counters[w].hits++;
+        counters[w].done.fetch_add(1, std::memory_order_release);
+    });
+
+    double t0 = NowMs();
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; ++p) {
+        threads.emplace_back([&, p]() {
+            for (long i = p; i < ticks; i += producers) {
+                EvalTask t = MakeTask(i, instruments);
+                pool.Push(p, t.instrumentId % workers, t);
+            }
+        });
+    }
+    for (auto& th : threads) th.join();
+
+    // ȫ tick жټʱ
+    for (;;) {
+        uint64_t done = 0;
+        for (auto& c : counters) done += c.done.load(std::memory_order_acquire);
+        if (done >= (uint64_t)ticks) break;
+        std::this_thread::yield();
+    }
+    double ms = NowMs() - t0;
+    pool.Report();
+    pool.Stop();
+
+    hits = 0;
+    for (auto& c : counters) hits += c.hits;
+    return ms;
+}
+
+int main(int argc, char** argv)
+{
+    long ticks = argc > 1 ? atol(argv[1]) : 400000;
+    int instruments = argc > 2 ? atoi(argv[2]) : 512;
+    int producers = argc > 3 ? atoi(argv[3]) : 1;
+    EvalIdleMode idle = ParseEvalIdleMode(argc > 4 ? argv[4] : "park");
+    if (ticks <= 0 || instruments <= 0 || producers <= 0) {
+        printf("÷: %s [ticks=400000] [instruments=512] [producers=1] [idle=park|busy]\n", argv[0]);
+        return 1;
+    }
+
+    printf("[BENCH] %ld  tick%d Լ%d ߣӲ߳ %u\n",
+        ticks, instruments, producers, std::thread::hardware_concurrency());
+    fflush(stdout);
+
+    const int workerCounts[] = { 1, 2, 4, 8 };
+    double baseMs = 0.0;
+    for (int workers : workerCounts) {
+        uint64_t hits = 0;
+        double ms = RunOnce(workers, ticks, instruments, producers, idle, hits);
+        if (baseMs == 0.0) baseMs = ms;
+        printf("[BENCH] workers=%d  %.0f ms  %.2f Mtick/s   %.2fx   %llu\n",
+            workers, ms, ticks / ms / 1000.0, baseMs / ms, (unsigned long long)hits);
+        fflush(stdout);
+    }
+    return 0;
+}
@@ -0,0 +1,177 @@
+// IntakeLoadGen.cpp
+// Ԥͽӿѹ⹤ߣ̣ Alert-core ̣
+// ʵ [Intake] Bind:PortȲⵥӳ٣ٰ 1 / 16 / 256 ˮ߷
+// ADD / MOD / DELͳƳı£/룩
+//
+// ÷IntakeLoadGen <port> [host=127.0.0.1] [total=1000000] [idBase=900000000]
+//
+// ѹʹ idBase  kIdSpan Ԥ idʱ DEL ʹ;˳
+// ЩԤ DB вڣһȫҲƳҪʵʹʵԤص idBase
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#include <stdio.h>
+#include <cstdlib>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+
+#pragma comment(lib, "ws2_32.lib")
+
+static const long kIdSpan = 100000;         // ѭʹõԤ id 
+static const int kRttSamples = 2000;
+static const int kWindowBatches = 8;        // ˮδִ
+
+static int64_t NowUs()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+//  seq ÿ 10 һ DEL ADD / MOD 棬ֲ 12 Լ1000 ˻
+static std::string MakeLine(long id, long seq)
+{
+    char buf[256];
+    if (seq % 10 == 9)
+        snprintf(buf, sizeof(buf), "DEL\tid=%ld\n", id);
+    else
+        snprintf(buf, sizeof(buf),
+            "%s\tid=%ld\taccount=u%ld\tsymbol=rb26%02ld\tmax=%ld\tmin=0\trule=last > ma(20)\trepeat=1\n",
+            seq % 3 ? "MOD" : "ADD", id, id % 1000, id % 12 + 1, 4000 + seq % 50);
+    return buf;
+}
+
+static bool SendAll(SOCKET s, const std::string& data)
+{
+    size_t off = 0;
+    while (off < data.size()) {
+        int n = send(s, data.data() + off, (int)(data.size() - off), 0);
+        if (n <= 0) return false;
+        off += n;
+    }
+    return true;
+}
+
+// ȡִмERR е false ʾӶϿ
+struct ReplyReader
+{
+    std::string partial;
+    long lines{ 0 };
+    long errors{ 0 };
+
+    bool Read(SOCKET s)
+    {
+        char buf[64 * 1024];
+        int n = recv(s, buf, sizeof(buf), 0);
+        if (n <= 0) return false;
+        partial.append(buf, n);
+        size_t start = 0, nl;
+        while ((nl = partial.find('\n', start)) != std::string::npos) {
+            if (partial.compare(start, 3, "ERR") == 0) {
+                if (errors < 5)
+                    printf("  %s\n", partial.substr(start, nl - start).c_str());
+                errors++;
+            }
+            lines++;
+            start = nl + 1;
+        }
+        partial.erase(0, start);
+        return true;
+    }
+};
+
+static double Percentile(std::vector<int64_t>& v, double q)
+{
+    if (v.empty()) return 0.0;
+    std::sort(v.begin(), v.end());
+    return (double)v[std::min(v.size() - 1, (size_t)(v.size() * q))];
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2) {
+        printf("÷: %s <port> [host=127.0.0.1] [total=1000000] [idBase=900000000]\n", argv[0]);
+        return 1;
+    }
+    int port = atoi(argv[1]);
+    const char* host = argc > 2 ? argv[2] : "127.0.0.1";
+    long total = argc > 3 ? atol(argv[3]) : 1000000;
+    long idBase = argc > 4 ? atol(argv[4]) : 900000000;
+
+    WSADATA wsaData;
+    WSAStartup(MAKEWORD(2, 2), &wsaData);
+
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((u_short)port);
+    SOCKET s = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (inet_pton(AF_INET, host, &addr.sin_addr) != 1 ||
+        s == INVALID_SOCKET || connect(s, (sockaddr*)&addr, sizeof(addr)) != 0) {
+        printf("[LOADGEN ERROR] ޷ %s:%d\n", host, port);
+        return 1;
+    }
+    int one = 1;
+    setsockopt(s, IPPROTO_TCP, TCP_NODELAY, (const char*)&one, sizeof(one));
+
+    ReplyReader reader;
+
+    // ===== ӳ =====
+    std::vector<int64_t> rtt;
+    rtt.reserve(kRttSamples);
+    for (long i = 0; i < kRttSamples; ++i) {
+        long expect = reader.lines + 1;
+        int64_t t0 = NowUs();
+        if (!SendAll(s, MakeLine(idBase + i % kIdSpan, i))) break;
+        while (reader.lines < expect)
+            if (!reader.Read(s)) { printf("[LOADGEN ERROR] ӶϿ\n"); return 1; }
+        rtt.push_back(NowUs() - t0);
+    }
+    printf("[LOADGEN]  p50=%.0fus p99=%.0fus%zu Σ\n",
+        Percentile(rtt, 0.50), Percentile(rtt, 0.99), rtt.size());
+    fflush(stdout);
+
+    // ===== ˮ£ÿ batch  kWindowBatches δִ =====
+    const int batches[] = { 1, 16, 256 };
+    for (int batch : batches) {
+        long n = batch == 1 ? std::min(total, 100000L) : total;
+        long window = (long)batch * kWindowBatches;
+        long sent = 0, base = reader.lines, errors = reader.errors;
+        std::string out;
+        int64_t t0 = NowUs();
+        while (reader.lines - base < n) {
+            while (sent < n && sent - (reader.lines - base) < window) {
+                out.clear();
+                for (int k = 0; k < batch && sent < n; ++k, ++sent)
+                    out += MakeLine(idBase + sent % kIdSpan, sent);
+                if (!SendAll(s, out)) { printf("[LOADGEN ERROR] ʧ\n"); return 1; }
+            }
+            if (!reader.Read(s)) { printf("[LOADGEN ERROR] ӶϿ\n"); return 1; }
+        }
+        double sec = (NowUs() - t0) / 1e6;
+        printf("[LOADGEN]  %d%ld  %.2f 룬%.0f /룬ERR %ld\n",
+            batch, n, sec, sec > 0 ? n / sec : 0.0, reader.errors - errors);
+        fflush(stdout);
+    }
+
+    // ===== ѹԤ =====
+    long cleanup = std::min(std::max(total, (long)kRttSamples), kIdSpan);
+    long base = reader.lines;
+    std::string out;
+    for (long i = 0; i < cleanup; ++i) {
+        char buf[64];
+        snprintf(buf, sizeof(buf), "DEL\tid=%ld\n", idBase + i);
+        out += buf;
+        if (out.size() >= 64 * 1024 || i + 1 == cleanup) {
+            if (!SendAll(s, out)) break;
+            out.clear();
+            while (reader.lines - base < i + 1)
+                if (!reader.Read(s)) break;
+        }
+    }
+    printf("[LOADGEN] ɾ %ld ѹԤ\n", cleanup);
+
+    closesocket(s);
+    WSACleanup();
+    return 0;
+}
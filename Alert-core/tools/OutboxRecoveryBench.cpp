@@ -0,0 +1,133 @@
+// OutboxRecoveryBench.cpp
+//  outbox д / ָ / ѹ׼̣ Alert-core ̣
+//   1. ͨ TriggerOutbox ׷ N ¼ύ + fsyncԼ pendingPercent% ֪ͨһֱؽ
+//      ֪ͨ DB ¶ɹļͬʱ¼¼ȷϼ¼
+//   2. ֹͣµ TriggerOutbox ͬһļɨȫ¼ֻδ¼дļѹ
+//   3. ٴһѹļԱѹǰĻָʱ
+//
+// ÷OutboxRecoveryBench [events=200000] [pendingPercent=10] [path=outbox_bench.wal]
+//
+// ׼ļڿʼͽʱɾfsync ʱȡڴ̣Ӧڲ outbox ڴС
+#include "../TriggerOutbox.h"
+#include <stdio.h>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <chrono>
+
+static const int kAppendBatch = 64;         // ÿ Append ¼һ reload / tick ڵĶ
+
+static double NowMs()
+{
+    return std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static int64_t FileBytes(const std::string& path)
+{
+    FILE* fp = nullptr;
+    if (fopen_s(&fp, path.c_str(), "rb") != 0 || !fp) return 0;
+    _fseeki64(fp, 0, SEEK_END);
+    int64_t size = _ftelli64(fp);
+    fclose(fp);
+    return size;
+}
+
+static TriggerEvent MakeEvent(long i)
+{
+    TriggerEvent ev;
+    ev.orderId = 100000 + i;
+    ev.fireSeq = 1;
+    ev.final = true;
+    ev.account = "u" + std::to_string(i % 1000);
+    ev.symbol = "rb26" + std::to_string(10 + i % 12);
+    ev.price = 4000 + i % 50;
+    ev.reason = ">=  4000.000000";
+    ev.detectMs = 1760000000000LL + i;
+    ev.exchangeTime = "09:30:00.500";
+    ev.detectLatencyUs = 20;
+    return ev;
+}
+
+// 򿪣ָ + ѹغʱTriggerOutbox Ҳ [OUTBOX] ָ־
+static double TimeOpen(const std::string& path)
+{
+    TriggerOutbox outbox;
+    double t0 = NowMs();
+    if (!outbox.Open(path)) {
+        printf("[BENCH ERROR]  %s ʧ\n", path.c_str());
+        exit(1);
+    }
+    return NowMs() - t0;
+}
+
+int main(int argc, char** argv)
+{
+    long events = argc > 1 ? atol(argv[1]) : 200000;
+    int pendingPercent = argc > 2 ? atoi(argv[2]) : 10;
+    std::string path = argc > 3 ? argv[3] : "outbox_bench.wal";
+    if (events <= 0 || pendingPercent < 1 || pendingPercent > 100) {
+        printf("÷: %s [events=200000] [pendingPercent=10] [path=outbox_bench.wal]\n", argv[0]);
+        return 1;
+    }
+    remove(path.c_str());
+    remove((path + ".tmp").c_str());
+
+    // Լ pendingPercent% ¼֪ͨ NOTIFY_PENDING ɣ֤ļȫɶض
+    long pendingEvery = 100 / pendingPercent;
+    long expectOk = events - (events + pendingEvery - 1) / pendingEvery;
+    std::atomic<long> notified{ 0 };
+    std::atomic<long> marked{ 0 };
+
+    double writeMs = 0.0;
+    {
+        TriggerOutbox outbox;
+        if (!outbox.Open(path)) return 1;
+        outbox.Start(
+            [&](const TriggerEvent& e) -> uint8_t {
+                notified++;
+                return (e.orderId - 100000) % pendingEvery == 0 ? (uint8_t)NOTIFY_PENDING : (uint8_t)NOTIFY_OK;
+            },
+            [&](const TriggerEvent&) { marked++; return true; });
+
+        // ===== д룺¼̺ŻͶݣȫ¼֪ͨΪд =====
+        double t0 = NowMs();
+        std::vector<TriggerEvent> batch;
+        for (long i = 0; i < events; i += kAppendBatch) {
+            batch.clear();
+            for (long k = i; k < events && k < i + kAppendBatch; ++k)
+                batch.push_back(MakeEvent(k));
+            outbox.Append(batch);
+        }
+        while (notified.load() < events)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        writeMs = NowMs() - t0;
+
+        // ȳɹ¼д DB ȷϣֹͣwriter ֹͣǰдʣȷϼ¼
+        while (marked.load() < expectOk)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        outbox.Stop();
+    }
+    int64_t before = FileBytes(path);
+    printf("[BENCH] д %ld ¼ÿ Append %d ύ + fsync%.0f ms%.0f ¼/\n",
+        events, kAppendBatch, writeMs, events * 1000.0 / writeMs);
+    fflush(stdout);
+
+    // ===== ָ + ѹ =====
+    double recoverMs = TimeOpen(path);
+    int64_t after = FileBytes(path);
+    printf("[BENCH] ָѹ %ld ¼ %.0f ms%.0f ¼/룻ļ %.1f MB -> %.1f MB\n",
+        events, recoverMs, events * 1000.0 / recoverMs, before / 1048576.0, after / 1048576.0);
+    fflush(stdout);
+
+    // ===== ѹٴλָ =====
+    double reopenMs = TimeOpen(path);
+    printf("[BENCH] ѹٴλָ %.0f msʣδ¼ %ld \n", reopenMs, events - expectOk);
+    fflush(stdout);
+
+    remove(path.c_str());
+    remove((path + ".tmp").c_str());
+    return 0;
+}
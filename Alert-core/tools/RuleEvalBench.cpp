@@ -0,0 +1,160 @@
+// RuleEvalBench.cpp
+// Ԥ򵥴жϺʱ׼̣ Alert-core ̣
+// Աԭ CheckAlert Ӳжϣ double Ƚ + ÿ tick ʽǰʱ䡢sscanf_s / mktime  trigger_time
+//  AlertRule.h ֽ룬ÿÿжϵ
+//
+// ÷RuleEvalBench [iterations=20000000]
+//
+// tick ȡԤɵ 1024 ѭʹãۼӵ volatile ⱻŻ
+#include "../AlertRule.h"
+#include "../Indicators.h"
+#include <stdio.h>
+#include <cstdlib>
+#include <cmath>
+#include <ctime>
+#include <string>
+#include <vector>
+#include <memory>
+#include <chrono>
+
+static const int kSamples = 1024;
+
+static volatile long long g_sink = 0;
+
+static double NowNs()
+{
+    return std::chrono::duration<double, std::nano>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Уͨ tick һ£С䶯λ 1㵥λ 1
+static void MakeTicks(std::vector<TickRecord>& ticks)
+{
+    ticks.resize(kSamples);
+    for (int i = 0; i < kSamples; ++i) {
+        TickRecord& t = ticks[i];
+        for (double& v : t.v) v = NAN;
+        t.v[TF_LAST] = 3950 + (i * 7919 % 100);
+        t.v[TF_BID] = t.v[TF_LAST] - 1 - (i % 5 == 0 ? 3 : 0);
+        t.v[TF_ASK] = t.v[TF_LAST] + 1;
+        t.v[TF_VOLUME] = 90000 + (i * 104729 % 20000);
+        t.v[TF_SPREAD] = t.v[TF_ASK] - t.v[TF_BID];
+        t.v[TF_PRE_SETTLEMENT] = 3900;
+        t.v[TF_PRICE_TICK] = 1.0;
+        t.time = 34200 + i * 0.5;
+        t.recvUs = 0;
+        t.priceUnit = 1.0;
+        t.lastTicks = PriceToTicks(t.v[TF_LAST], t.priceUnit);
+        t.bidTicks = PriceToTicks(t.v[TF_BID], t.priceUnit);
+        t.askTicks = PriceToTicks(t.v[TF_ASK], t.priceUnit);
+    }
+}
+
+// ===== ԭʵ֣CheckAlert ԵԤж =====
+struct LegacyAlert
+{
+    double max_price;
+    double min_price;
+    std::string trigger_time;
+};
+
+static bool LegacyCheck(const LegacyAlert& a, double price)
+{
+    time_t now = time(0);
+    tm local_tm = { 0 };
+    localtime_s(&local_tm, &now);
+    char time_buffer[20];
+    strftime(time_buffer, sizeof(time_buffer), "%Y-%m-%d %H:%M:%S", &local_tm);
+    std::string current_time_str = std::string(time_buffer);
+
+    bool triggered = false;
+    if (a.max_price > 0 && price >= a.max_price) triggered = true;
+    else if (a.min_price > 0 && price <= a.min_price) triggered = true;
+
+    if (!a.trigger_time.empty()) {
+        tm trigger_tm = { 0 };
+        int result = sscanf_s(a.trigger_time.c_str(), "%d-%d-%d %d:%d:%d",
+            &trigger_tm.tm_year, &trigger_tm.tm_mon, &trigger_tm.tm_mday,
+            &trigger_tm.tm_hour, &trigger_tm.tm_min, &trigger_tm.tm_sec);
+        if (result == 6) {
+            trigger_tm.tm_year -= 1900;
+            trigger_tm.tm_mon -= 1;
+            if (time(0) >= mktime(&trigger_tm)) triggered = true;
+        }
+    }
+    return triggered;
+}
+
+// ԭʵȥʱ䴦ֻʣޱȽϣΪ޲
+static bool LegacyPriceOnly(const LegacyAlert& a, double price)
+{
+    return (a.max_price > 0 && price >= a.max_price) || (a.min_price > 0 && price <= a.min_price);
+}
+
+template <typename F>
+static void Measure(const char* name, long iterations, F eval)
+{
+    long long hits = 0;
+    double t0 = NowNs();
+    for (long i = 0; i < iterations; ++i)
+        hits += eval(i & (kSamples - 1)) ? 1 : 0;
+    double ns = (NowNs() - t0) / iterations;
+    g_sink += hits;
+    printf("[BENCH] %-48s %7.1f ns/   %.1f%%\n", name, ns, 100.0 * hits / iterations);
+    fflush(stdout);
+}
+
+int main(int argc, char** argv)
+{
+    long iterations = argc > 1 ? atol(argv[1]) : 20000000;
+    if (iterations <= 0) {
+        printf("÷: %s [iterations=20000000]\n", argv[0]);
+        return 1;
+    }
+
+    std::vector<TickRecord> ticks;
+    MakeTicks(ticks);
+
+    printf("[BENCH] ÿ %ld жϣ%d  tick ѭ\n", iterations, kSamples);
+
+    // ԭʵֻÿζиʽ mktimeʱ΢뼶
+    LegacyAlert legacy = { 4040, 3960, "2099-01-01 09:00:00" };
+    long legacyIterations = iterations / 20 > 0 ? iterations / 20 : 1;
+    Measure("ԭʵ  + trigger_time", legacyIterations,
+        [&](int i) { return LegacyCheck(legacy, ticks[i].v[TF_LAST]); });
+    Measure("ԭʵ ޣdouble", iterations,
+        [&](int i) { return LegacyPriceOnly(legacy, ticks[i].v[TF_LAST]); });
+
+    // ֽ룺ıһΣ߽簴Ԥ㣨 AlertOrder::PrepareTicks ͬ
+    const char* rules[] = {
+        "last >= 4040 OR last <= 3960",
+        "last >= 4000 AND volume > 1e5",
+        "ask - bid > 3 ticks",
+        "last > ma(20) + 2 * stdev(20) AND volume > 1e5",
+        "(last - pre_settle) / pre_settle > 0.02 OR NOT (bid > 0)",
+    };
+    IndicatorPool pool;
+    for (const char* text : rules) {
+        CompiledRule rule;
+        std::string error;
+        IndicatorResolver resolver = [&](const std::string& name, int param, IndicatorRef& out) {
+            return pool.Resolve("bench", name, param, out);
+        };
+        if (!RuleCompiler::Compile(text, rule, error, resolver)) {
+            printf("[BENCH ERROR]  \"%s\" ʧ: %s\n", text, error.c_str());
+            return 1;
+        }
+        // ָԤһ֣жʱֻȡ䵱ǰֵ
+        IndicatorSet indicators;
+        indicators.items = rule.inputs;
+        for (const TickRecord& t : ticks) indicators.Update(t);
+
+        std::vector<RulePriceBound> bounds;
+        rule.PrepareTicks(1.0, bounds);
+        char name[128];
+        snprintf(name, sizeof(name), "ֽ %s%zu ָ", text, rule.code.size());
+        Measure(name, iterations,
+            [&](int i) { return rule.Eval(ticks[i], bounds.data()); });
+    }
+    return 0;
+}
@@ -0,0 +1,103 @@
+// WebhookLoadGen.cpp
+// WebhookNotifier ѹ̣ Alert-core ̣ ../WebhookNotifier.cpp һ룩
+// Թ̶ʻ򾡿 SendAlertɻصͳƳɹ / ʧܡÿԤ -> ȫ URL  2xxӳٷֲ
+// Լʱͻ˳е WebhookStandIn ۼɺ˶ keep-alive ã
+// Զۼ˵ӱãۼ maxInFlight
+//
+// ÷WebhookLoadGen <url> [alerts=20000] [maxInFlight=16] [perSec=0]
+//   url      http://127.0.0.1:18080/hookԶŷָ
+//   perSec  0 Ϊύ maxInFlight ƣ>0 Ϊ̶ύ
+#include "../WebhookNotifier.h"
+#include <stdio.h>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+
+static int64_t NowUs()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static double Percentile(std::vector<int64_t>& v, double q)
+{
+    if (v.empty()) return 0.0;
+    std::sort(v.begin(), v.end());
+    return v[std::min(v.size() - 1, (size_t)(v.size() * q))] / 1000.0;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2) {
+        printf("÷: %s <url> [alerts=20000] [maxInFlight=16] [perSec=0]\n", argv[0]);
+        return 1;
+    }
+    long alerts = argc > 2 ? atol(argv[2]) : 20000;
+    int maxInFlight = argc > 3 ? atoi(argv[3]) : 16;
+    int perSec = argc > 4 ? atoi(argv[4]) : 0;
+    if (alerts <= 0 || maxInFlight <= 0) {
+        printf("÷: %s <url> [alerts=20000] [maxInFlight=16] [perSec=0]\n", argv[0]);
+        return 1;
+    }
+
+    WebhookNotifier::Options o;
+    std::string urls = argv[1];
+    for (size_t start = 0; start <= urls.size();) {
+        size_t comma = urls.find(',', start);
+        if (comma == std::string::npos) comma = urls.size();
+        if (comma > start) o.urls.push_back(urls.substr(start, comma - start));
+        start = comma + 1;
+    }
+    o.maxInFlight = maxInFlight;
+    o.maxQueue = (int)std::min<long>(alerts + 16, 1000000);
+
+    // ɻص߳еãÿԤֻдԼ±
+    std::vector<int64_t> sentUs(alerts, 0);
+    std::vector<int64_t> latencyUs(alerts, 0);
+    std::atomic<long> ok{ 0 };
+    std::atomic<long> failed{ 0 };
+    long rejected = 0;
+
+    WebhookNotifier webhook(o);
+    if (!webhook.HasEndpoints()) {
+        printf("[LOADGEN ERROR] ûпõ URL: %s\n", argv[1]);
+        return 1;
+    }
+
+    int64_t t0 = NowUs();
+    for (long i = 0; i < alerts; ++i) {
+        if (perSec > 0) {
+            int64_t due = t0 + i * 1000000LL / perSec;
+            int64_t now = NowUs();
+            if (due > now) std::this_thread::sleep_for(std::chrono::microseconds(due - now));
+        }
+        sentUs[i] = NowUs();
+        bool queued = webhook.SendAlert("u" + std::to_string(i % 1000), "rb2610", 4000.0 + i % 50,
+            ">=  4000.000000", [&, i](bool success) {
+                latencyUs[i] = NowUs() - sentUs[i];
+                (success ? ok : failed)++;
+            });
+        if (!queued) rejected++;
+    }
+    while (ok.load() + failed.load() + rejected < alerts)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    double sec = (NowUs() - t0) / 1e6;
+
+    std::vector<int64_t> done;
+    done.reserve(alerts);
+    for (long i = 0; i < alerts; ++i)
+        if (latencyUs[i] > 0) done.push_back(latencyUs[i]);
+
+    WebhookNotifier::Stats st = webhook.GetStats();
+    printf("[LOADGEN] %ld Ԥ  %zu  URLmaxInFlight=%d%.2f 룬%.0f /\n",
+        alerts, o.urls.size(), maxInFlight, sec, alerts / sec);
+    printf("[LOADGEN] ɹ %ld ʧ %ld ܾ %ld  %llu | ӳ p50 %.2f ms p99 %.2f ms | ǰ %zu\n",
+        ok.load(), failed.load(), rejected, (unsigned long long)st.retries,
+        Percentile(done, 0.50), Percentile(done, 0.99), st.connections);
+    fflush(stdout);
+    return 0;
+}
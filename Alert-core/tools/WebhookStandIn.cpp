@@ -0,0 +1,159 @@
+// WebhookStandIn.cpp
+// Webhook ̣ Alert-core ̣ WebhookLoadGen ѹ WebhookNotifier
+// ֻ 127.0.0.1ÿһ̣߳ HTTP/1.1 keep-alive ȡContent-Length 壩
+//  200chunked Ӧ壬ǿͻ˵ķֿѡÿӳ١ÿ N  503ÿ N Ӧرӡ
+// ÿһۼƽܵ뱾봦ں˶Կͻ˵Ӹá
+//
+// ÷WebhookStandIn <port> [delayMs=0] [failEvery=0] [closeEvery=0]
+//   failEvery=N   ÿ N  503ͻӦ˱ԣ
+//   closeEvery=N  ÿӴ N  Connection: close رգͻӦ½
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#include <stdio.h>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <atomic>
+#include <chrono>
+
+#pragma comment(lib, "ws2_32.lib")
+
+static int g_delayMs = 0;
+static long g_failEvery = 0;
+static long g_closeEvery = 0;
+static std::atomic<long> g_accepted{ 0 };
+static std::atomic<long> g_served{ 0 };
+static std::atomic<long> g_failed{ 0 };
+
+static bool SendAll(SOCKET s, const char* data, size_t len)
+{
+    while (len > 0) {
+        int n = send(s, data, (int)len, 0);
+        if (n <= 0) return false;
+        data += n;
+        len -= n;
+    }
+    return true;
+}
+
+//  headers в nameִСдֵҲؿմ
+static std::string HeaderValue(const std::string& headers, const char* name)
+{
+    size_t nameLen = strlen(name);
+    size_t pos = 0;
+    while ((pos = headers.find("\r\n", pos)) != std::string::npos) {
+        pos += 2;
+        if (headers.size() - pos > nameLen && _strnicmp(headers.c_str() + pos, name, nameLen) == 0 &&
+            headers[pos + nameLen] == ':') {
+            size_t start = headers.find_first_not_of(' ', pos + nameLen + 1);
+            size_t end = headers.find("\r\n", pos);
+            if (start == std::string::npos || start >= end) return std::string();
+            return headers.substr(start, end - start);
+        }
+    }
+    return std::string();
+}
+
+static void Serve(SOCKET s)
+{
+    int one = 1;
+    setsockopt(s, IPPROTO_TCP, TCP_NODELAY, (const char*)&one, sizeof(one));
+
+    std::string in;
+    char buf[16 * 1024];
+    long handled = 0;
+    for (;;)
+    {
+        // һͷ + Content-Length ֽڵ
+        size_t headerEnd;
+        while ((headerEnd = in.find("\r\n\r\n")) == std::string::npos) {
+            int n = recv(s, buf, sizeof(buf), 0);
+            if (n <= 0) { closesocket(s); return; }
+            in.append(buf, n);
+        }
+        std::string headers = in.substr(0, headerEnd + 2);
+        size_t bodyLen = (size_t)atol(HeaderValue(headers, "Content-Length").c_str());
+        while (in.size() < headerEnd + 4 + bodyLen) {
+            int n = recv(s, buf, sizeof(buf), 0);
+            if (n <= 0) { closesocket(s); return; }
+            in.append(buf, n);
+        }
+        in.erase(0, headerEnd + 4 + bodyLen);
+
+        if (g_delayMs > 0)
+            std::this_thread::sleep_for(std::chrono::milliseconds(g_delayMs));
+
+        long k = ++g_served;
+        bool close = g_closeEvery > 0 && ++handled >= g_closeEvery;
+        bool fail = g_failEvery > 0 && k % g_failEvery == 0;
+        std::string resp;
+        if (fail) {
+            g_failed++;
+            resp = "HTTP/1.1 503 Service Unavailable\r\nContent-Length: 0\r\n";
+        }
+        else {
+            resp = "HTTP/1.1 200 OK\r\nContent-Type: text/plain\r\nTransfer-Encoding: chunked\r\n";
+        }
+        if (close) resp += "Connection: close\r\n";
+        resp += "\r\n";
+        if (!fail) resp += "2\r\nok\r\n0\r\n\r\n";
+
+        if (!SendAll(s, resp.data(), resp.size()) || close) {
+            closesocket(s);
+            return;
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2) {
+        printf("÷: %s <port> [delayMs=0] [failEvery=0] [closeEvery=0]\n", argv[0]);
+        return 1;
+    }
+    int port = atoi(argv[1]);
+    g_delayMs = argc > 2 ? atoi(argv[2]) : 0;
+    g_failEvery = argc > 3 ? atol(argv[3]) : 0;
+    g_closeEvery = argc > 4 ? atol(argv[4]) : 0;
+
+    WSADATA wsaData;
+    WSAStartup(MAKEWORD(2, 2), &wsaData);
+
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((u_short)port);
+    inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+    SOCKET listener = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    int one = 1;
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, (const char*)&one, sizeof(one));
+    if (listener == INVALID_SOCKET || bind(listener, (sockaddr*)&addr, sizeof(addr)) != 0 ||
+        listen(listener, SOMAXCONN) != 0) {
+        printf("[STANDIN ERROR] ޷ 127.0.0.1:%d %d\n", port, WSAGetLastError());
+        return 1;
+    }
+    printf("[STANDIN]  127.0.0.1:%dӳ %d msÿ %ld  503ÿ %ld رգ0 Ϊã\n",
+        port, g_delayMs, g_failEvery, g_closeEvery);
+    fflush(stdout);
+
+    // ÿ뱨һ
+    std::thread([]() {
+        long last = 0;
+        for (;;) {
+            std::this_thread::sleep_for(std::chrono::seconds(1));
+            long served = g_served.load();
+            if (served == last) continue;
+            printf("[STANDIN] ۼ %ldۼ %ld503 %ld %ld \n",
+                g_accepted.load(), served, g_failed.load(), served - last);
+            fflush(stdout);
+            last = served;
+        }
+    }).detach();
+
+    for (;;) {
+        SOCKET c = accept(listener, nullptr, nullptr);
+        if (c == INVALID_SOCKET) continue;
+        g_accepted++;
+        std::thread(Serve, c).detach();
+    }
+}